@@ -61,13 +61,16 @@
 *
 *     Format of the message
 *
-*           l[0]              l[1]         s[4]   s[5]       l[3]               l[4]
+*           l[0]              l[1]         s[4]   s[5]    s[6]    s[7]    s[8]  b[18] b[19]
 *     +----------------+----------------+----------------+----------------+----------------+
-*     |                |                |       |        |                |                | 
-*     |  total_lines   |  current_line  |  col  | write  |                |                | 
-*     |                |                |       |        |                |                | 
+*     |                |                |       |        | tindex kbytes  |tindex  |   |    |
+*     |  total_lines   |  current_line  |  col  | write  |                |build   |hit|stat|
+*     |                |                |       |        |  high  |  low  |tenths  |pct|    |
 *     +----------------+----------------+----------------+----------------+----------------+
 *     
+*     The tindex fields describe the trigram index (tindex.c).
+*     The percent and state bytes need no conversion.
+*     
 *
 ***************************************************************/
 
@@ -75,6 +78,11 @@
 #define   CURRENT_LINENO       xclient.data.l[1]
 #define   CURRENT_COLNO        xclient.data.s[4]
 #define   PAD_WRITABLE         xclient.data.s[5]
+#define   TINDEX_KBYTES_HIGH   xclient.data.s[6]
+#define   TINDEX_KBYTES_LOW    xclient.data.s[7]
+#define   TINDEX_BUILD_TENTHS  xclient.data.s[8]
+#define   TINDEX_HIT_PCT       xclient.data.b[18]
+#define   TINDEX_STATE         xclient.data.b[19]
 
 #endif
 
@@ -0,0 +1,1010 @@
+/*static char *sccsid = "%Z% %M% %I% - %G% %U% ";*/
+/***************************************************************
+*
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in autoimage.c
+*     autoimage_interval      - Set the seconds between autosave images
+*     autoimage_open          - Start autosave images of the edit file
+*     autoimage_timeout       - Microseconds till the next autosave work
+*     autoimage_reset         - Start over after the file is written or reloaded
+*     autoimage_pause         - Hold off images while a background pw runs
+*     autoimage_resume        - Carry on after a background pw
+*     autoimage_recover       - Load the last autosave image for -recover
+*     autoimage_close         - Remove the image on a clean exit
+*
+*  Internal routines:
+*     autoimage_start         - Create an empty image for the edit file
+*     autoimage_stop          - Close and remove the image
+*     autoimage_offsets       - See if the main pad is being read from the edit file
+*     autoimage_pass          - Start writing a new image
+*     autoimage_commit        - Write the map and header of a new image
+*     autoimage_best          - Read the newest good header of an image
+*     autoimage_copy          - Copy a run of text while recovering
+*     autoimage_write         - Write at an offset
+*     autoimage_fail          - Stop writing images after an I/O error
+*     autoimage_sum           - Check sum of a header or map
+*
+*  memdata keeps, for each block of lines, where its text was last
+*  saved.  Blocks read from the edit file start out saved there,
+*  and a pw saves them all there again.  Changing a line clears
+*  the saved place of its block.  An image is the text of the
+*  blocks which are not saved anywhere, appended to <file>.CEA,
+*  followed by a map of the runs which make up the buffer and a
+*  header pointing at the map.  A few changes to a big file give
+*  a few blocks and a short map.
+*
+*  There are two header slots at the front of the image, used in
+*  turn, and everything else is appended.  The map and the blocks
+*  are synced before the header is written, so the header last
+*  written which checks always describes a complete buffer.  When
+*  most of the image is text which was replaced since, the next
+*  image is written to a new file which is renamed over the old.
+*
+*  Writing an image is done from timeout_set, a slice of at most
+*  AUTOIMAGE_SLICE_BYTES at a time, so input is looked at between
+*  slices.  Blocks changed between slices are written again, the
+*  map is only built once a slice finds them all saved.
+*
+*  When the journal is kept, it starts over each time an image is
+*  written and records the image serial number.  -recover loads
+*  the image, then replays the journal over it.
+*
+***************************************************************/
+
+#include <stdio.h>          /* /usr/include/stdio.h      */
+#include <string.h>         /* /usr/include/string.h     */
+#include <stddef.h>         /* /usr/include/stddef.h     */
+#include <errno.h>          /* /usr/include/errno.h      */
+#include <stdlib.h>         /* /usr/include/stdlib.h     */
+#include <sys/types.h>      /* /usr/include/sys/types.h  */
+#include <sys/stat.h>       /* /usr/include/sys/stat.h   */
+#include <fcntl.h>          /* /usr/include/fcntl.h      */
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>         /* /usr/include/unistd.h     */
+#include <sys/time.h>       /* /usr/include/sys/time.h   */
+#endif
+
+#include "autoimage.h"
+#include "debug.h"
+#include "dmwin.h"
+#include "emalloc.h"
+#include "journal.h"
+#include "memdata.h"
+#include "parms.h"
+#include "windowdefs.h"
+
+#ifndef MAXPATHLEN
+#define MAXPATHLEN	1024
+#endif
+
+#ifdef WIN32
+#define fsync(fd)          _commit(fd)
+#endif
+
+/***************************************************************
+*
+*  AUTOIMAGE_SLICE_BYTES is how much is written each time round
+*  the wait for input.  A new file is started once the text no
+*  longer used passes twice what is used plus AUTOIMAGE_SLACK.
+*  AUTOIMAGE_MAX_SECONDS keeps the timeout in an int.
+*
+***************************************************************/
+
+#define AUTOIMAGE_SLICE_BYTES  1048576
+#define AUTOIMAGE_SLACK        1048576
+#define AUTOIMAGE_MAX_SECONDS  2000
+
+#define AUTOIMAGE_MAGIC        "CeImag1\n"
+
+typedef struct {
+   char            magic[8];       /* AUTOIMAGE_MAGIC                           */
+   long            size;           /* edit file size, -1 for a new file         */
+   long            mtime;          /* edit file modify time                     */
+   long            serial;         /* counts the images written, 0 for none     */
+   long            map_offset;     /* where the BLOCK_MAP array is              */
+   long            map_count;      /* runs in the map                           */
+   long            tail;           /* rest of the edit file not yet read, or -1 */
+   unsigned int    map_check;      /* autoimage_sum of the map                  */
+   unsigned int    check;          /* autoimage_sum of the fields above         */
+} AUTOIMAGE_HEADER;
+
+/* the two header slots come first, blocks and maps after */
+#define AUTOIMAGE_DATA  ((long)(2 * sizeof(AUTOIMAGE_HEADER)))
+
+static int              afd = -1;                 /* the image, -1 for none            */
+static DATA_TOKEN      *atoken = NULL;            /* the main pad                      */
+static char             aname[MAXPATHLEN+8];      /* <edit_file>.CEA                   */
+static char             nname[MAXPATHLEN+16];     /* <edit_file>.CEA.new               */
+static AUTOIMAGE_HEADER aheader;                  /* the last header written           */
+static unsigned int     agen;                     /* saved_in for blocks in the image  */
+static unsigned int     last_gen = SAVED_IN_FILE; /* last saved_in value handed out    */
+static long             aend;                     /* end of the image                  */
+static long             alive;                    /* bytes of blocks the last map uses */
+static long             ausecs = 0;               /* wait after a change, 0 for none   */
+
+static int              tfd = -1;                 /* file an image is going to, or -1  */
+static unsigned int     tgen;                     /* saved_in for blocks going there   */
+static long             tend;                     /* end of the file being written     */
+
+static int              await = False;            /* adirty is set                     */
+static int              afailed = False;          /* an I/O error stopped the images   */
+static int              apaused = False;          /* a background pw is running        */
+#ifndef WIN32
+static struct timeval   adirty;                   /* when a change was first seen      */
+#endif
+
+/***************************************************************
+*
+*  Prototypes for local routines
+*
+***************************************************************/
+
+static void  autoimage_start(DATA_TOKEN      *token,
+                             char            *edit_file);
+
+static void  autoimage_stop(void);
+
+static void  autoimage_offsets(DATA_TOKEN      *token,
+                               char            *edit_file);
+
+static void  autoimage_pass(void);
+
+static void  autoimage_commit(void);
+
+static long  autoimage_best(int               fd,
+                            AUTOIMAGE_HEADER *header);
+
+static int   autoimage_copy(int               fd,
+                            long              offset,
+                            long              bytes,
+                            FILE             *stream);
+
+static int   autoimage_write(int               fd,
+                             long              offset,
+                             char             *data,
+                             long              len);
+
+static void  autoimage_fail(char            *what);
+
+static unsigned int autoimage_sum(char            *data,
+                                  long             len);
+
+
+/************************************************************************
+
+NAME:      autoimage_interval  - Set the seconds between autosave images
+
+PURPOSE:    This routine is called from the -autoimage parm.  An image is
+            written once the main pad has been changed for this long.
+            Zero turns images off.  Not done on Windows, where the edit
+            file is read and written in text mode and the byte offsets
+            kept by memdata do not hold.
+
+*************************************************************************/
+
+void  autoimage_interval(int              seconds)           /* input  */
+{
+
+#ifndef WIN32
+if (seconds > AUTOIMAGE_MAX_SECONDS)
+   seconds = AUTOIMAGE_MAX_SECONDS;
+
+ausecs = (seconds > 0) ? (long)seconds * 1000000 : 0;
+#endif
+
+} /* end of autoimage_interval */
+
+
+/************************************************************************
+
+NAME:      autoimage_open  - Start autosave images of the edit file
+
+PURPOSE:    This routine is called once the main pad is set up, before
+            it is read.  It starts an empty image for the file.  If an
+            image is already there, a session editing the file did not end
+            cleanly.  It is left alone for ce -recover and this session
+            writes no images.
+
+PARAMETERS:
+
+   1.  token      -  pointer to DATA_TOKEN (INPUT / OUTPUT)
+                     The main pad memdata.
+
+   2.  edit_file  -  pointer to char (INPUT)
+                     The file being edited.
+
+   3.  image      -  long (INPUT)
+                     The serial number of the image autoimage_recover
+                     loaded, or zero.  A loaded image is kept as it is
+                     until the file is written, the journal may be
+                     based on it.
+
+*************************************************************************/
+
+void  autoimage_open(DATA_TOKEN      *token,             /* input / output */
+                     char            *edit_file,         /* input  */
+                     long             image)             /* input  */
+{
+AUTOIMAGE_HEADER  header;
+char              msg[MAXPATHLEN+128];
+int               fd;
+
+if (image)
+   {
+      atoken = token;
+      return;
+   }
+
+if (!ausecs)
+   return;
+
+if (LSF)
+   {
+      dm_error("-autoimage is not done with -lsf, the file on disk is not the text in memory", DM_ERROR_BEEP);
+      return;
+   }
+
+snprintf(aname, sizeof(aname), "%s%s", edit_file, AUTOIMAGE_SUFFIX);
+
+fd = open(aname, O_RDONLY);
+if (fd >= 0)
+   {
+      image = autoimage_best(fd, &header);
+      close(fd);
+      if (image)
+         {
+            snprintf(msg, sizeof(msg), "%s holds an autosave from a session which did not end, use ce -recover to load it", aname);
+            dm_error(msg, DM_ERROR_BEEP);
+            return;
+         }
+   }
+
+autoimage_offsets(token, edit_file);
+autoimage_start(token, edit_file);
+
+} /* end of autoimage_open */
+
+
+/************************************************************************
+
+NAME:      autoimage_timeout  - Microseconds till the next autosave work
+
+PURPOSE:    This routine is called from timeout_set each time around the
+            wait for input.  Once the main pad has been changed for the
+            autoimage interval, each call writes one slice of the image.
+
+RETURNED VALUE:
+   usecs   -   int
+               The microseconds till there is work to do, 1 while an image
+               is being written, zero if nothing has changed.
+
+*************************************************************************/
+
+int   autoimage_timeout(void)
+{
+#ifndef WIN32
+struct timeval    now;
+long              waited;
+int               rc;
+#endif
+
+if ((afd < 0) || afailed || !ausecs || !atoken || apaused)
+   return(0);
+
+#ifdef WIN32
+return(0);
+#else
+if (tfd < 0)
+   {
+      if (!atoken->blocks_dirty)
+         {
+            await = False;
+            return(0);
+         }
+
+      gettimeofday(&now, NULL);
+      if (!await)
+         {
+            await = True;
+            adirty = now;
+            return(ausecs);
+         }
+
+      waited = ((now.tv_sec - adirty.tv_sec) * 1000000) + (now.tv_usec - adirty.tv_usec);
+      if ((waited < ausecs) && (waited >= 0))
+         return(ausecs - waited);
+
+      /* the rest of the file can be put in the map by offset only if it is the edit file */
+      if ((instream != NULL) && !atoken->file_offsets)
+         return(ausecs);
+
+      autoimage_pass();
+      if (tfd < 0)
+         return(0);
+   }
+
+rc = save_blocks(atoken, tfd, tgen, &tend, AUTOIMAGE_SLICE_BYTES); /* in memdata.c */
+if (rc < 0)
+   autoimage_fail("write");
+else
+   if (rc > 0)
+      autoimage_commit();
+
+return((tfd >= 0) ? 1 : 0);
+#endif
+
+} /* end of autoimage_timeout */
+
+
+/************************************************************************
+
+NAME:      autoimage_reset  - Start over after the file is written or reloaded
+
+PURPOSE:    Once the memory copy matches the file on disk, the image is
+            not needed.  It is thrown away, each block is marked as saved
+            in the file, and a new image started.  This is also where a pad
+            name change moves the image to the new name.
+
+PARAMETERS:
+
+   1.  token      -  pointer to DATA_TOKEN (INPUT / OUTPUT)
+                     The main pad memdata, a reload gives a new one.
+
+   2.  edit_file  -  pointer to char (INPUT)
+                     The file being edited.
+
+*************************************************************************/
+
+void  autoimage_reset(DATA_TOKEN      *token,             /* input / output */
+                      char            *edit_file)         /* input  */
+{
+
+if (afd < 0)
+   return;
+
+autoimage_stop();
+
+if (!ausecs || afailed)
+   return;
+
+snprintf(aname, sizeof(aname), "%s%s", edit_file, AUTOIMAGE_SUFFIX);
+blocks_saved(token); /* in memdata.c */
+autoimage_offsets(token, edit_file);
+autoimage_start(token, edit_file);
+
+} /* end of autoimage_reset */
+
+
+/************************************************************************
+
+NAME:      autoimage_pause  - Hold off images while a background pw runs
+
+PURPOSE:    While a background pw is writing the file, no image is
+            committed.  That keeps the journal from being cut back, which
+            journal_rebase needs.  Where each block will be in the new
+            file is noted, so the blocks not changed in the meantime can
+            be marked saved in it when the pw is done.
+
+*************************************************************************/
+
+void  autoimage_pause(DATA_TOKEN      *token)             /* input / output */
+{
+
+if (afd < 0)
+   return;
+
+blocks_pending(token); /* in memdata.c */
+apaused = True;
+
+} /* end of autoimage_pause */
+
+
+/************************************************************************
+
+NAME:      autoimage_resume  - Carry on after a background pw
+
+PURPOSE:    If the pw worked, the image is thrown away and a new one
+            started from the new file, as autoimage_reset does.  Only the
+            blocks changed while the pw ran need to go in it.  If the pw
+            failed, the image carries on where it was.
+
+PARAMETERS:
+
+   1.  token      -  pointer to DATA_TOKEN (INPUT / OUTPUT)
+                     The main pad memdata.
+
+   2.  edit_file  -  pointer to char (INPUT)
+                     The file being edited.
+
+   3.  saved      -  int (INPUT)
+                     True if the file was written.
+
+*************************************************************************/
+
+void  autoimage_resume(DATA_TOKEN      *token,             /* input / output */
+                       char            *edit_file,         /* input  */
+                       int              saved)             /* input  */
+{
+
+if (!apaused)
+   return;
+apaused = False;
+
+blocks_pending_saved(token, saved); /* in memdata.c */
+if (!saved || (afd < 0))
+   return;
+
+autoimage_stop();
+if (!ausecs || afailed)
+   return;
+
+snprintf(aname, sizeof(aname), "%s%s", edit_file, AUTOIMAGE_SUFFIX);
+autoimage_offsets(token, edit_file);
+autoimage_start(token, edit_file);
+
+} /* end of autoimage_resume */
+
+
+/************************************************************************
+
+NAME:      autoimage_recover  - Load the last autosave image for -recover
+
+PURPOSE:    This routine is called for -recover with the main pad fully
+            read.  If the edit file has an image and the file is the size
+            and age it was when the image was started, the text the image
+            describes is put together in a temporary file and read into a
+            new memdata in place of the main pad.  The image is kept open,
+            autoimage_open carries on from it.
+
+PARAMETERS:
+
+   1.  token      -  pointer to pointer to DATA_TOKEN (INPUT / OUTPUT)
+                     The main pad memdata, replaced if the image is loaded.
+
+   2.  edit_file  -  pointer to char (INPUT)
+                     The file being edited.
+
+RETURNED VALUE:
+   image   -   long
+               The serial number of the image loaded, zero if none was.
+
+*************************************************************************/
+
+long  autoimage_recover(DATA_TOKEN     **token,             /* input / output */
+                        char            *edit_file)         /* input  */
+{
+AUTOIMAGE_HEADER  header;
+BLOCK_MAP        *map;
+DATA_TOKEN       *new_token;
+struct stat       file_stats;
+char              msg[MAXPATHLEN+128];
+FILE             *stream;
+long              image;
+long              bytes;
+long              i;
+int               fd;
+int               efd = -1;
+int               ok;
+int               eof = False;
+
+snprintf(aname, sizeof(aname), "%s%s", edit_file, AUTOIMAGE_SUFFIX);
+
+fd = open(aname, O_RDWR);
+if (fd < 0)
+   return(0);
+
+image = autoimage_best(fd, &header);
+if (!image)
+   {
+      close(fd);
+      return(0);
+   }
+
+if (stat(edit_file, &file_stats) != 0)
+   {
+      file_stats.st_size  = -1;
+      file_stats.st_mtime = 0;
+   }
+if ((header.size != (long)file_stats.st_size) || ((header.size >= 0) && (header.mtime != (long)file_stats.st_mtime)))
+   {
+      snprintf(msg, sizeof(msg), "(recover) %s has changed since %s was started, not loaded", edit_file, aname);
+      dm_error(msg, DM_ERROR_BEEP);
+      close(fd);
+      return(0);
+   }
+
+/***************************************************************
+*  Read and check the map.
+***************************************************************/
+bytes = header.map_count * sizeof(BLOCK_MAP);
+map = (BLOCK_MAP *)CE_MALLOC(bytes + sizeof(BLOCK_MAP));
+if (!map)
+   {
+      close(fd);
+      return(0);
+   }
+if ((lseek(fd, header.map_offset, SEEK_SET) < 0) || (read(fd, (char *)map, bytes) != bytes) ||
+    (autoimage_sum((char *)map, bytes) != header.map_check))
+   {
+      snprintf(msg, sizeof(msg), "(recover) %s is damaged, not loaded", aname);
+      dm_error(msg, DM_ERROR_BEEP);
+      free((char *)map);
+      close(fd);
+      return(0);
+   }
+
+/***************************************************************
+*  Put the text together, the runs from the image and the file,
+*  then whatever of the file had not been read.
+***************************************************************/
+stream = tmpfile();
+if (header.size >= 0)
+   efd = open(edit_file, O_RDONLY);
+ok = (stream != NULL);
+for (i = 0; ok && (i < header.map_count); i++)
+   ok = autoimage_copy(((map[i].saved_in == SAVED_IN_FILE) ? efd : fd), map[i].offset, map[i].bytes, stream);
+if (ok && (header.tail >= 0))
+   ok = autoimage_copy(efd, header.tail, header.size - header.tail, stream);
+free((char *)map);
+if (efd >= 0)
+   close(efd);
+
+if (!ok || (fflush(stream) != 0))
+   {
+      snprintf(msg, sizeof(msg), "(recover) Cannot put together the text in %s (%s), not loaded", aname, strerror(errno));
+      dm_error(msg, DM_ERROR_BEEP);
+      if (stream)
+         fclose(stream);
+      close(fd);
+      return(0);
+   }
+
+rewind(stream);
+new_token = mem_init(75, False); /* in memdata.c, same as the main pad */
+WRITABLE(new_token) = (*token)->writable;
+while (!eof)
+   load_a_block(new_token, stream, False, &eof);
+fclose(stream);
+
+mem_kill(*token);
+*token = new_token;
+dirty_bit(new_token) = True;
+
+afd     = fd;
+aheader = header;
+aend    = lseek(fd, 0, SEEK_END);
+alive   = aend - AUTOIMAGE_DATA;
+agen    = ++last_gen;
+atoken  = new_token;
+
+snprintf(msg, sizeof(msg), "(recover) %d lines loaded from %s", total_lines(new_token), aname);
+dm_error(msg, DM_ERROR_MSG);
+
+return(image);
+
+} /* end of autoimage_recover */
+
+
+/************************************************************************
+
+NAME:      autoimage_close  - Remove the image on a clean exit
+
+*************************************************************************/
+
+void  autoimage_close(void)
+{
+
+autoimage_stop();
+atoken = NULL;
+
+} /* end of autoimage_close */
+
+
+/************************************************************************
+
+NAME:      autoimage_start  - Create an empty image for the edit file
+
+*************************************************************************/
+
+static void  autoimage_start(DATA_TOKEN      *token,
+                             char            *edit_file)
+{
+struct stat       file_stats;
+char              msg[MAXPATHLEN+128];
+char              empty[2 * sizeof(AUTOIMAGE_HEADER)];
+
+memset((char *)&aheader, 0, sizeof(aheader));
+memcpy(aheader.magic, AUTOIMAGE_MAGIC, sizeof(aheader.magic));
+if (stat(edit_file, &file_stats) == 0)
+   {
+      aheader.size  = file_stats.st_size;
+      aheader.mtime = file_stats.st_mtime;
+   }
+else
+   aheader.size = -1;
+
+afd = open(aname, O_RDWR | O_CREAT | O_TRUNC, 0600);
+if (afd < 0)
+   {
+      snprintf(msg, sizeof(msg), "Cannot create autosave image %s (%s), no images written", aname, strerror(errno));
+      dm_error(msg, DM_ERROR_LOG);
+      return;
+   }
+
+memset(empty, 0, sizeof(empty));
+if (!autoimage_write(afd, 0, empty, sizeof(empty)))
+   {
+      autoimage_fail("write");
+      return;
+   }
+
+aend   = AUTOIMAGE_DATA;
+alive  = 0;
+agen   = ++last_gen;
+atoken = token;
+await  = False;
+
+DEBUG1(fprintf(stderr, "autoimage_start: %s\n", aname);)
+
+} /* end of autoimage_start */
+
+
+/************************************************************************
+
+NAME:      autoimage_stop  - Close and remove the image
+
+*************************************************************************/
+
+static void  autoimage_stop(void)
+{
+
+if ((tfd >= 0) && (tfd != afd))
+   {
+      close(tfd);
+      unlink(nname);
+   }
+tfd = -1;
+
+if (afd >= 0)
+   {
+      close(afd);
+      unlink(aname);
+      afd = -1;
+   }
+
+await = False;
+
+} /* end of autoimage_stop */
+
+
+/************************************************************************
+
+NAME:      autoimage_offsets  - See if the main pad is being read from the edit file
+
+PURPOSE:    Blocks can only be put in the map as a place in the edit file
+            if the stream memdata reads is the edit file itself.  It is
+            something else for stdin, a filter or a man page.
+
+*************************************************************************/
+
+static void  autoimage_offsets(DATA_TOKEN      *token,
+                               char            *edit_file)
+{
+struct stat       file_stats;
+struct stat       stream_stats;
+
+token->file_offsets = (instream != NULL) && !MANFORMAT &&
+                      (fstat(fileno(instream), &stream_stats) == 0) && (stat(edit_file, &file_stats) == 0) &&
+                      (stream_stats.st_dev == file_stats.st_dev) && (stream_stats.st_ino == file_stats.st_ino);
+
+} /* end of autoimage_offsets */
+
+
+/************************************************************************
+
+NAME:      autoimage_pass  - Start writing a new image
+
+PURPOSE:    Normally the new image is appended to the current one.  When
+            most of the current one is blocks replaced since, a new file
+            is started beside it and every block not in the edit file is
+            written to it.
+
+*************************************************************************/
+
+static void  autoimage_pass(void)
+{
+char              empty[2 * sizeof(AUTOIMAGE_HEADER)];
+
+if ((aend - AUTOIMAGE_DATA) > ((2 * alive) + AUTOIMAGE_SLACK))
+   {
+      snprintf(nname, sizeof(nname), "%s.new", aname);
+      tfd = open(nname, O_RDWR | O_CREAT | O_TRUNC, 0600);
+      if (tfd >= 0)
+         {
+            memset(empty, 0, sizeof(empty));
+            if (!autoimage_write(tfd, 0, empty, sizeof(empty)))
+               {
+                  autoimage_fail("write");
+                  return;
+               }
+            tgen = ++last_gen;
+            tend = AUTOIMAGE_DATA;
+            DEBUG1(fprintf(stderr, "autoimage_pass: %ld of %ld bytes used, new image %s\n", alive, aend, nname);)
+            return;
+         }
+   }
+
+tfd  = afd;
+tgen = agen;
+tend = aend;
+
+} /* end of autoimage_pass */
+
+
+/************************************************************************
+
+NAME:      autoimage_commit  - Write the map and header of a new image
+
+PURPOSE:    This routine is called when save_blocks has every block saved.
+            Nothing can change between that and this, so the map describes
+            the buffer as it is.  The map is appended and synced, then the
+            header goes in the older slot and is synced.  The journal starts
+            over from the new image.
+
+*************************************************************************/
+
+static void  autoimage_commit(void)
+{
+AUTOIMAGE_HEADER  header;
+BLOCK_MAP        *map;
+int               count;
+long              bytes;
+int               i;
+
+map = block_map(atoken, &count); /* in memdata.c */
+if (!map)
+   {
+      autoimage_fail("map");
+      return;
+   }
+
+header = aheader;
+header.serial++;
+header.map_offset = tend;
+header.map_count  = count;
+header.tail       = (instream != NULL) ? ftell(instream) : -1;
+bytes = count * sizeof(BLOCK_MAP);
+header.map_check  = autoimage_sum((char *)map, bytes);
+header.check      = autoimage_sum((char *)&header, offsetof(AUTOIMAGE_HEADER, check));
+
+if (!autoimage_write(tfd, tend, (char *)map, bytes) || (fsync(tfd) != 0) ||
+    !autoimage_write(tfd, (header.serial & 1) * sizeof(AUTOIMAGE_HEADER), (char *)&header, sizeof(header)) ||
+    (fsync(tfd) != 0))
+   {
+      free((char *)map);
+      autoimage_fail("write");
+      return;
+   }
+
+if (tfd != afd)
+   {
+      if (rename(nname, aname) != 0)
+         {
+            free((char *)map);
+            autoimage_fail("rename");
+            return;
+         }
+      close(afd);
+      afd  = tfd;
+      agen = tgen;
+   }
+
+aheader = header;
+aend    = tend + bytes;
+alive   = 0;
+for (i = 0; i < count; i++)
+   if (map[i].saved_in == agen)
+      alive += map[i].bytes;
+free((char *)map);
+
+tfd   = -1;
+await = False;
+
+DEBUG1(fprintf(stderr, "autoimage_commit: image %ld, %d runs, %ld of %ld bytes used\n", header.serial, count, alive, aend);)
+
+journal_checkpoint(header.serial); /* in journal.c */
+
+} /* end of autoimage_commit */
+
+
+/************************************************************************
+
+NAME:      autoimage_best  - Read the newest good header of an image
+
+RETURNED VALUE:
+   image   -   long
+               The serial number of the header returned, zero if neither
+               slot holds a header which checks.
+
+*************************************************************************/
+
+static long  autoimage_best(int               fd,
+                            AUTOIMAGE_HEADER *header)
+{
+AUTOIMAGE_HEADER  slot[2];
+int               best = -1;
+int               i;
+
+if ((lseek(fd, 0, SEEK_SET) < 0) || (read(fd, (char *)slot, sizeof(slot)) != sizeof(slot)))
+   return(0);
+
+for (i = 0; i < 2; i++)
+   if ((memcmp(slot[i].magic, AUTOIMAGE_MAGIC, sizeof(slot[i].magic)) == 0) && (slot[i].serial > 0) &&
+       (autoimage_sum((char *)&slot[i], offsetof(AUTOIMAGE_HEADER, check)) == slot[i].check) &&
+       ((best < 0) || (slot[i].serial > slot[best].serial)))
+      best = i;
+
+if (best < 0)
+   return(0);
+
+*header = slot[best];
+return(header->serial);
+
+} /* end of autoimage_best */
+
+
+/************************************************************************
+
+NAME:      autoimage_copy  - Copy a run of text while recovering
+
+RETURNED VALUE:
+   ok   -   int
+            True if all of it was there and copied.
+
+*************************************************************************/
+
+static int   autoimage_copy(int               fd,
+                            long              offset,
+                            long              bytes,
+                            FILE             *stream)
+{
+char              buff[65536];
+int               rc;
+
+if ((fd < 0) || (offset < 0) || (bytes < 0) || (lseek(fd, offset, SEEK_SET) < 0))
+   return(False);
+
+while (bytes > 0)
+{
+   rc = read(fd, buff, ((bytes > (long)sizeof(buff)) ? (long)sizeof(buff) : bytes));
+   if (rc < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         return(False);
+      }
+   if ((rc == 0) || (fwrite(buff, 1, rc, stream) != (size_t)rc))
+      return(False);
+   bytes -= rc;
+}
+
+return(True);
+
+} /* end of autoimage_copy */
+
+
+/************************************************************************
+
+NAME:      autoimage_write  - Write at an offset
+
+RETURNED VALUE:
+   ok   -   int
+            True if it was all written.
+
+*************************************************************************/
+
+static int   autoimage_write(int               fd,
+                             long              offset,
+                             char             *data,
+                             long              len)
+{
+int               rc;
+
+if (lseek(fd, offset, SEEK_SET) < 0)
+   return(False);
+
+while (len > 0)
+{
+   rc = write(fd, data, len);
+   if (rc < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         return(False);
+      }
+   data += rc;
+   len  -= rc;
+}
+
+return(True);
+
+} /* end of autoimage_write */
+
+
+/************************************************************************
+
+NAME:      autoimage_fail  - Stop writing images after an I/O error
+
+PURPOSE:    The journal is based on the last image committed, so that
+            image stays on disk for -recover and is only removed by
+            autoimage_stop.  A new file the failed image was going to is
+            thrown away.  The header slot a failed commit was writing is
+            the older one, the header of the last image is still good.
+
+*************************************************************************/
+
+static void  autoimage_fail(char            *what)
+{
+char              msg[MAXPATHLEN+128];
+
+snprintf(msg, sizeof(msg), "Autosave image %s failed on %s (%s), no more images written", what, aname, strerror(errno));
+
+if ((tfd >= 0) && (tfd != afd))
+   {
+      close(tfd);
+      unlink(nname);
+   }
+tfd     = -1;
+afailed = True;
+await   = False;
+
+dm_error(msg, DM_ERROR_BEEP);
+
+} /* end of autoimage_fail */
+
+
+/************************************************************************
+
+NAME:      autoimage_sum  - Check sum of a header or map
+
+*************************************************************************/
+
+static unsigned int autoimage_sum(char            *data,
+                                  long             len)
+{
+unsigned int      sum = (unsigned int)len;
+long              i;
+
+for (i = 0; i < len; i++)
+   sum = (sum * 31) + (unsigned char)data[i];
+
+return(sum);
+
+} /* end of autoimage_sum */
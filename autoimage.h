@@ -0,0 +1,81 @@
+#ifndef _AUTOIMAGE_INCLUDED
+#define _AUTOIMAGE_INCLUDED
+
+/* "%Z% %M% %I% - %G% %U% " */
+
+/***************************************************************
+*
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in autoimage.c
+*     autoimage_interval      - Set the seconds between autosave images
+*     autoimage_open          - Start autosave images of the edit file
+*     autoimage_timeout       - Microseconds till the next autosave work
+*     autoimage_reset         - Start over after the file is written or reloaded
+*     autoimage_pause         - Hold off images while a background pw runs
+*     autoimage_resume        - Carry on after a background pw
+*     autoimage_recover       - Load the last autosave image for -recover
+*     autoimage_close         - Remove the image on a clean exit
+*
+*  With -autoimage <seconds> (resource .autoimage), the main pad is
+*  saved to <file>.CEA next to the edit file once it has been
+*  changed for that many seconds.  Only the blocks changed since
+*  they were last saved are written, along with a map of where
+*  every block is, in the image or in the edit file itself.  The
+*  writing is done a piece at a time while waiting for input.
+*  ce -recover loads the last image, and the journal on top of it.
+*
+***************************************************************/
+
+#include "memdata.h"
+
+#define AUTOIMAGE_SUFFIX  ".CEA"
+
+void  autoimage_interval(int              seconds);          /* input  */
+
+void  autoimage_open(DATA_TOKEN      *token,             /* input / output */
+                     char            *edit_file,         /* input  */
+                     long             image);            /* input  */
+
+int   autoimage_timeout(void);
+
+void  autoimage_reset(DATA_TOKEN      *token,             /* input / output */
+                      char            *edit_file);        /* input  */
+
+void  autoimage_pause(DATA_TOKEN      *token);            /* input / output */
+
+void  autoimage_resume(DATA_TOKEN      *token,             /* input / output */
+                       char            *edit_file,         /* input  */
+                       int              saved);            /* input  */
+
+long  autoimage_recover(DATA_TOKEN     **token,             /* input / output */
+                        char            *edit_file);        /* input  */
+
+void  autoimage_close(void);
+
+
+#endif
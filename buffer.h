@@ -300,6 +300,8 @@ typedef struct {
    char                 *work_buff_ptr;          /* Permanent maxlen buffer to modify   */
    int                   buff_modified;          /* shows buff was modified             */
    void                 *cdgc_data;              /* Color data work area                */
+   void                 *render_cache;           /* Saved drawing data for lines, xutil.c */
+   void                 *damage_data;            /* What the pixmap shows, redraw.c     */
    int                   redraw_mask;            /* One of the REDRAW_* below           */
    struct DISPLAY_DESCR *display_data;           /* pointer to overall display structure*/
    int                  *insert_mode;            /* points toTrue for insert false for overwrite */
@@ -462,7 +464,8 @@ typedef struct {
 typedef struct {
    void              *private;                /* private static data in dmfind        */
    void              *search_private;         /* private static data in search.c      */
-   int                in_progress[2];         /* flags used withing getevent.c to flag find and substitute in progress, invisible outside */ 
+   void              *ifind_private;          /* private static data in ifind.c       */
+   int                in_progress[3];         /* flags used withing getevent.c to flag find, substitute, and incremental find in progress, invisible outside */ 
 } FIND_DATA;
 
 
@@ -680,6 +683,9 @@ struct DISPLAY_DESCR {
    void                 *xsmp_private_data; /* Single data area used by xsmp.c */
    int                   xsmp_active;       /* flag, True means xsmp is active */
    void                 *ind_data;          /* data allocated and used by ind.c                       */
+   void                 *shm_data;          /* Shared memory drawing data used by shmdraw.c           */
+   void                 *xr_data;           /* XRender text drawing data used by xrtext.c             */
+   void                 *hlmatch_data;      /* Match highlighting line cache used by hlmatch.c        */
    char                 *current_font_name; /* current font name, no wild cards                       */
    char                 *wm_title;          /* Title set by the title commmand                        */
    SCROLLBAR_DESCR      *sb_data;           /* Public data from sbwin.c                               */
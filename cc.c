@@ -57,6 +57,7 @@
 *     cc_get_update          -   process an update sent via property change from another window
 *     cc_plbn                -   send a line as a result of a PutLine_By_Number
 *     cc_ca                  -   Tranmit color impacts to other displays
+*     cc_lines_changed       -   Tell the other windows a range of lines was replaced
 *     cc_dlbn                -   Tell the other windows to delete a line  (Delete Line By Number)
 *     cc_joinln              -   Flush cc windows prior to a join
 *     cc_titlebar            -   Tell the other windows about a titlebar change
@@ -184,6 +185,7 @@ typedef  unsigned short ushort;
 #include "redraw.h"
 #include "sendevnt.h"
 #include "serverdef.h"
+#include "tindex.h"
 #include "txcursor.h"
 #include "typing.h"   /* needed for flush */
 #include "undo.h"
@@ -1900,6 +1902,72 @@ for (walk_dspl = dspl_descr->next; walk_dspl != dspl_descr; walk_dspl = walk_dsp
 } /* end of cc_ca */
 
 
+/************************************************************************
+
+NAME:      cc_lines_changed  -   Tell the other windows a range of lines was replaced
+
+PURPOSE:    This routine is called when many lines are replaced in one step
+            by swap_lines.  Instead of the per line work done by cc_plbn,
+            each other window which shows part of the range gets one full
+            redraw.
+
+PARAMETERS:
+
+   1.  token       - pointer to DATA_TOKEN (INPUT)
+                     This is the memdata the lines were replaced in.
+
+   2.  top_line    - int (INPUT)
+                     This is the first line replaced.
+
+   3.  bottom_line - int (INPUT)
+                     This is the last line replaced.
+
+FUNCTIONS :
+   1.   Verify that this request is for the main window.
+
+   2.   Unsnuff any window whose cursor line was replaced.
+
+   3.   Flag a full redraw in each window showing part of the range.
+
+
+*************************************************************************/
+
+void     cc_lines_changed(DATA_TOKEN *token,       /* opaque */
+                          int         top_line,    /* input  */
+                          int         bottom_line) /* input  */
+{
+DISPLAY_DESCR        *walk_dspl;
+int                   last_line;
+
+/***************************************************************
+*  Make sure this request is for the main window.
+***************************************************************/
+if (token != dspl_descr->main_pad->token)
+   return;
+
+DEBUG18(fprintf(stderr, "cc_lines_changed: lines %d to %d, display %d\n", top_line, bottom_line, dspl_descr->display_no);)
+
+for (walk_dspl = dspl_descr->next; walk_dspl != dspl_descr; walk_dspl = walk_dspl->next)
+{
+   last_line   = walk_dspl->main_pad->first_line+walk_dspl->main_pad->window->lines_on_screen;
+
+   if ((walk_dspl->main_pad->file_line_no >= top_line) &&
+       (walk_dspl->main_pad->file_line_no <= bottom_line) &&
+       (walk_dspl->cursor_buff->which_window == MAIN_PAD))
+      walk_dspl->cursor_buff->up_to_snuff = False;
+
+   if ((walk_dspl->main_pad->first_line <= bottom_line) &&
+       (last_line > top_line))
+      {
+         walk_dspl->main_pad->impacted_redraw_line = 0;
+         walk_dspl->main_pad->impacted_redraw_mask |= MAIN_PAD_MASK & FULL_REDRAW;
+         DEBUG18(fprintf(stderr, "cc_lines_changed: impacted display %d, window %d->%d\n", walk_dspl->display_no, walk_dspl->main_pad->first_line, last_line);)
+      }
+} /* end of walking list of secondary display descriptions */
+
+} /* end of cc_lines_changed */
+
+
 /************************************************************************
 
 NAME:      cc_dlbn  -   tell the other windows to delete a line  (Delete Line By Number)
@@ -4425,6 +4493,10 @@ FUNCTIONS :
 void send_api_stats(PAD_DESCR   *main_pad,
                     XEvent      *event)
 {
+int                   tindex_kbytes;
+int                   tindex_build_tenths;
+int                   tindex_hit_pct;
+int                   tindex_state;
 
 /***************************************************************
 *  
@@ -4438,6 +4510,15 @@ event->CURRENT_LINENO     = htonl(main_pad->file_line_no+1); /* we are zero base
 event->CURRENT_COLNO      = htons((short)(main_pad->file_col_no+1));  /* we are zero based */
 event->PAD_WRITABLE       = htons((short)WRITABLE(main_pad->token));
 
+tindex_stats(&tindex_kbytes, &tindex_build_tenths, &tindex_hit_pct, &tindex_state);
+if (tindex_build_tenths > 0xffff)
+   tindex_build_tenths = 0xffff;
+event->TINDEX_KBYTES_HIGH  = htons((unsigned short)(tindex_kbytes >> 16));
+event->TINDEX_KBYTES_LOW   = htons((unsigned short)(tindex_kbytes & 0xffff));
+event->TINDEX_BUILD_TENTHS = htons((unsigned short)tindex_build_tenths);
+event->TINDEX_HIT_PCT      = (char)tindex_hit_pct;
+event->TINDEX_STATE        = (char)tindex_state;
+
 XSendEvent(event->xclient.display,
            event->xclient.window,
            False,
@@ -40,6 +40,7 @@
 *     cc_get_update          -   Process an update sent via property change from another window
 *     cc_plbn                -   Send a line as a result of a PutLine_By_Number
 *     cc_ca                  -   Tranmit color impacts to other displays
+*     cc_lines_changed       -   Tell the other windows a range of lines was replaced
 *     cc_dlbn                -   Tell the other windows to delete a line  (Delete Line By Number)
 *     cc_joinln              -   Flush cc windows prior to a join
 *     cc_titlebar            -   Tell the other windows about a titlebar change
@@ -144,6 +145,10 @@ void     cc_ca(DISPLAY_DESCR   *dspl_descr,   /* input/output */
                int              top_line,     /* input        */
                int              bottom_line); /* input        */
 
+void     cc_lines_changed(DATA_TOKEN *token,       /* opaque */
+                          int         top_line,    /* input  */
+                          int         bottom_line);/* input  */
+
 void     cc_dlbn(DATA_TOKEN *token,       /* opaque */
                  int         line_no,     /* input */
                  int         count);      /* input;   (always 1) */
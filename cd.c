@@ -40,6 +40,7 @@
 *     cd_add_remove           - Update cd data in memdata to add or delete chars
 *     cdpad_add_remove        - Update pad cd data to add or delete chars
 *     cdpad_curr_cdgc         - Get the current cdgc list for drawing
+*     cdpad_cdgc_pending      - See if a line has color changes not yet flushed
 *     cd_join_line            - Update work cd data to accomadate a join
 *     pulldown_overflow_color - Preserve color when a line is going away.
 *     cd_flush                - Flush color data back to the memdata database
@@ -1035,6 +1036,46 @@ return(private->curr_cdgc);
 }  /* end of cdpad_curr_cdgc */
 
 
+/************************************************************************
+
+NAME:      cdpad_cdgc_pending  - See if a line has color changes not yet flushed
+
+PURPOSE:    This routine tells the drawing code when the color data for a
+            line is being modified in the pad work area and has not been
+            written back to memdata yet.  Memdata does not know about such
+            changes, so the line generation does not show them.
+
+PARAMETERS:
+   1.  pad             - pointer to PAD_DESCR (INPUT)
+                         This is the pad we are operating on.
+
+   2.  lineno          - int (INPUT)
+                         This is the file line no we are interested in.
+
+FUNCTIONS :
+   1.   If the line is the one being modified and it has a work cdgc
+        list, return True.
+
+RETURNED VALUE:
+   pending       -  int
+                    True  - The line has unflushed color changes
+                    False - Memdata has the current color data for the line
+
+*************************************************************************/
+
+int  cdpad_cdgc_pending(PAD_DESCR      *pad,           /* input  */
+                        int             lineno)        /* input  */
+{
+CD_PAD_PRIVATE       *private = (CD_PAD_PRIVATE *)pad->cdgc_data;
+
+if (!private)
+   return(False);
+
+return((lineno == private->cur_line_no) && private->color_read && (private->cdgc_list != NULL));
+
+}  /* end of cdpad_cdgc_pending */
+
+
 /************************************************************************
 
 NAME:      cd_join_line       - Update cd data to accommodate a join
@@ -39,6 +39,7 @@
 *     cd_add_remove           - Update cd data in memdata to add or delete chars
 *     cdpad_add_remove        - Update pad cd data to add or delete chars
 *     cdpad_curr_cdgc         - Get the current cdgc list for drawing
+*     cdpad_cdgc_pending      - See if a line has color changes not yet flushed
 *     cd_join_line            - Update work cd data to accomadate a join
 *     cd_flush                - Flush color data back to the memdata database
 *
@@ -88,6 +89,9 @@ FANCY_LINE  *cdpad_curr_cdgc(PAD_DESCR      *pad,           /* input  */
                              int             lineno,        /* input  */
                              int            *fancy_lineno); /* output */
 
+int  cdpad_cdgc_pending(PAD_DESCR      *pad,           /* input  */
+                        int             lineno);       /* input  */
+
 /* call just before the lines are joined */
 void  cd_join_line(DATA_TOKEN      *token,       /* input/output */
                    int              lineno,      /* input */
@@ -1340,6 +1340,11 @@ if (rc == 0)
       returned_stats.current_line =  ntohl(message.CURRENT_LINENO);
       returned_stats.current_col  =  ntohs(message.CURRENT_COLNO);
       returned_stats.writable     =  ntohs(message.PAD_WRITABLE);
+      returned_stats.tindex_kbytes = ((unsigned short)ntohs(message.TINDEX_KBYTES_HIGH) << 16)
+                                   | (unsigned short)ntohs(message.TINDEX_KBYTES_LOW);
+      returned_stats.tindex_build_tenths = (unsigned short)ntohs(message.TINDEX_BUILD_TENTHS);
+      returned_stats.tindex_hit_pct = (unsigned char)message.TINDEX_HIT_PCT;
+      returned_stats.tindex_state   = (unsigned char)message.TINDEX_STATE;
       return(&returned_stats);
    }
 else
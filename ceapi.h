@@ -62,6 +62,10 @@ typedef struct {
    int             current_line;           /* Current line number in the file                */
    short           current_col;            /* Current column number in the file              */
    short           writable;               /* Flag - True means file is currently read/write */
+   int             tindex_kbytes;          /* memory used by the trigram index (-tindex)     */
+   int             tindex_build_tenths;    /* tenths of a second spent building the index    */
+   short           tindex_hit_pct;         /* percent of indexed blocks finds passed over    */
+   short           tindex_state;           /* 0 no index, 1 building, 2 built                */
 
 } CeStats;
 
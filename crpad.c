@@ -148,7 +148,7 @@
 *      DEBUG28      -  Indent processing ind.c
 *      DEBUG29      -  Pulldown creation and processing in pd.c
 *      DEBUG30      -  dde testing bit for ceterm, turns off the usleeps to avoid SIGALARM signals
-*      DEBUG31   
+*      DEBUG31      -  Flash the rows painted by each redraw of the main window, redraw.c
 *      DEBUG32      -  dynamic debugging (for debugging on the fly)
 *
 * MISC NOTES:
@@ -283,9 +283,13 @@
 #endif
 #include "hexdump.h"
 #include "init.h"
+#include "journal.h"
+#include "autoimage.h"
 #include "kd.h"
 #include "keypress.h"
 #include "lineno.h"
+#include "loadcache.h"
+#include "lock.h"
 #include "mark.h"
 #include "memdata.h"
 #include "mvcursor.h"
@@ -407,6 +411,7 @@ int                   cursor_row;       /* work variable used when processing cu
 int                   cursor_col;       /*   "                   "                      "               "          */
 int                   window_echo;      /* Boolean work variable used when processing cursor motion events - shows the current window has text highlighting */
 int                   open_for_write;   /* Boolean work variable used to hold data about opening file and main window for r/w before memdata token is set up */
+long                  image;            /* Serial number of the autosave image -recover loaded, 0 for none */
 
 static int            conf_event   = ConfigureNotify; /* constant used to eat extra configure notify events */
 static int            motion_event = MotionNotify;    /* constant used to eat extra motion events */
@@ -1085,6 +1090,52 @@ if (getuid() && !geteuid())
     }
 #endif /* WIN32 */
 
+/***************************************************************
+*  
+*  With -loadcache, the line lengths of a big file are kept in
+*  the paste buffer directory, so opening it again reads the
+*  lines without looking for each newline.  This is done after
+*  we stop being root so the cache belongs to the user.
+*  
+***************************************************************/
+
+if (LOADCACHE && !dspl_descr->pad_mode && !LSF && !MANFORMAT &&
+    (instream != NULL) && (strcmp(edit_file, STDIN_FILE_STRING) != 0))
+   loadcache_open(dspl_descr->main_pad->token, edit_file, instream, LOADCACHE); /* in loadcache.c */
+
+/***************************************************************
+*  
+*  With -journal, changes to the file are journaled so a crash
+*  loses nothing.  With -autoimage, changed blocks are saved to an
+*  image from time to time.  -recover loads the last image and
+*  replays the journal left by a session which did not end, this
+*  needs the whole file in memory first.  This is done after we
+*  stop being root so the journal and image belong to the user.
+*  
+***************************************************************/
+
+if ((JOURNAL || RECOVER || AUTOIMAGE) && !dspl_descr->pad_mode &&
+    WRITABLE(dspl_descr->main_pad->token) && (strcmp(edit_file, STDIN_FILE_STRING) != 0))
+   {
+      image = 0;
+      if (RECOVER)
+         {
+            load_enough_data(INT_MAX); /* in getevent.c */
+            image = autoimage_recover(&dspl_descr->main_pad->token, edit_file); /* in autoimage.c */
+            /* reading the file to put the image together released the lock, get it back as load_enough_data does */
+            if (LOCKF && WRITABLE(dspl_descr->main_pad->token))
+               {
+                  unlock_file(); /* in lock.c */
+                  if (lock_file(edit_file) == False)
+                     WRITABLE(dspl_descr->main_pad->token) = False;
+               }
+         }
+      if (JOURNAL || RECOVER)
+         journal_open(dspl_descr->main_pad->token, edit_file, RECOVER, image); /* in journal.c */
+      autoimage_open(dspl_descr->main_pad->token, edit_file, image); /* in autoimage.c */
+      dspl_descr->main_pad->buff_ptr = get_line_by_num(dspl_descr->main_pad->token, dspl_descr->main_pad->file_line_no);
+   }
+
 /***************************************************************
 *  
 *  Save the top of the event loop for later use.
@@ -1505,6 +1556,7 @@ while(1)
                   {
                      dspl_descr->currently_mapped = True;
                      redraw_needed = realloc_pixmap(dspl_descr->main_pad->window, dspl_descr->display, &dspl_descr->x_pixmap, dspl_descr->main_pad->x_window);
+                     damage_whole_window(dspl_descr->main_pad);
                      process_redraw(dspl_descr, redraw_needed, False /* no warp */);
                   }
                if (dspl_descr->Hummingbird_flag) /* RES 7/9/2003 add Hummingbird flag */
@@ -1572,10 +1624,14 @@ while(1)
 #endif
   
       if (event_union.xany.window == dspl_descr->main_pad->x_window)
-         window_resized = resize_pixmap(&event_union,                        /* input */
-                                        &dspl_descr->x_pixmap,               /* input / output */
-                                        dspl_descr->main_pad->window,        /* input / output */
-                                        ForgetGravity);                      /* input leave screen blank. */
+         {
+            window_resized = resize_pixmap(&event_union,                        /* input */
+                                           &dspl_descr->x_pixmap,               /* input / output */
+                                           dspl_descr->main_pad->window,        /* input / output */
+                                           ForgetGravity);                      /* input leave screen blank. */
+            if (window_resized)
+               damage_whole_window(dspl_descr->main_pad);
+         }
       else
          {
             DEBUG(
@@ -1589,10 +1645,21 @@ while(1)
             )
          }
 
-      get_root_location(dspl_descr->display,
-                        dspl_descr->main_pad->x_window,
-                        &dspl_descr->main_pad->window->x,
-                        &dspl_descr->main_pad->window->y);
+      /***************************************************************
+      *  A synthetic configure from the window manager already has
+      *  the root relative position (ICCCM 4.1.5).  Only real ones
+      *  need the geometry and tree queries in get_root_location.
+      ***************************************************************/
+      if (event_union.xconfigure.send_event && (event_union.xany.window == dspl_descr->main_pad->x_window))
+         {
+            dspl_descr->main_pad->window->x = event_union.xconfigure.x;
+            dspl_descr->main_pad->window->y = event_union.xconfigure.y;
+         }
+      else
+         get_root_location(dspl_descr->display,
+                           dspl_descr->main_pad->x_window,
+                           &dspl_descr->main_pad->window->x,
+                           &dspl_descr->main_pad->window->y);
 
       clear_text_cursor(None, dspl_descr);
 
@@ -1771,6 +1838,7 @@ while(1)
                   if (dspl_descr->x_pixmap == None)
                      {
                         redraw_needed = realloc_pixmap(dspl_descr->main_pad->window, dspl_descr->display, &dspl_descr->x_pixmap, dspl_descr->main_pad->x_window);
+                        damage_whole_window(dspl_descr->main_pad);
                         process_redraw(dspl_descr, redraw_needed, False /* no warp */);
                      }
                }
@@ -1923,21 +1991,9 @@ while(1)
 
       /***************************************************************
       *  02/17/2005  - RES, add check for file change on focus in.
+      *  The edit file is now watched from the event loop and the
+      *  reload prompt comes up when it changes, see reload_watch.
       ***************************************************************/
-      if ((dspl_descr->pad_mode == False) && (dspl_descr->reload_off == False) && (file_has_changed(edit_file)))
-         {
-            DMC             *prompt;
-            strcpy(msg, "reload -&'File externally changed, reload? ' ");
-            prompt = prompt_prescan(msg, True, dspl_descr->escape_char);  /* in kd.c */
-            if (prompt != NULL)
-               {
-                  ce_XBell(dspl_descr, 0);
-
-                  redraw_needed = dm_prompt(prompt, dspl_descr);
-                  if (redraw_needed)
-                     process_redraw(dspl_descr, redraw_needed, False);
-               }
-         }
       break;
 
    /***************************************************************
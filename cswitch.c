@@ -59,6 +59,8 @@
 #include "emalloc.h"   /* needed for malloc copy, causes a lint error */
 #include "execute.h"
 #include "getevent.h"
+#include "hlmatch.h"
+#include "ifind.h"
 #include "init.h"
 #include "ind.h"
 #include "kd.h"
@@ -238,6 +240,7 @@ case DM_sq:
    clear_prompt_stack(dspl_descr); /* RES 8/3/95 Clear any outstanding prompts (enhancement) */
    set_dm_prompt(dspl_descr, NULL);
    redraw_needed = DMINPUT_MASK & FULL_REDRAW;
+   redraw_needed |= ifind_cancel(dspl_descr);
 
    if (dspl_descr->echo_mode)
       {
@@ -347,6 +350,16 @@ case DM_bell:
       ce_XBell(dspl_descr, i);
    break;
 
+/***************************************************************
+*
+*  bgstat - show the background task statistics, a debug aid
+*  In getevent.c
+*
+***************************************************************/
+case DM_bgstat:
+   dm_bgstat();
+   break;
+
 /***************************************************************
 *
 *  bl - Balance 
@@ -368,6 +381,7 @@ case DM_bl:
 case DM_bgc:
 case DM_fgc:
    dm_bgc(dm_list, dspl_descr);
+   damage_whole_window(dspl_descr->main_pad); /* in redraw.c, the colors changed not the rows */
    redraw_needed = ((MAIN_PAD_MASK | DMINPUT_MASK | DMOUTPUT_MASK | TITLEBAR_MASK | UNIXCMD_MASK) & FULL_REDRAW);
    break;
 
@@ -852,6 +866,25 @@ case DM_fbdr:
       }
    break;
 
+/***************************************************************
+*
+*  fcnt - count the matches of patterns in the main pad
+*  In dmfind.c
+*
+***************************************************************/
+case DM_fcnt:
+   if (get_background_work(BACKGROUND_FIND_OR_SUB))
+      {
+         dm_error_dspl("Operation illegal during search or substitute", DM_ERROR_BEEP, dspl_descr);
+         break;
+      }
+   dm_fcnt(dm_list,
+           dspl_descr->find_data,
+           dspl_descr->main_pad,
+           dspl_descr->case_sensitive,
+           dspl_descr->escape_char);
+   break;
+
 /***************************************************************
 *
 *  find and rfind - do a find forward or reverse
@@ -871,6 +904,8 @@ case DM_rfind:
                              dspl_descr->case_sensitive,
                              stop_dm_list,
                              dspl_descr->escape_char);
+   if (hlmatch_stale(dspl_descr))
+      redraw_needed |= (MAIN_PAD_MASK & PARTIAL_REDRAW);  /* new pattern to highlight */
    if(!get_background_work(BACKGROUND_FIND))
       *warp_needed = True;
    /* continue if next command is a colon (null command) RES 10/13/95 */
@@ -947,6 +982,21 @@ case DM_icon:
    dm_icon(dm_list, dspl_descr->display, dspl_descr->main_pad->x_window);
    break;
 
+/***************************************************************
+*
+*  ifind - incremental find, search as the pattern is typed
+*  In ifind.c
+*
+***************************************************************/
+case DM_ifind:
+   if (get_background_work(BACKGROUND_FIND_OR_SUB))
+      {
+         dm_error_dspl("Operation illegal during search or substitute", DM_ERROR_BEEP, dspl_descr);
+         break;
+      }
+   redraw_needed |= dm_ifind(dm_list, dspl_descr, new_dmc);
+   break;
+
 /***************************************************************
 *
 *  ind - language sensitive indent functionality
@@ -967,6 +1017,7 @@ case DM_ind:
 ***************************************************************/
 case DM_inv:
    dm_inv(dspl_descr);
+   damage_whole_window(dspl_descr->main_pad); /* in redraw.c, the colors changed not the rows */
    redraw_needed = ((MAIN_PAD_MASK | DMINPUT_MASK | DMOUTPUT_MASK | TITLEBAR_MASK | UNIXCMD_MASK) & FULL_REDRAW);
    *warp_needed = True;
    break;
@@ -1324,13 +1375,13 @@ case DM_pw:
                dm_error_dspl("Pad has not been named, use 'pn' first", DM_ERROR_BEEP, dspl_descr);
                break;
             }
-         (void) dm_pw(dspl_descr, edit_file, False);
+         (void) dm_pw_bg(dspl_descr, edit_file);
          redraw_needed |= (TITLEBAR_MASK & FULL_REDRAW);
       }
 #else
    if (WRITABLE(dspl_descr->main_pad->token))
       {
-         (void) dm_pw(dspl_descr, edit_file, False);
+         (void) dm_pw_bg(dspl_descr, edit_file);
          redraw_needed |= (TITLEBAR_MASK & FULL_REDRAW);
       }
 #endif
@@ -1376,6 +1427,7 @@ case DM_rl:
 *
 ***************************************************************/
 case DM_rd:
+   damage_whole_window(dspl_descr->main_pad); /* in redraw.c, repaint every row */
    process_redraw(dspl_descr, FULL_REDRAW, False);
    break;
 
@@ -1436,6 +1488,7 @@ case DM_rs:
 *
 ***************************************************************/
 case DM_rw:
+   damage_whole_window(dspl_descr->main_pad); /* in redraw.c, repaint every row */
    redraw_needed = ((MAIN_PAD_MASK | DMINPUT_MASK | DMOUTPUT_MASK | TITLEBAR_MASK | UNIXCMD_MASK) & FULL_REDRAW);
    *warp_needed = True;
    break;
@@ -1460,6 +1513,8 @@ case DM_so:
                           stop_dm_list,
                           (dspl_descr->echo_mode == RECTANGULAR_HIGHLIGHT),
                           dspl_descr->escape_char);
+   if (hlmatch_stale(dspl_descr))
+      redraw_needed |= (MAIN_PAD_MASK & PARTIAL_REDRAW);  /* new pattern to highlight */
    stop_text_highlight(dspl_descr);
    dspl_descr->echo_mode = NO_HIGHLIGHT;
    dspl_descr->mark1.mark_set = False;
@@ -61,10 +61,15 @@
 #include "display.h"
 #include "emalloc.h"
 #include "ind.h"
+#include "hlmatch.h"  /* needed for free_hlmatch_data */
 #include "hsearch.h"
 #include "memdata.h"
 #include "parms.h"
+#include "redraw.h"   /* needed for free_damage_data */
+#include "shmdraw.h"  /* needed for free_shm_data */
+#include "xrtext.h"   /* needed for free_xr_data */
 #include "unixwin.h"  /* needed for MAX_UNIX_LINES */
+#include "xutil.h"    /* needed for free_render_cache */
 #include "xsmp.h"
 
 void   exit(int code);
@@ -536,6 +541,10 @@ if (pad->token && kill_token)
    mem_kill(pad->token);
 if (pad->cdgc_data)
    free((char *)pad->cdgc_data);
+if (pad->render_cache)
+   free_render_cache(pad);
+if (pad->damage_data)
+   free_damage_data(pad);
 free((char *)pad);
 } /* end of free_pad */
 
@@ -608,6 +617,12 @@ if (dspl->properties)
    free((char *)dspl->properties);
 if (dspl->cursor_data)
    free((char *)dspl->cursor_data);
+if (dspl->shm_data)
+   free_shm_data(dspl);
+if (dspl->xr_data)
+   free_xr_data(dspl);
+if (dspl->hlmatch_data)
+   free_hlmatch_data(dspl);
 
 if (dspl->sb_data)
    {
@@ -649,6 +664,8 @@ if (dspl->find_data)
          free((char *)dspl->find_data->private);
       if (dspl->find_data->search_private)
          free((char *)dspl->find_data->search_private);
+      if (dspl->find_data->ifind_private)
+         free((char *)dspl->find_data->ifind_private);
       free((char *)dspl->find_data);
    }
 
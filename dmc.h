@@ -196,6 +196,7 @@ typedef struct {
 typedef DMC_ce DMC_cv;
 typedef DMC_ce DMC_cc;
 typedef DMC_ce DMC_cp;
+typedef DMC_ce DMC_fcnt;   /* fcnt pattern ... */
 
 typedef struct {
         struct DMC *next;        /* next cmd if chained */
@@ -239,6 +240,7 @@ typedef struct {
         short int   temp;        /* true if delete after use (cmd line cmds)  */
         int         dash_r;      /* nonzero if specified */
   } DMC_echo;
+typedef DMC_echo DMC_ifind;   /* ifind [-r] */
 
 typedef struct {
         struct DMC *next;        /* next cmd if chained */
@@ -564,6 +566,7 @@ typedef union _DMC {
    DMC_es     es;
    DMC_eval   eval;
    DMC_fbdr   fbdr;
+   DMC_fcnt   fcnt;
    DMC_find   find;
    DMC_fgc    fgc;
    DMC_fl     fl;
@@ -572,6 +575,7 @@ typedef union _DMC {
    DMC_gm     gm;
    DMC_hex    hex;
    DMC_icon   icon;
+   DMC_ifind  ifind;
    DMC_ind    ind;
    DMC_inv    inv;
    DMC_kd     kd;
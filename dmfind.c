@@ -35,6 +35,7 @@
 *     dm_continue_find   -  Continue a find started by dm_start_find. (via dm_find).
 *     dm_continue_sub    -  Continue a find started by dm_start_find. (via dm_s)
 *     dm_re              -  Convert a regular expression from aegis to unix and display
+*     dm_fcnt            -  Count the matches of one or more patterns in the file
 *     find_border_adjust - Adjust first line to set border around the find.
 *
 *
@@ -49,6 +50,12 @@
 *
 *     max_line_len       -   Calculate the maximum length of a group of lines
 *
+*     parallel_find      -   Finish a continued find with the pfind worker threads
+*
+*     count_matches      -   Count the matches of one pattern
+*
+*     bulk_sub           -   Substitute over a large range of whole lines in one step
+*
 ***************************************************************/
 
 #include <stdio.h>          /* /usr/include/stdio.h      */
@@ -73,6 +80,7 @@
 #include "mvcursor.h"
 #include "parms.h"
 #include "parsedm.h"
+#include "pfind.h"
 #include "search.h"
 #include "typing.h"   /* needed for flush */
 
@@ -89,6 +97,15 @@
 
 #define DM_FIND_SEARCH_LINES 512
 
+/***************************************************************
+*  
+*  Substitutes over at least this many whole lines are done by
+*  bulk_sub in one step instead of a line at a time in search().
+*  
+***************************************************************/
+
+#define DM_BULK_SUB_LINES 4096
+
 /***************************************************************
 *  
 *  Static data hung off the display description.
@@ -129,6 +146,15 @@ typedef struct {
 /*   char        substitute[MAX_LINE+1];  RES  9/5/95 Seems to be not used */
 } FIND_PRIVATE;
 
+/***************************************************************
+*  
+*  circf is in search.c, it is set when the expression last
+*  compiled starts with ^.  count_matches puts it back.
+*  
+***************************************************************/
+
+extern int circf;
+
 /***************************************************************
 *  
 *  Prototypes for local routines
@@ -170,6 +196,32 @@ static int max_line_len(DATA_TOKEN   *token,
 
 static   void ins(char *string, char *line, char *ptr);
 
+static int  parallel_find(FIND_PRIVATE *private,          /* input / output */
+                          int          *found_line,       /* output */
+                          int          *found_col,        /* output */
+                          char          escape_char,      /* input  */
+                          void        **search_private_ptr);/* input / output  */
+
+static int  count_matches(PAD_DESCR    *pad,              /* input  */
+                          char         *pattern,          /* input  */
+                          int           case_sensitive,   /* input  */
+                          char          escape_char,      /* input  */
+                          int          *lines_matched);   /* output */
+
+static int  bulk_sub(PAD_DESCR    *pad,              /* input  */
+                     FIND_PRIVATE *private,          /* input / output */
+                     int           from_line,        /* input  */
+                     int           from_col,         /* input  */
+                     int           to_line,          /* input  */
+                     int           to_col,           /* input  */
+                     char         *pattern,          /* input  */
+                     char         *substitute,       /* input  */
+                     int           sub_once,         /* input  */
+                     int          *found_line,       /* output */
+                     int          *found_col,        /* output */
+                     char          escape_char,      /* input  */
+                     void        **search_private_ptr);/* input / output  */
+
 
 
 
@@ -551,6 +603,7 @@ else
 *  If this is part of a complex set of cmds, make sure the substitute
 *  finishes before we continue.  Othewise get the find started.
 *  and let it run in background.
+*  A large range of whole lines is done in one step by bulk_sub.
 ***************************************************************/
 
 DEBUG2(fprintf(stderr, "(%s) in %s from : [%d,%d]  to : [%d,%d]\n",
@@ -560,21 +613,34 @@ DEBUG2(fprintf(stderr, "(%s) in %s from : [%d,%d]  to : [%d,%d]\n",
 
 private->substitute_changes_count = 0;
 
-dm_start_sub(buffer,
-             private,
-             top_line,
-             top_col,
-             bottom_line,
-             bottom_col,
-             private->last_find_pattern,  /* changed 12/2/94 fixes case when find was case insensitive on a mixed case, followed by s//something/ */
-             lcl_substitute,
-             (dm_list->next != NULL),  /* do it all parm */
-             (dm_list->find.cmd == DM_so),
-             &found_line,
-             &found_col,
-             rectangular,
-             escape_char,
-             &find_data->search_private);
+if (rectangular || !bulk_sub(buffer,
+                             private,
+                             top_line,
+                             top_col,
+                             bottom_line,
+                             bottom_col,
+                             private->last_find_pattern,
+                             lcl_substitute,
+                             (dm_list->find.cmd == DM_so),
+                             &found_line,
+                             &found_col,
+                             escape_char,
+                             &find_data->search_private))
+   dm_start_sub(buffer,
+                private,
+                top_line,
+                top_col,
+                bottom_line,
+                bottom_col,
+                private->last_find_pattern,  /* changed 12/2/94 fixes case when find was case insensitive on a mixed case, followed by s//something/ */
+                lcl_substitute,
+                (dm_list->next != NULL),  /* do it all parm */
+                (dm_list->find.cmd == DM_so),
+                &found_line,
+                &found_col,
+                rectangular,
+                escape_char,
+                &find_data->search_private);
 
 /***************************************************************
 *  Find failed, flag the error and put the cursor back.
@@ -1046,6 +1112,15 @@ DEBUG2(fprintf(stderr, "@dm_continue_find[%d,%d] to [%d,%d] %s)\n",
 *found_pad       = private->pad;
 
 
+if (parallel_find(private, found_line, found_col, escape_char, &find_data->search_private))
+   {
+      DEBUG2(fprintf(stderr, "dm_continue_find: parallel find -> [%d,%d]\n", *found_line, *found_col);)
+      lcl_from_line = private->from_line;
+      lcl_from_col  = private->from_col;
+      lcl_to_line   = private->to_line;
+      lcl_to_col    = private->to_col;
+   }
+else
 if (!private->reverse)
    {
 
@@ -1173,6 +1248,140 @@ else
 } /* end of dm_continue_find */
 
 
+/************************************************************************
+
+NAME:      parallel_find  -  Finish a continued find with the pfind worker threads
+
+PURPOSE:    Once the whole file is in memory, the rest of a continued find
+            is handed to pfind_first, which tests the remaining lines
+            on all processors and returns the first line in search order
+            which may match.  search() is then run on just that line to
+            get the column.  If search() rejects it, the scan picks up
+            after that line.
+
+PARAMETERS:
+
+   1.  private          - pointer to FIND_PRIVATE (INPUT / OUTPUT)
+                          The continued find.  The from_line or to_line is
+                          moved past the lines searched.
+
+   2.  found_line       - pointer to int (OUTPUT)
+                          The line found or DM_FIND_NOT_FOUND.
+
+   3.  found_col        - pointer to int (OUTPUT)
+                          The column found.
+
+   4.  escape_char      - char (INPUT)
+                          The escape character passed to search.
+
+   5.  search_private_ptr - pointer to pointer to void (INPUT / OUTPUT)
+                          The static pattern data for search.
+
+FUNCTIONS :
+
+   1.   Returns False if the parallel scan was not used, the caller
+        goes on searching DM_FIND_SEARCH_LINES at a time.
+
+*************************************************************************/
+
+static int  parallel_find(FIND_PRIVATE *private,          /* input / output */
+                          int          *found_line,       /* output */
+                          int          *found_col,        /* output */
+                          char          escape_char,      /* input  */
+                          void        **search_private_ptr)/* input / output  */
+{
+int                      candidate;
+int                      lcl_to_col;
+int                      dummy_parm;
+
+if (!private->reverse)
+   {
+      if (!load_enough_data(private->from_line))
+         return(False);  /* still reading the file in */
+      private->to_line = total_lines(private->pad->token);
+   }
+
+*found_line = DM_FIND_NOT_FOUND;
+
+while(*found_line == DM_FIND_NOT_FOUND)
+{
+   if (!private->reverse)
+      {
+         if (!pfind_first(private->pad->token, *search_private_ptr, !private->case_sensitive,
+                          private->from_line, private->to_line - 1, False, &candidate))
+            return(False);
+         if (candidate == DM_FIND_NOT_FOUND)
+            {
+               private->from_line = private->to_line + 1;
+               break;
+            }
+
+         lcl_to_col = MAX_LINE+1;
+         search(private->pad->token,
+                candidate,
+                -1,
+                candidate,
+                &lcl_to_col, /* pass by reference */
+                False,
+                NULL,   /* use old find string  */
+                NULL,   /* no substitute string */
+                !private->case_sensitive,
+                found_line,
+                found_col,
+                &dummy_parm,
+                0 /* not rectangular */,
+                0 /* not rectangular */,
+                0 /* not rectangular */,
+                NULL /* not in substitute mode */,
+                0 /* not substitute once */,
+                escape_char,
+                search_private_ptr);
+         private->from_line = candidate + 1;
+      }
+   else
+      {
+         if (!pfind_first(private->pad->token, *search_private_ptr, !private->case_sensitive,
+                          private->from_line, private->to_line, True, &candidate))
+            return(False);
+         if (candidate == DM_FIND_NOT_FOUND)
+            {
+               private->to_line = private->from_line - 1;
+               break;
+            }
+
+         /* a reverse search to [candidate+1,0] starts at the end of line candidate */
+         lcl_to_col = 0;
+         search(private->pad->token,
+                candidate,
+                0,
+                candidate + 1,
+                &lcl_to_col, /* pass by reference */
+                True,
+                NULL,   /* use old find string  */
+                NULL,   /* no substitute string */
+                !private->case_sensitive,
+                found_line,
+                found_col,
+                &dummy_parm,
+                0 /* not rectangular */,
+                0 /* not rectangular */,
+                0 /* not rectangular */,
+                NULL /* not in substitute mode */,
+                0 /* not substitute once */,
+                escape_char,
+                search_private_ptr);
+         private->to_line = candidate - 1;
+      }
+
+   if (*found_line == DM_FIND_NOT_FOUND)
+      DEBUG2(fprintf(stderr, "parallel_find: line %d rejected by search\n", candidate);)
+}
+
+return(True);
+
+} /* end of parallel_find */
+
+
 
 
 /************************************************************************
@@ -1645,6 +1854,264 @@ DEBUG2(fprintf(stderr, "end continue_sub[%d,%d] - lcl end [%d,%d]\n", *found_lin
 } /* end of dm_continue_sub */
 
 
+/************************************************************************
+
+NAME:      bulk_sub  -  Substitute over a large range of whole lines in one step
+
+PURPOSE:    A substitute through search() rewrites each changed line with
+            put_line_by_num, which logs an undo event and tells the cc
+            windows once per line.  Over a whole file this is most of the
+            time spent.  When the range is whole lines and the substitute
+            cannot add or remove lines, this routine does it in one step.
+            The pfind workers flag the lines which may match, the changed
+            lines are built off to the side, and swap_lines puts them all
+            in memdata at once with a single undo event and cc redraw.
+
+PARAMETERS:
+
+   1.  pad              - pointer to PAD_DESCR (INPUT)
+                          This is the pad description for the pad where the sub is being done.
+
+   2.  private          - pointer to FIND_PRIVATE (INPUT / OUTPUT)
+                          This is the address of the static data used by find and substitute.
+
+   3.  from_line        - int (INPUT)
+                          This is the line the substitute starts at.
+
+   4.  from_col         - int (INPUT)
+                          This is the column the substitute starts at.
+
+   5.  to_line          - int (INPUT)
+                          This is the line the substitute ends at.
+
+   6.  to_col           - int (INPUT)
+                          This is the column the substitute ends at.
+
+   7.  pattern          - pointer to char (INPUT)
+                          This is the pattern to find.
+
+   8.  substitute       - pointer to char (INPUT)
+                          This is the substitute pattern.
+
+   9.  sub_once         - int (INPUT)
+                          True for so, one substitute per line.
+
+  10. found_line        - pointer to int (OUTPUT)
+                          This is the last line changed, DM_FIND_NOT_FOUND,
+                          or DM_FIND_ERROR.
+
+  11. found_col         - pointer to int (OUTPUT)
+                          This is the column just past the last change.
+
+FUNCTIONS :
+
+   1.   Make sure the range is whole lines and large enough to be worth it.
+
+   2.   Compile the pattern with a call to search which cannot match
+        and make sure the substitute keeps each line a line.
+
+   3.   Get the lines which may match from the pfind workers.
+
+   4.   Run subs_line on each of them and save each changed line.
+        If memory runs out, nothing is changed and found_line is
+        DM_FIND_ERROR.
+
+   5.   Put the changed lines in memdata with swap_lines.
+
+RETURNED VALUE:
+   done   -  int
+             True  -  The substitute was done, found_line is set.
+             False -  The substitute must be done with dm_start_sub.
+
+*************************************************************************/
+
+static int  bulk_sub(PAD_DESCR    *pad,              /* input  */
+                     FIND_PRIVATE *private,          /* input / output */
+                     int           from_line,        /* input  */
+                     int           from_col,         /* input  */
+                     int           to_line,          /* input  */
+                     int           to_col,           /* input  */
+                     char         *pattern,          /* input  */
+                     char         *substitute,       /* input  */
+                     int           sub_once,         /* input  */
+                     int          *found_line,       /* output */
+                     int          *found_col,        /* output */
+                     char          escape_char,      /* input  */
+                     void        **search_private_ptr)/* input / output  */
+{
+DATA_TOKEN              *token = pad->token;
+char                    *line;
+int                      lcl_to_col = MAX_LINE+1;
+int                      newlines_added = 0;
+int                      changes = 0;
+int                      last_col = 0;
+unsigned char           *hits;
+LINE_SPAN               *spans;
+int                      nspans;
+LINE_SWAP               *swaps = NULL;
+LINE_SWAP               *new_swaps;
+int                      max_swaps = 0;
+int                      count = 0;
+int                      i;
+int                      j;
+int                      line_no;
+int                      made;
+int                      failed = False;
+char                     buff[MAX_LINE+2];
+
+/***************************************************************
+*  The range must start at the beginning of a line and end past
+*  the end of one.  search() treats column 0 on the last line as
+*  the end of the line before.  Color data is shifted by subs a
+*  change at a time and is left to search().
+***************************************************************/
+if ((from_col != 0) || COLORED(token))
+   return(False);
+
+load_enough_data(to_line);
+if (to_line >= total_lines(token))
+   to_line = total_lines(token) - 1;
+else
+   if (to_col == 0)
+      to_line--;
+   else
+      {
+         line = get_line_by_num(token, to_line);
+         if (!line || (to_col <= (int)strlen(line)))
+            return(False);
+      }
+
+if ((to_line - from_line + 1) < DM_BULK_SUB_LINES)
+   return(False);
+
+/***************************************************************
+*  Compile the pattern and substitute.  Starting past the end of
+*  the first line, search cannot find anything.
+***************************************************************/
+search(token,
+       from_line,
+       MAX_LINE,
+       from_line,
+       &lcl_to_col,
+       0,
+       pattern,
+       substitute,
+       0, /* substitutes are always case sensitive */
+       found_line,
+       found_col,
+       &newlines_added,
+       False,
+       0,
+       MAX_LINE+1,
+       &changes,
+       sub_once,
+       escape_char,
+       search_private_ptr);
+
+if (*found_line == DM_FIND_ERROR)
+   return(True); /* message already output */
+
+if (!subs_line_ok(*search_private_ptr))
+   return(False);
+
+/***************************************************************
+*  Let the workers flag the lines which may match.  If they
+*  cannot run this pattern, every line is tried.
+***************************************************************/
+spans = line_spans(token, from_line, to_line, &nspans);
+if (!spans)
+   return(False);
+
+hits = pfind_lines(token, *search_private_ptr, 0, from_line, to_line);
+
+DEBUG2(fprintf(stderr, "bulk_sub: [%d,%d] %d spans, %s\n", from_line, to_line, nspans, hits ? "pfind" : "every line");)
+
+changes = 0;
+for (i = 0; (i < nspans) && !failed; i++)
+   for (j = 0; (j < spans[i].lines) && !failed; j++)
+   {
+      line_no = spans[i].first_line + j;
+      if (hits && !hits[line_no - from_line])
+         continue;
+
+      made = subs_line(token, *search_private_ptr, line_no, span_line(&spans[i], j), sub_once, buff, &last_col);
+      if (!made)
+         continue;
+
+      if (count == max_swaps)
+         {
+            max_swaps = max_swaps ? max_swaps * 2 : 1024;
+            new_swaps = (LINE_SWAP *)realloc((char *)swaps, max_swaps * sizeof(LINE_SWAP));
+            if (!new_swaps)
+               {
+                  malloc_error(max_swaps * sizeof(LINE_SWAP), __FILE__, __LINE__);
+                  failed = True;
+                  continue;
+               }
+            swaps = new_swaps;
+         }
+
+      swaps[count].size = (strlen(buff) + 8) & ~7;
+      swaps[count].text = (char *)CE_MALLOC(swaps[count].size);
+      if (!swaps[count].text)
+         {
+            failed = True;
+            continue;
+         }
+      strcpy(swaps[count].text, buff);
+      swaps[count].line_no = line_no;
+      count++;
+      changes += made;
+      *found_line = line_no;
+      *found_col  = last_col;
+   }
+
+free((char *)spans);
+if (hits)
+   free((char *)hits);
+
+/***************************************************************
+*  Out of memory part way, nothing has been changed yet.  Throw
+*  the gathered lines away rather than do part of the substitute.
+***************************************************************/
+if (failed)
+   {
+      for (i = 0; i < count; i++)
+         free(swaps[i].text);
+      if (swaps)
+         free((char *)swaps);
+      private->substitute_changes_count = 0;
+      *found_line = DM_FIND_ERROR; /* message already output */
+      return(True);
+   }
+
+/***************************************************************
+*  Put all the changes in at once.  swap_lines hands the array,
+*  now holding the old lines, to the undo list.
+***************************************************************/
+if (count)
+   {
+      swap_lines(token, swaps, count);
+      private->found_once      = 1;
+      private->last_found_line = *found_line;
+      private->last_found_col  = *found_col;
+   }
+else
+   {
+      if (swaps)
+         free((char *)swaps);
+      *found_line = DM_FIND_NOT_FOUND;
+   }
+
+private->substitute_changes_count = changes;
+
+DEBUG2(fprintf(stderr, "bulk_sub: %d lines changed, last found pos [%d,%d]\n", count, *found_line, *found_col);)
+
+return(True);
+
+} /* end of bulk_sub */
+
+
 /***********************************************************************
 *
 *  dm_re - translate a RE from aegis to UNIX
@@ -1701,6 +2168,216 @@ dm_error(buf, DM_ERROR_MSG);
 }  /* dm_re() */
 
 
+/************************************************************************
+
+NAME:      dm_fcnt  -  Count the matches of one or more patterns in the file
+
+PURPOSE:    This routine counts the matches of each pattern passed in the
+            main pad and shows the totals in the message window.  With
+            no patterns, the last find pattern is counted.  A match is
+            counted each place a repeated // would stop.
+
+PARAMETERS:
+
+   1.  dmc            - pointer to DMC (INPUT)
+                        The fcnt command, the patterns are in argv[1..].
+
+   2.  find_data      - pointer to FIND_DATA (INPUT)
+                        The find data, used for the last find pattern.
+
+   3.  main_pad       - pointer to PAD_DESCR (INPUT)
+                        The main pad.
+
+   4.  case_sensitive - int (INPUT)
+                        The current case setting.
+
+   5.  escape_char    - char (INPUT)
+                        The escape character, '@' for aegis patterns.
+
+FUNCTIONS :
+
+   1.   Read in the rest of the file.
+
+   2.   Count each pattern and build the message.
+
+*************************************************************************/
+
+void  dm_fcnt(DMC               *dmc,                   /* input   */
+              FIND_DATA         *find_data,             /* input   */
+              PAD_DESCR         *main_pad,              /* input   */
+              int                case_sensitive,        /* input   */
+              char               escape_char)           /* input   */
+{
+char                     msg[512];
+char                    *pattern;
+int                      count;
+int                      lines;
+int                      i;
+int                      len = 0;
+char                    *last_pattern = NULL;
+
+if (find_data->private && ((FIND_PRIVATE *)find_data->private)->last_find_pattern[0])
+   last_pattern = ((FIND_PRIVATE *)find_data->private)->last_find_pattern;
+
+if ((dmc->fcnt.argc < 2) && !last_pattern)
+   {
+      dm_error("(fcnt) No pattern specified", DM_ERROR_BEEP);
+      return;
+   }
+
+load_enough_data(INT_MAX);
+msg[0] = '\0';
+
+for (i = 1; (i < dmc->fcnt.argc) || (i == 1); i++)
+{
+   pattern = (dmc->fcnt.argc < 2) ? last_pattern : dmc->fcnt.argv[i];
+   count = count_matches(main_pad, pattern, case_sensitive, escape_char, &lines);
+   if (count < 0)
+      return; /* bad pattern, message already output */
+
+   if (len < sizeof(msg))
+      len += snprintf(&msg[len], sizeof(msg) - len, "%s%s: %d match%s on %d line%s",
+                      (len ? ";  " : ""), pattern,
+                      count, ((count == 1) ? "" : "es"), lines, ((lines == 1) ? "" : "s"));
+}
+
+dm_error(msg, DM_ERROR_MSG);
+
+} /* end of dm_fcnt */
+
+
+/************************************************************************
+
+NAME:      count_matches  -  Count the matches of one pattern
+
+PURPOSE:    The pattern is compiled into its own search data so the
+            find data of the window is not disturbed.  pfind_lines flags
+            the lines which may match using all processors and search()
+            counts the matches on those lines.  If the pattern cannot be
+            tested by pfind, search() walks the whole file.
+
+PARAMETERS:
+
+   1.  pad            - pointer to PAD_DESCR (INPUT)
+                        The pad to search.
+
+   2.  pattern        - pointer to char (INPUT)
+                        The pattern.
+
+   3.  case_sensitive - int (INPUT)
+                        The current case setting.
+
+   4.  escape_char    - char (INPUT)
+                        The escape character.
+
+   5.  lines_matched  - pointer to int (OUTPUT)
+                        The number of lines with at least one match.
+
+FUNCTIONS :
+
+   1.   Returns the number of matches or -1 for a bad pattern.
+
+*************************************************************************/
+
+static int  count_matches(PAD_DESCR    *pad,              /* input  */
+                          char         *pattern,          /* input  */
+                          int           case_sensitive,   /* input  */
+                          char          escape_char,      /* input  */
+                          int          *lines_matched)    /* output */
+{
+void                    *sdata = NULL;
+unsigned char           *hits;
+int                      save_circf = circf;
+int                      total;
+int                      count = 0;
+int                      seg_from;
+int                      seg_to;
+int                      from_line;
+int                      from_col;
+int                      to_col;
+int                      found_line;
+int                      found_col;
+int                      last_line = -1;
+int                      dummy_parm;
+char                    *line;
+
+*lines_matched = 0;
+total = total_lines(pad->token);
+if (total <= 0)
+   return(0);
+
+/***************************************************************
+*  Compile the pattern with a search of the first line.
+***************************************************************/
+to_col = MAX_LINE+1;
+search(pad->token, 0, -1, 0, &to_col, False, pattern, NULL, !case_sensitive,
+       &found_line, &found_col, &dummy_parm, 0, 0, 0, NULL, 0, escape_char, &sdata);
+if (found_line == DM_FIND_ERROR)
+   {
+      free_search_data(&sdata);
+      circf = save_circf;
+      return(-1);
+   }
+
+hits = pfind_lines(pad->token, sdata, !case_sensitive, 0, total - 1);
+
+/***************************************************************
+*  With hits, each flagged line is a segment, otherwise the
+*  whole file is one segment.
+***************************************************************/
+for (seg_from = 0; seg_from < total; seg_from = seg_to + 1)
+{
+   if (hits)
+      {
+         while ((seg_from < total) && !hits[seg_from])
+            seg_from++;
+         if (seg_from >= total)
+            break;
+         seg_to = seg_from;
+      }
+   else
+      seg_to = total - 1;
+
+   from_line = seg_from;
+   from_col  = -1;
+   while (from_line <= seg_to)
+   {
+      to_col = MAX_LINE+1;
+      search(pad->token, from_line, from_col, seg_to, &to_col, False, NULL, NULL, !case_sensitive,
+             &found_line, &found_col, &dummy_parm, 0, 0, 0, NULL, 0, escape_char, &sdata);
+      if (found_line < 0)
+         break;
+
+      count++;
+      if (found_line != last_line)
+         (*lines_matched)++;
+      last_line = found_line;
+
+      /* move past the match, a match at the end of the line goes to the next line */
+      line = get_line_by_num(pad->token, found_line);
+      from_line = found_line;
+      from_col  = found_col;
+      if (!line || (found_col >= (int)strlen(line)))
+         {
+            from_line++;
+            from_col = -1;
+         }
+   }
+}
+
+DEBUG2(fprintf(stderr, "count_matches: \"%s\" %d matches on %d lines (%s)\n",
+               pattern, count, *lines_matched, (hits ? "parallel" : "serial"));)
+
+if (hits)
+   free((char *)hits);
+free_search_data(&sdata);
+circf = save_circf; /* the window's own find data was compiled with it */
+
+return(count);
+
+} /* end of count_matches */
+
+
 /***********************************************************************
 *
 *  ins - insert into a line a string removing the character under the ptr
@@ -37,6 +37,7 @@
 *     dm_continue_find  -  Continue a find started by dm_start_find. (via dm_find).
 *     dm_continue_sub   -  Continue a find started by dm_start_find. (via dm_s)
 *     dm_re             -  Convert a regular expression from aegis to unix and display
+*     dm_fcnt           -  Count the matches of one or more patterns in the file
 *     find_border_adjust - Adjust first line to set border around the find.
 *
 ***************************************************************/
@@ -85,6 +86,12 @@ void  dm_continue_sub(FIND_DATA  *find_data,        /* input / output */
 void dm_re(DMC  *dmc,
            char  escape_char);
 
+void  dm_fcnt(DMC               *dmc,                   /* input   */
+              FIND_DATA         *find_data,             /* input   */
+              PAD_DESCR         *main_pad,              /* input   */
+              int                case_sensitive,        /* input   */
+              char               escape_char);          /* input   */
+
 int find_border_adjust(PAD_DESCR   *main_pad,
                        int          border);
 
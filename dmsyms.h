@@ -268,9 +268,12 @@
 #define  DM_rl            159
 #define  DM_reload        160
 #define  DM_cntlc         161
+#define  DM_fcnt          162
+#define  DM_ifind         163
+#define  DM_bgstat        164
 
 
-#define  DM_MAXDEF        162
+#define  DM_MAXDEF        165
 
 
 /***************************************************************
@@ -498,6 +501,9 @@ DMSYM      dmsyms[DM_MAXDEF] = {
   { "rl",        1,         0,           0,        0,       0,        0,       VT100_OK    },  /*  159   DM_rl          */
   { "reload",    1,         0,           1,        0,       0,        0,       VT100_NEVER },  /*  160   DM_reload      */
   { "cntlc",     1,         0,           1,        0,       0,        0,       VT100_NEVER },  /*  161   DM_cntlc       */
+  { "fcnt",      1,         0,           1,        0,       0,        0,       VT100_OK    },  /*  162   DM_fcnt        */
+  { "ifind",     1,         0,           1,        0,       0,        0,       VT100_DM    },  /*  163   DM_ifind       */
+  { "bgstat",    1,         0,           0,        0,       0,        0,       VT100_OK    },  /*  164   DM_bgstat      */
                                                                              
 /*  name      supported   modifies     needs    special   cursor    autocut    vt100                                 */
 /*                          buff       flush     delim     pos                  ok                                   */
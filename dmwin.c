@@ -756,20 +756,28 @@ unsigned long         window_mask;
 
 /***************************************************************
 *
-*  Get the border width from the main window.
+*  Get the border width from the main window.  get_dm_windows
+*  already asked the server and overlapped the dminput window
+*  by that much, so reuse it rather than make a round trip on
+*  every resize.
 *
 ***************************************************************/
 
-DEBUG9(XERRORPOS)
-if (!XGetWindowAttributes(display,
-                         main_x_window,
-                         &window_attributes))
+if (dminput_window->x < 0)
+   border_width = 0 - dminput_window->x;
+else
    {
-      fprintf(stderr, "resize_dm_windows:  Cannot get window attributes for main window 0x%02X\n", main_x_window);
-      border_width = 1;
+      DEBUG9(XERRORPOS)
+      if (!XGetWindowAttributes(display,
+                               main_x_window,
+                               &window_attributes))
+         {
+            fprintf(stderr, "resize_dm_windows:  Cannot get window attributes for main window 0x%02X\n", main_x_window);
+            border_width = 1;
+         }
+      else
+         border_width = window_attributes.border_width;
    }
-else
-   border_width = window_attributes.border_width;
 
 
 /***************************************************************
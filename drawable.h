@@ -149,6 +149,7 @@ typedef struct {
    int             pix_len;                /* Length of the line in pixels                  */
    int             tabs;                   /* Flag if there are tabs in the line            */
    int             w_first_char;           /* First char displayed in window                */
+   unsigned int    w_generation;           /* memdata generation of line drawn, 0 if unknown */
 #ifdef EXCLUDEP
    int             w_file_line_offset;     /* File line number being displayed - first line on screen, needed for x'ed out data */
    int             w_file_lines_here;      /* Number of lines excluded or 1 if not excluded, needed for x'ed out data */
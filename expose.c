@@ -57,6 +57,7 @@
 #include "expose.h"
 #include "dumpxevent.h"
 #include "getevent.h"
+#include "hlmatch.h"
 #include "parms.h"
 #include "pd.h"
 #include "redraw.h"
@@ -220,6 +221,8 @@ if (dspl_descr->echo_mode && (dspl_descr->mark1.buffer->which_window == from_buf
                 from_buffer->window->width,             /* width to copy        */
                 from_buffer->window->height,            /* height to copy       */
                 0, 0);                                  /* target origin        */
+      if (from_buffer->which_window == MAIN_PAD)
+         hlmatch_overlay(dspl_descr, 0, 0, from_buffer->window->width, from_buffer->window->height);
       clear_text_cursor(from_buffer->x_window, dspl_descr);
       clear_text_highlight(dspl_descr);
       text_rehighlight(from_buffer->x_window, from_buffer->window, dspl_descr);
@@ -288,6 +291,11 @@ else
                 event_union->xexpose.x,
                 event_union->xexpose.y);
 
+      if (from_buffer->which_window == MAIN_PAD)
+         hlmatch_overlay(dspl_descr,
+                         event_union->xexpose.x, event_union->xexpose.y,
+                         event_union->xexpose.width, event_union->xexpose.height);
+
       if (in_area && in_window(dspl_descr))
          redo_cursor(dspl_descr, False);
 
@@ -49,13 +49,27 @@
 *     fake_keystroke          - Generate a fake keystroke event to trigger other things.
 *     store_cmds              - Store commands to be triggered with a fake keystroke
 *     set_global_dspl         - Set the current global display to a particular display.
+*     dm_bgstat               - Show the background task statistics.
 *
 *  Internal:
 *     do_background_task      - Handle the processing of background work.
+*     bg_keydefs_ready        - Background keydefs, see if there is work
+*     bg_keydefs_unit         - Background keydefs, do one batch
+*     bg_ifind_unit           - Background ifind, do one scan
+*     bg_find_ready           - Background find, see if there is work
+*     bg_sub_ready            - Background substitute, see if there is work
+*     bg_find_unit            - Background find or substitute, do one range
+*     bg_read_ready           - Background read ahead, see if there is work
+*     bg_read_unit            - Background read ahead, read one block
+*     bg_scroll_unit          - Background scroll, do one scroll
+*     bg_clock                - Get the time a slice starts
+*     bg_usecs                - Microseconds since a start time
+*     bg_input_waiting        - See if any display has X input waiting
 *     ce_XIfEvent_pad         - Scan all displays for a typed event.
 *     check_background_work   - calculate something_to_do_in_background
 *     add_commas              - Make an integer a printable character string with commas inserted.
 *     any_find_or_sub         - Scan display list for finds or subs in progress
+*     any_ifind               - Scan display list for incremental finds in progress
 *     any_scroll              - Scan display list for background scrolling in progress
 *     adjust_motion_event     - Fixup motion events when the mouse button is held down
 *     reset_child             - Reset the child state signal handler in pad.c
@@ -72,6 +86,7 @@
 #ifndef WIN32
 #include <sys/time.h>       /* /usr/include/sys/time.h   */
 #include <signal.h>         /* /usr/include/signal.h     */
+#include <time.h>           /* /usr/include/time.h       */
 #else
 #include <time.h>
 #include <winsock.h>
@@ -86,10 +101,14 @@
 #include "emalloc.h"
 #include "execute.h"     /* needef for reap_child_process    */
 #include "getevent.h"
+#include "ifind.h"
 #include "ind.h"
 #include "init.h"
+#include "journal.h"
+#include "autoimage.h"
 #include "kd.h"
 #include "lineno.h"
+#include "loadcache.h"
 #include "lock.h"
 #include "mouse.h"
 #ifdef PAD
@@ -98,12 +117,14 @@
 #endif
 #include "parms.h"
 #include "redraw.h"
+#include "reload.h"
 #include "sbwin.h"
 #include "scroll.h"
 #include "search.h"
 #include "sendevnt.h"
 #include "tab.h"
 #include "timeout.h"
+#include "tindex.h"
 #include "titlebar.h"
 #include "txcursor.h"
 #include "typing.h"
@@ -152,12 +173,52 @@ static int            something_to_do_in_background = 0;
 
 #define  FIND_IN_PROGRESS         find_data->in_progress[0]
 #define  SUBSTITUTE_IN_PROGRESS   find_data->in_progress[1]
+#define  IFIND_IN_PROGRESS        find_data->in_progress[2]
 
 static int            keydefs_in_progress = 0;
 
 static int            main_window_eof = 0;
 static int            read_ahead = 0;
 
+/***************************************************************
+*  The trigram index (tindex.c) is built while we wait for input
+*  in a browse of a file which is read only and fully loaded.
+***************************************************************/
+#define TINDEX_WANTED(dspl) (TINDEX && main_window_eof && !(dspl)->pad_mode && !WRITABLE((dspl)->main_pad->token))
+
+/***************************************************************
+*  
+*  Background work is done in slices.  A slice runs units of the
+*  ready task with the best (lowest) priority until the task has
+*  no more work or the slice has used its time budget.  The
+*  budget drops to BG_INPUT_USECS as soon as X input is waiting.
+*  The counts are shown by the bgstat command.
+*  
+***************************************************************/
+
+#define BG_IDLE_USECS    20000
+#define BG_INPUT_USECS    2000
+
+#ifndef WIN32
+#ifdef CLOCK_MONOTONIC
+typedef struct timespec BG_TIME;
+#else
+typedef struct timeval BG_TIME;
+#endif
+#else
+typedef long BG_TIME;
+#endif
+
+typedef struct {
+   char            *name;                                    /* shown by bgstat                        */
+   int              priority;                                /* lowest ready priority runs             */
+   DISPLAY_DESCR *(*ready)(DISPLAY_DESCR *dspl_descr);       /* display with work for the task or NULL */
+   int            (*unit)(DISPLAY_DESCR *dspl_descr);        /* one unit of work, True if more remains */
+   long             slices;
+   long             units;
+   long             usecs;
+} BG_TASK;
+
 /***************************************************************
 *  Mask for mouse buttons.
 ***************************************************************/
@@ -258,8 +319,36 @@ static void check_background_work(void);
 
 static DISPLAY_DESCR *any_find_or_sub(DISPLAY_DESCR *dspl_descr);
 
+static DISPLAY_DESCR *any_ifind(DISPLAY_DESCR *dspl_descr);
+
 static DISPLAY_DESCR *any_scroll(DISPLAY_DESCR *dspl_descr);
 
+static DISPLAY_DESCR *bg_keydefs_ready(DISPLAY_DESCR *dspl_descr);
+
+static int   bg_keydefs_unit(DISPLAY_DESCR *dspl_descr);
+
+static int   bg_ifind_unit(DISPLAY_DESCR *dspl_descr);
+
+static DISPLAY_DESCR *bg_find_ready(DISPLAY_DESCR *dspl_descr);
+
+static DISPLAY_DESCR *bg_sub_ready(DISPLAY_DESCR *dspl_descr);
+
+static int   bg_find_unit(DISPLAY_DESCR *dspl_descr);
+
+static DISPLAY_DESCR *bg_read_ready(DISPLAY_DESCR *dspl_descr);
+
+static int   bg_read_unit(DISPLAY_DESCR *dspl_descr);
+
+#ifdef PAD
+static int   bg_scroll_unit(DISPLAY_DESCR *dspl_descr);
+#endif
+
+static void  bg_clock(BG_TIME *now);
+
+static long  bg_usecs(BG_TIME *start);
+
+static int   bg_input_waiting(DISPLAY_DESCR *dspl_descr);
+
 static void  adjust_motion_event(XEvent *event);
 
 #ifdef PAD
@@ -272,6 +361,25 @@ void check_pad_eof_char(void);
 
 static WARP_DATA *get_private_data(DISPLAY_DESCR  *dspl_descr);
 
+/***************************************************************
+*  
+*  The background tasks.  Find and substitute share a priority,
+*  a display never has both going at once.
+*  
+***************************************************************/
+
+static BG_TASK        bg_tasks[] = {
+/*   name        priority  ready              unit            */
+   { "keydefs",  1,        bg_keydefs_ready,  bg_keydefs_unit },
+   { "ifind",    2,        any_ifind,         bg_ifind_unit   },
+   { "find",     3,        bg_find_ready,     bg_find_unit    },
+   { "sub",      3,        bg_sub_ready,      bg_find_unit    },
+   { "read",     4,        bg_read_ready,     bg_read_unit    },
+#ifdef PAD
+   { "scroll",   5,        any_scroll,        bg_scroll_unit  },
+#endif
+   { NULL,       0,        NULL,              NULL            }};
+
 
 /************************************************************************
 
@@ -399,15 +507,24 @@ else
       *  to watch multiple file descriptors via the wait_for_input
       *  routine.  We also have to watch for certain signals to show
       *  up such as the shell ending or the need to reset the signal
-      *  handler which is required on some machines.
+      *  handler which is required on some machines.  wait_for_input
+      *  also times out for a journal commit which is waiting, for
+      *  autosave image work, and to watch a background pw.  It also
+      *  wakes up when the edit file is changed by someone else.
       *  
       ***************************************************************/
 
+      reload_watch(dspl_descr); /* in reload.c */
+
       if (dspl_descr->pad_mode
           || (dspl_descr->next != dspl_descr)
           || dspl_descr->sb_data->sb_microseconds
           || dspl_descr->pd_data->pd_microseconds
           || dspl_descr->xsmp_active
+          || journal_timeout()
+          || autoimage_timeout()
+          || pw_timeout()
+          || watch_active()
           || (*cmd_fd != -1))
          {
             temp_cmd_fd = cmd_fd;
@@ -432,9 +549,12 @@ else
                got_event = ce_XIfEvent_pad(dspl_descr, event_union, find_valid_event);
                if (!got_event)
                   {
+                     tindex_idle(dspl_descr->main_pad->token, TINDEX_WANTED(dspl_descr));
                      dspl_descr = wait_for_input(dspl_descr, /* set_global_dspl() */
                                                 *shell_fd,
                                                 temp_cmd_fd);
+                     tindex_busy();
+                     reload_watch(dspl_descr); /* in reload.c */
                      warp_data = get_private_data(dspl_descr);
                   }
 
@@ -463,7 +583,11 @@ else
          {
             DEBUG9(XERRORPOS)
             if (!got_event)
-               ce_XNextEvent(dspl_descr->display, event_union);
+               {
+                  tindex_idle(dspl_descr->main_pad->token, TINDEX_WANTED(dspl_descr));
+                  ce_XNextEvent(dspl_descr->display, event_union);
+                  tindex_busy();
+               }
          }
    } /* end of not expecting warp */
 
@@ -1171,7 +1295,7 @@ dspl_descr_head = dspl_descr; /* force this to be the next one read from */
 NAME:      do_background_task
 
 PURPOSE:    This routine performs background task between incoming events.
-            Currently only reading blocks of data is done in background.
+            One slice of the most important task with work to do is run.
 
 PARAMETERS:
 
@@ -1180,133 +1304,344 @@ PARAMETERS:
 
 GLOBAL INPUT DATA:
 
-   1.  main_window_eof -   int (INPUT / OUTPUT)
-               This flag is set when all the data is read in.
-
-   2.  FIND_IN_PROGRESS -  int (INPUT / OUTPUT)
-               This flag shows that a find is in progress.
-
-   3.  SUBSTITUTE_IN_PROGRESS -  int (INPUT / OUTPUT)
-               This flag shows that a substitute is in progress.
-
+   1.  bg_tasks        -   array of BG_TASK (INPUT / OUTPUT)
+               The tasks and their statistics.
 
 FUNCTIONS :
 
-   1.   If there is data from the file to read in, read it
+   1.   Pick the ready task with the lowest priority number.  In order,
+        these are keydefs, incremental find, find or substitute, reading
+        in the file, and pad scrolling.
  
-   2.   If there is a find in progress, continue it for a while.
-        continue_file() will do some number of lines and return.
+   2.   Run units of the task until it is done or the time budget is
+        used.  The budget is BG_IDLE_USECS, or BG_INPUT_USECS once there
+        is X input waiting.  At least one unit is always run.
 
-   3.   If there is a substitute in progress, continue it as with the
-        find.  Note that there is never a find and substitute in
-        progress at the same time.
+   3.   Add the slice to the task statistics.
 
 
 *************************************************************************/
 
 static void  do_background_task(DISPLAY_DESCR *dspl_descr)
 {
+BG_TASK              *task = NULL;
+BG_TASK              *walk_task;
+DISPLAY_DESCR        *walk_dspl;
+DISPLAY_DESCR        *task_dspl = NULL;
+BG_TIME               start;
+long                  budget = BG_IDLE_USECS;
+long                  used;
+int                   more;
+int                   units = 0;
 
+DEBUG2(fprintf(stderr, "@do_background_task: eof = %d, lines = %d find = %d, substitute = %d keydefs = %d scroll = %d\n",
+                        main_window_eof, total_lines(dspl_descr->main_pad->token),
+                        dspl_descr->FIND_IN_PROGRESS, dspl_descr->SUBSTITUTE_IN_PROGRESS,
+                        keydefs_in_progress, dspl_descr->background_scroll_lines);
+)
+
+for (walk_task = bg_tasks; walk_task->name; walk_task++)
+   if ((!task || (walk_task->priority < task->priority)) && ((walk_dspl = walk_task->ready(dspl_descr)) != NULL))
+      {
+         task      = walk_task;
+         task_dspl = walk_dspl;
+      }
+
+if (task)
+   {
+      bg_clock(&start);
+      do
+      {
+         more = task->unit(task_dspl);
+         units++;
+         if ((budget > BG_INPUT_USECS) && bg_input_waiting(dspl_descr))
+            budget = BG_INPUT_USECS;
+         used = bg_usecs(&start);
+      } while(more && (used < budget));
+
+      task->slices++;
+      task->units += units;
+      task->usecs += used;
+      DEBUG2(fprintf(stderr, "do_background_task: %s, %d units in %ld usecs, %s\n", task->name, units, used, more ? "more to do" : "done");)
+   }
+
+check_background_work();
+
+} /* end of do_background_task  */
+
+
+/************************************************************************
+
+NAME:      bg_keydefs_ready  - Background keydefs, see if there is work
+
+NAME:      bg_keydefs_unit   - Background keydefs, do one batch
+
+PURPOSE:    Key definitions are loaded a batch at a time by
+            process_some_keydefs in kd.c.
+
+*************************************************************************/
+
+static DISPLAY_DESCR *bg_keydefs_ready(DISPLAY_DESCR *dspl_descr)
+{
+return(keydefs_in_progress ? dspl_descr : NULL);
+} /* end of bg_keydefs_ready */
+
+
+static int   bg_keydefs_unit(DISPLAY_DESCR *dspl_descr)
+{
+keydefs_in_progress = process_some_keydefs(dspl_descr); /* in kd.c */
+return(keydefs_in_progress);
+} /* end of bg_keydefs_unit */
+
+
+/************************************************************************
+
+NAME:      bg_ifind_unit  - Background ifind, do one scan
+
+PURPOSE:    Incremental find scan, one ifind time slice at a time so the
+            next keystroke is not held up.
+
+*************************************************************************/
+
+static int   bg_ifind_unit(DISPLAY_DESCR *dspl_descr)
+{
+int                   redraw_needed;
+
+set_global_dspl(dspl_descr);  /* switch displays globally to the one we need to process */
+redraw_needed = ifind_continue(dspl_descr);
+if (redraw_needed)
+   process_redraw(dspl_descr, redraw_needed, False);
+
+return(dspl_descr->IFIND_IN_PROGRESS);
+
+} /* end of bg_ifind_unit */
+
+
+/************************************************************************
+
+NAME:      bg_find_ready  - Background find, see if there is work
+
+NAME:      bg_sub_ready   - Background substitute, see if there is work
+
+*************************************************************************/
+
+static DISPLAY_DESCR *bg_find_ready(DISPLAY_DESCR *dspl_descr)
+{
+DISPLAY_DESCR        *walk_dspl = any_find_or_sub(dspl_descr);
+
+return((walk_dspl && !walk_dspl->SUBSTITUTE_IN_PROGRESS) ? walk_dspl : NULL);
+
+} /* end of bg_find_ready */
+
+
+static DISPLAY_DESCR *bg_sub_ready(DISPLAY_DESCR *dspl_descr)
+{
+DISPLAY_DESCR        *walk_dspl = any_find_or_sub(dspl_descr);
+
+return((walk_dspl && walk_dspl->SUBSTITUTE_IN_PROGRESS) ? walk_dspl : NULL);
+
+} /* end of bg_sub_ready */
+
+
+/************************************************************************
+
+NAME:      bg_find_unit  - Background find or substitute, do one range
+
+PURPOSE:    This routine continues a find or substitute for one range
+            of lines (DM_FIND_SEARCH_LINES in dmfind.c).  When it ends,
+            the cursor is positioned and the window redrawn.
+
+FUNCTIONS :
+
+   1.   Returns True if the find or substitute is still in progress.
+
+*************************************************************************/
+
+static int   bg_find_unit(DISPLAY_DESCR *dspl_descr)
+{
 int                   redraw_needed = 0;
-int                   warp_needed;
+int                   warp_needed = 0;
 int                   found_line;
 int                   found_col;
 PAD_DESCR            *found_pad;
-DISPLAY_DESCR        *walk_dspl;
-#ifdef PAD
-int                   lines_displayed;
-#endif
+
+set_global_dspl(dspl_descr);  /* switch displays globally to the one we need to process */
+if (dspl_descr->SUBSTITUTE_IN_PROGRESS)  /* is never both */
+   dm_continue_sub(dspl_descr->find_data, &found_line, &found_col, &found_pad, dspl_descr->escape_char);
+else
+   dm_continue_find(dspl_descr->find_data, &found_line, &found_col, &found_pad, dspl_descr->escape_char);
+
+if (found_line == DM_FIND_IN_PROGRESS)
+   return(True);
+
+dspl_descr->FIND_IN_PROGRESS = 0;
+dspl_descr->SUBSTITUTE_IN_PROGRESS = 0;
+if (found_line == DM_FIND_NOT_FOUND)
+   {
+      redraw_needed |= dm_position(dspl_descr->cursor_buff, dspl_descr->main_pad, dspl_descr->cursor_buff->current_win_buff->file_line_no, dspl_descr->cursor_buff->current_win_buff->file_col_no);
+      warp_needed = 1;
+   }
+else
+   {
+      if (found_line != DM_FIND_ERROR)
+         {
+            /***************************************************************
+            *  We found it.
+            ***************************************************************/
+            flush(dspl_descr->main_pad);
+            dspl_descr->main_pad->file_line_no = found_line;
+            dspl_descr->main_pad->file_col_no  = found_col;
+            dspl_descr->main_pad->buff_ptr = get_line_by_num(dspl_descr->main_pad->token, dspl_descr->main_pad->file_line_no);
+            redraw_needed |= dm_position(dspl_descr->cursor_buff, dspl_descr->main_pad, found_line, found_col);
+            if ((dspl_descr->find_border > 0) && find_border_adjust(dspl_descr->main_pad, dspl_descr->find_border))
+               redraw_needed |= dm_position(dspl_descr->cursor_buff, dspl_descr->main_pad, found_line, found_col);
+         }
+      redraw_needed |= (MAIN_PAD_MASK & FULL_REDRAW);
+      warp_needed = 1;
+   }
+/***************************************************************
+*  If we need to redraw, do it.
+*  We redraw the pixmap and then send an expose event to copy
+*  it to the window.
+***************************************************************/
+if (redraw_needed || warp_needed)
+   process_redraw(dspl_descr, redraw_needed, warp_needed);
+
+return(False);
+
+} /* end of bg_find_unit */
+
+
+/************************************************************************
+
+NAME:      bg_read_ready  - Background read ahead, see if there is work
+
+NAME:      bg_read_unit   - Background read ahead, read one block
+
+*************************************************************************/
+
+static DISPLAY_DESCR *bg_read_ready(DISPLAY_DESCR *dspl_descr)
+{
+return(main_window_eof ? NULL : dspl_descr);
+} /* end of bg_read_ready */
+
+
+static int   bg_read_unit(DISPLAY_DESCR *dspl_descr)
+{
 #ifdef DebuG
 static int  block_count = 0;
 #endif
 
-DEBUG2(fprintf(stderr, "@do_background_task: eof = %d, lines = %d find = %d, substitute = %d keydefs = %d scroll = %d\n",
-                        main_window_eof, total_lines(dspl_descr->main_pad->token),
-                        dspl_descr->FIND_IN_PROGRESS, dspl_descr->SUBSTITUTE_IN_PROGRESS,
-                        keydefs_in_progress, dspl_descr->background_scroll_lines);
+load_enough_data(total_lines(dspl_descr->main_pad->token)+1);
+DEBUG32(
+block_count++;
+if (block_count >= 50)
+   {
+      fprintf(stderr, "lines read %7d  (%d)\n", total_lines(dspl_descr->main_pad->token), time(0));
+      block_count = 0;
+   }
 )
 
+return(!main_window_eof);
 
-if (keydefs_in_progress)
-   keydefs_in_progress = process_some_keydefs(dspl_descr); /* in kd.c */
-else
-   if ((walk_dspl = any_find_or_sub(dspl_descr)) != NULL)
-      {
-         set_global_dspl(walk_dspl);  /* switch displays globally to the one we need to process */
-         if (walk_dspl->SUBSTITUTE_IN_PROGRESS)  /* is never both */
-            dm_continue_sub(walk_dspl->find_data, &found_line, &found_col, &found_pad, walk_dspl->escape_char);
-         else
-            dm_continue_find(walk_dspl->find_data, &found_line, &found_col, &found_pad, walk_dspl->escape_char);
+} /* end of bg_read_unit */
 
-         if (found_line != DM_FIND_IN_PROGRESS)
-            {
-               walk_dspl->FIND_IN_PROGRESS = 0;
-               walk_dspl->SUBSTITUTE_IN_PROGRESS = 0;
-               if (found_line == DM_FIND_NOT_FOUND)
-                  {
-                     redraw_needed |= dm_position(walk_dspl->cursor_buff, walk_dspl->main_pad, walk_dspl->cursor_buff->current_win_buff->file_line_no, walk_dspl->cursor_buff->current_win_buff->file_col_no);
-                     warp_needed = 1;
-                  }
-               else
-                  {
-                     if (found_line != DM_FIND_ERROR)
-                        {
-                           /***************************************************************
-                           *  We found it.
-                           ***************************************************************/
-                           flush(walk_dspl->main_pad);
-                           walk_dspl->main_pad->file_line_no = found_line;
-                           walk_dspl->main_pad->file_col_no  = found_col;
-                           walk_dspl->main_pad->buff_ptr = get_line_by_num(walk_dspl->main_pad->token, walk_dspl->main_pad->file_line_no);
-                           redraw_needed |= dm_position(walk_dspl->cursor_buff, walk_dspl->main_pad, found_line, found_col);
-                           if ((walk_dspl->find_border > 0) && find_border_adjust(walk_dspl->main_pad, walk_dspl->find_border))
-                              redraw_needed |= dm_position(walk_dspl->cursor_buff, walk_dspl->main_pad, found_line, found_col);
-                        }
-                     redraw_needed |= (MAIN_PAD_MASK & FULL_REDRAW);
-                     warp_needed = 1;
-                  }
-               /***************************************************************
-               *  If we need to redraw, do it.
-               *  We redraw the pixmap and then send an expose event to copy
-               *  it to the window.
-               ***************************************************************/
-               if (redraw_needed || warp_needed)
-                  process_redraw(walk_dspl, redraw_needed, warp_needed);
-            }   /* end of find is not still in progress */
-      } /* end of find_in_progress  or substitute_in_progress */
-   else
-      if (!main_window_eof)
-         {
-            load_enough_data(total_lines(dspl_descr->main_pad->token)+1);
-            DEBUG32(
-            block_count++;
-            if (block_count >= 50)
-               {
-                  fprintf(stderr, "lines read %7d  (%d)\n", total_lines(dspl_descr->main_pad->token), time(0));
-                  block_count = 0;
-               }
-            )
 
-         }
 #ifdef PAD
-      else
-         if ((walk_dspl = any_scroll(dspl_descr)) != NULL)
-            {
-               set_global_dspl(walk_dspl);  /* switch displays globally to the one we need to process */
-               lines_displayed = total_lines(walk_dspl->main_pad->token) - walk_dspl->main_pad->first_line;
-               if (lines_displayed > walk_dspl->main_pad->window->lines_on_screen)
-                  lines_displayed = walk_dspl->main_pad->window->lines_on_screen;
-
-               DEBUG19(fprintf(stderr, "Background scroll, %d lines\n", walk_dspl->background_scroll_lines);)
-               scroll_some(&walk_dspl->background_scroll_lines,
-                           walk_dspl,
-                           lines_displayed);
-            }
+/************************************************************************
+
+NAME:      bg_scroll_unit  - Background scroll, do one scroll
+
+*************************************************************************/
+
+static int   bg_scroll_unit(DISPLAY_DESCR *dspl_descr)
+{
+int                   lines_displayed;
+
+set_global_dspl(dspl_descr);  /* switch displays globally to the one we need to process */
+lines_displayed = total_lines(dspl_descr->main_pad->token) - dspl_descr->main_pad->first_line;
+if (lines_displayed > dspl_descr->main_pad->window->lines_on_screen)
+   lines_displayed = dspl_descr->main_pad->window->lines_on_screen;
+
+DEBUG19(fprintf(stderr, "Background scroll, %d lines\n", dspl_descr->background_scroll_lines);)
+scroll_some(&dspl_descr->background_scroll_lines,
+            dspl_descr,
+            lines_displayed);
+
+return(dspl_descr->background_scroll_lines != 0);
+
+} /* end of bg_scroll_unit */
 #endif
 
-check_background_work();
 
-} /* end of do_background_task  */
+/************************************************************************
+
+NAME:      bg_clock  - Get the time a slice starts
+
+NAME:      bg_usecs  - Microseconds since a start time
+
+PURPOSE:    These routines measure background slices with the monotonic
+            clock when there is one, so a change to the time of day does
+            not end a slice early or stretch it.  Under WIN32 there is no
+            clock and each slice is one unit.
+
+*************************************************************************/
+
+static void  bg_clock(BG_TIME *now)
+{
+#ifndef WIN32
+#ifdef CLOCK_MONOTONIC
+clock_gettime(CLOCK_MONOTONIC, now);
+#else
+gettimeofday(now, NULL);
+#endif
+#else
+*now = 0;
+#endif
+} /* end of bg_clock */
+
+
+static long  bg_usecs(BG_TIME *start)
+{
+#ifndef WIN32
+BG_TIME               now;
+
+bg_clock(&now);
+#ifdef CLOCK_MONOTONIC
+return(((now.tv_sec - start->tv_sec) * 1000000) + ((now.tv_nsec - start->tv_nsec) / 1000));
+#else
+return(((now.tv_sec - start->tv_sec) * 1000000) + (now.tv_usec - start->tv_usec));
+#endif
+#else
+return(BG_IDLE_USECS);
+#endif
+} /* end of bg_usecs */
+
+
+/************************************************************************
+
+NAME:      bg_input_waiting  - See if any display has X input waiting
+
+PURPOSE:    This routine reads whatever the X server has sent without
+            waiting or flushing output and reports whether any display
+            now has events queued.
+
+*************************************************************************/
+
+static int   bg_input_waiting(DISPLAY_DESCR *dspl_descr)
+{
+DISPLAY_DESCR        *walk_dspl = dspl_descr;
+
+do
+{
+   if (XEventsQueued(walk_dspl->display, QueuedAfterReading))
+      return(True);
+   walk_dspl = walk_dspl->next;
+} while(walk_dspl != dspl_descr);
+
+return(False);
+
+} /* end of bg_input_waiting */
 
 
 /************************************************************************
@@ -1361,6 +1696,50 @@ else
 } /* end of any_find_or_sub */
 
 
+/************************************************************************
+
+NAME:      any_ifind - Scan display list for incremental finds in progress
+
+PURPOSE:    This routine checks to see if there are any incremental find
+            scans in progress and returns the first one it finds.
+
+PARAMETERS:
+
+   1.  dspl_descr      -  pointer to DISPLAY_DESCR (INPUT)
+                          This is the display description to start the
+                          search with.
+
+
+FUNCTIONS :
+
+   1.   Check the passed dspl_descr to see if it has an incremental find in progress.
+ 
+   2.   If not, check any extra display descriptions.
+
+RETURNED VALUE:
+
+   dspl_descr   -   pointer to DISPLAY_DESCR
+                    NULL  -  no incremental finds in progress
+                    !NULL -  display description 
+
+*************************************************************************/
+
+static DISPLAY_DESCR *any_ifind(DISPLAY_DESCR *dspl_descr)
+{
+DISPLAY_DESCR        *walk_dspl = dspl_descr;
+
+if (dspl_descr->IFIND_IN_PROGRESS)
+   return(dspl_descr);
+
+for (walk_dspl = dspl_descr->next; walk_dspl != dspl_descr; walk_dspl = walk_dspl->next)
+   if (walk_dspl->IFIND_IN_PROGRESS)
+      return(walk_dspl);
+
+return(NULL);
+
+} /* end of any_ifind */
+
+
 /************************************************************************
 
 NAME:      any_scroll - Scan display list for background scrolls
@@ -1559,6 +1938,8 @@ while(!main_window_eof && total_lines(dspl_descr->main_pad->token) < total_lines
                 instream,                    /* input  */
                 MANFORMAT,                   /* input  */
                 &main_window_eof);           /* input / output */
+   if (main_window_eof)
+      loadcache_done(dspl_descr->main_pad->token); /* in loadcache.c, keep or drop the line lengths */
 
    DEBUG32(fprintf(stderr, "test %d <? %d   total lines = %d\n", (total_lines(dspl_descr->main_pad->token) % message_output_limit), start_line, total_lines(dspl_descr->main_pad->token));)
    if ((total_lines(dspl_descr->main_pad->token) % message_output_limit) < start_line)
@@ -1577,7 +1958,7 @@ while(!main_window_eof && total_lines(dspl_descr->main_pad->token) < total_lines
 
          message_output_limit = MESSAGE_TRIGGER;
       }
-   if (main_window_eof && (instream != NULL)) /* RES 9/6/95 added close on eof */
+   if (main_window_eof && (instream != NULL) && !reload_following(dspl_descr)) /* RES 9/6/95 added close on eof, a followed file stays open, in reload.c */
       {
          if (LSF)
             lsf_close(instream, dspl_descr->ind_data);
@@ -1715,6 +2096,7 @@ PARAMETERS:
                This is one of the #defined values for background work.
                Values: BACKGROUND_FIND
                        BACKGROUND_SUB
+                       BACKGROUND_IFIND
                        BACKGROUND_KEYDEFS
                        MAIN_WINDOW_EOF
                        BACKGROUND_SCROLL
@@ -1777,6 +2159,11 @@ case BACKGROUND_SUB:
    passed_dspl_descr->SUBSTITUTE_IN_PROGRESS = value;
    break;
 
+case BACKGROUND_IFIND:
+   DEBUG2(fprintf(stderr, "IFIND_IN_PROGRESS set to %d\n", value);)
+   passed_dspl_descr->IFIND_IN_PROGRESS = value;
+   break;
+
 case BACKGROUND_KEYDEFS:
    DEBUG4(fprintf(stderr, "keydefs_in_progress set to %d\n", value);)
    keydefs_in_progress = value;
@@ -1869,11 +2256,12 @@ DISPLAY_DESCR        *walk_dspl;
 
 something_to_do_in_background = (!main_window_eof && read_ahead) ||
                                 dspl_descr->FIND_IN_PROGRESS || dspl_descr->SUBSTITUTE_IN_PROGRESS ||
+                                dspl_descr->IFIND_IN_PROGRESS ||
                                 keydefs_in_progress || 
                                 (dspl_descr->background_scroll_lines && !dspl_descr->hold_mode);
 if (!something_to_do_in_background)
    for (walk_dspl = dspl_descr->next; walk_dspl != dspl_descr; walk_dspl = walk_dspl->next)
-      something_to_do_in_background |= ((walk_dspl->FIND_IN_PROGRESS) || (walk_dspl->SUBSTITUTE_IN_PROGRESS) ||
+      something_to_do_in_background |= ((walk_dspl->FIND_IN_PROGRESS) || (walk_dspl->SUBSTITUTE_IN_PROGRESS) || (walk_dspl->IFIND_IN_PROGRESS) ||
                                        (walk_dspl->background_scroll_lines && !(walk_dspl->hold_mode)));
 
 
@@ -1892,6 +2280,7 @@ PARAMETERS:
                This is one of the #defined values for background work.
                Values: BACKGROUND_FIND
                        BACKGROUND_SUB
+                       BACKGROUND_IFIND
                        BACKGROUND_KEYDEFS
                        MAIN_WINDOW_EOF
                        BACKGROUND_SCROLL
@@ -1922,6 +2311,10 @@ case BACKGROUND_SUB:
    value = dspl_descr->SUBSTITUTE_IN_PROGRESS;
    break;
 
+case BACKGROUND_IFIND:
+   value = dspl_descr->IFIND_IN_PROGRESS;
+   break;
+
 case BACKGROUND_KEYDEFS:
    value = keydefs_in_progress;
    break;
@@ -1953,6 +2346,47 @@ return(value);
 } /* end of get_background_work */
 
 
+/************************************************************************
+
+NAME:      dm_bgstat  - Show the background task statistics.
+
+PURPOSE:    This routine is the bgstat debug command.  For each background
+            task which has run, it shows the slices run, the time used and
+            the units of work done.  The units are find and substitute
+            ranges, key definition batches, blocks read, and so on.
+
+FUNCTIONS :
+
+   1.   Format the statistics and put them in the message window.
+
+*************************************************************************/
+
+void dm_bgstat(void)
+{
+BG_TASK              *task;
+char                  msg[512];
+int                   len = 0;
+
+msg[0] = '\0';
+for (task = bg_tasks; task->name && (len < (int)sizeof(msg) - 80); task++)
+{
+   if (!task->slices)
+      continue;
+   len += snprintf(&msg[len], sizeof(msg) - len, "%s%s %ld slices %ld.%03ld sec %ld units",
+                   len ? ", " : "", task->name, task->slices,
+                   task->usecs / 1000000, (task->usecs / 1000) % 1000, task->units);
+   DEBUG2(fprintf(stderr, "bgstat: %s priority %d, %ld slices, %ld usecs, %ld units\n",
+                  task->name, task->priority, task->slices, task->usecs, task->units);)
+}
+
+if (len)
+   dm_error(msg, DM_ERROR_MSG);
+else
+   dm_error("(bgstat) No background work has been done", DM_ERROR_MSG);
+
+} /* end of dm_bgstat */
+
+
 /************************************************************************
 
 NAME:      finish_keydefs - make sure all the key definitions have been read in.
@@ -40,6 +40,7 @@
 *     find_event              - CheckMaskEvent compare routine to find a single event type
 *     change_background_work  - Turn on or off background tasks.
 *     get_background_work     - Retrieve the current state of background task variables
+*     dm_bgstat               - Show the background task statistics.
 *     autovt_switch           - Perform switching for AUTOVT mode
 *     finish_keydefs          - Force the Keydefs to finish before continuing.
 *     set_event_masks         - Set the input event masks, for the windows.
@@ -87,6 +88,7 @@ int expecting_warp(DISPLAY_DESCR    *dspl_descr);
 #define   BACKGROUND_SCROLL      5
 #define   BACKGROUND_READ_AHEAD  6
 #define   BACKGROUND_FIND_OR_SUB 7
+#define   BACKGROUND_IFIND       8
 
 void change_background_work(DISPLAY_DESCR    *passed_dspl_descr,
                             int               type,
@@ -94,6 +96,8 @@ void change_background_work(DISPLAY_DESCR    *passed_dspl_descr,
 
 int  get_background_work(int      type);
 
+void dm_bgstat(void);
+
 void finish_keydefs(void);
 
 int autovt_switch(void);
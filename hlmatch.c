@@ -0,0 +1,544 @@
+/*static char *sccsid = "%Z% %M% %I% - %G% %U% ";*/
+/***************************************************************
+*
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in hlmatch.c
+*     hlmatch_stale           - Check if the match highlighting on the window is out of date
+*     hlmatch_overlay         - Highlight every match in part of the main window
+*     hlmatch_line            - Get the match columns for a line
+*     free_hlmatch_data       - Free the match highlighting data for a display
+*
+*  Internal routines:
+*     get_hlmatch_data        - Get the match data for a display, allocating it if needed
+*     current_pattern         - Get the generation of the pattern to highlight
+*     col_to_x                - Get the x pixel position of a column on a window line
+*
+*  When -hlall is on, every match of the last find pattern in
+*  the main window is shown in reverse video and a bar is drawn
+*  in the line number area next to each line with a match.
+*  The highlight is xor'ed onto the window after each copy from
+*  the pixmap, the same way the text cursor and the marked
+*  region are, so the pixmap and the redraw damage tracking do
+*  not know it is there.  The match columns of each line are
+*  kept in a small cache keyed on the line, its memdata
+*  generation, and the pattern generation.  A scroll or a
+*  change to a few lines only rescans the lines which are new
+*  or were changed.
+*
+***************************************************************/
+
+#include <stdio.h>          /* /usr/include/stdio.h      */
+#include <string.h>         /* /usr/include/string.h     */
+
+#include "borders.h"        /* needed for MARGIN */
+#include "debug.h"
+#include "dmwin.h"          /* needed for True and False */
+#include "emalloc.h"
+#include "hlmatch.h"
+#include "ifind.h"
+#include "parms.h"
+#include "search.h"
+#include "tab.h"
+#include "xerrorpos.h"
+
+
+/***************************************************************
+*
+*  Number of lines in the cache and the most matches kept per
+*  line.  The cache holds a few windows worth of lines.
+*  Matches past the limit on a line are not shown.
+*
+***************************************************************/
+
+#define HL_CACHE_SIZE     256
+#define HL_MAX_MATCHES    32
+
+typedef struct {
+   char           *line;           /* line the entry is for, NULL if empty     */
+   unsigned int    generation;     /* memdata generation of the line           */
+   unsigned int    pattern_gen;    /* pattern generation the columns are for   */
+   int             count;          /* number of matches in cols                */
+   short           cols[HL_MAX_MATCHES*2];  /* start and end column pairs      */
+} HL_LINE;
+
+typedef struct {
+   unsigned int    drawn_gen;      /* pattern generation on the whole window   */
+   HL_LINE         line[HL_CACHE_SIZE];
+   HL_LINE         scratch;        /* used for lines with no generation        */
+   int             hits;           /* lines found in the cache                 */
+   int             misses;         /* lines which had to be scanned            */
+} HL_DATA;
+
+
+/***************************************************************
+*  
+*  Prototypes for local routines.
+*  
+***************************************************************/
+
+static HL_DATA *get_hlmatch_data(DISPLAY_DESCR   *dspl_descr);
+
+static unsigned int current_pattern(DISPLAY_DESCR   *dspl_descr);
+
+static int  col_to_x(DRAWABLE_DESCR  *window,
+                     WINDOW_LINE     *wl,
+                     char            *line,
+                     int              col);
+
+
+/************************************************************************
+
+NAME:      hlmatch_stale - Check if the match highlighting on the window is out of date
+
+PURPOSE:    This routine is called by redraw_pad before the main window
+            is copied from the pixmap.  If the find pattern changed, or
+            highlighting was turned on or off, the highlight on the
+            parts of the window which are not being copied is wrong
+            and the whole window must be copied.
+
+PARAMETERS:
+
+   1.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT)
+                        This is the display to check.
+
+FUNCTIONS :
+
+   1.   Compare the pattern generation last put on the whole window
+        with the current one.
+
+RETURNED VALUE:
+   stale   -  int
+              True  -  The whole window needs to be copied
+              False -  The highlight on the window is current
+
+*************************************************************************/
+
+int  hlmatch_stale(DISPLAY_DESCR   *dspl_descr)         /* input  */
+{
+HL_DATA              *hl = (HL_DATA *)dspl_descr->hlmatch_data;
+
+if (hl)
+   return(hl->drawn_gen != current_pattern(dspl_descr));
+else
+   return(current_pattern(dspl_descr) != 0);
+
+} /* end of hlmatch_stale */
+
+
+/************************************************************************
+
+NAME:      hlmatch_overlay - Highlight every match in part of the main window
+
+PURPOSE:    This routine is called right after part of the main window
+            is copied from the pixmap.  It xors every match of the
+            current find pattern which falls in the copied area and
+            the line number bar for those lines.
+
+PARAMETERS:
+
+   1.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT)
+                        This is the display whose main window was copied.
+
+   2.  x, y           - int (INPUT)
+                        The top left corner of the area copied to the window.
+
+   3.  width, height  - int (INPUT)
+                        The size of the area copied to the window.
+
+FUNCTIONS :
+
+   1.   Clip the xor gc to the copied area.
+
+   2.   For each window line in the area, get the match columns and
+        xor each match.
+
+   3.   If the line has matches and line numbers are on, xor the bar
+        in the line number area.
+
+   4.   If the whole window was copied, remember the pattern now on it.
+
+*************************************************************************/
+
+void hlmatch_overlay(DISPLAY_DESCR   *dspl_descr,        /* input  */
+                     int              x,                 /* input  */
+                     int              y,                 /* input  */
+                     int              width,             /* input  */
+                     int              height)            /* input  */
+{
+PAD_DESCR            *main_pad = dspl_descr->main_pad;
+DRAWABLE_DESCR       *window = main_pad->window;
+DRAWABLE_DESCR       *lineno = dspl_descr->lineno_subarea;
+HL_DATA              *hl;
+unsigned int          pattern_gen;
+WINDOW_LINE          *wl;
+XRectangle            clip;
+short                *cols;
+int                   count;
+int                   row;
+int                   first_row;
+int                   last_row;
+int                   row_y;
+int                   x1;
+int                   x2;
+int                   right;
+int                   i;
+
+pattern_gen = current_pattern(dspl_descr);
+if (pattern_gen)
+   hl = get_hlmatch_data(dspl_descr);
+else
+   hl = (HL_DATA *)dspl_descr->hlmatch_data;
+if (!hl || (!pattern_gen && !hl->drawn_gen))
+   return;
+
+if (!main_pad->win_lines || (window->line_height <= 0) || (width <= 0) || (height <= 0))
+   return;
+
+/***************************************************************
+*  If the whole text area is being put back, after this call
+*  it shows the current pattern.
+***************************************************************/
+if ((x <= window->sub_x) && (y <= window->sub_y) &&
+    (x + width >= window->sub_x + (int)window->sub_width) &&
+    (y + height >= window->sub_y + (int)window->sub_height))
+   hl->drawn_gen = pattern_gen;
+
+if (!pattern_gen)
+   return;
+
+first_row = (y - window->sub_y) / window->line_height;
+if (first_row < 0)
+   first_row = 0;
+last_row = (y + height - window->sub_y - 1) / window->line_height;
+if (last_row >= window->lines_on_screen)
+   last_row = window->lines_on_screen - 1;
+if (last_row >= main_pad->win_lines_size)
+   last_row = main_pad->win_lines_size - 1;
+if (first_row > last_row)
+   return;
+
+clip.x      = x;
+clip.y      = y;
+clip.width  = width;
+clip.height = height;
+DEBUG9(XERRORPOS)
+XSetClipRectangles(dspl_descr->display, window->xor_gc, 0, 0, &clip, 1, Unsorted);
+
+right = window->sub_x + window->sub_width;
+
+for (row = first_row; row <= last_row; row++)
+{
+   wl = &main_pad->win_lines[row];
+   if (!wl->line)
+      break;  /* past end of file */
+
+   count = hlmatch_line(dspl_descr, wl->line, wl->w_generation, &cols);
+   if (count == 0)
+      continue;
+
+   row_y = window->sub_y + (row * window->line_height);
+
+   for (i = 0; i < count; i++)
+   {
+      x1 = col_to_x(window, wl, wl->line, cols[i*2]);
+      x2 = col_to_x(window, wl, wl->line, cols[(i*2)+1]);
+      if (x1 >= right)
+         break;
+      if (x2 > right)
+         x2 = right;
+      if (x2 <= window->sub_x)
+         continue;
+      if (x1 < window->sub_x)
+         x1 = window->sub_x;
+      DEBUG9(XERRORPOS)
+      XFillRectangle(dspl_descr->display, main_pad->x_window, window->xor_gc,
+                     x1, row_y, x2 - x1, window->line_height);
+   }
+
+   /* bar between the line number separator and the text */
+   if (dspl_descr->show_lineno && lineno && (lineno->width > MARGIN))
+      {
+         DEBUG9(XERRORPOS)
+         XFillRectangle(dspl_descr->display, main_pad->x_window, window->xor_gc,
+                        ((lineno->x + lineno->width) - MARGIN) + 1,
+                        lineno->y + (row * lineno->line_height),
+                        MARGIN - 1, lineno->line_height);
+      }
+}
+
+DEBUG9(XERRORPOS)
+XSetClipMask(dspl_descr->display, window->xor_gc, None);
+
+DEBUG12(fprintf(stderr, "hlmatch_overlay:  rows %d-%d, %d cached, %d scanned\n", first_row, last_row, hl->hits, hl->misses);)
+
+} /* end of hlmatch_overlay */
+
+
+/************************************************************************
+
+NAME:      hlmatch_line - Get the match columns for a line
+
+PURPOSE:    This routine returns the start and end columns of each match
+            of the current pattern on a line.  The columns come from
+            the cache if the line, its generation, and the pattern are
+            the same as the last time the line was scanned.
+
+PARAMETERS:
+
+   1.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT)
+                        This is the display whose find pattern is used.
+
+   2.  line           - pointer to char (INPUT)
+                        This is the line to scan.
+
+   3.  generation     - unsigned int (INPUT)
+                        This is the memdata generation of the line.  Zero
+                        means the line cannot be cached, such as the work
+                        buffer of the line being typed on.
+
+   4.  cols           - pointer to pointer to short (OUTPUT)
+                        The start and end column pairs are returned here.
+                        They stay valid until the next call.
+
+FUNCTIONS :
+
+   1.   Look up the line in the cache.
+
+   2.   If it is not there or out of date, scan it and save the columns.
+
+RETURNED VALUE:
+   count   -  int
+              The number of matches is returned.
+
+*************************************************************************/
+
+int  hlmatch_line(DISPLAY_DESCR   *dspl_descr,           /* input  */
+                  char            *line,                 /* input  */
+                  unsigned int     generation,           /* input  */
+                  short          **cols)                 /* output */
+{
+HL_DATA              *hl;
+HL_LINE              *entry;
+unsigned int          pattern_gen;
+
+pattern_gen = current_pattern(dspl_descr);
+hl = get_hlmatch_data(dspl_descr);
+if (!pattern_gen || !hl || !line)
+   return(0);
+
+if (generation)
+   {
+      entry = &hl->line[(((unsigned long)line) >> 4) % HL_CACHE_SIZE];
+      if ((entry->line == line) && (entry->generation == generation) && (entry->pattern_gen == pattern_gen))
+         {
+            hl->hits++;
+            *cols = entry->cols;
+            return(entry->count);
+         }
+   }
+else
+   entry = &hl->scratch;
+
+hl->misses++;
+entry->line        = line;
+entry->generation  = generation;
+entry->pattern_gen = pattern_gen;
+entry->count       = line_match_cols(dspl_descr->find_data->search_private, line, entry->cols, HL_MAX_MATCHES);
+
+*cols = entry->cols;
+return(entry->count);
+
+} /* end of hlmatch_line */
+
+
+/************************************************************************
+
+NAME:      free_hlmatch_data - Free the match highlighting data for a display
+
+PURPOSE:    This routine frees the line cache hung off a display.
+
+PARAMETERS:
+
+   1.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT / OUTPUT)
+                        This is the display whose data is to be freed.
+
+FUNCTIONS :
+
+   1.   Free the data and clear the pointer.
+
+*************************************************************************/
+
+void free_hlmatch_data(DISPLAY_DESCR   *dspl_descr)     /* input  */
+{
+
+if (dspl_descr->hlmatch_data)
+   free((char *)dspl_descr->hlmatch_data);
+dspl_descr->hlmatch_data = NULL;
+
+} /* end of free_hlmatch_data */
+
+
+/************************************************************************
+
+NAME:      get_hlmatch_data - Get the match data for a display, allocating it if needed
+
+PURPOSE:    This routine returns the line cache for a display.  It is
+            created the first time it is needed.
+
+PARAMETERS:
+
+   1.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT / OUTPUT)
+                        This is the display the data is hung off of.
+
+FUNCTIONS :
+
+   1.   If the data exists, return it.
+
+   2.   Otherwise malloc and clear it.
+
+RETURNED VALUE:
+   hl      -  pointer to HL_DATA
+              NULL is returned if the malloc fails.
+
+*************************************************************************/
+
+static HL_DATA *get_hlmatch_data(DISPLAY_DESCR   *dspl_descr)
+{
+HL_DATA              *hl;
+
+if (dspl_descr->hlmatch_data)
+   return((HL_DATA *)dspl_descr->hlmatch_data);
+
+hl = (HL_DATA *)CE_MALLOC(sizeof(HL_DATA));
+if (!hl)
+   return(NULL);
+
+memset((char *)hl, 0, sizeof(HL_DATA));
+dspl_descr->hlmatch_data = (void *)hl;
+return(hl);
+
+} /* end of get_hlmatch_data */
+
+
+/************************************************************************
+
+NAME:      current_pattern - Get the generation of the pattern to highlight
+
+PURPOSE:    This routine returns the generation of the last compiled
+            find pattern, or zero if nothing should be highlighted.
+            Nothing is highlighted when -hlall is off, in hex mode,
+            or when the pattern spans lines.
+
+PARAMETERS:
+
+   1.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT)
+                        This is the display to check.
+
+FUNCTIONS :
+
+   1.   Check the option and the display state.
+
+   2.   Get the generation from search.c.
+
+RETURNED VALUE:
+   generation - unsigned int
+                The pattern generation or zero.
+
+*************************************************************************/
+
+static unsigned int current_pattern(DISPLAY_DESCR   *dspl_descr)
+{
+
+if ((!HLALL && !ifind_active(dspl_descr)) || dspl_descr->hex_mode || !dspl_descr->find_data)
+   return(0);
+else
+   return(pattern_generation(dspl_descr->find_data->search_private));
+
+} /* end of current_pattern */
+
+
+/************************************************************************
+
+NAME:      col_to_x - Get the x pixel position of a column on a window line
+
+PURPOSE:    This routine converts a column in a line of the file to the
+            x pixel position in the main window, allowing for tabs and
+            horizontal scrolling.
+
+PARAMETERS:
+
+   1.  window         - pointer to DRAWABLE_DESCR (INPUT)
+                        This is the main window.
+
+   2.  wl             - pointer to WINDOW_LINE (INPUT)
+                        This is the window line being drawn on.
+
+   3.  line           - pointer to char (INPUT)
+                        This is the text of the line.
+
+   4.  col            - int (INPUT)
+                        This is the column in the line.
+
+FUNCTIONS :
+
+   1.   Expand tabs if the line has any.
+
+   2.   Take off the columns scrolled off the left side.
+
+   3.   Get the pixel position.  Columns scrolled off the left side
+        return the left edge of the text area.
+
+RETURNED VALUE:
+   x       -  int
+              The x pixel position.
+
+*************************************************************************/
+
+static int  col_to_x(DRAWABLE_DESCR  *window,
+                     WINDOW_LINE     *wl,
+                     char            *line,
+                     int              col)
+{
+int                   win_col;
+
+if (wl->tabs)
+   win_col = tab_pos(line, col, TAB_EXPAND, False);
+else
+   win_col = col;
+
+win_col -= wl->w_first_char;
+if (win_col <= 0)
+   return(window->sub_x);
+
+if (window->fixed_font)
+   return(window->sub_x + (win_col * window->fixed_font));
+else
+   return(window_col_to_x_pixel(line, win_col, wl->w_first_char, window->sub_x, window->font, False));
+
+} /* end of col_to_x */
+
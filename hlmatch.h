@@ -0,0 +1,66 @@
+#ifndef _HLMATCH_INCLUDED
+#define _HLMATCH_INCLUDED
+
+/* "%Z% %M% %I% - %G% %U% " */
+
+/***************************************************************
+*  
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*  
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*  
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*  
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*  
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*  
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in hlmatch.c
+*     hlmatch_stale           - Check if the match highlighting on the window is out of date
+*     hlmatch_overlay         - Highlight every match in part of the main window
+*     hlmatch_line            - Get the match columns for a line
+*     free_hlmatch_data       - Free the match highlighting data for a display
+*
+*  Match highlighting is turned on with -hlall yes (resource .hlall).
+*  Every match of the last find pattern in the main window is
+*  highlighted, and a bar is drawn in the line number area next to
+*  each line with a match.
+*
+***************************************************************/
+
+#include "buffer.h"
+
+int  hlmatch_stale(DISPLAY_DESCR   *dspl_descr);         /* input  */
+
+void hlmatch_overlay(DISPLAY_DESCR   *dspl_descr,        /* input  */
+                     int              x,                 /* input  */
+                     int              y,                 /* input  */
+                     int              width,             /* input  */
+                     int              height);           /* input  */
+
+int  hlmatch_line(DISPLAY_DESCR   *dspl_descr,           /* input  */
+                  char            *line,                 /* input  */
+                  unsigned int     generation,           /* input  */
+                  short          **cols);                /* output */
+
+void free_hlmatch_data(DISPLAY_DESCR   *dspl_descr);     /* input  */
+
+
+#endif
+
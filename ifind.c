@@ -0,0 +1,825 @@
+/*static char *sccsid = "%Z% %M% %I% - %G% %U% ";*/
+/***************************************************************
+*
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in ifind.c
+*     dm_ifind                - Start an incremental find (ifind command)
+*     ifind_active            - Check if an incremental find is up
+*     ifind_update            - Restart the scan after the DM input line changed
+*     ifind_continue          - Scan the next time slice in background
+*     ifind_cancel            - Put the main window back and stop the incremental find
+*
+*  Internal routines:
+*     get_ifind_private       - Get the incremental find data, allocating it if needed
+*     ifind_scan              - Scan for the pattern for one time slice
+*     ifind_stop              - Turn off the incremental find
+*     pattern_extends         - Check if every match of a new pattern is a match of the old one
+*
+*  The ifind command puts up a Find: prompt in the DM input
+*  window.  After each keystroke the text in the DM input window
+*  is searched for from where the cursor was in the main window,
+*  and the main window is moved to show the first match.  The
+*  scan is done a few thousand lines at a time and stops after
+*  IFIND_SLICE_USECS so typing is not held up.  The rest of the
+*  scan is done in background between keystrokes, and a
+*  keystroke throws away the scan in progress.  When the new
+*  pattern is the old one with more on the end, nothing before
+*  the old match can match, so the scan starts from there.
+*  Enter runs the find the normal way, abrt puts the main window
+*  back where it was.
+*
+***************************************************************/
+
+#include <stdio.h>          /* /usr/include/stdio.h      */
+#include <string.h>         /* /usr/include/string.h     */
+
+#ifndef WIN32
+#include <sys/time.h>       /* /usr/include/sys/time.h   */
+#endif
+
+#include "debug.h"
+#include "dmwin.h"
+#include "emalloc.h"
+#include "getevent.h"
+#include "hlmatch.h"
+#include "ifind.h"
+#include "memdata.h"
+#include "mvcursor.h"
+#include "parsedm.h"  /* needed for DMC_COMMENT */
+#include "prompt.h"
+#include "search.h"
+#include "typing.h"   /* needed for flush */
+
+
+/***************************************************************
+*
+*  Lines passed to each search call and the most time one
+*  slice may take.  The time is checked between search calls,
+*  so a slice runs at most one batch past the limit.
+*
+***************************************************************/
+
+#define IFIND_SLICE_LINES  2048
+#define IFIND_SLICE_USECS  8000
+
+/***************************************************************
+*
+*  Values of IFIND_PRIVATE.state
+*
+***************************************************************/
+
+#define IFIND_IDLE         0    /* nothing typed yet              */
+#define IFIND_SCANNING     1    /* scan not finished              */
+#define IFIND_FOUND        2    /* found_line, found_col are set  */
+#define IFIND_NOT_FOUND    3    /* no match in the whole file     */
+#define IFIND_ERROR        4    /* bad regular expression         */
+
+typedef struct {
+   int             active;            /* True while the Find: prompt is up         */
+   int             reverse;           /* True for a reverse incremental find       */
+   int             origin_line;       /* main window cursor when ifind was entered */
+   int             origin_col;
+   int             origin_first_line; /* main window position when ifind was entered */
+   int             origin_first_char;
+   char            pattern[MAX_LINE+1]; /* text being searched for                 */
+   unsigned int    pattern_gen;       /* generation of the compiled pattern, 0 if not compiled */
+   int             state;             /* IFIND_IDLE, IFIND_SCANNING, ...           */
+   int             next_line;         /* next line to scan                         */
+   int             next_col;          /* forward: match after this col, reverse: match before it */
+   int             found_line;        /* match shown in the main window            */
+   int             found_col;
+} IFIND_PRIVATE;
+
+
+/***************************************************************
+*  
+*  Prototypes for local routines.
+*  
+***************************************************************/
+
+static IFIND_PRIVATE *get_ifind_private(FIND_DATA   *find_data);
+
+static int  ifind_scan(DISPLAY_DESCR   *dspl_descr,
+                       IFIND_PRIVATE   *private);
+
+static void ifind_stop(DISPLAY_DESCR   *dspl_descr,
+                       IFIND_PRIVATE   *private);
+
+static int  pattern_extends(char   *old_pattern,
+                            char   *new_pattern,
+                            char    escape_char);
+
+
+/************************************************************************
+
+NAME:      dm_ifind - Start an incremental find (ifind command)
+
+PURPOSE:    This routine saves where the main window is and puts up a
+            prompt in the DM input window.  The response to the prompt
+            is a normal find, so Enter finds the pattern the same way
+            /pattern/ would.  Until then, ifind_update searches as the
+            pattern is typed.
+
+PARAMETERS:
+
+   1.  dmc         - pointer to DMC (INPUT)
+                     This is the ifind command.  -r makes it a reverse find.
+
+   2.  dspl_descr  - pointer to DISPLAY_DESCR (INPUT / OUTPUT)
+                     This is the display the find is done in.
+
+   3.  new_dmc     - pointer to pointer to DMC (OUTPUT)
+                     The prompt command is returned here.
+
+FUNCTIONS :
+
+   1.   Save the cursor and window position in the main window.
+
+   2.   Build the prompt command.
+
+RETURNED VALUE:
+   redraw -  The mask anded with the type of redraw needed is returned.
+
+*************************************************************************/
+
+int   dm_ifind(DMC             *dmc,                    /* input  */
+               DISPLAY_DESCR   *dspl_descr,             /* input / output */
+               DMC            **new_dmc)                /* output */
+{
+IFIND_PRIVATE        *private;
+PAD_DESCR            *main_pad = dspl_descr->main_pad;
+char                  cmd[80];
+int                   find_dlm;
+
+*new_dmc = NULL;
+
+private = get_ifind_private(dspl_descr->find_data);
+if (!private)
+   return(0);
+
+if (private->active)
+   {
+      dm_error("Incremental find already in progress", DM_ERROR_BEEP);
+      return(0);
+   }
+
+private->reverse           = dmc->ifind.dash_r;
+private->origin_line       = main_pad->file_line_no;
+private->origin_col        = main_pad->file_col_no;
+private->origin_first_line = main_pad->first_line;
+private->origin_first_char = main_pad->first_char;
+private->pattern[0]        = '\0';
+private->pattern_gen       = 0;
+private->state             = IFIND_IDLE;
+
+/***************************************************************
+*  Set up the find delimiter the same way dm_find does.
+***************************************************************/
+if (!private->reverse)
+   find_dlm = '/';
+else
+   if (dspl_descr->escape_char == '@')
+      find_dlm = '\\';
+   else
+      find_dlm = '?';
+
+snprintf(cmd, sizeof(cmd), "%c&'%s'%c", find_dlm, (private->reverse ? "Reverse find: " : "Find: "), find_dlm);
+*new_dmc = prompt_prescan(cmd, True, dspl_descr->escape_char);
+if ((*new_dmc == NULL) || (*new_dmc == DMC_COMMENT))
+   {
+      *new_dmc = NULL;
+      return(0);
+   }
+
+DEBUG2(fprintf(stderr, "dm_ifind: %s from [%d,%d]\n", (private->reverse ? "reverse" : "forward"), private->origin_line, private->origin_col);)
+private->active = True;
+return(0);
+
+} /* end of dm_ifind */
+
+
+/************************************************************************
+
+NAME:      ifind_active - Check if an incremental find is up
+
+PURPOSE:    This routine tells whether the Find: prompt from the ifind
+            command is still waiting for Enter.
+
+PARAMETERS:
+
+   1.  dspl_descr  - pointer to DISPLAY_DESCR (INPUT)
+                     This is the display to check.
+
+FUNCTIONS :
+
+   1.   Look at the private data.
+
+RETURNED VALUE:
+   active  -  int
+              True  -  An incremental find is up
+              False -  No incremental find
+
+*************************************************************************/
+
+int   ifind_active(DISPLAY_DESCR   *dspl_descr)         /* input  */
+{
+IFIND_PRIVATE        *private;
+
+if (!dspl_descr->find_data)
+   return(False);
+
+private = (IFIND_PRIVATE *)dspl_descr->find_data->ifind_private;
+return(private && private->active);
+
+} /* end of ifind_active */
+
+
+/************************************************************************
+
+NAME:      ifind_update - Restart the scan after the DM input line changed
+
+PURPOSE:    This routine is called after each keystroke while an
+            incremental find is up.  If the text in the DM input window
+            changed, the scan in progress is thrown away and a new one
+            is started.
+
+PARAMETERS:
+
+   1.  dspl_descr  - pointer to DISPLAY_DESCR (INPUT / OUTPUT)
+                     This is the display the find is done in.
+
+FUNCTIONS :
+
+   1.   If the prompt has been answered or cleared, stop.
+
+   2.   If the text did not change, do nothing.
+
+   3.   If the new text is the old text with more on the end, start
+        from the old match, or from where the old scan got to.
+        Otherwise start from the original cursor position.
+
+   4.   Scan for one time slice.
+
+RETURNED VALUE:
+   redraw -  The mask anded with the type of redraw needed is returned.
+
+*************************************************************************/
+
+int   ifind_update(DISPLAY_DESCR   *dspl_descr)         /* input / output */
+{
+IFIND_PRIVATE        *private;
+PAD_DESCR            *dminput_pad = dspl_descr->dminput_pad;
+char                 *line;
+int                   extends;
+int                   redraw_needed = 0;
+
+if (!ifind_active(dspl_descr))
+   return(0);
+private = (IFIND_PRIVATE *)dspl_descr->find_data->ifind_private;
+
+/***************************************************************
+*  Enter or abrt finished the prompt.  Enter has already put
+*  the find on the command list.
+***************************************************************/
+if (!prompt_in_progress(dspl_descr))
+   {
+      ifind_stop(dspl_descr, private);
+      if (hlmatch_stale(dspl_descr))
+         redraw_needed |= (MAIN_PAD_MASK & PARTIAL_REDRAW);
+      return(redraw_needed);
+   }
+
+if (dminput_pad->file_line_no != 0)
+   return(0);
+line = dminput_pad->buff_ptr;
+if (!line || (strcmp(line, private->pattern) == 0))
+   return(0);
+
+extends = (private->state != IFIND_IDLE) && (private->state != IFIND_ERROR) &&
+          pattern_extends(private->pattern, line, dspl_descr->escape_char);
+
+strncpy(private->pattern, line, MAX_LINE);
+private->pattern[MAX_LINE] = '\0';
+private->pattern_gen = 0;
+
+DEBUG2(fprintf(stderr, "ifind_update: \"%s\"%s\n", private->pattern, (extends ? " extends old pattern" : ""));)
+
+if (private->pattern[0] == '\0')
+   {
+      /***************************************************************
+      *  Everything was erased, go back to the start.
+      ***************************************************************/
+      private->state = IFIND_IDLE;
+      change_background_work(dspl_descr, BACKGROUND_IFIND, False);
+      if ((dspl_descr->main_pad->first_line != private->origin_first_line) ||
+          (dspl_descr->main_pad->first_char != private->origin_first_char))
+         {
+            dspl_descr->main_pad->first_line = private->origin_first_line;
+            dspl_descr->main_pad->first_char = private->origin_first_char;
+            redraw_needed |= (MAIN_PAD_MASK & FULL_REDRAW);
+         }
+      return(redraw_needed);
+   }
+
+if (extends && (private->state == IFIND_FOUND))
+   {
+      /***************************************************************
+      *  The new match cannot be before the old one.  Forward
+      *  from_col is exclusive and reverse to_col is exclusive.
+      ***************************************************************/
+      private->next_line = private->found_line;
+      private->next_col  = (private->reverse ? private->found_col + 1 : private->found_col - 1);
+   }
+else
+   if (extends && (private->state == IFIND_NOT_FOUND))
+      {
+         /***************************************************************
+         *  Still no match, but scan one empty spot so the new pattern
+         *  gets compiled for the highlighting.
+         ***************************************************************/
+         private->next_line = (private->reverse ? 0 : total_lines(dspl_descr->main_pad->token) - 1);
+         private->next_col  = (private->reverse ? 0 : MAX_LINE);
+      }
+   else
+      if (!extends || (private->state != IFIND_SCANNING))
+         {
+            private->next_line = private->origin_line;
+            private->next_col  = (private->reverse ? private->origin_col : private->origin_col - 1);
+         }
+      /* else scanning and extends, keep going from where the old scan got to */
+
+private->state = IFIND_SCANNING;
+redraw_needed |= ifind_scan(dspl_descr, private);
+
+return(redraw_needed);
+
+} /* end of ifind_update */
+
+
+/************************************************************************
+
+NAME:      ifind_continue - Scan the next time slice in background
+
+PURPOSE:    This routine is called from the background task code in
+            getevent.c while an incremental scan is not finished.
+
+PARAMETERS:
+
+   1.  dspl_descr  - pointer to DISPLAY_DESCR (INPUT / OUTPUT)
+                     This is the display the find is done in.
+
+FUNCTIONS :
+
+   1.   Scan for one time slice.
+
+RETURNED VALUE:
+   redraw -  The mask anded with the type of redraw needed is returned.
+
+*************************************************************************/
+
+int   ifind_continue(DISPLAY_DESCR   *dspl_descr)       /* input / output */
+{
+IFIND_PRIVATE        *private;
+
+if (!ifind_active(dspl_descr))
+   {
+      change_background_work(dspl_descr, BACKGROUND_IFIND, False);
+      return(0);
+   }
+
+private = (IFIND_PRIVATE *)dspl_descr->find_data->ifind_private;
+return(ifind_scan(dspl_descr, private));
+
+} /* end of ifind_continue */
+
+
+/************************************************************************
+
+NAME:      ifind_cancel - Put the main window back and stop the incremental find
+
+PURPOSE:    This routine is called by the abrt command.  The main window
+            is put back the way it was when the ifind command was entered.
+
+PARAMETERS:
+
+   1.  dspl_descr  - pointer to DISPLAY_DESCR (INPUT / OUTPUT)
+                     This is the display the find is done in.
+
+FUNCTIONS :
+
+   1.   Put back the main window position and cursor.
+
+   2.   Turn off the incremental find.
+
+RETURNED VALUE:
+   redraw -  The mask anded with the type of redraw needed is returned.
+
+*************************************************************************/
+
+int   ifind_cancel(DISPLAY_DESCR   *dspl_descr)         /* input / output */
+{
+IFIND_PRIVATE        *private;
+PAD_DESCR            *main_pad = dspl_descr->main_pad;
+
+if (!ifind_active(dspl_descr))
+   return(0);
+private = (IFIND_PRIVATE *)dspl_descr->find_data->ifind_private;
+
+if (main_pad->buff_modified)
+   flush(main_pad);
+main_pad->first_line   = private->origin_first_line;
+main_pad->first_char   = private->origin_first_char;
+main_pad->file_line_no = private->origin_line;
+main_pad->file_col_no  = private->origin_col;
+main_pad->buff_ptr     = get_line_by_num(main_pad->token, main_pad->file_line_no);
+
+ifind_stop(dspl_descr, private);
+
+return(MAIN_PAD_MASK & FULL_REDRAW);
+
+} /* end of ifind_cancel */
+
+
+/************************************************************************
+
+NAME:      get_ifind_private - Get the incremental find data, allocating it if needed
+
+PURPOSE:    This routine returns the incremental find data hung off the
+            find data.  It is created the first time it is needed.
+
+PARAMETERS:
+
+   1.  find_data   - pointer to FIND_DATA (INPUT / OUTPUT)
+                     This is the find data for the display.
+
+FUNCTIONS :
+
+   1.   If the data exists, return it.
+
+   2.   Otherwise malloc and clear it.
+
+RETURNED VALUE:
+   private -  pointer to IFIND_PRIVATE
+              NULL is returned if the malloc fails.
+
+*************************************************************************/
+
+static IFIND_PRIVATE *get_ifind_private(FIND_DATA   *find_data)
+{
+IFIND_PRIVATE        *private;
+
+if (find_data->ifind_private)
+   return((IFIND_PRIVATE *)find_data->ifind_private);
+
+private = (IFIND_PRIVATE *)CE_MALLOC(sizeof(IFIND_PRIVATE));
+if (!private)
+   return(NULL);
+
+memset((char *)private, 0, sizeof(IFIND_PRIVATE));
+find_data->ifind_private = (void *)private;
+return(private);
+
+} /* end of get_ifind_private */
+
+
+/************************************************************************
+
+NAME:      ifind_scan - Scan for the pattern for one time slice
+
+PURPOSE:    This routine searches IFIND_SLICE_LINES lines at a time from
+            where the scan got to until the pattern is found, the file
+            is done, or the time slice is used up.
+
+PARAMETERS:
+
+   1.  dspl_descr  - pointer to DISPLAY_DESCR (INPUT / OUTPUT)
+                     This is the display the find is done in.
+
+   2.  private     - pointer to IFIND_PRIVATE (INPUT / OUTPUT)
+                     This is the scan state.
+
+FUNCTIONS :
+
+   1.   Search the next batch of lines.  The first search passes the
+        pattern to compile it, after that the compiled pattern is used.
+
+   2.   If found, move the main window to show the match.
+
+   3.   If the file is done, put the main window back.
+
+   4.   If time is up, make sure the background work is on.
+
+RETURNED VALUE:
+   redraw -  The mask anded with the type of redraw needed is returned.
+
+*************************************************************************/
+
+static int  ifind_scan(DISPLAY_DESCR   *dspl_descr,
+                       IFIND_PRIVATE   *private)
+{
+PAD_DESCR            *main_pad = dspl_descr->main_pad;
+BUFF_DESCR            scratch_buff;
+char                 *pattern;
+int                   from_line;
+int                   to_line;
+int                   to_col;
+int                   found_line;
+int                   found_col;
+int                   dummy_parm;
+int                   all_data_read;
+int                   batches = 0;
+int                   redraw_needed = 0;
+#ifndef WIN32
+struct timeval        start_time;
+struct timeval        now;
+
+gettimeofday(&start_time, NULL);
+#endif
+
+while (private->state == IFIND_SCANNING)
+{
+   if (private->pattern_gen && (private->pattern_gen == pattern_generation(dspl_descr->find_data->search_private)))
+      pattern = NULL;  /* use the compiled pattern */
+   else
+      pattern = private->pattern;
+
+   found_line = DM_FIND_NOT_FOUND;
+   if (!private->reverse)
+      {
+         if (private->next_line < 0)
+            private->next_line = 0;
+         to_line = private->next_line + IFIND_SLICE_LINES - 1;
+         all_data_read = load_enough_data(to_line + 1);
+         if (to_line >= total_lines(main_pad->token))
+            to_line = total_lines(main_pad->token) - 1;
+         if (private->next_line > to_line)
+            {
+               if (all_data_read)
+                  private->state = IFIND_NOT_FOUND;
+               break;
+            }
+         to_col = MAX_LINE+1;
+         search(main_pad->token,
+                private->next_line,
+                private->next_col,
+                to_line,
+                &to_col, /* pass by reference */
+                False,
+                pattern,
+                NULL,   /* no substitute string */
+                !dspl_descr->case_sensitive,
+                &found_line,
+                &found_col,
+                &dummy_parm,
+                0 /* not rectangular */,
+                0 /* not rectangular */,
+                0 /* not rectangular */,
+                NULL /* not in substitute mode */,
+                0 /* not substitute once */,
+                dspl_descr->escape_char,
+                &dspl_descr->find_data->search_private);
+         private->next_line = to_line + 1;
+         private->next_col  = -1;
+      }
+   else
+      {
+         if (private->next_line >= total_lines(main_pad->token))
+            {
+               private->next_line = total_lines(main_pad->token) - 1;
+               private->next_col  = MAX_LINE+1;
+            }
+         if (private->next_line < 0)
+            {
+               private->state = IFIND_NOT_FOUND;
+               break;
+            }
+         from_line = private->next_line - IFIND_SLICE_LINES + 1;
+         if (from_line < 0)
+            from_line = 0;
+         to_col = private->next_col;
+         search(main_pad->token,
+                from_line,
+                0,
+                private->next_line,
+                &to_col, /* pass by reference */
+                True,
+                pattern,
+                NULL,   /* no substitute string */
+                !dspl_descr->case_sensitive,
+                &found_line,
+                &found_col,
+                &dummy_parm,
+                0 /* not rectangular */,
+                0 /* not rectangular */,
+                0 /* not rectangular */,
+                NULL /* not in substitute mode */,
+                0 /* not substitute once */,
+                dspl_descr->escape_char,
+                &dspl_descr->find_data->search_private);
+         private->next_line = from_line - 1;
+         private->next_col  = MAX_LINE+1;
+      }
+
+   if (pattern)
+      private->pattern_gen = pattern_generation(dspl_descr->find_data->search_private);
+   batches++;
+
+   if (found_line == DM_FIND_ERROR)
+      private->state = IFIND_ERROR;
+   else
+      if (found_line >= 0)
+         {
+            private->state      = IFIND_FOUND;
+            private->found_line = found_line;
+            private->found_col  = found_col;
+         }
+      else
+         if (private->reverse && (private->next_line < 0))
+            private->state = IFIND_NOT_FOUND;
+
+#ifndef WIN32
+   gettimeofday(&now, NULL);
+   if ((((now.tv_sec - start_time.tv_sec) * 1000000) + (now.tv_usec - start_time.tv_usec)) >= IFIND_SLICE_USECS)
+      break;
+#else
+   if (batches >= 4)
+      break;
+#endif
+}
+
+DEBUG2(fprintf(stderr, "ifind_scan: %d batches, state %d, next line %d\n", batches, private->state, private->next_line);)
+
+change_background_work(dspl_descr, BACKGROUND_IFIND, (private->state == IFIND_SCANNING));
+
+if (private->state == IFIND_FOUND)
+   {
+      /***************************************************************
+      *  Move the main window to the match.  The cursor stays in
+      *  the DM input window, so position a copy of the cursor buff.
+      ***************************************************************/
+      memcpy((char *)&scratch_buff, (char *)dspl_descr->cursor_buff, sizeof(BUFF_DESCR));
+      redraw_needed |= dm_position(&scratch_buff, main_pad, private->found_line, private->found_col);
+   }
+else
+   if (private->state == IFIND_NOT_FOUND)
+      {
+         dm_error("No match", DM_ERROR_MSG);
+         if ((main_pad->first_line != private->origin_first_line) ||
+             (main_pad->first_char != private->origin_first_char))
+            {
+               main_pad->first_line = private->origin_first_line;
+               main_pad->first_char = private->origin_first_char;
+               redraw_needed |= (MAIN_PAD_MASK & FULL_REDRAW);
+            }
+      }
+
+if (hlmatch_stale(dspl_descr))
+   redraw_needed |= (MAIN_PAD_MASK & PARTIAL_REDRAW);
+
+return(redraw_needed);
+
+} /* end of ifind_scan */
+
+
+/************************************************************************
+
+NAME:      ifind_stop - Turn off the incremental find
+
+PURPOSE:    This routine clears the active flag and stops any scan
+            still going in background.
+
+PARAMETERS:
+
+   1.  dspl_descr  - pointer to DISPLAY_DESCR (INPUT / OUTPUT)
+                     This is the display the find is done in.
+
+   2.  private     - pointer to IFIND_PRIVATE (INPUT / OUTPUT)
+                     This is the scan state.
+
+FUNCTIONS :
+
+   1.   Clear the flags.
+
+*************************************************************************/
+
+static void ifind_stop(DISPLAY_DESCR   *dspl_descr,
+                       IFIND_PRIVATE   *private)
+{
+
+DEBUG2(fprintf(stderr, "ifind_stop: \"%s\"\n", private->pattern);)
+private->active = False;
+private->state  = IFIND_IDLE;
+change_background_work(dspl_descr, BACKGROUND_IFIND, False);
+
+} /* end of ifind_stop */
+
+
+/************************************************************************
+
+NAME:      pattern_extends - Check if every match of a new pattern is a match of the old one
+
+PURPOSE:    This routine checks whether the new pattern is the old one
+            with more added to the end in a way that any match of the
+            new pattern starts with a match of the old one.  If so, the
+            scan for the new pattern does not have to look at anything
+            the old scan already passed.
+
+PARAMETERS:
+
+   1.  old_pattern - pointer to char (INPUT)
+                     The pattern last scanned for.
+
+   2.  new_pattern - pointer to char (INPUT)
+                     The pattern now in the DM input window.
+
+   3.  escape_char - char (INPUT)
+                     The escape character for the display.
+
+FUNCTIONS :
+
+   1.   The old pattern must be a prefix of the new one.
+
+   2.   The old pattern must not end in the middle of a [] class or an
+        escape, or with a $.
+
+   3.   The added text must not start with something which changes
+        what came before, like * or a \ sequence.
+
+RETURNED VALUE:
+   extends -  int
+              True  -  The old scan results can be reused
+              False -  The scan must start over
+
+*************************************************************************/
+
+static int  pattern_extends(char   *old_pattern,
+                            char   *new_pattern,
+                            char    escape_char)
+{
+int                   len = strlen(old_pattern);
+int                   in_class = False;
+char                 *p;
+
+if ((len == 0) || (strncmp(old_pattern, new_pattern, len) != 0))
+   return(False);
+
+for (p = old_pattern; *p; p++)
+{
+   if ((*p == '\\') || (*p == escape_char))
+      {
+         if (*(p+1) == '\0')
+            return(False);
+         p++;
+      }
+   else
+      if ((*p == '[') && !in_class)
+         {
+            in_class = True;
+            if (*(p+1) == '^')
+               p++;
+            if (*(p+1) == ']')
+               p++;  /* leading ] is part of the class */
+         }
+      else
+         if (*p == ']')
+            in_class = False;
+         else
+            if (*p == '|')
+               return(False);
+}
+
+if (in_class || (old_pattern[len-1] == '$') || (old_pattern[len-1] == '%'))
+   return(False);
+
+if (strchr("*+?{}@%\\", new_pattern[len]) || (new_pattern[len] == escape_char))
+   return(False);
+
+return(True);
+
+} /* end of pattern_extends */
+
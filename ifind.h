@@ -0,0 +1,60 @@
+#ifndef _IFIND_INCLUDED
+#define _IFIND_INCLUDED
+
+/* "%Z% %M% %I% - %G% %U% " */
+
+/***************************************************************
+*  
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*  
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*  
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*  
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*  
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*  
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in ifind.c
+*     dm_ifind                - Start an incremental find (ifind command)
+*     ifind_active            - Check if an incremental find is up
+*     ifind_update            - Restart the scan after the DM input line changed
+*     ifind_continue          - Scan the next time slice in background
+*     ifind_cancel            - Put the main window back and stop the incremental find
+*
+***************************************************************/
+
+#include "dmc.h"
+#include "buffer.h"
+
+int   dm_ifind(DMC             *dmc,                    /* input  */
+               DISPLAY_DESCR   *dspl_descr,             /* input / output */
+               DMC            **new_dmc);               /* output */
+
+int   ifind_active(DISPLAY_DESCR   *dspl_descr);        /* input  */
+
+int   ifind_update(DISPLAY_DESCR   *dspl_descr);        /* input / output */
+
+int   ifind_continue(DISPLAY_DESCR   *dspl_descr);      /* input / output */
+
+int   ifind_cancel(DISPLAY_DESCR   *dspl_descr);        /* input / output */
+
+
+#endif
+
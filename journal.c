@@ -0,0 +1,944 @@
+/*static char *sccsid = "%Z% %M% %I% - %G% %U% ";*/
+/***************************************************************
+*
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in journal.c
+*     journal_open            - Start the journal for the edit file, or replay it
+*     journal_put             - Record a put_line_by_num
+*     journal_delete          - Record a delete_line_by_num
+*     journal_commit          - Write and sync the queued records
+*     journal_timeout         - Microseconds till the next group commit
+*     journal_reset           - Start over after the file is written or reloaded
+*     journal_checkpoint      - Start over after an autosave image is written
+*     journal_mark            - Where the journal is now, for journal_rebase
+*     journal_rebase          - Start over after a background pw, keeping later records
+*     journal_close           - Remove the journal on a clean exit
+*     journal_active          - Is a journal being kept
+*     journal_missing         - Is a journal wanted but not being kept
+*
+*  Internal routines:
+*     journal_start           - Create an empty journal for the edit file
+*     journal_replay          - Apply the records in a journal to the file
+*     journal_queue           - Add a record to the queue
+*     journal_write           - Write out the queue
+*     journal_fail            - Give up on the journal after an I/O error
+*     journal_sum             - Check sum of a record
+*
+*  The journal is a header followed by records.  The header holds
+*  the size and modify time of the edit file when the journal was
+*  started, so it is only replayed over the file it was made from.
+*  When an autosave image is written, the journal starts over and
+*  the header also holds the image serial number.  Such a journal
+*  is only replayed over that image.
+*  Each record is the put_line_by_num or delete_line_by_num call
+*  memdata was given, with the text of the line.  Everything else
+*  which changes lines, undo and redo included, comes down to
+*  these two calls, so replaying them in order over the same file
+*  gives the same lines.
+*
+*  Records are queued in a static buffer and written when it
+*  fills or when journal_commit runs.  journal_commit also syncs
+*  the file.  It is called from timeout_set once the oldest
+*  unsynced record is JOURNAL_COMMIT_USECS old, so a burst of
+*  typing costs one sync.  No memory is allocated after the
+*  journal is open, so committing from the crash routines is
+*  safe when malloc has failed.
+*
+*  A record carries a check sum.  Replay stops at the first
+*  record which is short or does not check, which is where a
+*  crash in the middle of a write leaves the tail.
+*
+***************************************************************/
+
+#include <stdio.h>          /* /usr/include/stdio.h      */
+#include <string.h>         /* /usr/include/string.h     */
+#include <errno.h>          /* /usr/include/errno.h      */
+#include <stdlib.h>         /* /usr/include/stdlib.h     */
+#include <sys/types.h>      /* /usr/include/sys/types.h  */
+#include <sys/stat.h>       /* /usr/include/sys/stat.h   */
+#include <fcntl.h>          /* /usr/include/fcntl.h      */
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>         /* /usr/include/unistd.h     */
+#include <sys/time.h>       /* /usr/include/sys/time.h   */
+#endif
+
+#include "debug.h"
+#include "dmwin.h"
+#include "emalloc.h"
+#include "journal.h"
+#include "memdata.h"
+
+#ifndef MAXPATHLEN
+#define MAXPATHLEN	1024
+#endif
+
+#ifdef WIN32
+#define fsync(fd)          _commit(fd)
+#define ftruncate(fd, len) _chsize(fd, len)
+#endif
+
+/***************************************************************
+*
+*  JOURNAL_COMMIT_USECS is how long a record may wait to be
+*  synced.  JOURNAL_BUF_SIZE is the size of the queue, a full
+*  queue is written without waiting for the commit.
+*
+***************************************************************/
+
+#define JOURNAL_COMMIT_USECS  500000
+#define JOURNAL_BUF_SIZE      32768
+
+#define JOURNAL_MAGIC         "CeJrnl1\n"
+
+#define JOURNAL_INSERT        1
+#define JOURNAL_OVERWRITE     2
+#define JOURNAL_DELETE        3
+
+typedef struct {
+   char            magic[8];       /* JOURNAL_MAGIC                             */
+   long            size;           /* edit file size, -1 for a new file         */
+   long            mtime;          /* edit file modify time                     */
+   long            image;          /* autosave image serial, 0 for the file     */
+} JOURNAL_HEADER;
+
+typedef struct {
+   int             op;             /* JOURNAL_INSERT, _OVERWRITE or _DELETE     */
+   int             line_no;        /* as passed to memdata                      */
+   int             len;            /* bytes of text following, no null         */
+   unsigned int    check;          /* journal_sum of the rest and the text      */
+} JOURNAL_REC;
+
+static int            jfd = -1;                 /* the open journal, -1 for none   */
+static int            jwanted = False;          /* journal_open was called         */
+static DATA_TOKEN    *jtoken = NULL;            /* the main pad being journaled    */
+static char           jname[MAXPATHLEN+8];      /* <edit_file>.CEJ                 */
+static JOURNAL_HEADER jheader;                  /* as written at the front         */
+static char           jbuf[JOURNAL_BUF_SIZE];   /* records not written yet         */
+static int            jused = 0;                /* bytes used in jbuf              */
+static int            jpending = False;         /* records not synced yet          */
+#ifndef WIN32
+static struct timeval jfirst;                   /* when jpending was set           */
+#endif
+
+/***************************************************************
+*
+*  Prototypes for local routines
+*
+***************************************************************/
+
+static void  journal_start(DATA_TOKEN      *token,
+                           char            *edit_file);
+
+static void  journal_replay(DATA_TOKEN      *token,
+                            char            *edit_file,
+                            long             image);
+
+static void  journal_queue(JOURNAL_REC     *rec,
+                           char            *text);
+
+static int   journal_write(char            *data,
+                           int              len);
+
+static void  journal_fail(char            *what);
+
+static unsigned int journal_sum(JOURNAL_REC     *rec,
+                                char            *text);
+
+
+/************************************************************************
+
+NAME:      journal_open  - Start the journal for the edit file, or replay it
+
+PURPOSE:    This routine is called once the main pad is set up.  It starts
+            an empty journal for the file.  If a journal with records is
+            already there, a session editing the file did not end cleanly.
+            With -recover its records are replayed and the session carries
+            on adding to it.  Otherwise it is left alone for a later
+            -recover and this session keeps no journal, which the
+            titlebar shows (journal_missing).  A crash then makes the
+            crash file as it does without -journal.
+
+PARAMETERS:
+
+   1.  token      -  pointer to DATA_TOKEN (INPUT / OUTPUT)
+                     The main pad memdata.  For a replay it must be fully
+                     loaded.
+
+   2.  edit_file  -  pointer to char (INPUT)
+                     The file being edited.
+
+   3.  recover    -  int (INPUT)
+                     True if -recover was specified.
+
+   4.  image      -  long (INPUT)
+                     The serial number of the autosave image -recover
+                     loaded, zero if the file was loaded.
+
+*************************************************************************/
+
+void  journal_open(DATA_TOKEN      *token,             /* input / output */
+                   char            *edit_file,         /* input  */
+                   int              recover,           /* input  */
+                   long             image)             /* input  */
+{
+struct stat       file_stats;
+char              msg[MAXPATHLEN+128];
+
+snprintf(jname, sizeof(jname), "%s%s", edit_file, JOURNAL_SUFFIX);
+jwanted = True;
+
+if ((stat(jname, &file_stats) == 0) && (file_stats.st_size > (off_t)sizeof(JOURNAL_HEADER)))
+   {
+      if (recover)
+         journal_replay(token, edit_file, image);
+      else
+         {
+            snprintf(msg, sizeof(msg), "%s holds changes from a session which did not end, use ce -recover to replay them, this session is not journaled", jname);
+            dm_error(msg, DM_ERROR_BEEP);
+         }
+      return;
+   }
+
+if (recover)
+   {
+      snprintf(msg, sizeof(msg), "(recover) No changes to recover in %s", jname);
+      dm_error(msg, DM_ERROR_MSG);
+   }
+
+jheader.image = image;
+journal_start(token, edit_file);
+
+} /* end of journal_open */
+
+
+/************************************************************************
+
+NAME:      journal_put  - Record a put_line_by_num
+
+PURPOSE:    This routine is called by put_line_by_num for the journaled
+            token, after long lines have been wrapped, with the line it
+            is about to insert or overwrite.
+
+*************************************************************************/
+
+void  journal_put(DATA_TOKEN      *token,             /* input  */
+                  int              line_no,           /* input  */
+                  char            *line,              /* input  */
+                  int              flag)              /* input  */
+{
+JOURNAL_REC       rec;
+
+if ((token != jtoken) || (jfd < 0))
+   return;
+
+rec.op      = (flag == INSERT) ? JOURNAL_INSERT : JOURNAL_OVERWRITE;
+rec.line_no = line_no;
+rec.len     = strlen(line);
+journal_queue(&rec, line);
+
+} /* end of journal_put */
+
+
+/************************************************************************
+
+NAME:      journal_delete  - Record a delete_line_by_num
+
+*************************************************************************/
+
+void  journal_delete(DATA_TOKEN      *token,             /* input  */
+                     int              line_no)           /* input  */
+{
+JOURNAL_REC       rec;
+
+if ((token != jtoken) || (jfd < 0))
+   return;
+
+rec.op      = JOURNAL_DELETE;
+rec.line_no = line_no;
+rec.len     = 0;
+journal_queue(&rec, NULL);
+
+} /* end of journal_delete */
+
+
+/************************************************************************
+
+NAME:      journal_commit  - Write and sync the queued records
+
+PURPOSE:    This routine makes everything recorded so far safe on disk.
+            It is called when the commit timer runs out and from
+            create_crash_file.
+
+*************************************************************************/
+
+void  journal_commit(void)
+{
+
+if (jfd < 0)
+   return;
+
+if (jused)
+   {
+      if (!journal_write(jbuf, jused))
+         return;
+      jused = 0;
+   }
+
+if (jpending)
+   {
+      if (fsync(jfd) != 0)
+         {
+            journal_fail("sync");
+            return;
+         }
+      jpending = False;
+      DEBUG1(fprintf(stderr, "journal_commit: %s synced\n", jname);)
+   }
+
+} /* end of journal_commit */
+
+
+/************************************************************************
+
+NAME:      journal_timeout  - Microseconds till the next group commit
+
+PURPOSE:    This routine is called from timeout_set each time around the
+            wait for input.  If the oldest unsynced record has waited
+            long enough, the commit is done.
+
+RETURNED VALUE:
+   usecs   -   int
+               The microseconds till the commit is due, zero if nothing
+               is waiting.
+
+*************************************************************************/
+
+int   journal_timeout(void)
+{
+#ifndef WIN32
+struct timeval    now;
+long              waited;
+#endif
+
+if ((jfd < 0) || !jpending)
+   return(0);
+
+#ifdef WIN32
+journal_commit();
+return(0);
+#else
+gettimeofday(&now, NULL);
+waited = ((now.tv_sec - jfirst.tv_sec) * 1000000) + (now.tv_usec - jfirst.tv_usec);
+if ((waited >= JOURNAL_COMMIT_USECS) || (waited < 0))
+   {
+      journal_commit();
+      return(0);
+   }
+
+return(JOURNAL_COMMIT_USECS - waited);
+#endif
+
+} /* end of journal_timeout */
+
+
+/************************************************************************
+
+NAME:      journal_reset  - Start over after the file is written or reloaded
+
+PURPOSE:    Once the memory copy matches the file on disk, the records so
+            far are not needed.  The journal is thrown away and a new one
+            started from the file as it is now.  This is also where a pad
+            name change moves the journal to the new name.
+
+PARAMETERS:
+
+   1.  token      -  pointer to DATA_TOKEN (INPUT / OUTPUT)
+                     The main pad memdata, a reload gives a new one.
+
+   2.  edit_file  -  pointer to char (INPUT)
+                     The file being edited.
+
+*************************************************************************/
+
+void  journal_reset(DATA_TOKEN      *token,             /* input / output */
+                    char            *edit_file)         /* input  */
+{
+
+if (jfd < 0)
+   return;
+
+close(jfd);
+jfd = -1;
+unlink(jname);
+jused = 0;
+jpending = False;
+
+snprintf(jname, sizeof(jname), "%s%s", edit_file, JOURNAL_SUFFIX);
+jheader.image = 0;
+journal_start(token, edit_file);
+
+} /* end of journal_reset */
+
+
+/************************************************************************
+
+NAME:      journal_checkpoint  - Start over after an autosave image is written
+
+PURPOSE:    An autosave image holds every change made so far, so the
+            records are not needed.  The journal is cut back to its header,
+            which now names the image.  This is called after the image is
+            synced, a crash in between leaves a journal which does not match
+            the image and is not replayed, which loses nothing.
+
+PARAMETERS:
+
+   1.  image      -  long (INPUT)
+                     The serial number of the image written.
+
+*************************************************************************/
+
+void  journal_checkpoint(long             image)           /* input  */
+{
+
+if (jfd < 0)
+   return;
+
+jused = 0;
+jpending = False;
+jheader.image = image;
+
+if ((ftruncate(jfd, 0) != 0) || (lseek(jfd, 0, SEEK_SET) < 0))
+   {
+      journal_fail("truncate");
+      return;
+   }
+
+if (!journal_write((char *)&jheader, sizeof(jheader)))
+   return;
+
+if (fsync(jfd) != 0)
+   journal_fail("sync");
+
+} /* end of journal_checkpoint */
+
+
+/************************************************************************
+
+NAME:      journal_mark  - Where the journal is now, for journal_rebase
+
+PURPOSE:    A background pw writes the buffer as it is when the pw is done.
+            This routine returns how far the journal has got at that
+            point, queued records included.
+
+RETURNED VALUE:
+   mark    -   long
+               The offset the next record will go at, -1 if no journal
+               is being kept.
+
+*************************************************************************/
+
+long  journal_mark(void)
+{
+long              end;
+
+if (jfd < 0)
+   return(-1);
+
+end = lseek(jfd, 0, SEEK_END);
+if (end < 0)
+   return(-1);
+
+return(end + jused);
+
+} /* end of journal_mark */
+
+
+/************************************************************************
+
+NAME:      journal_rebase  - Start over after a background pw, keeping later records
+
+PURPOSE:    When a background pw finishes, the file on disk holds every
+            change up to the mark, but the changes made while it was being
+            written are only in the journal.  A new journal is started from
+            the file with just the records after the mark.  It is written
+            beside the old one and renamed over it, so a crash at any point
+            leaves a journal which matches the file it names.
+
+PARAMETERS:
+
+   1.  edit_file  -  pointer to char (INPUT)
+                     The file just written.
+
+   2.  mark       -  long (INPUT)
+                     From journal_mark when the pw was started.
+
+*************************************************************************/
+
+void  journal_rebase(char            *edit_file,         /* input  */
+                     long             mark)              /* input  */
+{
+#ifndef WIN32
+long              end;
+long              len;
+char             *records = NULL;
+int               fd;
+int               old_fd;
+char              new_name[MAXPATHLEN+16];
+struct stat       file_stats;
+int               rc;
+
+if (jfd < 0)
+   return;
+
+journal_commit();
+if (jfd < 0)
+   return;
+
+end = lseek(jfd, 0, SEEK_END);
+len = end - mark;
+if ((mark < (long)sizeof(jheader)) || (len < 0))
+   {
+      errno = EINVAL;
+      journal_fail("rebase");
+      return;
+   }
+
+if (len > 0)
+   {
+      records = CE_MALLOC(len);
+      if (!records)
+         {
+            journal_fail("rebase");
+            return;
+         }
+      if (pread(jfd, records, len, mark) != len)
+         {
+            free(records);
+            journal_fail("read");
+            return;
+         }
+   }
+
+if (stat(edit_file, &file_stats) == 0)
+   {
+      jheader.size  = file_stats.st_size;
+      jheader.mtime = file_stats.st_mtime;
+   }
+else
+   {
+      jheader.size  = -1;
+      jheader.mtime = 0;
+   }
+jheader.image = 0;
+
+snprintf(new_name, sizeof(new_name), "%s.new", jname);
+fd = open(new_name, O_RDWR | O_CREAT | O_TRUNC, 0600);
+if (fd < 0)
+   {
+      if (records)
+         free(records);
+      journal_fail("create");
+      return;
+   }
+
+old_fd = jfd;
+jfd = fd; /* journal_write writes to jfd */
+rc = journal_write((char *)&jheader, sizeof(jheader)) && ((len == 0) || journal_write(records, len));
+if (records)
+   free(records);
+if (!rc)
+   {
+      /* journal_fail closed the new one and removed jname */
+      close(old_fd);
+      unlink(new_name);
+      return;
+   }
+
+if ((fsync(jfd) != 0) || (rename(new_name, jname) != 0))
+   {
+      close(old_fd);
+      unlink(new_name);
+      journal_fail("rename");
+      return;
+   }
+
+close(old_fd);
+DEBUG1(fprintf(stderr, "journal_rebase: %s restarted with %ld bytes of records\n", jname, len);)
+#else
+journal_reset(jtoken, edit_file);
+#endif
+
+} /* end of journal_rebase */
+
+
+/************************************************************************
+
+NAME:      journal_close  - Remove the journal on a clean exit
+
+*************************************************************************/
+
+void  journal_close(void)
+{
+
+if (jfd < 0)
+   return;
+
+close(jfd);
+jfd = -1;
+unlink(jname);
+jtoken = NULL;
+jwanted = False;
+
+} /* end of journal_close */
+
+
+/************************************************************************
+
+NAME:      journal_active  - Is a journal being kept
+
+*************************************************************************/
+
+int   journal_active(void)
+{
+
+return(jfd >= 0);
+
+} /* end of journal_active */
+
+
+/************************************************************************
+
+NAME:      journal_missing  - Is a journal wanted but not being kept
+
+PURPOSE:    This routine is called when the titlebar is drawn.  It is
+            True when -journal or -recover asked for a journal and there
+            is none, because an old journal was in the way or writing the
+            journal failed.
+
+*************************************************************************/
+
+int   journal_missing(void)
+{
+
+return(jwanted && (jfd < 0));
+
+} /* end of journal_missing */
+
+
+/************************************************************************
+
+NAME:      journal_start  - Create an empty journal for the edit file
+
+*************************************************************************/
+
+static void  journal_start(DATA_TOKEN      *token,
+                           char            *edit_file)
+{
+struct stat       file_stats;
+char              msg[MAXPATHLEN+128];
+
+memcpy(jheader.magic, JOURNAL_MAGIC, sizeof(jheader.magic));
+if (stat(edit_file, &file_stats) == 0)
+   {
+      jheader.size  = file_stats.st_size;
+      jheader.mtime = file_stats.st_mtime;
+   }
+else
+   {
+      jheader.size  = -1;
+      jheader.mtime = 0;
+   }
+
+jfd = open(jname, O_RDWR | O_CREAT | O_TRUNC, 0600);
+if (jfd < 0)
+   {
+      snprintf(msg, sizeof(msg), "Cannot create journal %s (%s), changes are not journaled", jname, strerror(errno));
+      dm_error(msg, DM_ERROR_LOG);
+      return;
+   }
+
+if (!journal_write((char *)&jheader, sizeof(jheader)))
+   return;
+
+jtoken = token;
+token->journaled = True;
+
+DEBUG1(fprintf(stderr, "journal_start: %s\n", jname);)
+
+} /* end of journal_start */
+
+
+/************************************************************************
+
+NAME:      journal_replay  - Apply the records in a journal to the file
+
+PURPOSE:    This routine does the -recover.  The journal is only used if
+            the edit file is the size and age it was when the journal was
+            started, and the autosave image loaded is the one it was
+            started from.  Records are applied until the end or the first
+            one which does not check.  The journal is cut back to the records
+            used and kept open, so the recovered changes stay journaled
+            until the file is written.
+
+*************************************************************************/
+
+static void  journal_replay(DATA_TOKEN      *token,
+                            char            *edit_file,
+                            long             image)
+{
+JOURNAL_HEADER    header;
+JOURNAL_REC       rec;
+struct stat       file_stats;
+struct stat       journal_stats;
+char              msg[MAXPATHLEN+128];
+char             *data;
+char             *text;
+char              hold;
+long              size;
+long              pos;
+int               fd;
+int               count = 0;
+
+fd = open(jname, O_RDWR);
+if ((fd < 0) || (fstat(fd, &journal_stats) != 0) ||
+    (read(fd, (char *)&header, sizeof(header)) != sizeof(header)) ||
+    (memcmp(header.magic, JOURNAL_MAGIC, sizeof(header.magic)) != 0))
+   {
+      snprintf(msg, sizeof(msg), "(recover) %s is not a journal", jname);
+      dm_error(msg, DM_ERROR_BEEP);
+      if (fd >= 0)
+         close(fd);
+      return;
+   }
+
+if (stat(edit_file, &file_stats) != 0)
+   {
+      file_stats.st_size  = -1;
+      file_stats.st_mtime = 0;
+   }
+if ((header.size != (long)file_stats.st_size) || ((header.size >= 0) && (header.mtime != (long)file_stats.st_mtime)))
+   {
+      snprintf(msg, sizeof(msg), "(recover) %s has changed since %s was started, not replayed", edit_file, jname);
+      dm_error(msg, DM_ERROR_BEEP);
+      close(fd);
+      return;
+   }
+
+if (header.image != image)
+   {
+      snprintf(msg, sizeof(msg), "(recover) %s does not follow the %s loaded, not replayed", jname, (image ? "autosave image" : "file"));
+      dm_error(msg, DM_ERROR_BEEP);
+      close(fd);
+      return;
+   }
+
+size = journal_stats.st_size - sizeof(header);
+data = CE_MALLOC(size + 1);
+if (!data || (read(fd, data, size) != size))
+   {
+      snprintf(msg, sizeof(msg), "(recover) Cannot read %s (%s)", jname, strerror(errno));
+      dm_error(msg, DM_ERROR_BEEP);
+      if (data)
+         free(data);
+      close(fd);
+      return;
+   }
+
+pos = 0;
+while (pos + (long)sizeof(rec) <= size)
+{
+   memcpy((char *)&rec, data + pos, sizeof(rec));
+   if ((rec.len < 0) || (pos + (long)sizeof(rec) + rec.len > size))
+      break;
+   text = data + pos + sizeof(rec);
+   if (journal_sum(&rec, text) != rec.check)
+      break;
+
+   if (rec.op == JOURNAL_DELETE)
+      delete_line_by_num(token, rec.line_no, 1);
+   else
+      {
+         /* the next record follows the text, save its first byte over the null */
+         hold = text[rec.len];
+         text[rec.len] = '\0';
+         put_line_by_num(token, rec.line_no, text, ((rec.op == JOURNAL_INSERT) ? INSERT : OVERWRITE));
+         text[rec.len] = hold;
+      }
+
+   pos += sizeof(rec) + rec.len;
+   count++;
+}
+
+free(data);
+
+if ((ftruncate(fd, sizeof(header) + pos) != 0) || (lseek(fd, 0, SEEK_END) < 0))
+   {
+      snprintf(msg, sizeof(msg), "(recover) Cannot trim %s (%s)", jname, strerror(errno));
+      dm_error(msg, DM_ERROR_LOG);
+   }
+
+jfd = fd;
+jheader = header;
+jtoken = token;
+token->journaled = True;
+if (count)
+   dirty_bit(token) = True;
+
+snprintf(msg, sizeof(msg), "(recover) %d changes replayed from %s%s", count, jname, ((pos < size) ? ", damaged tail dropped" : ""));
+dm_error(msg, DM_ERROR_MSG);
+
+} /* end of journal_replay */
+
+
+/************************************************************************
+
+NAME:      journal_queue  - Add a record to the queue
+
+*************************************************************************/
+
+static void  journal_queue(JOURNAL_REC     *rec,
+                           char            *text)
+{
+
+rec->check = journal_sum(rec, text);
+
+if (jused + sizeof(JOURNAL_REC) + rec->len > sizeof(jbuf))
+   {
+      if (!journal_write(jbuf, jused))
+         return;
+      jused = 0;
+   }
+
+if (sizeof(JOURNAL_REC) + rec->len > sizeof(jbuf))
+   {
+      /* bigger than the queue, write it straight out */
+      if (!journal_write((char *)rec, sizeof(JOURNAL_REC)) || !journal_write(text, rec->len))
+         return;
+   }
+else
+   {
+      memcpy(jbuf + jused, (char *)rec, sizeof(JOURNAL_REC));
+      jused += sizeof(JOURNAL_REC);
+      if (rec->len)
+         memcpy(jbuf + jused, text, rec->len);
+      jused += rec->len;
+   }
+
+if (!jpending)
+   {
+      jpending = True;
+#ifndef WIN32
+      gettimeofday(&jfirst, NULL);
+#endif
+   }
+
+} /* end of journal_queue */
+
+
+/************************************************************************
+
+NAME:      journal_write  - Write out the queue
+
+RETURNED VALUE:
+   ok   -   int
+            True if it was all written, False if the journal was given up.
+
+*************************************************************************/
+
+static int   journal_write(char            *data,
+                           int              len)
+{
+int               rc;
+
+while (len > 0)
+{
+   rc = write(jfd, data, len);
+   if (rc < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         journal_fail("write");
+         return(False);
+      }
+   data += rc;
+   len  -= rc;
+}
+
+return(True);
+
+} /* end of journal_write */
+
+
+/************************************************************************
+
+NAME:      journal_fail  - Give up on the journal after an I/O error
+
+PURPOSE:    A journal with a record missing would replay to the wrong
+            lines, so it is removed and the session carries on without one.
+
+*************************************************************************/
+
+static void  journal_fail(char            *what)
+{
+char              msg[MAXPATHLEN+128];
+
+snprintf(msg, sizeof(msg), "Journal %s failed on %s (%s), changes are no longer journaled", what, jname, strerror(errno));
+close(jfd);
+jfd = -1;
+unlink(jname);
+jused = 0;
+jpending = False;
+if (jtoken)
+   jtoken->journaled = False;
+dm_error(msg, DM_ERROR_BEEP);
+
+} /* end of journal_fail */
+
+
+/************************************************************************
+
+NAME:      journal_sum  - Check sum of a record
+
+*************************************************************************/
+
+static unsigned int journal_sum(JOURNAL_REC     *rec,
+                                char            *text)
+{
+unsigned int      sum;
+int               i;
+
+sum = ((unsigned int)rec->op * 2654435761u) ^ ((unsigned int)rec->line_no * 40503u) ^ (unsigned int)rec->len;
+for (i = 0; i < rec->len; i++)
+   sum = (sum * 31) + (unsigned char)text[i];
+
+return(sum);
+
+} /* end of journal_sum */
+
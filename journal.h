@@ -0,0 +1,97 @@
+#ifndef _JOURNAL_INCLUDED
+#define _JOURNAL_INCLUDED
+
+/* "%Z% %M% %I% - %G% %U% " */
+
+/***************************************************************
+*
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in journal.c
+*     journal_open            - Start the journal for the edit file, or replay it
+*     journal_put             - Record a put_line_by_num
+*     journal_delete          - Record a delete_line_by_num
+*     journal_commit          - Write and sync the queued records
+*     journal_timeout         - Microseconds till the next group commit
+*     journal_reset           - Start over after the file is written or reloaded
+*     journal_checkpoint      - Start over after an autosave image is written
+*     journal_mark            - Where the journal is now, for journal_rebase
+*     journal_rebase          - Start over after a background pw, keeping later records
+*     journal_close           - Remove the journal on a clean exit
+*     journal_active          - Is a journal being kept
+*     journal_missing         - Is a journal wanted but not being kept
+*
+*  With -journal yes (resource .journal), each change memdata
+*  makes to the main pad is queued as a small record and written
+*  to <file>.CEJ next to the edit file.  Records are written and
+*  synced in groups, on a timer, rather than one at a time.  When
+*  the file is written the journal starts over, and a clean exit
+*  removes it.  After a crash, ce -recover replays the journal
+*  over the file on disk, or over the autosave image the journal
+*  was started from (see autoimage.c).
+*
+***************************************************************/
+
+#include "memdata.h"
+
+#define JOURNAL_SUFFIX  ".CEJ"
+
+void  journal_open(DATA_TOKEN      *token,             /* input / output */
+                   char            *edit_file,         /* input  */
+                   int              recover,           /* input  */
+                   long             image);            /* input  */
+
+void  journal_put(DATA_TOKEN      *token,             /* input  */
+                  int              line_no,           /* input  */
+                  char            *line,              /* input  */
+                  int              flag);             /* input  */
+
+void  journal_delete(DATA_TOKEN      *token,             /* input  */
+                     int              line_no);          /* input  */
+
+void  journal_commit(void);
+
+int   journal_timeout(void);
+
+void  journal_reset(DATA_TOKEN      *token,             /* input / output */
+                    char            *edit_file);        /* input  */
+
+void  journal_checkpoint(long             image);           /* input  */
+
+long  journal_mark(void);
+
+void  journal_rebase(char            *edit_file,         /* input  */
+                     long             mark);             /* input  */
+
+void  journal_close(void);
+
+int   journal_active(void);
+
+int   journal_missing(void);
+
+
+#endif
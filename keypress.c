@@ -52,6 +52,7 @@
 #include "dmc.h"
 #include "dmwin.h"
 #include "getevent.h"
+#include "ifind.h"
 #include "kd.h"
 #include "keypress.h"
 #include "mark.h"
@@ -531,6 +532,14 @@ while(dm_list != NULL)
 if (dspl_descr->cmd_record_data)
    rec_position(dspl_descr);
 
+/***************************************************************
+*  If an incremental find is running, the keystroke may have
+*  changed the pattern in the DM input window.  Restart the
+*  search from the new text.
+***************************************************************/
+if (ifind_active(dspl_descr))
+   redraw_needed |= ifind_update(dspl_descr);
+
 /***************************************************************
 *  autosave feature.
 ***************************************************************/
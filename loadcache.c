@@ -0,0 +1,588 @@
+/*static char *sccsid = "%Z% %M% %I% - %G% %U% ";*/
+/***************************************************************
+*
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in loadcache.c
+*     loadcache_open          - Get the line lengths of the edit file from the cache, or start recording them
+*     loadcache_done          - Save the recorded line lengths once the file is all read
+*
+*  Internal routines:
+*     loadcache_read          - Read and check a cache file
+*     loadcache_write         - Write a cache file
+*     loadcache_trim          - Remove the least recently used cache files past the limit
+*     loadcache_older         - qsort compare of cache file times
+*     loadcache_sum           - Check sum of a piece of a cache file
+*
+*  A cache file is a header, the full path of the edit file, and
+*  the line lengths in chunks of LOADCACHE_CHUNK_LINES, each with
+*  its own check sum.  The header holds the device, inode, size,
+*  and modify and change times of the edit file, to the nanosecond
+*  where stat gives it, so the lengths are only used for the file
+*  they were taken from.  The lengths must also add up to the size
+*  of the file.
+*
+*  The cache files are in the loadcache directory under the paste
+*  buffer directory, named by sums of the path.  A cache file is
+*  touched each time it is used.  After one is written, the ones
+*  used longest ago are removed until the directory is under the
+*  limit.
+*
+*  Only files of LOADCACHE_MIN_BYTES or more are cached.  Reading
+*  by the lengths is done in memdata.c, which also checks that each
+*  line ends in a newline where the cache says it does.  If one
+*  does not, the lengths are dropped and the file is read the
+*  normal way.
+*
+***************************************************************/
+
+#include <stdio.h>          /* /usr/include/stdio.h      */
+#include <string.h>         /* /usr/include/string.h     */
+#include <stddef.h>         /* /usr/include/stddef.h     */
+#include <errno.h>          /* /usr/include/errno.h      */
+#include <stdlib.h>         /* /usr/include/stdlib.h     */
+#include <limits.h>         /* /usr/include/limits.h     */
+#include <sys/types.h>      /* /usr/include/sys/types.h  */
+#include <sys/stat.h>       /* /usr/include/sys/stat.h   */
+#ifndef WIN32
+#include <unistd.h>         /* /usr/include/unistd.h     */
+#include <dirent.h>         /* /usr/include/dirent.h     */
+#include <utime.h>          /* /usr/include/utime.h      */
+#include <sys/param.h>      /* /usr/include/sys/param.h  */
+#endif
+
+#include "debug.h"
+#include "emalloc.h"
+#include "loadcache.h"
+#include "memdata.h"
+#include "pastebuf.h"
+
+#ifndef MAXPATHLEN
+#define MAXPATHLEN	1024
+#endif
+
+/***************************************************************
+*
+*  LOADCACHE_MIN_BYTES is the smallest file cached.
+*  LOADCACHE_CHUNK_LINES is the line lengths under one check sum.
+*  LOADCACHE_START_LINES is the room first made for recording.
+*
+***************************************************************/
+
+#define LOADCACHE_MIN_BYTES    1048576
+#define LOADCACHE_CHUNK_LINES  4096
+#define LOADCACHE_START_LINES  65536
+
+#define LOADCACHE_MAGIC        "CeLdIx2\n"
+
+/***************************************************************
+*
+*  The nanoseconds of the file times, zero where stat does not
+*  have them.
+*
+***************************************************************/
+
+#if defined(linux) || defined(__linux__) || defined(__sun)
+#define MTIME_NSEC(stats)      ((long)(stats).st_mtim.tv_nsec)
+#define CTIME_NSEC(stats)      ((long)(stats).st_ctim.tv_nsec)
+#else
+#if defined(__FreeBSD__) || defined(__APPLE__)
+#define MTIME_NSEC(stats)      ((long)(stats).st_mtimespec.tv_nsec)
+#define CTIME_NSEC(stats)      ((long)(stats).st_ctimespec.tv_nsec)
+#else
+#define MTIME_NSEC(stats)      0L
+#define CTIME_NSEC(stats)      0L
+#endif
+#endif
+
+typedef struct {
+   char            magic[8];       /* LOADCACHE_MAGIC                           */
+   long            dev;            /* edit file device                          */
+   long            ino;            /* edit file inode                           */
+   long            size;           /* edit file size                            */
+   long            mtime;          /* edit file modify time                     */
+   long            mtime_nsec;     /* nanoseconds of the modify time            */
+   long            ctime;          /* edit file change time                     */
+   long            ctime_nsec;     /* nanoseconds of the change time            */
+   long            lines;          /* line lengths in the cache file            */
+   long            path_len;       /* length of the path after the header       */
+   long            chunk_lines;    /* LOADCACHE_CHUNK_LINES                     */
+   unsigned int    check;          /* loadcache_sum of the fields above         */
+} LOADCACHE_HEADER;
+
+typedef struct {
+   char           *name;           /* cache file, with the directory            */
+   long            size;
+   long            mtime;
+} LOADCACHE_ENTRY;
+
+/***************************************************************
+*
+*  Local data, set up by loadcache_open for loadcache_done.
+*
+*  lpath   -  The full path of the edit file.
+*  ldir    -  The cache directory.
+*  lname   -  The cache file for the edit file.
+*  lstats  -  The edit file when it was opened.
+*  llimit  -  Most bytes the cache directory may hold.
+*
+***************************************************************/
+
+#ifndef WIN32
+static char             lpath[MAXPATHLEN+1];
+static char             ldir[MAXPATHLEN+16];
+static char             lname[MAXPATHLEN+48];
+static struct stat      lstats;
+static long             llimit;
+
+static int  loadcache_read(DATA_TOKEN      *token);
+
+static void loadcache_write(DATA_TOKEN      *token);
+
+static void loadcache_trim(void);
+
+static int  loadcache_older(const void      *a,
+                            const void      *b);
+
+static unsigned int loadcache_sum(char            *data,
+                                  long             len);
+#endif
+
+
+/************************************************************************
+
+NAME:      loadcache_open  - Get the line lengths of the edit file from the cache, or start recording them
+
+PURPOSE:    This routine is called when the main pad is about to be read
+            from the edit file.  If the cache has the line lengths for
+            this file, they are put in the memdata for load_a_block to
+            read by.  Otherwise load_a_block is set to record them.
+
+PARAMETERS:
+
+   1.  token      -  pointer to DATA_TOKEN (INPUT / OUTPUT)
+                     The main pad memdata, nothing read into it yet.
+
+   2.  edit_file  -  pointer to char (INPUT)
+                     The file being edited.
+
+   3.  stream     -  pointer to FILE (INPUT)
+                     The stream the file is read from, at the start.
+
+   4.  parm       -  pointer to char (INPUT)
+                     The -loadcache value, megabytes or yes.
+
+FUNCTIONS :
+
+   1.   Only a plain file of LOADCACHE_MIN_BYTES or more, not yet read
+        from, is done.
+
+   2.   Build the cache file name from the full path of the file.
+
+   3.   If the cache file checks, hand the lengths to memdata and mark
+        the cache file used.
+
+   4.   Otherwise start recording the lengths.
+
+*************************************************************************/
+
+void  loadcache_open(DATA_TOKEN      *token,             /* input / output */
+                     char            *edit_file,         /* input  */
+                     FILE            *stream,            /* input  */
+                     char            *parm)              /* input  */
+{
+#ifndef WIN32
+char             *dir;
+long              len;
+
+if (!parm || ((*parm | 0x20) == 'n') || !stream || token->line_index || (total_lines(token) != 0) || (ftell(stream) != 0))
+   return;
+
+llimit = ((*parm | 0x20) == 'y') ? LOADCACHE_DEFAULT_MB : atol(parm);
+if (llimit <= 0)
+   return;
+llimit *= 1048576;
+
+if ((fstat(fileno(stream), &lstats) != 0) || !S_ISREG(lstats.st_mode) || (lstats.st_size < LOADCACHE_MIN_BYTES))
+   return;
+
+if (realpath(edit_file, lpath) == NULL)
+   return;
+
+if ((dir = setup_paste_buff_dir("loadcache")) == NULL) /* in pastebuf.c */
+   return;
+
+snprintf(ldir, sizeof(ldir), "%s/loadcache", dir);
+if ((mkdir(ldir, 0700) != 0) && (errno != EEXIST))
+   {
+      DEBUG1(fprintf(stderr, "loadcache_open: cannot create %s (%s)\n", ldir, strerror(errno));)
+      return;
+   }
+
+len = strlen(lpath);
+snprintf(lname, sizeof(lname), "%s/%08x%08x%s", ldir, loadcache_sum(lpath, len), loadcache_sum(lpath, len / 2), LOADCACHE_SUFFIX);
+
+if (loadcache_read(token))
+   {
+      DEBUG1(fprintf(stderr, "loadcache_open: %d line lengths for %s from %s\n", token->line_index_lines, lpath, lname);)
+      utime(lname, NULL);
+      return;
+   }
+
+token->line_index = (uint32_t *)CE_MALLOC(LOADCACHE_START_LINES * sizeof(uint32_t));
+if (token->line_index)
+   {
+      token->line_index_lines = 0;
+      token->line_index_next  = LINE_INDEX_RECORD;
+      token->line_index_space = LOADCACHE_START_LINES;
+   }
+#endif
+
+} /* end of loadcache_open */
+
+
+/************************************************************************
+
+NAME:      loadcache_done  - Save the recorded line lengths once the file is all read
+
+PURPOSE:    This routine is called when the main pad reaches end of file.
+            If the line lengths were recorded, and the file is still the
+            one opened, they are written to the cache.  Either way the
+            lengths are freed.
+
+PARAMETERS:
+
+   1.  token      -  pointer to DATA_TOKEN (INPUT / OUTPUT)
+                     The main pad memdata.
+
+*************************************************************************/
+
+void  loadcache_done(DATA_TOKEN      *token)             /* input / output */
+{
+#ifndef WIN32
+struct stat       file_stats;
+long              bytes = 0;
+int               i;
+
+if (!token->line_index)
+   return;
+
+if (token->line_index_next == LINE_INDEX_RECORD)
+   {
+      for (i = 0; i < token->line_index_lines; i++)
+         bytes += (token->line_index[i] & ~LINE_INDEX_NEWLINE) + ((token->line_index[i] & LINE_INDEX_NEWLINE) ? 1 : 0);
+
+      if ((bytes == (long)lstats.st_size) && (stat(lpath, &file_stats) == 0) &&
+          (file_stats.st_dev == lstats.st_dev) && (file_stats.st_ino == lstats.st_ino) &&
+          (file_stats.st_size == lstats.st_size) && (file_stats.st_mtime == lstats.st_mtime) &&
+          (MTIME_NSEC(file_stats) == MTIME_NSEC(lstats)) && (file_stats.st_ctime == lstats.st_ctime) &&
+          (CTIME_NSEC(file_stats) == CTIME_NSEC(lstats)))
+         loadcache_write(token);
+      else
+         DEBUG1(fprintf(stderr, "loadcache_done: %s changed while it was read, not cached\n", lpath);)
+   }
+
+free((char *)token->line_index);
+token->line_index = NULL;
+#endif
+
+} /* end of loadcache_done */
+
+
+#ifndef WIN32
+/************************************************************************
+
+NAME:      loadcache_read  - Read and check a cache file
+
+PURPOSE:    This routine reads the cache file for the edit file.  The
+            header must check and match the edit file, each chunk of
+            lengths must check, and the lengths must add up to the size
+            of the file.
+
+PARAMETERS:
+
+   1.  token      -  pointer to DATA_TOKEN (INPUT / OUTPUT)
+                     The main pad memdata, the lengths are put in it.
+
+RETURNED VALUE:
+   ok   -  True if the lengths were put in the memdata.
+
+*************************************************************************/
+
+static int  loadcache_read(DATA_TOKEN      *token)
+{
+FILE             *fp;
+LOADCACHE_HEADER  header;
+char              path[MAXPATHLEN+1];
+uint32_t         *index = NULL;
+unsigned int      sum;
+long              bytes = 0;
+long              i;
+long              count;
+int               ok;
+
+if ((fp = fopen(lname, "r")) == NULL)
+   return(False);
+
+ok = (fread((char *)&header, sizeof(header), 1, fp) == 1) &&
+     (memcmp(header.magic, LOADCACHE_MAGIC, sizeof(header.magic)) == 0) &&
+     (header.check == loadcache_sum((char *)&header, offsetof(LOADCACHE_HEADER, check))) &&
+     (header.dev == (long)lstats.st_dev) && (header.ino == (long)lstats.st_ino) &&
+     (header.size == (long)lstats.st_size) && (header.mtime == (long)lstats.st_mtime) &&
+     (header.mtime_nsec == MTIME_NSEC(lstats)) && (header.ctime == (long)lstats.st_ctime) &&
+     (header.ctime_nsec == CTIME_NSEC(lstats)) &&
+     (header.lines > 0) && (header.lines <= header.size) && (header.lines < INT_MAX) &&
+     (header.path_len == (long)strlen(lpath)) && (header.chunk_lines == LOADCACHE_CHUNK_LINES) &&
+     (fread(path, header.path_len, 1, fp) == 1) && (memcmp(path, lpath, header.path_len) == 0);
+
+if (ok)
+   ok = ((index = (uint32_t *)CE_MALLOC(header.lines * sizeof(uint32_t))) != NULL);
+
+for (i = 0; ok && (i < header.lines); i += count)
+{
+   count = header.lines - i;
+   if (count > LOADCACHE_CHUNK_LINES)
+      count = LOADCACHE_CHUNK_LINES;
+   ok = (fread((char *)(index + i), sizeof(uint32_t), count, fp) == (size_t)count) &&
+        (fread((char *)&sum, sizeof(sum), 1, fp) == 1) &&
+        (sum == loadcache_sum((char *)(index + i), count * sizeof(uint32_t)));
+}
+
+for (i = 0; ok && (i < header.lines); i++)
+{
+   if ((index[i] & ~LINE_INDEX_NEWLINE) > MAX_LINE)
+      ok = False;
+   bytes += (index[i] & ~LINE_INDEX_NEWLINE) + ((index[i] & LINE_INDEX_NEWLINE) ? 1 : 0);
+}
+
+fclose(fp);
+
+if (!ok || (bytes != header.size))
+   {
+      DEBUG1(fprintf(stderr, "loadcache_read: %s does not match %s\n", lname, lpath);)
+      if (index)
+         free((char *)index);
+      return(False);
+   }
+
+token->line_index       = index;
+token->line_index_lines = header.lines;
+token->line_index_next  = 0;
+token->line_index_space = header.lines;
+
+return(True);
+
+} /* end of loadcache_read */
+
+
+/************************************************************************
+
+NAME:      loadcache_write  - Write a cache file
+
+PURPOSE:    This routine writes the recorded line lengths to a new file
+            next to the cache file and renames it into place, so a cache
+            file is never seen half written.  Then the cache directory is
+            cut back to the limit.
+
+PARAMETERS:
+
+   1.  token      -  pointer to DATA_TOKEN (INPUT)
+                     The main pad memdata, with the recorded lengths.
+
+*************************************************************************/
+
+static void loadcache_write(DATA_TOKEN      *token)
+{
+FILE             *fp;
+LOADCACHE_HEADER  header;
+char              temp_name[sizeof(lname)+16];
+unsigned int      sum;
+long              i;
+long              count;
+int               ok;
+
+if ((long)(sizeof(header) + strlen(lpath) + (token->line_index_lines * sizeof(uint32_t) * 2)) > llimit)
+   return;
+
+memset((char *)&header, 0, sizeof(header));
+memcpy(header.magic, LOADCACHE_MAGIC, sizeof(header.magic));
+header.dev         = lstats.st_dev;
+header.ino         = lstats.st_ino;
+header.size        = lstats.st_size;
+header.mtime       = lstats.st_mtime;
+header.mtime_nsec  = MTIME_NSEC(lstats);
+header.ctime       = lstats.st_ctime;
+header.ctime_nsec  = CTIME_NSEC(lstats);
+header.lines       = token->line_index_lines;
+header.path_len    = strlen(lpath);
+header.chunk_lines = LOADCACHE_CHUNK_LINES;
+header.check       = loadcache_sum((char *)&header, offsetof(LOADCACHE_HEADER, check));
+
+snprintf(temp_name, sizeof(temp_name), "%s.%d", lname, (int)getpid());
+if ((fp = fopen(temp_name, "w")) == NULL)
+   {
+      DEBUG1(fprintf(stderr, "loadcache_write: cannot create %s (%s)\n", temp_name, strerror(errno));)
+      return;
+   }
+
+ok = (fwrite((char *)&header, sizeof(header), 1, fp) == 1) &&
+     (fwrite(lpath, header.path_len, 1, fp) == 1);
+
+for (i = 0; ok && (i < header.lines); i += count)
+{
+   count = header.lines - i;
+   if (count > LOADCACHE_CHUNK_LINES)
+      count = LOADCACHE_CHUNK_LINES;
+   sum = loadcache_sum((char *)(token->line_index + i), count * sizeof(uint32_t));
+   ok = (fwrite((char *)(token->line_index + i), sizeof(uint32_t), count, fp) == (size_t)count) &&
+        (fwrite((char *)&sum, sizeof(sum), 1, fp) == 1);
+}
+
+if ((fclose(fp) != 0) || !ok || (rename(temp_name, lname) != 0))
+   {
+      DEBUG1(fprintf(stderr, "loadcache_write: cannot write %s (%s)\n", lname, strerror(errno));)
+      unlink(temp_name);
+      return;
+   }
+
+DEBUG1(fprintf(stderr, "loadcache_write: %ld line lengths for %s in %s\n", header.lines, lpath, lname);)
+
+loadcache_trim();
+
+} /* end of loadcache_write */
+
+
+/************************************************************************
+
+NAME:      loadcache_trim  - Remove the least recently used cache files past the limit
+
+PURPOSE:    This routine adds up the cache files in the cache directory.
+            If they are over the limit, the ones used longest ago are
+            removed until they are not.  The one just written is kept.
+
+*************************************************************************/
+
+static void loadcache_trim(void)
+{
+DIR              *dir;
+struct dirent    *dp;
+struct stat       file_stats;
+LOADCACHE_ENTRY  *entries = NULL;
+LOADCACHE_ENTRY  *new_entries;
+char              name[sizeof(ldir)+MAXPATHLEN+2];
+int               count = 0;
+int               space = 0;
+int               i;
+long              total = 0;
+size_t            len;
+size_t            suffix_len = strlen(LOADCACHE_SUFFIX);
+
+if ((dir = opendir(ldir)) == NULL)
+   return;
+
+while ((dp = readdir(dir)) != NULL)
+{
+   len = strlen(dp->d_name);
+   if ((len <= suffix_len) || (strcmp(dp->d_name + len - suffix_len, LOADCACHE_SUFFIX) != 0))
+      continue;
+   snprintf(name, sizeof(name), "%s/%s", ldir, dp->d_name);
+   if ((stat(name, &file_stats) != 0) || !S_ISREG(file_stats.st_mode))
+      continue;
+   total += file_stats.st_size;
+   if (strcmp(name, lname) == 0)
+      continue;
+   if (count >= space)
+      {
+         space = space ? space * 2 : 64;
+         new_entries = (LOADCACHE_ENTRY *)realloc((char *)entries, space * sizeof(LOADCACHE_ENTRY));
+         if (!new_entries)
+            break;
+         entries = new_entries;
+      }
+   if ((entries[count].name = malloc_copy(name)) == NULL)
+      break;
+   entries[count].size  = file_stats.st_size;
+   entries[count].mtime = file_stats.st_mtime;
+   count++;
+}
+closedir(dir);
+
+if (total > llimit)
+   qsort((char *)entries, count, sizeof(LOADCACHE_ENTRY), loadcache_older);
+
+for (i = 0; (i < count) && (total > llimit); i++)
+   if (unlink(entries[i].name) == 0)
+      {
+         DEBUG1(fprintf(stderr, "loadcache_trim: removed %s\n", entries[i].name);)
+         total -= entries[i].size;
+      }
+
+for (i = 0; i < count; i++)
+   free(entries[i].name);
+if (entries)
+   free((char *)entries);
+
+} /* end of loadcache_trim */
+
+
+/************************************************************************
+
+NAME:      loadcache_older  - qsort compare of cache file times
+
+*************************************************************************/
+
+static int  loadcache_older(const void      *a,
+                            const void      *b)
+{
+long              a_time = ((LOADCACHE_ENTRY *)a)->mtime;
+long              b_time = ((LOADCACHE_ENTRY *)b)->mtime;
+
+return((a_time > b_time) - (a_time < b_time));
+
+} /* end of loadcache_older */
+
+
+/************************************************************************
+
+NAME:      loadcache_sum  - Check sum of a piece of a cache file
+
+*************************************************************************/
+
+static unsigned int loadcache_sum(char            *data,
+                                  long             len)
+{
+unsigned int      sum = (unsigned int)len;
+long              i;
+
+for (i = 0; i < len; i++)
+   sum = (sum * 31) + (unsigned char)data[i];
+
+return(sum);
+
+} /* end of loadcache_sum */
+#endif
+
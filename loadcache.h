@@ -0,0 +1,62 @@
+#ifndef _LOADCACHE_INCLUDED
+#define _LOADCACHE_INCLUDED
+
+/* "%Z% %M% %I% - %G% %U% " */
+
+/***************************************************************
+*
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in loadcache.c
+*     loadcache_open          - Get the line lengths of the edit file from the cache, or start recording them
+*     loadcache_done          - Save the recorded line lengths once the file is all read
+*
+*  With -loadcache (resource .loadcache), the length of each line
+*  of a big edit file is kept in a cache under the paste buffer
+*  directory.  The next time the same file is opened, load_a_block
+*  reads whole blocks by the lengths instead of looking for the
+*  newlines a line at a time.  The value is the most megabytes the
+*  cache may use, or yes for LOADCACHE_DEFAULT_MB.
+*
+***************************************************************/
+
+#include <stdio.h>          /* /usr/include/stdio.h      */
+
+#include "memdata.h"
+
+#define LOADCACHE_SUFFIX      ".CEL"
+#define LOADCACHE_DEFAULT_MB  256
+
+void  loadcache_open(DATA_TOKEN      *token,             /* input / output */
+                     char            *edit_file,         /* input  */
+                     FILE            *stream,            /* input  */
+                     char            *parm);             /* input  */
+
+void  loadcache_done(DATA_TOKEN      *token);            /* input / output */
+
+
+#endif
@@ -38,6 +38,12 @@
 *     save_file_stats        -   Save stats to detect file changed.
 *     detect_changed_file    -   See if the passes stat buff matches the last saved
 *     file_has_changed       -   Get stats for current file and compare against the saved stats
+*     watch_file             -   Watch the edit file for changes made by others
+*     watch_active           -   Is the edit file being watched
+*     watch_fdset            -   Add the watch descriptor to a select mask
+*     watch_timeout          -   Microseconds till the next poll
+*     watch_ready            -   Is there something for watch_changed
+*     watch_changed          -   See if the watched file has changed
 *
 * Internal:
 *
@@ -98,6 +104,11 @@
 #include <io.h>
 #else
 #include <unistd.h>       /* /usr/include/unistd.h      */
+#include <sys/time.h>     /* /usr/include/sys/time.h    */
+#endif
+#ifdef linux
+#include <sys/inotify.h>  /* /usr/include/sys/inotify.h */
+#include <sys/vfs.h>      /* /usr/include/sys/vfs.h     */
 #endif
 
 
@@ -152,6 +163,18 @@
 *                       to the stats we know about.  It is used by 
 *                       detect_changed_file to see if the file changed.
 *
+*  watch_fd          -  File descriptor
+*                       The inotify descriptor watching the directory of
+*                       the edit file, or -1.
+*
+*  watch_polling     -  Boolean flag
+*                       Set when the file is stat'ed on a timer because
+*                       inotify cannot be used.
+*
+*  watch_hit         -  Boolean flag
+*                       Set when the watch descriptor is ready or a poll
+*                       found a change, cleared by watch_changed.
+*
 ***************************************************************/
 
 static int            locking_enabled = False;
@@ -160,6 +183,28 @@ static int            lock_fd = -1;
 static struct stat    lock_file_stats;
 static struct stat    saved_file_stats;
 
+static int            watch_fd = -1;
+static int            watch_polling = False;
+static int            watch_hit = False;
+static char           watch_name[MAXPATHLEN+1];   /* file being watched, "" for none */
+static char          *watch_base = watch_name;    /* last component of watch_name    */
+#if !defined(WIN32)
+static struct timeval watch_last_poll;
+#endif
+
+#define WATCH_POLL_USECS  2000000
+
+/***************************************************************
+*  
+*  File systems where inotify does not see changes made by other
+*  hosts: NFS, SMB, CIFS, AFS, Coda, and FUSE.
+*  
+***************************************************************/
+
+#define WATCH_REMOTE_FS(t) (((t) == 0x6969) || ((t) == 0x517B) || ((t) == (long)0xFF534D42) || \
+                            ((t) == (long)0xFE534D42) || ((t) == 0x5346414F) || ((t) == 0x73757245) || \
+                            ((t) == 0x65735546))
+
 #define DO_AFS
 
 
@@ -606,3 +651,274 @@ return(changed_file);
 
 
 
+/************************************************************************
+
+NAME:      watch_file             -   Watch the edit file for changes made by others
+
+PURPOSE:    This routine starts watching the edit file, or stops watching
+            when passed NULL.  It is called with the edit file each time
+            through the event loop and only does work when the name
+            changes, as after a pn.
+
+            On Linux, an inotify watch is put on the directory holding
+            the file, so a file replaced by rename is seen as well as one
+            written in place.  inotify does not see changes made by other
+            hosts to NFS and other network files, and is not there on other
+            systems.  For these, the file is stat'ed every WATCH_POLL_USECS
+            from timeout_set instead.
+
+PARAMETERS:
+
+   1.  edit_file  -  pointer to char (INPUT)
+                     The file being edited, or NULL to stop watching.
+
+*************************************************************************/
+
+void  watch_file(const char *edit_file)
+{
+#if !defined(WIN32)
+char            dir[MAXPATHLEN+1];
+char           *p;
+#ifdef linux
+struct statfs   fs_stats;
+#endif
+
+if (edit_file && (strcmp(edit_file, watch_name) == 0))
+   return;
+
+if (watch_fd >= 0)
+   {
+      close(watch_fd);
+      watch_fd = -1;
+   }
+watch_name[0] = '\0';
+watch_polling = False;
+watch_hit = False;
+
+if (!edit_file || !edit_file[0])
+   return;
+
+strncpy(watch_name, edit_file, sizeof(watch_name)-1);
+watch_name[sizeof(watch_name)-1] = '\0';
+
+strncpy(dir, edit_file, sizeof(dir)-1);
+dir[sizeof(dir)-1] = '\0';
+p = strrchr(dir, '/');
+if (p == dir)
+   {
+      watch_base = watch_name + 1;
+      dir[1] = '\0';
+   }
+else
+   if (p)
+      {
+         watch_base = watch_name + (p - dir) + 1;
+         *p = '\0';
+      }
+   else
+      {
+         watch_base = watch_name;
+         strcpy(dir, ".");
+      }
+
+#ifdef linux
+if ((statfs(dir, &fs_stats) == 0) && !WATCH_REMOTE_FS(fs_stats.f_type))
+   {
+      watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+      if ((watch_fd >= 0) &&
+          (inotify_add_watch(watch_fd, dir, IN_MODIFY | IN_ATTRIB | IN_CLOSE_WRITE | IN_CREATE |
+                                            IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO) < 0))
+         {
+            DEBUG27(fprintf(stderr, "watch_file: Cannot watch %s (%s)\n", dir, strerror(errno));)
+            close(watch_fd);
+            watch_fd = -1;
+         }
+   }
+#endif
+
+if (watch_fd < 0)
+   {
+      watch_polling = True;
+      gettimeofday(&watch_last_poll, NULL);
+   }
+
+DEBUG27(fprintf(stderr, "watch_file: %s %s\n", (watch_polling ? "polling" : "inotify on"), edit_file);)
+
+#endif
+} /* end of watch_file */
+
+
+/************************************************************************
+
+NAME:      watch_active           -   Is the edit file being watched
+
+PURPOSE:    When the file is watched, the event loop has to select on
+            the watch descriptor or wake up for the next poll.
+
+*************************************************************************/
+
+int   watch_active(void)
+{
+
+return(watch_name[0] != '\0');
+
+} /* end of watch_active */
+
+
+/************************************************************************
+
+NAME:      watch_fdset            -   Add the watch descriptor to a select mask
+
+PARAMETERS:
+
+   1.  readfds    -  pointer to fd_set (INPUT / OUTPUT)
+                     The read mask for the main select.
+
+RETURNED VALUE:
+   fd  -  int
+          The inotify descriptor added, or -1 if there is none.
+
+*************************************************************************/
+
+int   watch_fdset(fd_set   *readfds)
+{
+
+if (watch_fd >= 0)
+   FD_SET(watch_fd, readfds);
+
+return(watch_fd);
+
+} /* end of watch_fdset */
+
+
+/************************************************************************
+
+NAME:      watch_timeout          -   Microseconds till the next poll
+
+PURPOSE:    This routine is called from timeout_set.  When the file is
+            polled and the poll is due, the file is stat'ed and compared
+            against the saved stats.  A change is left for watch_ready
+            and watch_changed to pick up.
+
+RETURNED VALUE:
+   usecs  -  int
+             0 if the file is not being polled, otherwise the time till
+             the next poll.
+
+*************************************************************************/
+
+int   watch_timeout(void)
+{
+#if !defined(WIN32)
+struct timeval  now;
+struct stat     current_stats;
+long            waited;
+
+if (!watch_polling || watch_hit)
+   return(0);
+
+gettimeofday(&now, NULL);
+waited = ((now.tv_sec - watch_last_poll.tv_sec) * 1000000) + (now.tv_usec - watch_last_poll.tv_usec);
+if ((waited >= 0) && (waited < WATCH_POLL_USECS))
+   return(WATCH_POLL_USECS - waited);
+
+watch_last_poll = now;
+if (stat(watch_name, &current_stats) < 0)
+   memset(&current_stats, 0, sizeof(current_stats));
+if (detect_changed_file(&current_stats))
+   {
+      DEBUG27(fprintf(stderr, "watch_timeout: %s changed\n", watch_name);)
+      watch_hit = True;
+      return(0);
+   }
+
+return(WATCH_POLL_USECS);
+#else
+return(0);
+#endif
+} /* end of watch_timeout */
+
+
+/************************************************************************
+
+NAME:      watch_ready            -   Is there something for watch_changed
+
+PURPOSE:    This routine is called after the main select.  It notes if
+            the inotify descriptor is ready or a poll found a change.
+
+PARAMETERS:
+
+   1.  readfds    -  pointer to fd_set (INPUT)
+                     The read mask returned by select, or NULL if the
+                     select did not find anything.
+
+RETURNED VALUE:
+   ready  -  int flag
+             True  - watch_changed should be called.
+             False - Nothing has happened.
+
+*************************************************************************/
+
+int   watch_ready(fd_set   *readfds)
+{
+
+if (readfds && (watch_fd >= 0) && FD_ISSET(watch_fd, readfds))
+   watch_hit = True;
+
+return(watch_hit);
+
+} /* end of watch_ready */
+
+
+/************************************************************************
+
+NAME:      watch_changed          -   See if the watched file has changed
+
+PURPOSE:    Once watch_ready says something happened, this routine reads
+            the inotify events.  Only events for the edit file itself,
+            and an overflow of the event queue, cause the file to be
+            stat'ed.  file_has_changed then compares it against the saved
+            stats, so a pw by this program does not look like a change.
+
+RETURNED VALUE:
+   changed_file  -  int flag
+                    True  - The file has changed.
+                    False - The file has not changed.
+
+*************************************************************************/
+
+int   watch_changed(void)
+{
+int                    look = False;
+#ifdef linux
+char                   buff[4096];
+int                    len;
+int                    pos;
+struct inotify_event  *event;
+#endif
+
+if (!watch_hit)
+   return(False);
+watch_hit = False;
+
+if (watch_polling)
+   look = True;
+
+#ifdef linux
+if (watch_fd >= 0)
+   while ((len = read(watch_fd, buff, sizeof(buff))) > 0)
+      for (pos = 0; pos < len; pos += sizeof(struct inotify_event) + event->len)
+      {
+         event = (struct inotify_event *)(buff + pos);
+         if ((event->mask & IN_Q_OVERFLOW) || (event->len && (strcmp(event->name, watch_base) == 0)))
+            look = True;
+      }
+#endif
+
+if (!look)
+   return(False);
+
+return(file_has_changed(watch_name));
+
+} /* end of watch_changed */
+
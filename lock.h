@@ -40,9 +40,21 @@
 *     save_file_stats        -   Save stats to detect file changed.
 *     detect_changed_file    -   See if the passes stat buff matches the last saved
 *     file_has_changed       -   Get stats for current file and compare against the saved stats
+*     watch_file             -   Watch the edit file for changes made by others
+*     watch_active           -   Is the edit file being watched
+*     watch_fdset            -   Add the watch descriptor to a select mask
+*     watch_timeout          -   Microseconds till the next poll
+*     watch_ready            -   Is there something for watch_changed
+*     watch_changed          -   See if the watched file has changed
 *
 ***************************************************************/
 
+#include <sys/types.h>    /* /usr/include/sys/types.h   */
+#include <sys/stat.h>     /* /usr/include/sys/stat.h    */
+#ifndef WIN32
+#include <sys/time.h>     /* /usr/include/sys/time.h    */
+#endif
+
 /***************************************************************
 *
 *  Prototypes
@@ -65,5 +77,17 @@ int  detect_changed_file(struct stat    *file_stats);
 
 int  file_has_changed(const char *edit_file);
 
+void  watch_file(const char *edit_file);
+
+int   watch_active(void);
+
+int   watch_fdset(fd_set   *readfds);
+
+int   watch_timeout(void);
+
+int   watch_ready(fd_set   *readfds);
+
+int   watch_changed(void);
+
 #endif
 
@@ -44,11 +44,24 @@
 *     put_line_by_num       - Replace or insert a line
 *     put_block_by_num      - Insert multiple lines from a file
 *     save_file             - Write the file out
+*     save_file_fd          - Write the file out with large gathered writes
+*     save_blocks           - Write the changed blocks to an autosave image
+*     block_map             - Describe where each block was saved
+*     blocks_saved          - Mark every block saved in the edit file after a pw
+*     blocks_pending        - Note where each block goes in a background pw
+*     blocks_pending_saved  - Mark the blocks a background pw saved
 *     delayed_delete        - Mark a line to be deleted later
 *     sum_size              - Sum the malloced sizes of a range of lines
+*     line_generation       - Get the change generation of a line for display caching
+*     line_spans            - Describe a range of lines block by block
+*     span_line             - Get a line out of a span
+*     span_generation       - Sum the line generations of a span
+*     current_generation    - Get the last generation handed out
+*     swap_lines            - Exchange many lines with replacements in one step
 *     encrypt_init          -  Initialize an encryption
 *     encrypt_line          - encrypt a line
 *     join_line             - join one line to the next one after it.
+*     join_marked_lines     - join a run of lines marked by delayed_delete in one step
 *     mem_kill              - kill a memdata structure.
 *     vt100_eat             - Eat vt100 control sequences when in cv -man mode
 *     print_color_bits      - Dump the color lines and the color bit patterns
@@ -60,6 +73,8 @@
 *
 *  Internal routines:
 *     read_a_block          - Read a block into memory
+*     read_indexed_block    - Read a block into memory by the line lengths from the load cache
+*     line_index_add        - Record the length of a line read for the load cache
 *     hh_idx                - Return the 3 indexes to a line
 *     last_line_in_block    - return the index of the last filled line in a block
 *     remove_block          - Remove a block and pull up the following blocks
@@ -82,6 +97,12 @@
 #include <limits.h>         /* /usr/include/limits.h     */
 #include <string.h>         /* /usr/include/string.h     */
 #include <signal.h>         /* /usr/include/signal.h     */
+#ifdef WIN32
+#include <io.h>
+#else
+#include <unistd.h>         /* /usr/include/unistd.h     */
+#include <sys/uio.h>        /* /usr/include/sys/uio.h    */
+#endif
 
 
 #define _MEMDATA_ 1
@@ -91,6 +112,7 @@
 #include "dmwin.h"
 #include "debug.h"
 #include "emalloc.h"
+#include "journal.h"
 #include "memdata.h"
 #include "pastebuf.h"
 #include "undo.h" 
@@ -110,6 +132,33 @@
 #define MASK_8     (UINT_MAX & (UINT_MAX << 3))
 #define MROUND(n)  ((n + 7) & MASK_8)
 
+/*
+ *  
+ *  Each time the text or color of a line changes, the line gets
+ *  a new generation number.  The drawing code uses the line address
+ *  and the generation to decide if what it worked out last time for
+ *  the line is still good.  The counter is shared by all the tokens
+ *  so a line freed in one file and reused in another never looks
+ *  unchanged.  Zero is never handed out, it means "unknown".
+ *  
+ */
+
+static unsigned int next_generation = 0;
+
+#define NEW_GENERATION  ((++next_generation) ? next_generation : ++next_generation)
+
+/*
+ *  
+ *  Each block remembers where its text was last saved, in the
+ *  edit file or an autosave image.  Anything which changes the
+ *  lines in a block clears saved_in, so an autosave only has to
+ *  write the blocks which were changed.  It also clears pending,
+ *  the block no longer matches what a background pw is writing.
+ *  
+ */
+
+#define BLOCK_CHANGED(token, header)  { (header)->saved_in = SAVED_IN_NONE; (header)->pending = False; (token)->blocks_dirty = True; }
+
 #ifdef WIN32
 #define kill(a,b) exit(b)
 #endif
@@ -128,6 +177,16 @@ static block_struct *read_a_block(DATA_TOKEN *token,
                                   int         eat_vt100,               /* input */
                                   int        *last_line_has_newline); /* output */
 
+static block_struct *read_indexed_block(DATA_TOKEN *token,
+                                        FILE       *stream,
+                                        int        *lines_put_in_block,     /*  output */
+                                        int        *eof,                    /* input / output */
+                                        int        *last_line_has_newline); /* output */
+
+static void     line_index_add(DATA_TOKEN *token,
+                               int         len,
+                               int         newline);
+
 static void     hh_idx(DATA_TOKEN *token,         /* input  */
                        int        *data_idx,      /* output */
                        int        *header_idx,    /* output */
@@ -227,7 +286,7 @@ token->current_header_idx    = -1;
 token->current_data_idx      = -1;
 token->last_line_no          = -1;
 token->line_load_level       = (percent_full * LINES_PER_BLOCK) / 100;
-token->event_head            = NULL;
+token->undo_log              = NULL;
 token->last_hh_block_idx     = 0;   /* optimization code */
 token->last_hh_header_idx    = 0;
 token->last_hh_data_idx      = 0;
@@ -289,7 +348,10 @@ while ((i < DATA_SIZE) && (token->data[i].header != NULL) && (line_count < total
     i++;
 }
 
-kill_event_dlist(token); 
+undo_free(token); 
+
+if (token->line_index)
+   free((char *)token->line_index);
 
 free((char *)token);
 
@@ -355,6 +417,8 @@ int  header_idx;
 int  line_idx;    /* not used */
 int  lines_put_in_block; 
 int  last_line_has_newline;  /* not used */
+long start_offset = -1;
+long end_offset;
 
 char error_msg[64];
 
@@ -414,16 +478,27 @@ if (header == NULL)
 
  /*
   *  Create a new lowest level index and read in a block of lines.
-  *  Put that in the current block.  
+  *  Put that in the current block.  When reading the edit file
+  *  itself, the block is saved there as read.
   */
 
-header[header_idx].block = read_a_block(token,
-                                        stream, 
-                                        &lines_put_in_block,
-                                        eof,
-                                        -1,   /* called from LAB */
-                                        eat_vt100,
-                                        &last_line_has_newline);
+if (token->file_offsets && !eat_vt100)
+   start_offset = ftell(stream);
+
+if (token->line_index && (token->line_index_next >= 0) && !eat_vt100)
+   header[header_idx].block = read_indexed_block(token,
+                                                 stream,
+                                                 &lines_put_in_block,
+                                                 eof,
+                                                 &last_line_has_newline);
+else
+   header[header_idx].block = read_a_block(token,
+                                           stream, 
+                                           &lines_put_in_block,
+                                           eof,
+                                           -1,   /* called from LAB */
+                                           eat_vt100,
+                                           &last_line_has_newline);
 
 if (!header[header_idx].block){
     dm_error("Cannot read_a_block.", DM_ERROR_LOG);
@@ -432,6 +507,14 @@ if (!header[header_idx].block){
 }
 
 header[header_idx].lines       = lines_put_in_block;
+header[header_idx].saved_in    = SAVED_IN_NONE;
+header[header_idx].pending     = False;
+if ((start_offset >= 0) && ((end_offset = ftell(stream)) >= start_offset))
+   {
+      header[header_idx].saved_in     = SAVED_IN_FILE;
+      header[header_idx].saved_offset = start_offset;
+      header[header_idx].saved_bytes  = end_offset - start_offset;
+   }
 
 token->data[data_idx].lines   += lines_put_in_block;
 total_lines(token)            += lines_put_in_block;
@@ -587,6 +670,9 @@ for (i = 0; i < token->line_load_level && !*eof; i++)
          if (ENCRYPT) encrypt_line(buff);
 #endif
 
+         if (token->line_index && (token->line_index_next == LINE_INDEX_RECORD) && (line_no == -1))
+            line_index_add(token, len - 1, *last_line_has_newline);
+
          /*
           *   Put the line in more permanent storage.
           */
@@ -610,6 +696,7 @@ for (i = 0; i < token->line_load_level && !*eof; i++)
          block[i].text = target;
          block[i].size = MROUND(len);
          block[i].color_data = NULL;
+         block[i].generation = NEW_GENERATION;
 
    }else{
        if (ferror(stream)){
@@ -628,6 +715,174 @@ return(block);
 } /* end of read_a_block */
 
 
+/************************************************************************
+
+NAME:      read_indexed_block
+
+PURPOSE:   This routine does what read_a_block does when the length of
+           each line is known from the load cache.  The bytes for the
+           whole block are read at once and cut up by the lengths, so
+           there is no looking for newlines.
+
+PARAMETERS:
+   1.   token           -  pointer to DATA_TOKEN (opaque)
+        The memdata being loaded.  token->line_index holds the lengths.
+
+   2.   stream          -  pointer to file (INPUT)
+        This is the stream to read.
+
+   3.   lines_put_in_block -  pointer to int (OUTPUT)
+        The number of lines read into this block is returned in the parameter.
+
+   4.   eof             -  pointer to int (INPUT / OUTPUT)
+        This flag is set to true when eof is reached.
+
+   5.   last_line_has_newline  -  pointer to int (OUTPUT)
+        This flag is set to true if the last line read has a newline on it.
+
+FUNCTIONS :
+
+   1.   Add up the lengths for the lines in this block and read that many
+        bytes.
+
+   2.   If the bytes are short, or a newline is not where a line should
+        end, the file is not what the index says.  Drop the index, put
+        the stream back, and let read_a_block do the block.
+
+   3.   Copy each line to its own space, as read_a_block does.
+
+   4.   When the index is used up, drop it.  The next block is read by
+        read_a_block, which finds the eof.
+
+RETURNS:
+   block  -  pointer to block_struct
+             The address of the block_struct with all the lines in it.
+
+*************************************************************************/
+
+static block_struct *read_indexed_block(DATA_TOKEN *token,
+                                        FILE       *stream,
+                                        int        *lines_put_in_block,     /*  output */
+                                        int        *eof,                    /* input / output */
+                                        int        *last_line_has_newline)  /* output */
+{
+block_struct   *block = NULL;
+char           *buff;
+long            start_offset;
+size_t          bytes = 0;
+size_t          pos;
+int             count;
+int             i;
+int             len;
+int             newline;
+
+count = token->line_index_lines - token->line_index_next;
+if (count > token->line_load_level)
+   count = token->line_load_level;
+
+for (i = 0; i < count; i++)
+   bytes += (token->line_index[token->line_index_next + i] & ~LINE_INDEX_NEWLINE) +
+            ((token->line_index[token->line_index_next + i] & LINE_INDEX_NEWLINE) ? 1 : 0);
+
+start_offset = ftell(stream);
+buff = (char *)CE_MALLOC(bytes + 1);
+if (buff && (fread(buff, 1, bytes, stream) == bytes))
+   block = (block_struct *) CE_MALLOC(LINES_PER_BLOCK * sizeof(block_struct));
+
+for (i = 0, pos = 0; block && (i < count); i++)
+{
+   len     = token->line_index[token->line_index_next + i] & ~LINE_INDEX_NEWLINE;
+   newline = (token->line_index[token->line_index_next + i] & LINE_INDEX_NEWLINE) != 0;
+   if (newline && (buff[pos + len] != '\n'))
+      break;
+   block[i].text       = (char *)CE_MALLOC(MROUND(len + 1));
+   if (!block[i].text)
+      break;
+   memcpy(block[i].text, buff + pos, len);
+   block[i].text[len]  = '\0';
+   block[i].size       = MROUND(len + 1);
+   block[i].color_data = NULL;
+   block[i].generation = NEW_GENERATION;
+   pos += len + newline;
+   *last_line_has_newline = newline;
+}
+
+if (buff)
+   free(buff);
+
+if (!block || (i < count))
+   {
+      DEBUG3( fprintf(stderr, "read_indexed_block: file does not match the index at line %d, reading it\n", token->line_index_next + i);)
+      if (block)
+         {
+            while (--i >= 0)
+               free(block[i].text);
+            free((char *)block);
+         }
+      free((char *)token->line_index);
+      token->line_index = NULL;
+      clearerr(stream);
+      fseek(stream, start_offset, SEEK_SET);
+      return(read_a_block(token, stream, lines_put_in_block, eof, -1, False, last_line_has_newline));
+   }
+
+*lines_put_in_block = count;
+token->line_index_next += count;
+if (token->line_index_next >= token->line_index_lines)
+   {
+      free((char *)token->line_index);
+      token->line_index = NULL;
+   }
+
+return(block);
+
+} /* end of read_indexed_block */
+
+
+/************************************************************************
+
+NAME:      line_index_add
+
+PURPOSE:   This routine adds the length of a line read from the edit file
+           to the line index being recorded for the load cache.  If the
+           index cannot grow, recording stops.
+
+PARAMETERS:
+   1.   token           -  pointer to DATA_TOKEN (opaque)
+        The memdata being loaded.
+
+   2.   len             -  int (INPUT)
+        The length of the line text.
+
+   3.   newline         -  int (INPUT)
+        True if a newline followed the line.
+
+*************************************************************************/
+
+static void     line_index_add(DATA_TOKEN *token,
+                               int         len,
+                               int         newline)
+{
+uint32_t       *new_index;
+
+if (token->line_index_lines >= token->line_index_space)
+   {
+      new_index = (uint32_t *)realloc((char *)token->line_index, token->line_index_space * 2 * sizeof(uint32_t));
+      if (!new_index)
+         {
+            free((char *)token->line_index);
+            token->line_index = NULL;
+            return;
+         }
+      token->line_index = new_index;
+      token->line_index_space *= 2;
+   }
+
+token->line_index[token->line_index_lines++] = len | (newline ? LINE_INDEX_NEWLINE : 0);
+
+} /* end of line_index_add */
+
+
 
 /************************************************************************
 
@@ -1040,6 +1295,9 @@ block_ptr         = header_ptr[header_idx].block;
 
 if (!undo_semafor) event_do(token, DL_EVENT, line_no, 0, 0, block_ptr[block_idx].text);
 
+if (token->journaled)
+   journal_delete(token, line_no);
+
 if (line_no <= token->last_line_no)
    token->last_line_no = -1;
 
@@ -1061,6 +1319,7 @@ if (block_ptr[block_idx].color_data){
 
 token->data[data_idx].lines--;         /* reduce the population count */
 header_ptr[header_idx].lines--;
+BLOCK_CHANGED(token, &header_ptr[header_idx]);
 DEBUG3(fprintf(stderr," Dcount(%d)\n", header_ptr[header_idx].lines);)
 
 if (!header_ptr[header_idx].lines && (total_lines(token) > 1)){     
@@ -1076,6 +1335,7 @@ if (!header_ptr[header_idx].lines && (total_lines(token) > 1)){
          block_ptr[block_idx].text = block_ptr[block_idx+1].text;
          block_ptr[block_idx].size = block_ptr[block_idx+1].size;
          block_ptr[block_idx].color_data = block_ptr[block_idx+1].color_data;
+         block_ptr[block_idx].generation = block_ptr[block_idx+1].generation;
          block_idx++;
       }
 
@@ -1217,6 +1477,9 @@ if ((line_no > total_lines(token)) || (line_no < -1)){
       return(-1);
 }
 
+if (token->journaled)
+   journal_put(token, line_no, line, flag);
+
 hh_idx(token, &data_idx, &header_idx, &block_idx, line_no);
 
 /* #define EQN */
@@ -1317,6 +1580,7 @@ if (flag == INSERT){
          block_ptr[temp_idx+1].text =  block_ptr[temp_idx].text;
          block_ptr[temp_idx+1].size =  block_ptr[temp_idx].size;
          block_ptr[temp_idx+1].color_data =  block_ptr[temp_idx].color_data;
+         block_ptr[temp_idx+1].generation =  block_ptr[temp_idx].generation;
       }
 
       block_idx++; /* this positions us over the spot to overwrite */
@@ -1325,6 +1589,7 @@ if (flag == INSERT){
       block_ptr[block_idx].text = target;  /* implant the new record */
       block_ptr[block_idx].size = MROUND(len+1);
       block_ptr[block_idx].color_data = NULL;
+      block_ptr[block_idx].generation = NEW_GENERATION;
 
       header_ptr[header_idx].lines++; /* add one to each of the larger structures */
       token->data[data_idx].lines++;
@@ -1361,10 +1626,12 @@ else{
                token->last_line = target;
       }
       strcpy(block_ptr[block_idx].text, line);   /*  copy in new line */
+      block_ptr[block_idx].generation = NEW_GENERATION;
 /*      if (block_ptr[block_idx].color_data) put_color_by_num(token, line_no, NULL); */ /* added 6/9/97 to fix delete line/undelete line color propagation problem */
 
 } /* if INSERT/OVERWRITE */
 
+BLOCK_CHANGED(token, &header_ptr[header_idx]);
 dirty_bit(token) = 1;       /* update globals */
 
 return(0);
@@ -1767,150 +2034,735 @@ dirty_bit(token) = 0;
 
 } /* save_file */
 
+#ifndef WIN32
 /************************************************************************
 
-NAME:      hh_idx - given a line number, return  the three indexes that will
-                    point us at it.
+NAME:      save_file_fd - Write the file out with large gathered writes
 
-************************************************************************/
+PURPOSE:    This routine does what save_file does, but to a file descriptor.
+            Rather than putting each line through stdio, it points an iovec
+            at each line where it sits in the memdata blocks, and one at a
+            newline, and writes them SAVE_IOV at a time with writev.  The
+            text is not copied, so a large file goes out about as fast as
+            the disk takes it.
 
-static void     hh_idx(DATA_TOKEN *token,
-                       int        *data_idx,
-                       int        *header_idx,
-                       int        *block_idx,
-                       int         line_no)
-{
+PARAMETERS:
+   1.   token           -  pointer to DATA_TOKEN (opaque)
+        This is the pointer to the top level header structure.
 
-int i, j;
-int block_top;
-int block_bottom;
+   2.   fd              -  int (INPUT)
+        The file to write, open for output and positioned at the start.
 
-int total = 0;
+   3.   progress_fd     -  int (INPUT)
+        -1 for a normal pw.  For a background pw, this is run in the
+        process doing the writing.  The count of lines written so far
+        is written to progress_fd as a long from time to time, and no
+        messages are issued.
 
-header_struct *h_ptr;
+FUNCTIONS :
 
-DEBUG3( fprintf(stderr," @hh_idx(%d): start\n", line_no);)
-DEBUG0( if (!token || (token->marker != TOKEN_MARKER)) {fprintf(stderr, "Bad token passed to hh_idx\n"); kill(getpid(), SIGABRT);})
+   1.   Walk the lines, adding an iovec for each line and its newline.
 
-#ifdef blah
-fprintf(stderr,"ENTER-> last_hh_block_idx:%d   TOKEN(%d)\n", token->last_hh_block_idx, token);
-if (token->last_hh_block_idx == 25)
-            ob=0;
+   2.   When the iovec array is full, write it out, going around again
+        for a short write.
+
+   3.   When all the lines are out, clear the dirty bit and log the
+        PW_EVENT for undo, as save_file does.  A background pw leaves
+        this to the caller.
+
+RETURNED VALUE:
+   bytes  -  long
+             The number of bytes written, or -1 on a write failure.  A
+             message has been issued, unless progress_fd is set, and errno
+             is set.
+
+*************************************************************************/
+
+#if defined(IOV_MAX) && (IOV_MAX < 1024)
+#define SAVE_IOV  IOV_MAX
+#else
+#define SAVE_IOV  1024
 #endif
 
-if (token->current_block_idx != -1){  /* optomization! (if same block as last call) */
-    DEBUG3( fprintf(stderr," Optimizing DB search!\n");)
-    block_top = token->last_hh_line - token->last_hh_block_idx;  
-    block_bottom = block_top + token->data[token->last_hh_data_idx].header[token->last_hh_header_idx].lines -1;  
-    if ((line_no <= block_bottom) && (line_no >= block_top)){  /* we can optomize */
-       token->last_hh_block_idx += line_no - token->last_hh_line;
-       *block_idx = token->last_hh_block_idx;
-       *header_idx =  token->last_hh_header_idx;
-       *data_idx = token->last_hh_data_idx;
-       token->last_hh_line = line_no;  /* optomizes hh_idx */
-       DEBUG3( fprintf(stderr," optomizer:[D:%d, H:%d, B:%d]: stop\n", *data_idx, *header_idx, *block_idx);)
-       return; 
-    }
-}
+static int  write_iov(int            fd,
+                      struct iovec  *iov,
+                      int            count);
 
-if (line_no >= total_lines(token)) line_no = total_lines(token); 
+long     save_file_fd(DATA_TOKEN *token,       /* opaque */
+                      int         fd,          /* input  */
+                      int         progress_fd) /* input  */
+{
+int            i = 0;
+int            j;
+int            k;
+int            line_count = 0;
+int            count = 0;
+long           bytes = 0;
+long           progress;
+size_t         len;
+char           msg[80];
+struct iovec   iov[SAVE_IOV];
+static char    newline[] = "\n";
 
-if (line_no <= 0){  /* very first line is different because load a block may not have run */
-    *block_idx = 0;                                
-    *data_idx = 0;
-    *header_idx = 0;
-    token->last_hh_line = 0;  /* optomizes hh_idx */
-    token->last_hh_block_idx = 0;
-    token->last_hh_data_idx = 0;
-    token->last_hh_header_idx = 0; 
-    return;
-}
+header_struct *header_ptr;
+block_struct  *block_ptr;
 
-/*get the data index */
-for (i=0; i<DATA_SIZE; i++){
-   total += token->data[i].lines; 
+DEBUG0( if (!token || (token->marker != TOKEN_MARKER)){ fprintf(stderr, "Bad token passed to save_file_fd\n"); kill(getpid(), SIGABRT);})
+DEBUG3( fprintf(stderr, "@ save_file_fd\n");)
 
-   if ((total > line_no) || (total >= total_lines(token))){ 
-         total -= token->data[i].lines; 
-         break; 
-   }
-}
+while ((i < DATA_SIZE) && (token->data[i].header != NULL))
+{
+    header_ptr = token->data[i].header;
+    for (j = 0; (j < HEADER_SIZE) && (header_ptr[j].block != NULL); j++)
+    {
+        block_ptr = header_ptr[j].block;
+        for (k = 0; k < header_ptr[j].lines; k++)
+        {
+            if (count >= SAVE_IOV - 1)
+               {
+                  if (write_iov(fd, iov, count) != 0)
+                     {
+                        if (progress_fd < 0)
+                           {
+                              snprintf(msg, sizeof(msg), "Error writing out file near line %d (%s)", line_count+1, strerror(errno));
+                              dm_error(msg, DM_ERROR_LOG);
+                           }
+                        return(-1);
+                     }
+                  count = 0;
+               }
 
-/* get the header index */
-if (i == DATA_SIZE){
-      DEBUG( fprintf(stderr,"Line addressed out of range!: %d\n", line_no);)
-      dm_error("Line addressed out of range! (Internal Error)", DM_ERROR_LOG);
-      fprintf(stderr, "Line addressed out of range! (Internal Error)");
-      create_crash_file();
-      exit(1); 
-}
+            if (block_ptr[k].text)
+               len = strlen(block_ptr[k].text);
+            else
+               {
+                  if (progress_fd < 0)
+                     {
+                        snprintf(msg, sizeof(msg), "Internal error in save_file_fd, NULL pointer encountered, line %d lost.", line_count+1);
+                        dm_error(msg, DM_ERROR_LOG);
+                     }
+                  len = 0;
+               }
 
-h_ptr = token->data[i].header;
+            if (len)
+               {
+                  iov[count].iov_base = block_ptr[k].text;
+                  iov[count].iov_len  = len;
+                  count++;
+               }
+            iov[count].iov_base = newline;
+            iov[count].iov_len  = 1;
+            count++;
+            bytes += len + 1;
 
-for (j=0; j<HEADER_SIZE; j++){
-   if (h_ptr[j].block)
-      total += h_ptr[j].lines;
-   if ((total > line_no) || (total >= total_lines(token))){ 
-         total -= h_ptr[j].lines;
-         break; 
-   }                                                                        
-}                                                                        
+            line_count++;
+            if ((line_count == INIT_WRITE_REPORT) || (!(line_count % WRITE_REPORT) && (line_count >= INIT_WRITE_REPORT))){ 
+                 if (progress_fd >= 0)
+                    {
+                       progress = line_count;
+                       (void) write(progress_fd, (char *)&progress, sizeof(progress));
+                    }
+                 else
+                    {
+                       snprintf(msg, sizeof(msg), "Written %d lines.", line_count);
+                       dm_error(msg, DM_ERROR_MSG);
+                    }
+            }
+        }
+    }
+    i++;
+}
 
-*block_idx = line_no - total;
-*data_idx = i;
-*header_idx = j;
+if (count && (write_iov(fd, iov, count) != 0))
+   {
+      if (progress_fd < 0)
+         {
+            snprintf(msg, sizeof(msg), "Error writing out file near line %d (%s)", line_count, strerror(errno));
+            dm_error(msg, DM_ERROR_LOG);
+         }
+      return(-1);
+   }
 
-token->last_hh_line = line_no;  /* optomizes hh_idx */
-token->last_hh_block_idx = *block_idx;
-token->last_hh_data_idx = *data_idx;
-token->last_hh_header_idx = *header_idx;
+if (progress_fd < 0)
+   {
+      event_do(token, PW_EVENT, -1, 0, 0, NULL); 
+      dirty_bit(token) = 0;
+   }
+DEBUG3( fprintf(stderr, " save_file_fd: %d lines, %ld bytes\n", line_count, bytes);)
 
-DEBUG3( fprintf(stderr," hh_idx[D:%d, H:%d, B:%d]: stop\n\n", *data_idx, *header_idx, *block_idx);)
+return(bytes);
+
+} /* save_file_fd */
 
-}  /* hh_idx */
 
 /************************************************************************
 
-NAME:    remove_block - squeeze  a block out by removing it and
-                pulling all following blocks up.
+NAME:      write_iov - Write an iovec array, finishing short writes
 
-************************************************************************/
+*************************************************************************/
 
-static void     remove_block(DATA_TOKEN *token,
-                             int         data_idx,
-                             int         header_idx)
+static int  write_iov(int            fd,
+                      struct iovec  *iov,
+                      int            count)
 {
+ssize_t        rc;
 
-header_struct *header_ptr;
+while (count > 0)
+{
+   rc = writev(fd, iov, count);
+   if (rc < 0)
+      {
+         if (errno == EINTR)
+            continue;
+         return(-1);
+      }
+   if (rc == 0)
+      {
+         errno = ENOSPC;
+         return(-1);
+      }
 
-DEBUG0( if (!token || (token->marker != TOKEN_MARKER)) {fprintf(stderr, "Bad token passed to remove_block\n"); kill(getpid(), SIGABRT);})
-header_ptr = token->data[data_idx].header;
+   while ((count > 0) && ((size_t)rc >= iov->iov_len))
+   {
+      rc -= iov->iov_len;
+      iov++;
+      count--;
+   }
+   if (count > 0)
+      {
+         iov->iov_base  = (char *)iov->iov_base + rc;
+         iov->iov_len  -= rc;
+      }
+}
 
-free((char *)header_ptr[header_idx].block);
-shift_left(token->data[data_idx].color_bits, HEADER_SIZE, header_idx);             /* color bits need to be removed */
+return(0);
 
-while((header_idx < (HEADER_SIZE-1)) && (header_ptr[header_idx].block != NULL)){
-   header_ptr[header_idx] = header_ptr[header_idx+1];
-#ifdef blahbob
-   header_ptr[header_idx].block = header_ptr[header_idx+1].block;
-   header_ptr[header_idx].lines = header_ptr[header_idx+1].lines;
-   copy_color_block(header_ptr[header_idx].color_data, header_ptr[header_idx+1].color_data);
+} /* write_iov */
 #endif
-   header_idx++;
-}
 
-if (-1 == prev_bit(token->data[data_idx].color_bits, HEADER_SIZE)){
-   clear_color_bit(token->color_bits, data_idx);                  /* color bits need to be removed */
+/************************************************************************
 
-   if (-1 == prev_bit(token->color_bits, DATA_SIZE))
-      token->colored = False;
-}
+NAME:      save_blocks - Write the changed blocks to an autosave image
 
-header_ptr[HEADER_SIZE-1].block = NULL;
-header_ptr[HEADER_SIZE-1].lines  = 0;
-clear_color_block(header_ptr[HEADER_SIZE-1].color_bits);
+PURPOSE:    This routine writes the text of each block which is not saved
+            in the edit file or the current image to the end of the image.
+            Blocks which were not changed since they were last saved are
+            skipped, so the cost follows the edits rather than the size of
+            the file.  The work can be done in pieces, a call stops once
+            it has written max_bytes and the next call picks up the blocks
+            still not saved, including any changed in between.
 
-}  /* remove_block  */
+PARAMETERS:
+   1.   token           -  pointer to DATA_TOKEN (opaque)
+        This is the pointer to the top level header structure.
+
+   2.   fd              -  int (INPUT)
+        The open image file.
+
+   3.   image           -  unsigned int (INPUT)
+        The saved_in value for the image, above SAVED_IN_FILE.  Blocks saved
+        in any other image are written again.
+
+   4.   image_end       -  pointer to long (INPUT / OUTPUT)
+        The offset in the image to write at, moved past what is written.
+
+   5.   max_bytes       -  long (INPUT)
+        Stop after writing about this much.
+
+FUNCTIONS :
+
+   1.   Walk the blocks.  For each one not saved in the file or image,
+        gather its lines into a buffer, each with a newline as save_file
+        writes them, and write the buffer at image_end.
+
+   2.   Record where the block went in its header.
+
+   3.   If every block is saved, clear blocks_dirty.
+
+RETURNED VALUE:
+   rc   -  int
+           1  -  Every block is saved
+           0  -  max_bytes was reached, there is more to do
+          -1  -  Write failure, errno is set
+
+*************************************************************************/
+
+int      save_blocks(DATA_TOKEN   *token,       /* opaque */
+                     int           fd,          /* input  */
+                     unsigned int  image,       /* input  */
+                     long         *image_end,   /* input / output */
+                     long          max_bytes)   /* input  */
+{
+int            i = 0;
+int            j;
+int            k;
+long           written = 0;
+long           bytes;
+long           pos;
+int            rc;
+char          *buff = NULL;
+long           buff_size = 0;
+
+header_struct *header_ptr;
+block_struct  *block_ptr;
+
+DEBUG0( if (!token || (token->marker != TOKEN_MARKER)){ fprintf(stderr, "Bad token passed to save_blocks\n"); kill(getpid(), SIGABRT);})
+
+while ((i < DATA_SIZE) && (token->data[i].header != NULL))
+{
+    header_ptr = token->data[i].header;
+    for (j = 0; (j < HEADER_SIZE) && (header_ptr[j].block != NULL); j++)
+    {
+        if ((header_ptr[j].saved_in == SAVED_IN_FILE) || (header_ptr[j].saved_in == image))
+           continue;
+
+        if (written >= max_bytes)
+           {
+              if (buff)
+                 free(buff);
+              return(0);
+           }
+
+        block_ptr = header_ptr[j].block;
+        bytes = 0;
+        for (k = 0; k < header_ptr[j].lines; k++)
+           bytes += (block_ptr[k].text ? strlen(block_ptr[k].text) : 0) + 1;
+
+        if (bytes > buff_size)
+           {
+              if (buff)
+                 free(buff);
+              buff_size = bytes;
+              buff = CE_MALLOC(buff_size);
+              if (!buff)
+                 return(-1);
+           }
+
+        pos = 0;
+        for (k = 0; k < header_ptr[j].lines; k++)
+        {
+           if (block_ptr[k].text)
+              {
+                 strcpy(buff + pos, block_ptr[k].text);
+                 pos += strlen(block_ptr[k].text);
+              }
+           buff[pos++] = '\n';
+        }
+
+        if (lseek(fd, *image_end, SEEK_SET) < 0)
+           {
+              if (buff)
+                 free(buff);
+              return(-1);
+           }
+        pos = 0;
+        while (pos < bytes)
+        {
+           rc = write(fd, buff + pos, bytes - pos);
+           if (rc < 0)
+              {
+                 if (errno == EINTR)
+                    continue;
+                 free(buff);
+                 return(-1);
+              }
+           pos += rc;
+        }
+
+        header_ptr[j].saved_in     = image;
+        header_ptr[j].saved_offset = *image_end;
+        header_ptr[j].saved_bytes  = bytes;
+        *image_end += bytes;
+        written    += bytes;
+    }
+    i++;
+}
+
+if (buff)
+   free(buff);
+token->blocks_dirty = False;
+DEBUG3( fprintf(stderr, " save_blocks: %ld bytes written, image ends at %ld\n", written, *image_end);)
+
+return(1);
+
+} /* save_blocks */
+
+
+/************************************************************************
+
+NAME:      block_map - Describe where each block was saved
+
+PURPOSE:    Once save_blocks has saved every block, this routine returns
+            the runs of saved text which make up the buffer, in order.
+            Blocks saved next to each other in the same place are one run,
+            so an edit file with a few changed blocks gives a short map.
+
+PARAMETERS:
+   1.   token           -  pointer to DATA_TOKEN (opaque)
+
+   2.   count           -  pointer to int (OUTPUT)
+        The number of runs returned.
+
+RETURNED VALUE:
+   map  -  pointer to BLOCK_MAP
+           A malloc'ed array of count runs, the caller frees it.  NULL
+           if there is no memory or a block is not saved.
+
+*************************************************************************/
+
+BLOCK_MAP *block_map(DATA_TOKEN   *token,       /* opaque */
+                     int          *count)       /* output */
+{
+int            i = 0;
+int            j;
+int            max_count = 64;
+BLOCK_MAP     *map;
+BLOCK_MAP     *new_map;
+
+header_struct *header_ptr;
+
+DEBUG0( if (!token || (token->marker != TOKEN_MARKER)){ fprintf(stderr, "Bad token passed to block_map\n"); kill(getpid(), SIGABRT);})
+
+*count = 0;
+map = (BLOCK_MAP *)CE_MALLOC(max_count * sizeof(BLOCK_MAP));
+if (!map)
+   return(NULL);
+
+while ((i < DATA_SIZE) && (token->data[i].header != NULL))
+{
+    header_ptr = token->data[i].header;
+    for (j = 0; (j < HEADER_SIZE) && (header_ptr[j].block != NULL); j++)
+    {
+        if (header_ptr[j].saved_in == SAVED_IN_NONE)
+           {
+              free((char *)map);
+              return(NULL);
+           }
+        if (header_ptr[j].saved_bytes == 0)
+           continue;
+
+        if ((*count > 0) && (map[*count-1].saved_in == header_ptr[j].saved_in) &&
+            (map[*count-1].offset + map[*count-1].bytes == header_ptr[j].saved_offset))
+           {
+              map[*count-1].bytes += header_ptr[j].saved_bytes;
+              continue;
+           }
+
+        if (*count == max_count)
+           {
+              max_count *= 2;
+              new_map = (BLOCK_MAP *)realloc((char *)map, max_count * sizeof(BLOCK_MAP));
+              if (!new_map)
+                 {
+                    malloc_error(max_count * sizeof(BLOCK_MAP), __FILE__, __LINE__);
+                    free((char *)map);
+                    return(NULL);
+                 }
+              map = new_map;
+           }
+        map[*count].offset   = header_ptr[j].saved_offset;
+        map[*count].bytes    = header_ptr[j].saved_bytes;
+        map[*count].saved_in = header_ptr[j].saved_in;
+        (*count)++;
+    }
+    i++;
+}
+
+return(map);
+
+} /* block_map */
+
+
+/************************************************************************
+
+NAME:      blocks_saved - Mark every block saved in the edit file after a pw
+
+PURPOSE:    After save_file writes the edit file, each block is in the
+            file at the sum of the lines before it.  This routine records
+            that so the next autosave only writes blocks changed later.
+
+*************************************************************************/
+
+void     blocks_saved(DATA_TOKEN *token)       /* opaque */
+{
+int            i = 0;
+int            j;
+int            k;
+long           offset = 0;
+long           bytes;
+
+header_struct *header_ptr;
+block_struct  *block_ptr;
+
+DEBUG0( if (!token || (token->marker != TOKEN_MARKER)){ fprintf(stderr, "Bad token passed to blocks_saved\n"); kill(getpid(), SIGABRT);})
+
+while ((i < DATA_SIZE) && (token->data[i].header != NULL))
+{
+    header_ptr = token->data[i].header;
+    for (j = 0; (j < HEADER_SIZE) && (header_ptr[j].block != NULL); j++)
+    {
+        block_ptr = header_ptr[j].block;
+        bytes = 0;
+        for (k = 0; k < header_ptr[j].lines; k++)
+           bytes += (block_ptr[k].text ? strlen(block_ptr[k].text) : 0) + 1;
+
+        header_ptr[j].saved_in     = SAVED_IN_FILE;
+        header_ptr[j].saved_offset = offset;
+        header_ptr[j].saved_bytes  = bytes;
+        offset += bytes;
+    }
+    i++;
+}
+
+token->blocks_dirty = False;
+
+} /* blocks_saved */
+
+
+/************************************************************************
+
+NAME:      blocks_pending - Note where each block goes in a background pw
+
+PURPOSE:    A background pw writes the buffer as it was when the pw was
+            done, while editing goes on.  This routine records where each
+            block will be in the new file, as blocks_saved would, but in
+            the pending fields.  A block changed before the pw finishes
+            loses its pending mark.
+
+*************************************************************************/
+
+void     blocks_pending(DATA_TOKEN *token)     /* opaque */
+{
+int            i = 0;
+int            j;
+int            k;
+long           offset = 0;
+long           bytes;
+
+header_struct *header_ptr;
+block_struct  *block_ptr;
+
+DEBUG0( if (!token || (token->marker != TOKEN_MARKER)){ fprintf(stderr, "Bad token passed to blocks_pending\n"); kill(getpid(), SIGABRT);})
+
+while ((i < DATA_SIZE) && (token->data[i].header != NULL))
+{
+    header_ptr = token->data[i].header;
+    for (j = 0; (j < HEADER_SIZE) && (header_ptr[j].block != NULL); j++)
+    {
+        block_ptr = header_ptr[j].block;
+        bytes = 0;
+        for (k = 0; k < header_ptr[j].lines; k++)
+           bytes += (block_ptr[k].text ? strlen(block_ptr[k].text) : 0) + 1;
+
+        header_ptr[j].pending        = True;
+        header_ptr[j].pending_offset = offset;
+        header_ptr[j].pending_bytes  = bytes;
+        offset += bytes;
+    }
+    i++;
+}
+
+} /* blocks_pending */
+
+
+/************************************************************************
+
+NAME:      blocks_pending_saved - Mark the blocks a background pw saved
+
+PURPOSE:    When a background pw finishes, the blocks still marked pending
+            are in the new file just as they are in memory, so they are
+            marked saved in the file.  The rest were changed during the
+            pw and are saved nowhere.  If the pw failed, the pending marks
+            are dropped and the blocks stay saved where they were.
+
+PARAMETERS:
+   1.   token           -  pointer to DATA_TOKEN (opaque)
+
+   2.   saved           -  int (INPUT)
+        True if the new file was written.
+
+*************************************************************************/
+
+void     blocks_pending_saved(DATA_TOKEN *token,     /* opaque */
+                              int         saved)     /* input  */
+{
+int            i = 0;
+int            j;
+
+header_struct *header_ptr;
+
+DEBUG0( if (!token || (token->marker != TOKEN_MARKER)){ fprintf(stderr, "Bad token passed to blocks_pending_saved\n"); kill(getpid(), SIGABRT);})
+
+while ((i < DATA_SIZE) && (token->data[i].header != NULL))
+{
+    header_ptr = token->data[i].header;
+    for (j = 0; (j < HEADER_SIZE) && (header_ptr[j].block != NULL); j++)
+    {
+        if (saved)
+           {
+              if (header_ptr[j].pending)
+                 {
+                    header_ptr[j].saved_in     = SAVED_IN_FILE;
+                    header_ptr[j].saved_offset = header_ptr[j].pending_offset;
+                    header_ptr[j].saved_bytes  = header_ptr[j].pending_bytes;
+                 }
+              else
+                 {
+                    header_ptr[j].saved_in = SAVED_IN_NONE;
+                    token->blocks_dirty = True;
+                 }
+           }
+        header_ptr[j].pending = False;
+    }
+    i++;
+}
+
+} /* blocks_pending_saved */
+
+/************************************************************************
+
+NAME:      hh_idx - given a line number, return  the three indexes that will
+                    point us at it.
+
+************************************************************************/
+
+static void     hh_idx(DATA_TOKEN *token,
+                       int        *data_idx,
+                       int        *header_idx,
+                       int        *block_idx,
+                       int         line_no)
+{
+
+int i, j;
+int block_top;
+int block_bottom;
+
+int total = 0;
+
+header_struct *h_ptr;
+
+DEBUG3( fprintf(stderr," @hh_idx(%d): start\n", line_no);)
+DEBUG0( if (!token || (token->marker != TOKEN_MARKER)) {fprintf(stderr, "Bad token passed to hh_idx\n"); kill(getpid(), SIGABRT);})
+
+#ifdef blah
+fprintf(stderr,"ENTER-> last_hh_block_idx:%d   TOKEN(%d)\n", token->last_hh_block_idx, token);
+if (token->last_hh_block_idx == 25)
+            ob=0;
+#endif
+
+if (token->current_block_idx != -1){  /* optomization! (if same block as last call) */
+    DEBUG3( fprintf(stderr," Optimizing DB search!\n");)
+    block_top = token->last_hh_line - token->last_hh_block_idx;  
+    block_bottom = block_top + token->data[token->last_hh_data_idx].header[token->last_hh_header_idx].lines -1;  
+    if ((line_no <= block_bottom) && (line_no >= block_top)){  /* we can optomize */
+       token->last_hh_block_idx += line_no - token->last_hh_line;
+       *block_idx = token->last_hh_block_idx;
+       *header_idx =  token->last_hh_header_idx;
+       *data_idx = token->last_hh_data_idx;
+       token->last_hh_line = line_no;  /* optomizes hh_idx */
+       DEBUG3( fprintf(stderr," optomizer:[D:%d, H:%d, B:%d]: stop\n", *data_idx, *header_idx, *block_idx);)
+       return; 
+    }
+}
+
+if (line_no >= total_lines(token)) line_no = total_lines(token); 
+
+if (line_no <= 0){  /* very first line is different because load a block may not have run */
+    *block_idx = 0;                                
+    *data_idx = 0;
+    *header_idx = 0;
+    token->last_hh_line = 0;  /* optomizes hh_idx */
+    token->last_hh_block_idx = 0;
+    token->last_hh_data_idx = 0;
+    token->last_hh_header_idx = 0; 
+    return;
+}
+
+/*get the data index */
+for (i=0; i<DATA_SIZE; i++){
+   total += token->data[i].lines; 
+
+   if ((total > line_no) || (total >= total_lines(token))){ 
+         total -= token->data[i].lines; 
+         break; 
+   }
+}
+
+/* get the header index */
+if (i == DATA_SIZE){
+      DEBUG( fprintf(stderr,"Line addressed out of range!: %d\n", line_no);)
+      dm_error("Line addressed out of range! (Internal Error)", DM_ERROR_LOG);
+      fprintf(stderr, "Line addressed out of range! (Internal Error)");
+      create_crash_file();
+      exit(1); 
+}
+
+h_ptr = token->data[i].header;
+
+for (j=0; j<HEADER_SIZE; j++){
+   if (h_ptr[j].block)
+      total += h_ptr[j].lines;
+   if ((total > line_no) || (total >= total_lines(token))){ 
+         total -= h_ptr[j].lines;
+         break; 
+   }                                                                        
+}                                                                        
+
+*block_idx = line_no - total;
+*data_idx = i;
+*header_idx = j;
+
+token->last_hh_line = line_no;  /* optomizes hh_idx */
+token->last_hh_block_idx = *block_idx;
+token->last_hh_data_idx = *data_idx;
+token->last_hh_header_idx = *header_idx;
+
+DEBUG3( fprintf(stderr," hh_idx[D:%d, H:%d, B:%d]: stop\n\n", *data_idx, *header_idx, *block_idx);)
+
+}  /* hh_idx */
+
+/************************************************************************
+
+NAME:    remove_block - squeeze  a block out by removing it and
+                pulling all following blocks up.
+
+************************************************************************/
+
+static void     remove_block(DATA_TOKEN *token,
+                             int         data_idx,
+                             int         header_idx)
+{
+
+header_struct *header_ptr;
+
+DEBUG0( if (!token || (token->marker != TOKEN_MARKER)) {fprintf(stderr, "Bad token passed to remove_block\n"); kill(getpid(), SIGABRT);})
+header_ptr = token->data[data_idx].header;
+
+free((char *)header_ptr[header_idx].block);
+shift_left(token->data[data_idx].color_bits, HEADER_SIZE, header_idx);             /* color bits need to be removed */
+
+while((header_idx < (HEADER_SIZE-1)) && (header_ptr[header_idx].block != NULL)){
+   header_ptr[header_idx] = header_ptr[header_idx+1];
+#ifdef blahbob
+   header_ptr[header_idx].block = header_ptr[header_idx+1].block;
+   header_ptr[header_idx].lines = header_ptr[header_idx+1].lines;
+   copy_color_block(header_ptr[header_idx].color_data, header_ptr[header_idx+1].color_data);
+#endif
+   header_idx++;
+}
+
+if (-1 == prev_bit(token->data[data_idx].color_bits, HEADER_SIZE)){
+   clear_color_bit(token->color_bits, data_idx);                  /* color bits need to be removed */
+
+   if (-1 == prev_bit(token->color_bits, DATA_SIZE))
+      token->colored = False;
+}
+
+header_ptr[HEADER_SIZE-1].block = NULL;
+header_ptr[HEADER_SIZE-1].lines  = 0;
+clear_color_block(header_ptr[HEADER_SIZE-1].color_bits);
+
+}  /* remove_block  */
 
 /************************************************************************
 
@@ -2137,6 +2989,7 @@ if (block_idx < header_ptr[header_idx].lines && block_idx >= 0)
           new_block[j].text = block_ptr[i].text; 
           new_block[j].size = block_ptr[i].size; 
           new_block[j].color_data = block_ptr[i].color_data; 
+          new_block[j].generation = block_ptr[i].generation; 
       }
 
       new_block_lines = j;
@@ -2173,8 +3026,10 @@ for (i = first_block_to_move, j = i + blocks_needed;
 /* clear the one or two new spaces */
 while(j > header_idx){
    clear_color_block(header_ptr[j].color_bits);
+   BLOCK_CHANGED(token, &header_ptr[j]);
    header_ptr[j--].block = NULL;
 }
+BLOCK_CHANGED(token, &header_ptr[header_idx]);
 
  /*
   *  Put the new line block in place in the header.
@@ -2355,6 +3210,302 @@ return(sum);
 
 }  /* sum_size */
 
+/************************************************************************
+
+NAME:    line_generation - get the change generation of a line
+
+PURPOSE:   This routine returns the generation number of a line.  The
+           generation changes each time the text or color data of the
+           line changes.  The drawing code uses the line address and the
+           generation to tell whether a line has changed since it was
+           last drawn.
+
+PARAMETERS:
+   1.   token           -  pointer to DATA_TOKEN (opaque)
+        This is the pointer to the top level header structure.
+
+   2.   line_no         -  int (INPUT)
+        This is the zero based line number.
+
+   3.   line            -  pointer to char (INPUT)
+        This is the line address the caller is holding.  It is normally
+        the value returned by next_line or get_line_by_num for line_no.
+
+RETURNED VALUE:
+   generation - unsigned int
+        The generation of the line is returned.  Zero is returned if
+        the line number is out of range or the passed line address is
+        not the one in memdata (such as a work buffer).
+
+************************************************************************/
+
+unsigned int line_generation(DATA_TOKEN *token,        /* opaque */
+                             int         line_no,      /* input  */
+                             char       *line)         /* input  */
+{
+int                data_idx;
+int                header_idx;
+int                block_idx;
+block_struct      *block_ptr;
+header_struct     *header_ptr;
+
+if ((line_no >= total_lines(token)) || (line_no < 0) || !line)
+   return(0);
+
+hh_idx(token, &data_idx, &header_idx, &block_idx, line_no);
+
+header_ptr = token->data[data_idx].header;
+if (!header_ptr) return(0);
+
+block_ptr = header_ptr[header_idx].block;
+if (!block_ptr || (block_ptr[block_idx].text != line)) return(0);
+
+return(block_ptr[block_idx].generation);
+
+}  /* line_generation */
+
+/************************************************************************
+
+NAME:    line_spans - describe a range of lines block by block
+
+PURPOSE:   This routine returns one LINE_SPAN for each block holding lines
+           in the range.  Lines in a span are read with span_line, which
+           does not use or move the next_line position.  This lets
+           several threads read different spans at once.  The spans are
+           only good until the memdata is next changed.
+
+PARAMETERS:
+   1.   token           -  pointer to DATA_TOKEN (opaque)
+        This is the pointer to the top level header structure.
+
+   2.   from_line       -  int (INPUT)
+        This is the first zero based line in the range.
+
+   3.   to_line         -  int (INPUT)
+        This is the last zero based line in the range.
+
+   4.   count           -  pointer to int (OUTPUT)
+        The number of spans returned is placed here.
+
+RETURNED VALUE:
+   spans - pointer to LINE_SPAN
+        A malloc'ed array of spans in line order is returned.  The
+        caller frees it.  NULL is returned if the range is empty or
+        malloc fails.
+
+************************************************************************/
+
+LINE_SPAN *line_spans(DATA_TOKEN *token,        /* opaque */
+                      int         from_line,    /* input  */
+                      int         to_line,      /* input  */
+                      int        *count)        /* output */
+{
+int                data_idx;
+int                header_idx;
+int                block_idx;
+int                max_spans;
+int                lines;
+header_struct     *header_ptr;
+LINE_SPAN         *spans;
+LINE_SPAN         *new_spans;
+
+DEBUG0( if (!token || (token->marker != TOKEN_MARKER)){ fprintf(stderr, "Bad token passed to line_spans"); kill(getpid(), SIGABRT);})
+
+*count = 0;
+if (from_line < 0)
+   from_line = 0;
+if (to_line >= total_lines(token))
+   to_line = total_lines(token) - 1;
+if (from_line > to_line)
+   return(NULL);
+
+/* blocks are never less than 1 line, but are normally mostly full */
+max_spans = ((to_line - from_line) / (LINES_PER_BLOCK / 8)) + 2;
+spans = (LINE_SPAN *)CE_MALLOC(max_spans * sizeof(LINE_SPAN));
+
+hh_idx(token, &data_idx, &header_idx, &block_idx, from_line);
+
+while (spans && (data_idx < DATA_SIZE) && (token->data[data_idx].header != NULL) && (from_line <= to_line)){
+    header_ptr = token->data[data_idx].header;
+    while ((header_idx < HEADER_SIZE) && (header_ptr[header_idx].block != NULL) && (from_line <= to_line)){
+        lines = MIN(header_ptr[header_idx].lines - block_idx, to_line - from_line + 1);
+        if (lines > 0){
+            if (*count == max_spans){
+                max_spans *= 2;
+                new_spans = (LINE_SPAN *)realloc((char *)spans, max_spans * sizeof(LINE_SPAN));
+                if (!new_spans){
+                   malloc_error(max_spans * sizeof(LINE_SPAN), __FILE__, __LINE__);
+                   free((char *)spans);
+                   *count = 0;
+                   return(NULL);
+                }
+                spans = new_spans;
+            }
+            spans[*count].block      = (void *)header_ptr[header_idx].block;
+            spans[*count].header     = (void *)&header_ptr[header_idx];
+            spans[*count].first_idx  = block_idx;
+            spans[*count].first_line = from_line;
+            spans[*count].lines      = lines;
+            (*count)++;
+            from_line += lines;
+        }
+        header_idx++;
+        block_idx = 0;
+    }
+    data_idx++;
+    header_idx = 0;
+}
+
+DEBUG3( fprintf (stderr, " @line_spans -> %d spans\n", *count);)
+return(spans);
+
+}  /* line_spans */
+
+/************************************************************************
+
+NAME:    span_line - get a line out of a span
+
+PURPOSE:   This routine returns the text of line idx (zero based from
+           the start of the span) of a span built by line_spans.
+
+************************************************************************/
+
+char *span_line(LINE_SPAN  *span,        /* input  */
+                int         idx)         /* input  */
+{
+
+return(((block_struct *)span->block)[span->first_idx + idx].text);
+
+}  /* span_line */
+
+/************************************************************************
+
+NAME:    span_generation - sum the line generations of a span
+
+PURPOSE:   This routine adds up the generation numbers of the lines in a
+           span.  Lines keep their generation when they move within or
+           between blocks, and any change gives a line a new one, so the
+           sum changes when any line in the span is changed, added or
+           removed.  Callers which save results for a whole block use it
+           to tell when the block has changed.
+
+************************************************************************/
+
+unsigned int span_generation(LINE_SPAN  *span)        /* input  */
+{
+block_struct      *block = &((block_struct *)span->block)[span->first_idx];
+unsigned int       sum = 0;
+int                i;
+
+for (i = 0; i < span->lines; i++)
+   sum += block[i].generation;
+
+return(sum);
+
+}  /* span_generation */
+
+/************************************************************************
+
+NAME:    current_generation - get the last generation handed out
+
+PURPOSE:   This routine returns the most recent generation number given to
+           any line in any token.  If it has not moved, no line has been
+           changed or added since it was last looked at.
+
+************************************************************************/
+
+unsigned int current_generation(void)
+{
+
+return(next_generation);
+
+}  /* current_generation */
+
+/************************************************************************
+
+NAME:    swap_lines - Exchange many lines with replacements in one step
+
+PURPOSE:   This routine puts a set of replacement lines into memdata by
+           exchanging the text pointers in the blocks.  Nothing is copied
+           and the number of lines does not change.  Since the exchange
+           is its own inverse, the same array undoes and redoes it.  The
+           other windows get one redraw for the whole range and the undo
+           list gets one event.
+
+PARAMETERS:
+   1.   token           -  pointer to DATA_TOKEN (opaque)
+        This is the pointer to the top level header structure.
+
+   2.   swaps           -  pointer to LINE_SWAP (INPUT / OUTPUT)
+        The replacement lines in ascending line order.  On return each
+        entry holds the line which was replaced.  Unless this is an undo
+        or redo, the array is handed to the undo list and the caller must
+        not touch it again.
+
+   3.   count           -  int (INPUT)
+        The number of entries in swaps.
+
+************************************************************************/
+
+void     swap_lines(DATA_TOKEN *token,        /* opaque */
+                    LINE_SWAP  *swaps,        /* input / output */
+                    int         count)        /* input  */
+{
+LINE_SPAN         *spans;
+int                nspans;
+int                i;
+int                k = 0;
+block_struct      *block;
+char              *text;
+int                size;
+
+DEBUG0( if (!token || (token->marker != TOKEN_MARKER)){ fprintf(stderr, "Bad token passed to swap_lines"); kill(getpid(), SIGABRT);})
+DEBUG3( fprintf(stderr, " @swap_lines(%d lines from %d)\n", count, (count > 0) ? swaps[0].line_no : -1);)
+
+if (count <= 0)
+   return;
+
+spans = line_spans(token, swaps[0].line_no, swaps[count-1].line_no, &nspans);
+if (!spans)
+   return;
+
+for (i = 0; i < count; i++)
+{
+   while ((k < nspans) && (swaps[i].line_no >= spans[k].first_line + spans[k].lines))
+      k++;
+   if ((k >= nspans) || (swaps[i].line_no < spans[k].first_line))
+      break; /* out of order or past the end, cannot happen */
+
+   block = &((block_struct *)spans[k].block)[spans[k].first_idx + swaps[i].line_no - spans[k].first_line];
+   if (token->journaled && swaps[i].text)
+      journal_put(token, swaps[i].line_no, swaps[i].text, OVERWRITE);
+   text = block->text;
+   size = block->size;
+   block->text = swaps[i].text;
+   block->size = swaps[i].size;
+   block->generation = NEW_GENERATION;
+   BLOCK_CHANGED(token, (header_struct *)spans[k].header);
+   swaps[i].text = text;
+   swaps[i].size = size;
+}
+
+free((char *)spans);
+
+/*
+ *  The line held for get_line_by_num may be one of the old ones.
+ */
+if ((token->last_line_no >= swaps[0].line_no) && (token->last_line_no <= swaps[count-1].line_no))
+   token->last_line_no = -1;
+
+if (cc_ce)
+   cc_lines_changed(token, swaps[0].line_no, swaps[count-1].line_no);
+
+if (!undo_semafor) event_swap(token, swaps, count);
+
+dirty_bit(token) = 1;
+
+}  /* swap_lines */
+
 #ifdef Encrypt
 
 /****************************************************************************
@@ -2522,6 +3673,131 @@ delete_line_by_num(token, line_no + 1, 1);
 
 }  /* end of join_line */  
 
+/************************************************************************
+
+NAME:      join_marked_lines  - Join a run of lines marked by delayed_delete in one step
+
+PURPOSE:    A substitute which removes newlines (s/@n/x/) marks each line it
+            changes with delayed_delete and they are joined one at a time
+            from the bottom up.  Each join copies the whole joined text
+            below it again, so joining many lines is quadratic.  This
+            routine finds the run of marked lines ending at line_no and
+            builds the joined line once.  It does the same as calling
+            delayed_delete(NOW, join) on each line of the run, as long as
+            none of the lines holds a newline for the caller to split.
+
+PARAMETERS:
+
+   1.  token      -  pointer to DATA_TOKEN (INPUT / OUTPUT)
+                     This is the token for the memdata structure being operated on.
+
+   2.  from_line  -  int  (INPUT)
+                     The run does not go above this line.
+
+   3.  line_no    -  int  (INPUT)
+                     The last marked line in the run, line_no + 1 is appended
+                     onto the end of it.
+
+   4.  column     -  pointer to int  (OUTPUT)
+                     Set to one more than the length of the joined line, as
+                     delayed_delete does.
+
+FUNCTIONS :
+
+   1.   Walk up from line_no while the lines are marked for a join and
+        have no newlines in them.  If there is less than two, return zero
+        and let the caller join them one at a time.
+
+   2.   Copy the run and the line after it into a work buffer, truncating
+        on overflow with a message.
+
+   3.   Replace the first line of the run and delete the rest.
+
+RETURNED VALUE:
+   joined  -  int
+              The number of marked lines joined, 0 if nothing was done.
+
+*************************************************************************/
+
+int      join_marked_lines(DATA_TOKEN *token,       /* opaque */
+                           int         from_line,   /* input  */
+                           int         line_no,     /* input  */
+                           int        *column)      /* output */
+{
+int                data_idx;
+int                header_idx;
+int                block_idx;
+block_struct      *block_ptr;
+int                first;
+int                i;
+int                len = 0;
+int                n;
+char              *line;
+char              *buff;
+
+DEBUG0( if (!token || (token->marker != TOKEN_MARKER)){ fprintf(stderr, "Bad token passed to join_marked_lines\n"); kill(getpid(), SIGABRT);})
+
+/*
+ *  cc needs each join passed to the other windows.
+ */
+if (cc_ce || (line_no < from_line) || (line_no < 0) || ((line_no+1) >= total_lines(token)))
+   return(0);
+
+if (strchr(get_line_by_num(token, line_no+1), '\n'))
+   return(0);
+
+for (first = line_no; first >= from_line; first--)
+{
+   hh_idx(token, &data_idx, &header_idx, &block_idx, first);
+   block_ptr = token->data[data_idx].header[header_idx].block;
+   if ((block_ptr[block_idx].size >= 0) || (block_ptr[block_idx].size == DELETE_TOKEN) ||
+       !block_ptr[block_idx].text || strchr(block_ptr[block_idx].text, '\n'))
+      break;
+}
+first++;
+
+if ((line_no - first) < 1)
+   return(0);
+
+DEBUG3(fprintf(stderr," @join_marked_lines(lines %d-%d)\n", first, line_no+1);)
+
+buff = CE_MALLOC(MAX_LINE+1);
+if (!buff)
+   return(0);
+
+position_file_pointer(token, first);
+for (i = first; i <= line_no+1; i++)
+{
+   line = next_line(token);
+   if (!line)
+      break;
+   n = strlen(line);
+   if (len + n > MAX_LINE)
+      {
+         dm_error("Line too long", DM_ERROR_BEEP);
+         memcpy(buff + len, line, MAX_LINE - len);
+         len = MAX_LINE;
+         break;
+      }
+   memcpy(buff + len, line, n);
+   len += n;
+}
+buff[len] = '\0';
+
+put_line_by_num(token, first, buff, OVERWRITE);
+for (i = line_no+1; i > first; i--)
+   delete_line_by_num(token, i, 1);
+free(buff);
+
+hh_idx(token, &data_idx, &header_idx, &block_idx, first);
+block_ptr = token->data[data_idx].header[header_idx].block;
+block_ptr[block_idx].size = MROUND(len+1);
+*column = len+1;
+
+return(line_no - first + 1);
+
+}  /* end of join_marked_lines */
+
 #ifdef DebuG
 /************************************************************************
 
@@ -3139,6 +4415,8 @@ if (!undo_semafor) event_do(token, PC_EVENT, line_no, 0, 0, block_ptr[block_idx]
 if (block_ptr[block_idx].color_data)
     free(block_ptr[block_idx].color_data); /* don't NULL out pointer yet */
 
+block_ptr[block_idx].generation = NEW_GENERATION; /* cached drawing of this line is no good now */
+
 if (!color_data || !*color_data){  /* clear the color data */
     block_ptr[block_idx].color_data = NULL;
     clear_color_bit(header_ptr[header_idx].color_bits, block_idx);
@@ -44,11 +44,19 @@
 *     put_line_by_num       -  Replace or insert a line
 *     put_block_by_num      -  Insert multiple lines from a file
 *     save_file             -  Write the file out.
+*     save_file_fd          -  Write the file out with large gathered writes.
 *     delayed_delete        - Mark a line to be deleted later
 *     sum_size              - Sum the malloced sizes of a range of lines
+*     line_generation       - Get the change generation of a line for display caching
+*     line_spans            - Describe a range of lines block by block
+*     span_line             - Get a line out of a span
+*     span_generation       - Sum the line generations of a span
+*     current_generation    - Get the last generation handed out
+*     swap_lines            - Exchange many lines with replacements in one step
 *     encrypt_init          -  Initialize an encryption
 *     encrypt_line          -  Encrypt a line of data
 *     join_line             -   join one line to the next one after it.
+*     join_marked_lines     -   join a run of lines marked by delayed_delete in one step
 *     mem_kill              - kill a memdata structure.
 *     vt100_eat             - Eat vt100 control sequences when in cv -man mode
 *     print_color_bits      - Dump the color lines and the color bit patterns
@@ -78,22 +86,57 @@
 
 struct event_struct;  /* forward reference */
 
+/*
+ *  The undo events for a token are records packed one after another in
+ *  chunks.  A record is an event_struct followed by the text it saved,
+ *  rounded up to 8 bytes.  Walking is done with the record sizes, so
+ *  there are no link pointers and no malloc per event.  Old chunks may
+ *  be written to the spill file, the chunk header stays as the index.
+ */
 struct event_struct
 {
-short int malloc_size;
-short int malloc_old_size;
+unsigned int size;           /* bytes in this record, the next one follows it */
+unsigned int last_size;      /* bytes in the record before it in the chunk, 0 for the first */
+short int type;              /* type of database mnodifying event {PL, DL, ...} */
+unsigned char paste_type;    /* if paste, was it OVERWRITE or INSERT */
+unsigned char flags;         /* EVENT_DATA, EVENT_DEAD, EVENT_PW */
 int line;                    /* line it occured on */
 int column;                  /* column it occured on */
-int type;                    /* type of database mnodifying event {PL, DL, ...} */
-int paste_type;              /* if paste, was it OVERWRITE or INSERT */
-char *data;                  /* data being deleted ... */
-char *old_data;              /* data being replaced in a OVERWRITE */
-struct event_struct *next;   /* linked list pointers */
-struct event_struct *last;       /* same */
+int spare;                   /* keeps old_data 8 byte aligned */
+char *old_data;              /* data being replaced, malloced when the event is undone */
 };
 
 typedef struct event_struct event_struct;
 
+typedef struct undo_chunk
+{
+struct undo_chunk *next;     /* newer chunk */
+struct undo_chunk *last;     /* older chunk */
+unsigned int used;           /* bytes of records in the chunk */
+unsigned int size;           /* bytes of room in the chunk */
+unsigned int last_rec;       /* offset of the newest record in the chunk */
+unsigned int seq;            /* counts up from the oldest chunk */
+char        *area;           /* the records, NULL while spilled to disk */
+long         spill_offset;   /* where the records are in the spill file */
+unsigned int spill_bytes;    /* bytes written there, records then outside data */
+} undo_chunk;
+
+typedef struct UNDO_POS
+{
+undo_chunk   *chunk;         /* chunk holding event */
+event_struct *event;         /* NULL for an empty list */
+int           pw;            /* True when on the pad write right after event */
+} UNDO_POS;
+
+typedef struct undo_log
+{
+undo_chunk   *first;         /* oldest chunk */
+undo_chunk   *end;           /* chunk holding the newest record */
+undo_chunk   *spare;         /* emptied chunk kept for reuse */
+UNDO_POS      head;          /* current position, events up to here are done */
+UNDO_POS      pw;            /* event the file was last written after */
+} undo_log;
+
 /***************************************************************
 *  
 *  Internal structure declarations (Do not use externally!)
@@ -115,20 +158,44 @@ typedef struct block_struct{
                   char   *text;                 /* pointer to a line of text.                   */
                   char   *color_data;           /* per line color data.                   */
                   int     size;                 /* length of the storage allocated for the line */
+                  unsigned int generation;      /* changes each time the text or color changes  */
 } block_struct;
 
 typedef struct header_struct{
                   uint32_t             color_bits[LINES_PER_BLOCK/WORD_BIT]; /* one bit for each block_struct (line) in the array pointed to by the following pointer */
                   struct block_struct *block;   /* pointer to a block struct                  */
                   int   lines;                  /* count of lines in block struct pointed to  */
+                  unsigned int saved_in;        /* dirty bit, SAVED_IN_NONE once the block changes, see save_blocks */
+                  int   saved_bytes;            /* bytes of text where the block was saved, newlines included */
+                  long  saved_offset;           /* where the block was saved                  */
+                  int   pending;                /* True while a background pw is writing the block, see blocks_pending */
+                  int   pending_bytes;          /* bytes the block takes in that file         */
+                  long  pending_offset;         /* where it goes in that file                 */
 } header_struct;
 
+/***************************************************************
+*  Where a block was last saved, header_struct.saved_in.  Values
+*  above SAVED_IN_FILE are autosave images, see autoimage.c
+***************************************************************/
+#define  SAVED_IN_NONE   0
+#define  SAVED_IN_FILE   1
+
 typedef struct data_struct{
                   uint32_t              color_bits[HEADER_SIZE/WORD_BIT]; /* one bit for each header_struct in the array pointed to by the following pointer */
                   struct header_struct *header; /* pointer to a header struct                 */
                   int   lines;                  /* count of all the  lines in all the blocks in the header */
 } data_struct;
 
+/***************************************************************
+*  A line_index entry is the length of the line text, with
+*  LINE_INDEX_NEWLINE set if a newline followed it in the file.
+*  load_a_block either reads lines by the entries or, with
+*  line_index_next set to LINE_INDEX_RECORD, adds an entry for each
+*  line it reads.  See loadcache.c
+***************************************************************/
+#define  LINE_INDEX_NEWLINE  0x80000000
+#define  LINE_INDEX_RECORD   -1
+
 #define TOKEN_MARKER (unsigned long int)0xBEEFFEED
 
 typedef struct DATA_TOKEN
@@ -147,13 +214,20 @@ typedef struct DATA_TOKEN
    char               *last_line;
    int                 dirty_file;
    int                 line_load_level;
-   event_struct       *event_head; 
+   undo_log           *undo_log;  /* undo events, see undo.c */
    int                 last_hh_block_idx;   /* optimization code */
    int                 last_hh_header_idx;
    int                 last_hh_data_idx;
    int                 last_hh_line;
    int                 seq_insert_strategy; /* RES 01/07/2003, pad mode, split blocks differently */
    int                 colored; /* has this memdata ever been colored on? */
+   int                 journaled; /* changes go to the edit journal, see journal.c */
+   int                 file_offsets; /* load_a_block is reading the edit file, its blocks start out saved there */
+   int                 blocks_dirty; /* a block has changed since save_blocks last finished */
+   uint32_t           *line_index;       /* lengths of the lines of the edit file, see loadcache.c */
+   int                 line_index_lines; /* entries in line_index */
+   int                 line_index_next;  /* next entry load_a_block reads by, LINE_INDEX_RECORD while recording */
+   int                 line_index_space; /* entries line_index has room for while recording */
    uint32_t            color_bits[DATA_SIZE/WORD_BIT];   /* one bit for each data_struct in the following array */
    data_struct         data[DATA_SIZE];  /* the body of the header */
 
@@ -250,6 +324,46 @@ extern int line_load_level;
 
 #define TOGLE(a) a = !a
 
+/***************************************************************
+*  
+*  A run of lines in one block, returned by line_spans.
+*  
+***************************************************************/
+
+typedef struct {
+   void               *block;       /* opaque, the block the lines are in   */
+   void               *header;      /* opaque, the header of the block      */
+   int                 first_idx;   /* index of first_line in the block     */
+   int                 first_line;  /* zero based line number in the file   */
+   int                 lines;       /* number of lines in the span          */
+} LINE_SPAN;
+
+/***************************************************************
+*  
+*  A replacement line for swap_lines.  After the swap, text and
+*  size describe the line which was in memdata.
+*  
+***************************************************************/
+
+typedef struct {
+   int                 line_no;     /* zero based line number in the file   */
+   char               *text;        /* malloc'ed line                       */
+   int                 size;        /* malloc'ed size of text               */
+} LINE_SWAP;
+
+/***************************************************************
+*  
+*  A run of saved text, returned by block_map.  Together the runs
+*  give the whole buffer in order.
+*  
+***************************************************************/
+
+typedef struct {
+   long                offset;      /* where the text starts                */
+   long                bytes;       /* bytes of text, newlines included     */
+   unsigned int        saved_in;    /* SAVED_IN_FILE or an autosave image   */
+} BLOCK_MAP;
+
 /***************************************************************
 *  
 *  Prototypes
@@ -305,6 +419,10 @@ void     print_file(DATA_TOKEN *token);   /* input  */
 void     save_file(DATA_TOKEN *token,       /* opaque */
                    FILE       *fp);         /* input  */
 
+long     save_file_fd(DATA_TOKEN *token,       /* opaque */
+                      int         fd,          /* input  */
+                      int         progress_fd);/* input  */
+
 char *get_color_by_num(DATA_TOKEN *token,       /* opaque */
                        int         line_no,     /* input  */
                        int         direction,       /* direction to search for color info */
@@ -331,9 +449,50 @@ void     encrypt_init(char *passwd);  /* input */
 
 int      sum_size(DATA_TOKEN *token, int from_line, int to_line); /* inputs */
 
+unsigned int line_generation(DATA_TOKEN *token,        /* opaque */
+                             int         line_no,      /* input  */
+                             char       *line);        /* input  */
+
+LINE_SPAN *line_spans(DATA_TOKEN *token,        /* opaque */
+                      int         from_line,    /* input  */
+                      int         to_line,      /* input  */
+                      int        *count);       /* output */
+
+char    *span_line(LINE_SPAN  *span,        /* input  */
+                   int         idx);        /* input  */
+
+unsigned int span_generation(LINE_SPAN  *span);    /* input  */
+
+unsigned int current_generation(void);
+
+void     swap_lines(DATA_TOKEN *token,        /* opaque */
+                    LINE_SWAP  *swaps,        /* input / output */
+                    int         count);       /* input  */
+
 void     join_line(DATA_TOKEN      *token,      /* input */
                    int              line_no);   /* input */
 
+int      join_marked_lines(DATA_TOKEN *token,       /* opaque */
+                           int         from_line,   /* input  */
+                           int         line_no,     /* input  */
+                           int        *column);     /* output */
+
+int      save_blocks(DATA_TOKEN   *token,       /* opaque */
+                     int           fd,          /* input  */
+                     unsigned int  image,       /* input  */
+                     long         *image_end,   /* input / output */
+                     long          max_bytes);  /* input  */
+
+BLOCK_MAP *block_map(DATA_TOKEN   *token,       /* opaque */
+                     int          *count);      /* output */
+
+void     blocks_saved(DATA_TOKEN *token);       /* opaque */
+
+void     blocks_pending(DATA_TOKEN *token);     /* opaque */
+
+void     blocks_pending_saved(DATA_TOKEN *token,     /* opaque */
+                              int         saved);    /* input  */
+
 void vt100_eat(char        *target,
                char        *line);
 
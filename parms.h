@@ -64,9 +64,9 @@
 
 
 #ifdef WIN32
-#define OPTION_COUNT 72
+#define OPTION_COUNT 83
 #else
-#define OPTION_COUNT 69
+#define OPTION_COUNT 80
 #endif
 
 #ifdef _MAIN_
@@ -150,10 +150,21 @@ XrmOptionDescRec cmd_options[OPTION_COUNT] = {
 {"-bell",           ".bell",                        XrmoptionSepArg,        (caddr_t) "yes"},   /*  66  */
 {"-sm_client_id",   ".internalSM_CLIENT_ID",        XrmoptionSepArg,        (caddr_t) NULL},    /*  67  */
 {"-ws",             ".internalWorkspaceNum",        XrmoptionSepArg,        (caddr_t) NULL},    /*  68  */
+{"-shm",            ".shm",                         XrmoptionSepArg,        (caddr_t) NULL},    /*  69  */
+{"-render",         ".render",                      XrmoptionSepArg,        (caddr_t) NULL},    /*  70  */
+{"-hlall",          ".hlall",                       XrmoptionSepArg,        (caddr_t) NULL},    /*  71  */
+{"-tindex",         ".tindex",                      XrmoptionSepArg,        (caddr_t) NULL},    /*  72  */
+{"-undomem",        ".undomem",                     XrmoptionSepArg,        (caddr_t) NULL},    /*  73  */
+{"-journal",        ".journal",                     XrmoptionSepArg,        (caddr_t) NULL},    /*  74  */
+{"-recover",        ".internalRECOVER",             XrmoptionNoArg,         (caddr_t) "yes"},   /*  75  */
+{"-autoimage",      ".autoimage",                   XrmoptionSepArg,        (caddr_t) NULL},    /*  76  */
+{"-fsync",          ".fsync",                       XrmoptionSepArg,        (caddr_t) NULL},    /*  77  */
+{"-follow",         ".follow",                      XrmoptionSepArg,        (caddr_t) NULL},    /*  78  */
+{"-loadcache",      ".loadcache",                   XrmoptionSepArg,        (caddr_t) NULL},    /*  79  */
 #ifdef WIN32
-{"-browse",         ".internalBROWSE",              XrmoptionNoArg,         (caddr_t) "yes"},   /*  69  */
-{"-edit",           ".internalEDIT",                XrmoptionNoArg,         (caddr_t) "yes"},   /*  70  */
-{"-term",           ".internalTERM",                XrmoptionNoArg,         (caddr_t) "yes"},   /*  71  */
+{"-browse",         ".internalBROWSE",              XrmoptionNoArg,         (caddr_t) "yes"},   /*  80  */
+{"-edit",           ".internalEDIT",                XrmoptionNoArg,         (caddr_t) "yes"},   /*  81  */
+{"-term",           ".internalTERM",                XrmoptionNoArg,         (caddr_t) "yes"},   /*  82  */
 #endif
 };
 
@@ -227,10 +238,21 @@ char  *defaults[OPTION_COUNT] = {
              "yes",           /* 66 default -bell, normal active bell, supports 'n' for no bell and 'v' for visual */
              NULL,            /* 67 used by XSMP (X Session Manager) for restarting */
              NULL,            /* 68 default None, workspace to start in */
+             NULL,            /* 69 default -shm, draw large repaints in shared memory on local displays, Default no */
+             NULL,            /* 70 default -render, draw colored lines with XRender, Default no */
+             NULL,            /* 71 default -hlall, highlight every match of the find pattern, Default no */
+             NULL,            /* 72 default -tindex, trigram index for finds in read only browse sessions, Default no */
+             NULL,            /* 73 default -undomem, kilobytes of undo kept in memory before spilling to disk, Default no limit */
+             NULL,            /* 74 default -journal, journal changes to <file>.CEJ for crash recovery, Default no */
+             "no",            /* 75 default -recover, replay the journal left by a crash, default is not to */
+             NULL,            /* 76 default -autoimage, seconds after a change to write an autosave image to <file>.CEA, Default none */
+             "file",          /* 77 default -fsync, sync after pw: none, file, or dir for the file and its directory, Default file */
+             NULL,            /* 78 default -follow, load what is added to a read only file as it grows, Default no */
+             NULL,            /* 79 default -loadcache, megabytes of line lengths of big files kept under the paste directory, Default none */
 #ifdef WIN32
-             "no",            /* 69 default -browse, default is not browse  */
-             "no",            /* 70 default -edit, default is not edit  */
-             "no",            /* 71 default -term, default is not term, figure out from name  */
+             "no",            /* 80 default -browse, default is not browse  */
+             "no",            /* 81 default -edit, default is not edit  */
+             "no",            /* 82 default -term, default is not term, figure out from name  */
 #endif
                   };
 
@@ -331,10 +353,21 @@ extern char         *cmd_path;
 #define BELL_IDX        66
 #define SM_CLIENT_IDX   67
 #define WS_IDX          68
+#define SHM_IDX         69
+#define RENDER_IDX      70
+#define HLALL_IDX       71
+#define TINDEX_IDX      72
+#define UNDOMEM_IDX     73
+#define JOURNAL_IDX     74
+#define RECOVER_IDX     75
+#define AUTOIMAGE_IDX   76
+#define FSYNC_IDX       77
+#define FOLLOW_IDX      78
+#define LOADCACHE_IDX   79
 #ifdef WIN32
-#define BROWSE_IDX      69
-#define EDIT_IDX        70
-#define TERM_IDX        71
+#define BROWSE_IDX      80
+#define EDIT_IDX        81
+#define TERM_IDX        82
 #endif
 
 #define OPTION_VALUES     dspl_descr->option_values
@@ -412,6 +445,17 @@ extern char         *cmd_path;
 #define SUPPRESS_BELL  (OPTION_VALUES[BELL_IDX] && ((OPTION_VALUES[BELL_IDX][0] | 0x20) == 'n'))
 #define SM_CLIENT_ID   (OPTION_VALUES[SM_CLIENT_IDX])
 #define WS_NUM         (OPTION_VALUES[WS_IDX])
+#define SHMDRAW        (OPTION_VALUES[SHM_IDX] && ((OPTION_VALUES[SHM_IDX][0] | 0x20) == 'y'))
+#define RENDERTEXT     (OPTION_VALUES[RENDER_IDX] && ((OPTION_VALUES[RENDER_IDX][0] | 0x20) == 'y'))
+#define HLALL          (OPTION_VALUES[HLALL_IDX] && ((OPTION_VALUES[HLALL_IDX][0] | 0x20) == 'y'))
+#define TINDEX         (OPTION_VALUES[TINDEX_IDX] && ((OPTION_VALUES[TINDEX_IDX][0] | 0x20) == 'y'))
+#define UNDOMEM        (OPTION_VALUES[UNDOMEM_IDX])
+#define JOURNAL        (OPTION_VALUES[JOURNAL_IDX] && ((OPTION_VALUES[JOURNAL_IDX][0] | 0x20) == 'y'))
+#define RECOVER        (OPTION_VALUES[RECOVER_IDX] && ((OPTION_VALUES[RECOVER_IDX][0] | 0x20) == 'y'))
+#define AUTOIMAGE      (OPTION_VALUES[AUTOIMAGE_IDX])
+#define FSYNC_PARM     (OPTION_VALUES[FSYNC_IDX])
+#define FOLLOW         (OPTION_VALUES[FOLLOW_IDX] && ((OPTION_VALUES[FOLLOW_IDX][0] | 0x20) == 'y'))
+#define LOADCACHE      (OPTION_VALUES[LOADCACHE_IDX])
 #ifdef WIN32
 #define BROWSE_MODE    (OPTION_VALUES[BROWSE_IDX] && ((OPTION_VALUES[BROWSE_IDX][0] | 0x20) == 'y'))
 #define EDIT_MODE      (OPTION_VALUES[EDIT_IDX] && ((OPTION_VALUES[EDIT_IDX][0] | 0x20) == 'y'))
@@ -914,6 +914,7 @@ case DM_cv:
 case DM_cc:
 case DM_ceterm:
 case DM_cp:
+case DM_fcnt:
    dmc->cp.argc = 0;
    dmc->cp.argv = NULL;
    if (char_to_argv(cmd_name, p, cmd_name, cmd_line, &dmc->cv.argc, &dmc->cv.argv, escape_char) != 0)
@@ -1160,6 +1161,7 @@ case DM_dq:
 
 
 case DM_echo:
+case DM_ifind:
    dmc->echo.dash_r = 0;
    for (p = strtok(p, " \t");
         p != NULL;
@@ -3482,6 +3484,7 @@ case DM_rec:
 
 case DM_ceterm:
 case DM_cp:
+case DM_fcnt:
 case DM_cpo:
 case DM_cps:
    for (i = 0; i < dmc->cp.argc; i++) 
@@ -3888,6 +3891,7 @@ while(dmc != NULL)
 
    case DM_ceterm:
    case DM_cp:
+   case DM_fcnt:
       escaped_chars[0] = escape_char; /* RES 6/22/95 Lint change */
       strcpy(&escaped_chars[1], "\\$[]()*");
       p = &def[strlen(def)]; /* point to the null terminator */
@@ -3943,6 +3947,7 @@ while(dmc != NULL)
 
 
    case DM_echo:
+   case DM_ifind:
       if (dmc->echo.dash_r)
          strcat(def, " -r");
       break;
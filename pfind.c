@@ -0,0 +1,446 @@
+/*static char *sccsid = "%Z% %M% %I% - %G% %U% ";*/
+/***************************************************************
+*
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in pfind.c
+*     pfind_first             - Find the first line in search order which may match
+*     pfind_lines             - Flag every line in a range which may match
+*
+*  Internal routines:
+*     pfind_run               - Start the workers and wait for them
+*     pfind_worker            - Scan blocks until there are none left
+*     next_span               - Hand out the next block in search order
+*
+*  A find which misses in the first DM_FIND_SEARCH_LINES lines
+*  used to go on 512 lines at a time from the event loop.  When
+*  the whole file is in memory, the rest of the file is now
+*  split into its memdata blocks and handed to a pool of worker
+*  threads.  Each worker tests whole lines with its own copy of
+*  the search DFA (line_matcher in search.c), so no static data
+*  in search.c is touched.  The first block in search order with
+*  a hit wins and workers stop taking blocks past it.  The caller
+*  then runs search() on the winning line to get the column.
+*  Blocks the trigram index (tindex.c) rules out are passed over.
+*
+*  The main thread waits for the workers, so memdata does not
+*  change while they run.
+*
+***************************************************************/
+
+#include <stdio.h>          /* /usr/include/stdio.h      */
+#include <string.h>         /* /usr/include/string.h     */
+#ifndef WIN32
+#include <unistd.h>         /* /usr/include/unistd.h     */
+#endif
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>        /* /usr/include/pthread.h    */
+#endif
+
+#include "debug.h"
+#include "dmwin.h"          /* needed for True and False */
+#include "emalloc.h"
+#include "memdata.h"
+#include "pfind.h"
+#include "search.h"
+#include "tindex.h"
+
+/***************************************************************
+*
+*  Ranges smaller than this are left to search(), starting the
+*  threads would cost more than it saves.  More threads than
+*  PFIND_MAX_THREADS just fight over memory bandwidth.
+*
+***************************************************************/
+
+#define PFIND_MIN_LINES     8192
+#define PFIND_MAX_THREADS   8
+
+/***************************************************************
+*
+*  The scan shared by the workers.  Spans are numbered in search
+*  order, which is backwards through the array for a reverse find.
+*
+***************************************************************/
+
+typedef struct {
+   LINE_SPAN      *spans;          /* from line_spans                          */
+   int             nspans;
+   int             reverse;        /* search order is bottom to top            */
+   unsigned char  *hits;           /* pfind_lines, one byte per line, else NULL */
+   int             base_line;      /* line number of hits[0]                   */
+   unsigned char  *skips;          /* from tindex_skips, spans which cannot match, else NULL */
+   int             next;           /* next span to hand out                    */
+   volatile int    best_span;      /* first span with a hit, nspans if none    */
+   int             best_line;      /* the line hit in best_span                */
+#ifdef HAVE_PTHREAD
+   pthread_mutex_t lock;
+#endif
+} PFIND_SCAN;
+
+typedef struct {
+   PFIND_SCAN     *scan;
+   void           *matcher;        /* from line_matcher, one per worker        */
+#ifdef HAVE_PTHREAD
+   pthread_t       thread;
+   int             started;
+#endif
+} PFIND_WORKER;
+
+/***************************************************************
+*  
+*  Prototypes for local routines
+*  
+***************************************************************/
+
+static int   pfind_run(PFIND_SCAN      *scan,
+                       void            *sdata,
+                       int              case_insensitive);
+
+static void *pfind_worker(void *arg);
+
+static int   next_span(PFIND_SCAN      *scan);
+
+
+/************************************************************************
+
+NAME:      pfind_first  -  Find the first line in search order which may match
+
+PURPOSE:    This routine scans a range of lines with the worker threads
+            and returns the first line, in search order, which may hold
+            a match for the expression last compiled into sdata.
+
+PARAMETERS:
+
+   1.  token          - pointer to DATA_TOKEN (INPUT)
+                        The memdata to search.
+
+   2.  sdata          - pointer to void (INPUT)
+                        The static pattern data of a previous call to search.
+
+   3.  case_insensitive - int (INPUT)
+                        The case flag passed to search.
+
+   4.  from_line      - int (INPUT)
+                        The top line of the range.
+
+   5.  to_line        - int (INPUT)
+                        The bottom line of the range.
+
+   6.  reverse        - int (INPUT)
+                        True for a reverse find, the last line in the range
+                        which may match is returned.
+
+   7.  found_line     - pointer to int (OUTPUT)
+                        The line is returned here, or DM_FIND_NOT_FOUND if
+                        no line in the range can match.
+
+FUNCTIONS :
+
+   1.   Returns False, without setting found_line, if the range is
+        too small or the expression cannot be tested outside search().
+        The caller goes on with search().
+
+*************************************************************************/
+
+int  pfind_first(DATA_TOKEN      *token,             /* input  */
+                 void            *sdata,             /* input  */
+                 int              case_insensitive,  /* input  */
+                 int              from_line,         /* input  */
+                 int              to_line,           /* input  */
+                 int              reverse,           /* input  */
+                 int             *found_line)        /* output */
+{
+PFIND_SCAN               scan;
+int                      ran;
+
+if ((to_line - from_line + 1) < PFIND_MIN_LINES)
+   return(False);
+
+memset((char *)&scan, 0, sizeof(scan));
+scan.spans = line_spans(token, from_line, to_line, &scan.nspans);
+if (!scan.spans)
+   return(False);
+
+scan.reverse   = reverse;
+scan.best_span = scan.nspans;
+scan.best_line = DM_FIND_NOT_FOUND;
+scan.skips     = tindex_skips(token, sdata, scan.spans, scan.nspans);
+
+ran = pfind_run(&scan, sdata, case_insensitive);
+if (ran)
+   *found_line = scan.best_line;
+
+DEBUG13(fprintf(stderr, "pfind_first[%d,%d] %s -> %d (%s)\n", from_line, to_line,
+                reverse ? "reverse" : "forward", scan.best_line, ran ? "ran" : "not used");)
+
+if (scan.skips)
+   free((char *)scan.skips);
+free((char *)scan.spans);
+return(ran);
+
+} /* end of pfind_first */
+
+
+/************************************************************************
+
+NAME:      pfind_lines  -  Flag every line in a range which may match
+
+PURPOSE:    This routine scans a range of lines with the worker threads
+            and flags each line which may hold a match.  It is used to
+            count matches, the caller runs search() on the flagged lines.
+
+PARAMETERS:
+
+   1.  token          - pointer to DATA_TOKEN (INPUT)
+                        The memdata to search.
+
+   2.  sdata          - pointer to void (INPUT)
+                        The static pattern data of a previous call to search.
+
+   3.  case_insensitive - int (INPUT)
+                        The case flag passed to search.
+
+   4.  from_line      - int (INPUT)
+                        The top line of the range.
+
+   5.  to_line        - int (INPUT)
+                        The bottom line of the range.
+
+FUNCTIONS :
+
+   1.   Returns a malloc'ed array with one byte per line in the range,
+        non-zero if the line may match.  The caller frees it.
+        NULL is returned if the expression cannot be tested outside
+        search().
+
+*************************************************************************/
+
+unsigned char *pfind_lines(DATA_TOKEN      *token,             /* input  */
+                           void            *sdata,             /* input  */
+                           int              case_insensitive,  /* input  */
+                           int              from_line,         /* input  */
+                           int              to_line)           /* input  */
+{
+PFIND_SCAN               scan;
+
+if (to_line < from_line)
+   return(NULL);
+
+memset((char *)&scan, 0, sizeof(scan));
+scan.spans = line_spans(token, from_line, to_line, &scan.nspans);
+if (!scan.spans)
+   return(NULL);
+
+scan.hits = (unsigned char *)CE_MALLOC(to_line - from_line + 1);
+if (scan.hits)
+   {
+      memset((char *)scan.hits, 0, to_line - from_line + 1);
+      scan.base_line = from_line;
+      scan.best_span = scan.nspans;
+      scan.skips     = tindex_skips(token, sdata, scan.spans, scan.nspans);
+      if (!pfind_run(&scan, sdata, case_insensitive))
+         {
+            free((char *)scan.hits);
+            scan.hits = NULL;
+         }
+      if (scan.skips)
+         free((char *)scan.skips);
+   }
+
+free((char *)scan.spans);
+return(scan.hits);
+
+} /* end of pfind_lines */
+
+
+/************************************************************************
+
+NAME:      pfind_run  -  Start the workers and wait for them
+
+PURPOSE:    One worker is started per processor, up to PFIND_MAX_THREADS.
+            The calling thread is one of the workers.  If a thread cannot
+            be created, the workers which did start finish the scan.
+
+FUNCTIONS :
+
+   1.   Returns False if the expression cannot be tested outside search().
+
+*************************************************************************/
+
+static int   pfind_run(PFIND_SCAN      *scan,
+                       void            *sdata,
+                       int              case_insensitive)
+{
+PFIND_WORKER             workers[PFIND_MAX_THREADS];
+int                      count = 1;
+int                      i;
+
+#ifdef _SC_NPROCESSORS_ONLN
+count = sysconf(_SC_NPROCESSORS_ONLN);
+#endif
+if (count > PFIND_MAX_THREADS)
+   count = PFIND_MAX_THREADS;
+if (count > scan->nspans)
+   count = scan->nspans;
+if (count < 1)
+   count = 1;
+#ifndef HAVE_PTHREAD
+count = 1;
+#endif
+
+memset((char *)workers, 0, sizeof(workers));
+for (i = 0; i < count; i++)
+{
+   workers[i].scan    = scan;
+   workers[i].matcher = line_matcher(sdata, case_insensitive);
+   if (!workers[i].matcher)
+      {
+         while (i-- > 0)
+            free_line_matcher(workers[i].matcher);
+         return(False);
+      }
+}
+
+#ifdef HAVE_PTHREAD
+pthread_mutex_init(&scan->lock, NULL);
+for (i = 1; i < count; i++)
+   workers[i].started = (pthread_create(&workers[i].thread, NULL, pfind_worker, (void *)&workers[i]) == 0);
+#endif
+
+pfind_worker((void *)&workers[0]);
+
+#ifdef HAVE_PTHREAD
+for (i = 1; i < count; i++)
+   if (workers[i].started)
+      pthread_join(workers[i].thread, NULL);
+pthread_mutex_destroy(&scan->lock);
+#endif
+
+for (i = 0; i < count; i++)
+   free_line_matcher(workers[i].matcher);
+
+DEBUG13(fprintf(stderr, "pfind_run: %d spans, %d workers\n", scan->nspans, count);)
+
+return(True);
+
+} /* end of pfind_run */
+
+
+/************************************************************************
+
+NAME:      pfind_worker  -  Scan blocks until there are none left
+
+PURPOSE:    This is the thread body.  It takes blocks in search order and
+            tests their lines in search order.  When looking for the first
+            hit, a block stops at its first hit and the worker stops when
+            an earlier block has already hit.
+
+*************************************************************************/
+
+static void *pfind_worker(void *arg)
+{
+PFIND_WORKER            *worker = (PFIND_WORKER *)arg;
+PFIND_SCAN              *scan = worker->scan;
+LINE_SPAN               *span;
+int                      k;
+int                      i;
+int                      idx;
+int                      n;
+
+while ((k = next_span(scan)) >= 0)
+{
+   n = scan->reverse ? (scan->nspans - 1 - k) : k;
+   if (scan->skips && scan->skips[n])
+      continue; /* the trigram index says no line in the block can match */
+   span = &scan->spans[n];
+   for (i = 0; i < span->lines; i++)
+   {
+      if (!scan->hits && (k > scan->best_span))
+         break; /* an earlier block already has a hit */
+
+      idx = scan->reverse ? (span->lines - 1 - i) : i;
+      if (!line_may_match(worker->matcher, span_line(span, idx)))
+         continue;
+
+      if (scan->hits)
+         scan->hits[span->first_line + idx - scan->base_line] = 1;
+      else
+         {
+#ifdef HAVE_PTHREAD
+            pthread_mutex_lock(&scan->lock);
+#endif
+            if (k < scan->best_span)
+               {
+                  scan->best_span = k;
+                  scan->best_line = span->first_line + idx;
+               }
+#ifdef HAVE_PTHREAD
+            pthread_mutex_unlock(&scan->lock);
+#endif
+            break;
+         }
+   }
+}
+
+return(NULL);
+
+} /* end of pfind_worker */
+
+
+/************************************************************************
+
+NAME:      next_span  -  Hand out the next block in search order
+
+FUNCTIONS :
+
+   1.   Returns the span number, or -1 when there are no more blocks
+        or an earlier block already has a hit.
+
+*************************************************************************/
+
+static int   next_span(PFIND_SCAN      *scan)
+{
+int                      k;
+
+#ifdef HAVE_PTHREAD
+pthread_mutex_lock(&scan->lock);
+#endif
+
+k = scan->next++;
+if ((k >= scan->nspans) || (!scan->hits && (k > scan->best_span)))
+   k = -1;
+
+#ifdef HAVE_PTHREAD
+pthread_mutex_unlock(&scan->lock);
+#endif
+
+return(k);
+
+} /* end of next_span */
+
@@ -0,0 +1,63 @@
+#ifndef _PFIND_INCLUDED
+#define _PFIND_INCLUDED
+
+/* "%Z% %M% %I% - %G% %U% " */
+
+/***************************************************************
+*  
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*  
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*  
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*  
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*  
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*  
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in pfind.c
+*     pfind_first             - Find the first line in search order which may match
+*     pfind_lines             - Flag every line in a range which may match
+*
+*  The lines are tested by a pool of worker threads, each taking
+*  the next memdata block in search order.  Threads are only used
+*  when HAVE_PTHREAD is defined, otherwise the same scan runs in
+*  the calling thread.
+*
+***************************************************************/
+
+#include "memdata.h"
+
+int  pfind_first(DATA_TOKEN      *token,             /* input  */
+                 void            *sdata,             /* input  */
+                 int              case_insensitive,  /* input  */
+                 int              from_line,         /* input  */
+                 int              to_line,           /* input  */
+                 int              reverse,           /* input  */
+                 int             *found_line);       /* output */
+
+unsigned char *pfind_lines(DATA_TOKEN      *token,             /* input  */
+                           void            *sdata,             /* input  */
+                           int              case_insensitive,  /* input  */
+                           int              from_line,         /* input  */
+                           int              to_line);          /* input  */
+
+
+#endif
+
@@ -39,6 +39,10 @@
 *         ok_for_input        - Verify that a file can be opened for input.
 *         dm_pn               - Pad Name / Rename command
 *         dm_pw               - Pad Write (save) command
+*         dm_pw_bg            - Pad Write, large files written in the background
+*         pw_timeout          - Microseconds till a background pw is looked at again
+*         pw_wait             - Wait for a background pw to finish
+*         pw_progress         - Percent done of a background pw, for the titlebar
 *         dm_cd               - Change Dir (for edit process)
 *         dm_pwd              - print current DM working directory
 *
@@ -47,6 +51,14 @@
 *         bump_backup_files   - Rename .bak files to make room for a new .bak.
 *         create_backup_dm    - Create .bak file DM style (use rename to make .bak file)
 *         create_backup_vi    - Create .bak file vi style (use copy to make .bak file)
+*         open_save_temp      - Open a temporary file beside the edit file for pw
+*         save_to_temp        - Write the temporary file and rename it over the edit file
+*         sync_edit_dir       - Sync the directory of the edit file
+*         pw_save             - Do the work of dm_pw and dm_pw_bg
+*         pw_done             - Straighten out stats, locks, and cc data after a pw
+*         bg_start            - Fork a process to write the temporary file
+*         bg_read             - Read progress from the background pw
+*         bg_finish           - Finish a background pw once the file is written
 *         save_edit_dir       - Save the directory of the current file being edited
 *         translate_tilde_dot - Process file names starting with ~./
 *
@@ -69,6 +81,9 @@
 #include "usleep.h"
 #else
 #include <utime.h>          /* /usr/include/utime.h      */
+#include <sys/time.h>       /* /usr/include/sys/time.h   */
+#include <sys/wait.h>       /* /usr/include/sys/wait.h   */
+#include <unistd.h>         /* /usr/include/unistd.h     */
 #endif
 
 #ifdef MVS_SERVICES
@@ -100,6 +115,8 @@
 #include "dmsyms.h"
 #include "dmwin.h"
 #include "init.h"
+#include "journal.h"
+#include "autoimage.h"
 #include "lock.h"
 #ifdef PAD
 #include "pad.h"
@@ -108,6 +125,8 @@
 #include "mark.h"
 #include "normalize.h"
 #include "parms.h"
+#include "redraw.h"
+#include "undo.h"
 #include "xerror.h"
 
 #ifndef HAVE_STRLCPY
@@ -141,13 +160,51 @@ char   *getenv(const char *name);
 #endif
   
 
-static int   create_backup_dm(char       *edit_file);
+static int   create_backup_dm(char       *edit_file,
+                              int         keep_file);
 static int   create_backup_vi(char         *edit_file,
                               struct stat  *file_stats);
 
 static void  get_fake_file_stats(char          *edit_file,
                                  struct stat   *file_stats);
 
+#if !defined(WIN32) && !defined(MVS_SERVICES)
+static int   open_save_temp(char          *edit_file,
+                            struct stat   *file_stats,
+                            int            file_exists,
+                            char          *temp_file);
+
+static int   save_to_temp(DISPLAY_DESCR *dspl_descr,
+                          char          *edit_file,
+                          int            fd,
+                          char          *temp_file);
+
+static int   sync_edit_dir(char          *edit_file,
+                           char          *dir);
+
+static int   bg_start(DISPLAY_DESCR *dspl_descr,
+                      char          *edit_file,
+                      int            fd,
+                      char          *temp_file,
+                      struct stat   *file_stats,
+                      int            new_file);
+
+static int   bg_read(void);
+
+static void  bg_finish(void);
+#endif
+
+static int   pw_save(DISPLAY_DESCR *dspl_descr,
+                     char          *edit_file,
+                     int            from_crash_file,
+                     int            background);
+
+static void  pw_done(DISPLAY_DESCR *dspl_descr,
+                     char          *edit_file,
+                     struct stat   *file_stats,
+                     int            file_recreated,
+                     int            new_file);
+
 static void save_edit_dir(char  *dir);
 
 static void translate_tilde_dot(char  *file);
@@ -1304,6 +1361,8 @@ else
    if (strcmp(dmc->pn.path, edit_file) == 0)
       return;
 
+pw_wait(); /* a background pw is still writing the old name */
+
 
 /***************************************************************
 *  
@@ -1592,10 +1651,17 @@ PARAMETERS:
                    This is the path name being edited.  It can be
                    a relative or absolute path.
 
+   2.  keep_file - int (INPUT)
+                   True when pw will rename a new copy over the edit
+                   file.  The edit file is linked to the backup file
+                   rather than renamed, so it is there until the new
+                   copy replaces it.
+
 
 FUNCTIONS :
 
-   1.   Rename the file being edited to the backup file.
+   1.   Rename the file being edited to the backup file, or link it
+        when keep_file is set.
 
 
 OUTPUTS:
@@ -1605,7 +1671,8 @@ OUTPUTS:
 
 *************************************************************************/
 
-static int   create_backup_dm(char       *edit_file)
+static int   create_backup_dm(char       *edit_file,
+                              int         keep_file)
 {
 
 char                  msg[MAXPATHLEN];
@@ -1627,6 +1694,14 @@ strlcat(bak_file, ".bak",    sizeof(bak_file));
 #ifdef WIN32
 /* WIN32 rename does not replace existing file */
 unlink(bak_file);
+#else
+if (keep_file)
+   {
+      unlink(bak_file);
+      if (link(edit_file, bak_file) == 0)
+         return(0);
+      DEBUG1(fprintf(stderr, "create_backup_dm: link to %s failed (%s), renaming\n", bak_file, strerror(errno));)
+   }
 #endif
 if (rename(edit_file, bak_file) != 0)
    {
@@ -1766,6 +1841,522 @@ return(0);
 }  /* end of create_backup_vi */
 
 
+#if !defined(WIN32) && !defined(MVS_SERVICES)
+/************************************************************************
+
+NAME:      open_save_temp - Open a temporary file beside the edit file for pw
+
+PURPOSE:    pw writes the new copy of the file to a temporary file in the
+            same directory and renames it over the edit file.  The edit
+            file is never opened for output, so a save which fails or is
+            interrupted leaves it as it was.  This routine opens the
+            temporary file, if this can be done for the edit file.
+
+PARAMETERS:
+
+   1.  edit_file   - pointer to char (INPUT)
+                     This is the path name being edited.
+
+   2.  file_stats  - pointer to struct stat (INPUT)
+                     The stats of the edit file, if it exists.
+
+   3.  file_exists - int (INPUT)
+                     True if file_stats is filled in.
+
+   4.  temp_file   - pointer to char (OUTPUT)
+                     The name of the temporary file is put here.  It must
+                     be at least MAXPATHLEN+16 bytes.
+
+FUNCTIONS :
+
+   1.   If the edit file is a symbolic link or has more than one link,
+        renaming over it would break the link, so do not do it.
+
+   2.   Create a uniquely named temporary file from the edit file name.
+
+   3.   Give it the owner and permissions of the edit file, or of a new
+        file.  If the owner cannot be kept, write in place.
+
+OUTPUTS:
+   fd - Returned value
+        The open temporary file, or -1 if one cannot be used.  No
+        message is issued, pw writes the edit file in place.
+
+*************************************************************************/
+
+static int   open_save_temp(char          *edit_file,
+                            struct stat   *file_stats,
+                            int            file_exists,
+                            char          *temp_file)
+{
+int                   fd;
+struct stat           link_stats;
+mode_t                mask;
+
+if (file_exists &&
+    ((lstat(edit_file, &link_stats) != 0) || !S_ISREG(link_stats.st_mode) || (link_stats.st_nlink > 1)))
+   return(-1);
+
+snprintf(temp_file, MAXPATHLEN+16, "%s.CEWXXXXXX", edit_file);
+fd = mkstemp(temp_file);
+if (fd < 0)
+   {
+      DEBUG1(fprintf(stderr, "open_save_temp: Cannot create %s (%s), writing in place\n", temp_file, strerror(errno));)
+      return(-1);
+   }
+
+if (file_exists)
+   {
+      if (fchown(fd, file_stats->st_uid, file_stats->st_gid) != 0)
+         {
+            DEBUG1(fprintf(stderr, "open_save_temp: Cannot give %s the owner of %s (%s), writing in place\n", temp_file, edit_file, strerror(errno));)
+            close(fd);
+            unlink(temp_file);
+            return(-1);
+         }
+      (void) fchmod(fd, file_stats->st_mode & 07777);
+   }
+else
+   {
+      mask = umask(0);
+      umask(mask);
+      (void) fchmod(fd, 0666 & ~mask);
+   }
+
+return(fd);
+
+}  /* end of open_save_temp */
+
+
+/************************************************************************
+
+NAME:      save_to_temp - Write the temporary file and rename it over the edit file
+
+PURPOSE:    This routine writes the main pad to the temporary file from
+            open_save_temp, syncs it as -fsync says, and renames it over
+            the edit file.  It reports how long the write took for large
+            files.
+
+PARAMETERS:
+
+   1.  dspl_descr  - pointer to DISPLAY_DESCR (INPUT)
+                     The display with the main pad to save.
+
+   2.  edit_file   - pointer to char (INPUT)
+                     This is the path name being edited.
+
+   3.  fd          - int (INPUT)
+                     The temporary file, it is closed.
+
+   4.  temp_file   - pointer to char (INPUT)
+                     The name of the temporary file.
+
+FUNCTIONS :
+
+   1.   Write the file with save_file_fd.
+
+   2.   Unless -fsync none is set, sync the file.
+
+   3.   Rename the file over the edit file.  With -fsync dir, sync the
+        directory as well so the rename is on disk.
+
+   4.   If anything fails, remove the temporary file.
+
+OUTPUTS:
+   rc - Returned value
+        0  -  Save succeeded
+       -1  -  Save failed, dm_error call already issued.  The edit file
+              was not touched.
+
+*************************************************************************/
+
+#define SAVE_REPORT_BYTES  (1024 * 1024)
+
+static int   save_to_temp(DISPLAY_DESCR *dspl_descr,
+                          char          *edit_file,
+                          int            fd,
+                          char          *temp_file)
+{
+long                  bytes;
+int                   policy;
+char                  dir[MAXPATHLEN+1];
+char                  msg[MAXPATHLEN+128];
+struct timeval        start_time;
+struct timeval        end_time;
+double                seconds;
+
+policy = FSYNC_PARM ? (*FSYNC_PARM | 0x20) : 'f';
+
+gettimeofday(&start_time, NULL);
+
+bytes = save_file_fd(dspl_descr->main_pad->token, fd, -1); /* in memdata.c */
+
+if ((bytes >= 0) && (policy != 'n') && (fsync(fd) != 0))
+   {
+      snprintf(msg, sizeof(msg), "Can't sync %s, (%s) %s not changed", temp_file, strerror(errno), edit_file);
+      dm_error(msg, DM_ERROR_BEEP);
+      bytes = -1;
+   }
+
+if ((close(fd) != 0) && (bytes >= 0))
+   {
+      snprintf(msg, sizeof(msg), "Can't close %s, (%s) %s not changed", temp_file, strerror(errno), edit_file);
+      dm_error(msg, DM_ERROR_BEEP);
+      bytes = -1;
+   }
+
+if ((bytes >= 0) && (rename(temp_file, edit_file) != 0))
+   {
+      snprintf(msg, sizeof(msg), "Can't rename %s to %s, (%s) file not changed", temp_file, edit_file, strerror(errno));
+      dm_error(msg, DM_ERROR_BEEP);
+      bytes = -1;
+   }
+
+if (bytes < 0)
+   {
+      unlink(temp_file);
+      return(-1);
+   }
+
+if ((policy == 'd') && (sync_edit_dir(edit_file, dir) != 0))
+   {
+      snprintf(msg, sizeof(msg), "Can't sync directory %s, (%s)", dir, strerror(errno));
+      dm_error(msg, DM_ERROR_LOG);
+   }
+
+gettimeofday(&end_time, NULL);
+seconds = (end_time.tv_sec - start_time.tv_sec) + ((end_time.tv_usec - start_time.tv_usec) / 1000000.0);
+
+DEBUG1(fprintf(stderr, "save_to_temp: %ld bytes to %s in %.3f seconds, fsync %c\n", bytes, edit_file, seconds, policy);)
+
+if (bytes >= SAVE_REPORT_BYTES)
+   {
+      snprintf(msg, sizeof(msg), "File written, %d lines, %.1f MB in %.2f seconds (%.1f MB/s)",
+               total_lines(dspl_descr->main_pad->token), bytes / (1024.0 * 1024.0), seconds,
+               (seconds > 0.0) ? (bytes / (1024.0 * 1024.0)) / seconds : 0.0);
+      dm_error(msg, DM_ERROR_MSG);
+   }
+
+return(0);
+
+}  /* end of save_to_temp */
+
+
+/************************************************************************
+
+NAME:      sync_edit_dir - Sync the directory of the edit file
+
+PURPOSE:    With -fsync dir, the directory is synced after the rename so
+            the new directory entry is on disk too.
+
+PARAMETERS:
+
+   1.  edit_file   - pointer to char (INPUT)
+                     This is the path name being edited.
+
+   2.  dir         - pointer to char (OUTPUT)
+                     The directory synced is put here for messages.  It
+                     must be MAXPATHLEN+1 bytes.
+
+OUTPUTS:
+   rc - Returned value
+        0  -  The directory was synced
+       -1  -  It was not, errno is set.
+
+*************************************************************************/
+
+static int   sync_edit_dir(char          *edit_file,
+                           char          *dir)
+{
+int                   dir_fd;
+int                   rc;
+int                   save_errno;
+char                 *p;
+
+strlcpy(dir, edit_file, MAXPATHLEN+1);
+p = strrchr(dir, '/');
+if (p == dir)
+   p[1] = '\0';
+else
+   if (p)
+      *p = '\0';
+   else
+      strlcpy(dir, ".", MAXPATHLEN+1);
+
+dir_fd = open(dir, O_RDONLY);
+if (dir_fd < 0)
+   return(-1);
+
+rc = fsync(dir_fd);
+save_errno = errno;
+close(dir_fd);
+errno = save_errno;
+
+return(rc);
+
+}  /* end of sync_edit_dir */
+
+
+/***************************************************************
+*  
+*  A background pw.
+*
+*  A pw of a big file is done by a child process.  fork gives it
+*  a copy of the memory copy of the file as it is at the pw, and
+*  memdata is not safe to use from more than one thread, so the
+*  child never gets in the way of the editing going on in the
+*  parent.  The child writes the temporary file and renames it
+*  over the edit file.  Over a pipe, it sends the count of lines
+*  written from time to time and, at the end, -1 for success or
+*  -1 minus the errno.  Each of these is a long, written in one
+*  write, so they are never split on the pipe.
+*
+*  The parent looks at the pipe from timeout_set and does the
+*  backup, lock, and cc processing once the file is there.  The
+*  journal keeps the changes made in the meantime, see
+*  journal_rebase, and the autosave image waits, see
+*  autoimage_pause.
+*  
+***************************************************************/
+
+#define PW_BG_LINES    100000   /* smallest file written in the background */
+#define PW_BG_USECS    250000   /* how often the pipe is looked at         */
+#define PW_BG_OK       -1L      /* last record for success                 */
+
+static struct {
+   pid_t            pid;               /* the writer, 0 for none              */
+   int              pipe_fd;           /* progress from the writer            */
+   DISPLAY_DESCR   *dspl_descr;        /* display the pw was done from        */
+   char             edit_file[MAXPATHLEN+1];
+   char             temp_file[MAXPATHLEN+16];
+   struct stat      file_stats;        /* stats before the pw                 */
+   int              new_file;          /* the file did not exist              */
+   int              lines;             /* lines being written                 */
+   long             progress;          /* lines written so far                */
+   long             result;            /* last record, 0 till it shows up     */
+   long             mark;              /* journal_mark at the pw              */
+   struct timeval   start_time;
+} bg_pw;
+
+
+/************************************************************************
+
+NAME:      bg_start - Fork a process to write the temporary file
+
+PURPOSE:    This routine starts a background pw.
+
+PARAMETERS:
+
+   1.  dspl_descr  - pointer to DISPLAY_DESCR (INPUT)
+                     The display with the main pad to save.
+
+   2.  edit_file   - pointer to char (INPUT)
+                     This is the path name being edited.
+
+   3.  fd          - int (INPUT)
+                     The temporary file from open_save_temp.  If the pw
+                     goes to the background, it is closed in the parent.
+
+   4.  temp_file   - pointer to char (INPUT)
+                     The name of the temporary file.
+
+   5.  file_stats  - pointer to struct stat (INPUT)
+                     The stats of the edit file before the pw.
+
+   6.  new_file    - int (INPUT)
+                     True if the edit file did not exist.
+
+OUTPUTS:
+   rc - Returned value
+        0  -  The writer is running
+       -1  -  No process could be started, fd is still open and
+              the caller writes the file itself.
+
+*************************************************************************/
+
+static int   bg_start(DISPLAY_DESCR *dspl_descr,
+                      char          *edit_file,
+                      int            fd,
+                      char          *temp_file,
+                      struct stat   *file_stats,
+                      int            new_file)
+{
+int                   pipe_fds[2];
+int                   policy;
+int                   err = 0;
+long                  result;
+pid_t                 pid;
+char                  dir[MAXPATHLEN+1];
+
+if (pipe(pipe_fds) != 0)
+   {
+      DEBUG1(fprintf(stderr, "bg_start: pipe failed (%s), writing in the foreground\n", strerror(errno));)
+      return(-1);
+   }
+
+policy = FSYNC_PARM ? (*FSYNC_PARM | 0x20) : 'f';
+
+pid = fork();
+if (pid < 0)
+   {
+      DEBUG1(fprintf(stderr, "bg_start: fork failed (%s), writing in the foreground\n", strerror(errno));)
+      close(pipe_fds[0]);
+      close(pipe_fds[1]);
+      return(-1);
+   }
+
+if (pid == 0)
+   {
+      /***************************************************************
+      *  The writer.  It must not touch the X connection or run the
+      *  exit processing of the editor, so it leaves with _exit.
+      ***************************************************************/
+      close(pipe_fds[0]);
+      if (save_file_fd(dspl_descr->main_pad->token, fd, pipe_fds[1]) < 0) /* in memdata.c */
+         err = errno;
+      if (!err && (policy != 'n') && (fsync(fd) != 0))
+         err = errno;
+      if ((close(fd) != 0) && !err)
+         err = errno;
+      if (!err && (rename(temp_file, edit_file) != 0))
+         err = errno;
+      if (!err && (policy == 'd'))
+         (void) sync_edit_dir(edit_file, dir);
+      if (err)
+         unlink(temp_file);
+      result = err ? (PW_BG_OK - err) : PW_BG_OK;
+      (void) write(pipe_fds[1], (char *)&result, sizeof(result));
+      _exit(err ? 1 : 0);
+   }
+
+close(pipe_fds[1]);
+close(fd);
+fcntl(pipe_fds[0], F_SETFL, fcntl(pipe_fds[0], F_GETFL) | O_NONBLOCK);
+fcntl(pipe_fds[0], F_SETFD, FD_CLOEXEC);
+
+memset((char *)&bg_pw, 0, sizeof(bg_pw));
+bg_pw.pid        = pid;
+bg_pw.pipe_fd    = pipe_fds[0];
+bg_pw.dspl_descr = dspl_descr;
+strlcpy(bg_pw.edit_file, edit_file, sizeof(bg_pw.edit_file));
+strlcpy(bg_pw.temp_file, temp_file, sizeof(bg_pw.temp_file));
+bg_pw.file_stats = *file_stats;
+bg_pw.new_file   = new_file;
+bg_pw.lines      = total_lines(dspl_descr->main_pad->token);
+bg_pw.mark       = journal_mark(); /* in journal.c */
+gettimeofday(&bg_pw.start_time, NULL);
+
+/***************************************************************
+*  
+*  As far as undo and the titlebar go, the file is saved now.
+*  If the write fails, bg_finish puts the dirty bit back and takes
+*  the pad write mark out of the undo list.
+*  
+***************************************************************/
+
+autoimage_pause(dspl_descr->main_pad->token); /* in autoimage.c */
+event_do(dspl_descr->main_pad->token, PW_EVENT, -1, 0, 0, NULL); 
+dirty_bit(dspl_descr->main_pad->token) = 0;
+
+DEBUG1(fprintf(stderr, "bg_start: pid %d writing %d lines to %s\n", pid, bg_pw.lines, temp_file);)
+
+return(0);
+
+}  /* end of bg_start */
+
+
+/************************************************************************
+
+NAME:      bg_read - Read progress from the background pw
+
+PURPOSE:    This routine reads what the writer has sent so far.
+
+OUTPUTS:
+   done - Returned value
+        True  -  The writer is done, the pipe is at end of file.
+        False -  Nothing more is there yet.
+
+*************************************************************************/
+
+static int   bg_read(void)
+{
+long                  records[64];
+int                   count;
+int                   i;
+
+while ((count = read(bg_pw.pipe_fd, (char *)records, sizeof(records))) > 0)
+   for (i = 0; i < (int)(count / sizeof(long)); i++)
+      if (records[i] >= 0)
+         bg_pw.progress = records[i];
+      else
+         bg_pw.result = records[i];
+
+if ((count < 0) && ((errno == EAGAIN) || (errno == EINTR)))
+   return(False);
+
+return(True);
+
+}  /* end of bg_read */
+
+
+/************************************************************************
+
+NAME:      bg_finish - Finish a background pw once the file is written
+
+PURPOSE:    This routine does the work dm_pw does after the file is
+            written, or puts things back if the write failed.
+
+*************************************************************************/
+
+static void  bg_finish(void)
+{
+DATA_TOKEN           *token = bg_pw.dspl_descr->main_pad->token;
+struct stat           new_file_stats;
+struct timeval        end_time;
+double                seconds;
+double                mb;
+int                   err;
+char                  msg[MAXPATHLEN+128];
+
+close(bg_pw.pipe_fd);
+(void) waitpid(bg_pw.pid, NULL, 0); /* may already be gone to reap_child_process */
+bg_pw.pid = 0;
+
+if (bg_pw.result != PW_BG_OK)
+   {
+      err = bg_pw.result ? (int)(PW_BG_OK - bg_pw.result) : 0;
+      unlink(bg_pw.temp_file);
+      dirty_bit(token) = 1;
+      event_pw_failed(token); /* in undo.c, undo must not find the file saved here */
+      autoimage_resume(token, bg_pw.edit_file, False); /* in autoimage.c */
+      snprintf(msg, sizeof(msg), "Background pw of %s failed, (%s) file not changed",
+               bg_pw.edit_file, err ? strerror(err) : "writer ended early");
+      dm_error(msg, DM_ERROR_BEEP);
+      process_redraw(bg_pw.dspl_descr, TITLEBAR_MASK & FULL_REDRAW, False);
+      return;
+   }
+
+file_has_changed(bg_pw.edit_file);
+journal_rebase(bg_pw.edit_file, bg_pw.mark); /* in journal.c */
+autoimage_resume(token, bg_pw.edit_file, True); /* in autoimage.c */
+
+pw_done(bg_pw.dspl_descr, bg_pw.edit_file, &bg_pw.file_stats, !bg_pw.new_file, bg_pw.new_file);
+
+gettimeofday(&end_time, NULL);
+seconds = (end_time.tv_sec - bg_pw.start_time.tv_sec) + ((end_time.tv_usec - bg_pw.start_time.tv_usec) / 1000000.0);
+mb = (stat(bg_pw.edit_file, &new_file_stats) == 0) ? new_file_stats.st_size / (1024.0 * 1024.0) : 0.0;
+
+DEBUG1(fprintf(stderr, "bg_finish: %s written in %.3f seconds\n", bg_pw.edit_file, seconds);)
+
+snprintf(msg, sizeof(msg), "File written in the background, %d lines, %.1f MB in %.2f seconds (%.1f MB/s)",
+         bg_pw.lines, mb, seconds, (seconds > 0.0) ? mb / seconds : 0.0);
+dm_error(msg, DM_ERROR_MSG);
+process_redraw(bg_pw.dspl_descr, TITLEBAR_MASK & FULL_REDRAW, False);
+
+}  /* end of bg_finish */
+#endif
+
+
 /************************************************************************
 
 NAME:      dm_pw
@@ -1795,7 +2386,10 @@ FUNCTIONS :
    1.   If the file already exists and a backup has not been created,
         create a backup.
 
-   2.   Open the file for write and copy it out from the memory copy.
+   2.   Write the memory copy to a temporary file beside the file and
+        rename it over the file.  When this cannot be done, such as for
+        -lsf or a file with more than one link, open the file for write
+        and copy it out from the memory copy.
 
    3.   Close the file and adjust the stats and ownership.
 
@@ -1813,14 +2407,69 @@ int   dm_pw(DISPLAY_DESCR *dspl_descr,         /* input  */
             int            from_crash_file)    /* input  */
 {
 
+return(pw_save(dspl_descr, edit_file, from_crash_file, False));
+
+}  /* end of dm_pw */
+
+
+/************************************************************************
+
+NAME:      dm_pw_bg
+
+PURPOSE:    This routine does the pw command.  It is dm_pw, except a
+            file of PW_BG_LINES lines or more is written by a background
+            process while editing goes on.  The titlebar shows how far
+            along it is.
+
+PARAMETERS:
+
+   1.  dspl_descr      - pointer to DISPLAY_DESCR (INPUT)
+                         This is the display description for the current display.
+
+   2.  edit_file       - pointer to char (INPUT)
+                         This is the path name being edited.
+
+OUTPUTS:
+   rc - Returned value
+        0  -  Save succeeded or was started
+       -1  -  Save failed, dm_error call already issued.
+
+*************************************************************************/
+
+int   dm_pw_bg(DISPLAY_DESCR *dspl_descr,         /* input  */
+               char          *edit_file)          /* input  */
+{
+
+return(pw_save(dspl_descr, edit_file, False, True));
+
+}  /* end of dm_pw_bg */
+
+
+/************************************************************************
+
+NAME:      pw_save - Do the work of dm_pw and dm_pw_bg
+
+PURPOSE:    This routine does a pad write, see dm_pw.  If background is
+            True and the file is big enough, the file is written by
+            bg_start and finished later by bg_finish.
+
+*************************************************************************/
+
+static int   pw_save(DISPLAY_DESCR *dspl_descr,         /* input  */
+                     char          *edit_file,          /* input  */
+                     int            from_crash_file,    /* input  */
+                     int            background)         /* input  */
+{
+
 int                   rc;
 FILE                 *stream;
 struct stat           file_stats;
-struct stat           new_file_stats;
 int                   file_recreated = False;
 char                  msg[512];
 int                   new_file = False;
 int                   backup_count = 0;
+int                   temp_fd = -1;
+char                  temp_file[MAXPATHLEN+16];
 
 static int            backup_created = False;
 
@@ -1828,6 +2477,9 @@ static int            backup_created = False;
 if (strcmp(edit_file, STDIN_FILE_STRING) == 0)
    return(-1);
 
+if (!from_crash_file)
+   pw_wait();
+
 load_enough_data(INT_MAX);
 
 /***************************************************************
@@ -1845,6 +2497,12 @@ load_enough_data(INT_MAX);
 
 
 rc = stat(edit_file, &file_stats);
+
+#if !defined(WIN32) && !defined(MVS_SERVICES)
+if (!LSF) /* the temporary file is opened first so a dm backup can link rather than rename */
+   temp_fd = open_save_temp(edit_file, &file_stats, (rc == 0), temp_file);
+#endif
+
 if ((rc == 0) && (file_stats.st_size != 0))
    {
       if (!backup_created && ((*(BACKUP_TYPE) | 0x20) != 'n') &&
@@ -1859,13 +2517,27 @@ if ((rc == 0) && (file_stats.st_size != 0))
 
             backup_created = True;
             if ((*(BACKUP_TYPE) | 0x20) != 'v')
-               if (create_backup_dm(edit_file) == 0)
+               if (create_backup_dm(edit_file, (temp_fd >= 0)) == 0)
                   file_recreated = True;
                else
-                  return(-1);
+                  {
+                     if (temp_fd >= 0)
+                        {
+                           close(temp_fd);
+                           unlink(temp_file);
+                        }
+                     return(-1);
+                  }
             else
               if (create_backup_vi(edit_file, &file_stats) != 0)
-                 return(-1);
+                 {
+                    if (temp_fd >= 0)
+                       {
+                          close(temp_fd);
+                          unlink(temp_file);
+                       }
+                    return(-1);
+                 }
          }
       
    }
@@ -1876,34 +2548,115 @@ else
    }
 
 
-if (LSF)
-   stream = filter_out(&(dspl_descr->ind_data), dspl_descr->hsearch_data, edit_file, "w");
-else
-   stream = fopen(edit_file, "w");
+/***************************************************************
+*  
+*  Write the new copy beside the file and rename it over the
+*  file.  When that cannot be done, write the file in place.
+*  
+***************************************************************/
 
-if (stream == NULL)
+#if !defined(WIN32) && !defined(MVS_SERVICES)
+if (background && !from_crash_file && (temp_fd >= 0) &&
+    (total_lines(dspl_descr->main_pad->token) >= PW_BG_LINES) &&
+    (bg_start(dspl_descr, edit_file, temp_fd, temp_file, &file_stats, new_file) == 0))
+   return(0);
+
+if (temp_fd >= 0)
    {
-      snprintf(msg, sizeof(msg), "Can't save file, (%s) -> Try 1,$xc -f <some_file> to save elsewhere.", strerror(errno));
-      dm_error(msg, DM_ERROR_BEEP);
-      return(-1);
+      if (save_to_temp(dspl_descr, edit_file, temp_fd, temp_file) != 0)
+         return(-1);
+      if (!new_file)
+         file_recreated = True; /* the rename gave the file a new inode */
    }
+else
+#endif
+   {
+      if (LSF)
+         stream = filter_out(&(dspl_descr->ind_data), dspl_descr->hsearch_data, edit_file, "w");
+      else
+         stream = fopen(edit_file, "w");
+
+      if (stream == NULL)
+         {
+            snprintf(msg, sizeof(msg), "Can't save file, (%s) -> Try 1,$xc -f <some_file> to save elsewhere.", strerror(errno));
+            dm_error(msg, DM_ERROR_BEEP);
+            return(-1);
+         }
 
 
-save_file(dspl_descr->main_pad->token, stream); /* in memdata.c */
+      save_file(dspl_descr->main_pad->token, stream); /* in memdata.c */
 
 #ifdef MVS_SERVICES
-         mvs_file(edit_file) ? mvs_close((MVS_FILE *)stream, 0) : 
+               mvs_file(edit_file) ? mvs_close((MVS_FILE *)stream, 0) : 
 #endif
-if (fclose(stream) != 0) /* RES 2/9/1999 added test for failure */
-   {
-      snprintf(msg, sizeof(msg), "fclose of %s failed, (%s) file may be corrupted!, CREATING CRASH FILE", edit_file, strerror(errno));
-      dm_error(msg, DM_ERROR_LOG);
-      if (!from_crash_file)
-         create_crash_file();
-      return(-1);
+      if (fclose(stream) != 0) /* RES 2/9/1999 added test for failure */
+         {
+            snprintf(msg, sizeof(msg), "fclose of %s failed, (%s) file may be corrupted!, CREATING CRASH FILE", edit_file, strerror(errno));
+            dm_error(msg, DM_ERROR_LOG);
+            if (!from_crash_file)
+               create_crash_file();
+            return(-1);
+         }
    }
 file_has_changed(edit_file);
 
+/***************************************************************
+*  
+*  The file on disk now holds every change, the journal can
+*  start over from it.
+*  
+***************************************************************/
+
+if (!from_crash_file)
+   {
+      journal_reset(dspl_descr->main_pad->token, edit_file); /* in journal.c */
+      autoimage_reset(dspl_descr->main_pad->token, edit_file); /* in autoimage.c */
+   }
+
+pw_done(dspl_descr, edit_file, &file_stats, file_recreated, new_file);
+
+return(0);
+
+}  /* end of pw_save */
+
+
+/************************************************************************
+
+NAME:      pw_done - Straighten out stats, locks, and cc data after a pw
+
+PURPOSE:    Once the edit file is written, this routine checks the new
+            file looks new, puts back the permissions and owner, moves
+            the lock, and tells the cc list.
+
+PARAMETERS:
+
+   1.  dspl_descr      - pointer to DISPLAY_DESCR (INPUT)
+                         This is the display description for the pw.
+
+   2.  edit_file       - pointer to char (INPUT)
+                         This is the path name being edited.
+
+   3.  file_stats      - pointer to struct stat (INPUT)
+                         The stats of the edit file before the pw.
+
+   4.  file_recreated  - int (INPUT)
+                         True if the file has a new inode.
+
+   5.  new_file        - int (INPUT)
+                         True if the file did not exist.
+
+*************************************************************************/
+
+static void  pw_done(DISPLAY_DESCR *dspl_descr,
+                     char          *edit_file,
+                     struct stat   *file_stats,
+                     int            file_recreated,
+                     int            new_file)
+{
+FILE                 *stream;
+struct stat           new_file_stats;
+char                  msg[512];
+
 /***************************************************************
 *  
 *  NFS and AFS caching can sometimes mess up the stat information.
@@ -1914,9 +2667,9 @@ file_has_changed(edit_file);
 
 if (file_recreated)
    {
-      rc = stat(edit_file, &new_file_stats);
-      if ((file_stats.st_ino   == new_file_stats.st_ino) ||
-          (file_stats.st_ctime == new_file_stats.st_ctime))
+      (void) stat(edit_file, &new_file_stats);
+      if ((file_stats->st_ino   == new_file_stats.st_ino) ||
+          (file_stats->st_ctime == new_file_stats.st_ctime))
          {
             DEBUG(fprintf(stderr, "pw:  File inode and create time stayed the same in %s after DM type backup, trying tickle\n", edit_file);) 
             stream = fopen(edit_file, "r");  /* access the file again */
@@ -1929,9 +2682,9 @@ if (file_recreated)
 #else
             sleep(2);
 #endif
-            rc = stat(edit_file, &new_file_stats);
-            if ((file_stats.st_ino   == new_file_stats.st_ino) ||
-                (file_stats.st_ctime == new_file_stats.st_ctime))
+            (void) stat(edit_file, &new_file_stats);
+            if ((file_stats->st_ino   == new_file_stats.st_ino) ||
+                (file_stats->st_ctime == new_file_stats.st_ctime))
                {
                   snprintf(msg, sizeof(msg), "pw:  File inode and create time stayed the same in %s after rename to %s.bak and recreate of file, automatic CC detection frustrated", edit_file, edit_file);
                   dm_error(msg, DM_ERROR_LOG);
@@ -1950,9 +2703,9 @@ if (file_recreated || new_file)
    {
       if (!new_file) /* RES 9/27/95 new_file processing added */
          {
-            (void) chmod(edit_file, file_stats.st_mode);
+            (void) chmod(edit_file, file_stats->st_mode);
 #ifndef WIN32
-            (void) chown(edit_file, file_stats.st_uid, file_stats.st_gid);
+            (void) chown(edit_file, file_stats->st_uid, file_stats->st_gid);
 #endif
          }
       if (LOCKF && /* RES 9/5/95 added file locking */
@@ -1973,10 +2726,109 @@ else
 
 cc_padname(dspl_descr, edit_file); /* cc_padname is needed to update file size in cc data  9/23/97 RES */
 
+}  /* end of pw_done */
+
+
+/************************************************************************
+
+NAME:      pw_timeout - Microseconds till a background pw is looked at again
+
+PURPOSE:    This routine is called from timeout_set and getevent.  While a
+            background pw runs, it reads the progress from the writer,
+            redraws the titlebar when it changes, and finishes the pw
+            when the writer is done.
 
+OUTPUTS:
+   usecs - Returned value
+        0 if no background pw is running, otherwise how long to wait
+        before calling again.
+
+*************************************************************************/
+
+int   pw_timeout(void)
+{
+#if !defined(WIN32) && !defined(MVS_SERVICES)
+long                  progress;
+
+if (!bg_pw.pid)
+   return(0);
+
+progress = bg_pw.progress;
+if (bg_read())
+   {
+      bg_finish();
+      return(0);
+   }
+
+if (progress != bg_pw.progress)
+   process_redraw(bg_pw.dspl_descr, TITLEBAR_MASK & FULL_REDRAW, False);
+
+return(PW_BG_USECS);
+#else
 return(0);
+#endif
 
-}  /* end of dm_pw */
+}  /* end of pw_timeout */
+
+
+/************************************************************************
+
+NAME:      pw_wait - Wait for a background pw to finish
+
+PURPOSE:    Anything which writes, renames, rereads, or closes the edit
+            file calls this first so a background pw is finished before
+            it goes on.
+
+*************************************************************************/
+
+void  pw_wait(void)
+{
+#if !defined(WIN32) && !defined(MVS_SERVICES)
+
+if (!bg_pw.pid)
+   return;
+
+DEBUG1(fprintf(stderr, "pw_wait: waiting for pid %d\n", bg_pw.pid);)
+
+fcntl(bg_pw.pipe_fd, F_SETFL, fcntl(bg_pw.pipe_fd, F_GETFL) & ~O_NONBLOCK);
+while (!bg_read())
+   ; /* EINTR, go around */
+
+bg_finish();
+#endif
+
+}  /* end of pw_wait */
+
+
+/************************************************************************
+
+NAME:      pw_progress - Percent done of a background pw, for the titlebar
+
+PARAMETERS:
+
+   1.  dspl_descr      - pointer to DISPLAY_DESCR (INPUT)
+                         The display whose titlebar is being drawn.
+
+OUTPUTS:
+   percent - Returned value
+        How much of the file the background pw has written, or -1 if
+        no background pw of this main pad is running.
+
+*************************************************************************/
+
+int   pw_progress(DISPLAY_DESCR *dspl_descr)
+{
+#if !defined(WIN32) && !defined(MVS_SERVICES)
+
+if (!bg_pw.pid || (dspl_descr->main_pad->token != bg_pw.dspl_descr->main_pad->token) || (bg_pw.lines <= 0))
+   return(-1);
+
+return((int)((bg_pw.progress * 100) / bg_pw.lines));
+#else
+return(-1);
+#endif
+
+}  /* end of pw_progress */
 
 
 
@@ -41,6 +41,10 @@
 *         ok_for_input        - Verify that a file can be opened for input.
 *         dm_pn               - Pad Name / Rename command
 *         dm_pw               - Pad Write (save) command
+*         dm_pw_bg            - Pad Write, large files written in the background
+*         pw_timeout          - Microseconds till a background pw is looked at again
+*         pw_wait             - Wait for a background pw to finish
+*         pw_progress         - Percent done of a background pw, for the titlebar
 *         dm_cd               - Change Dir (for edit process)
 *         dm_pwd              - print current DM working directory
 *
@@ -100,6 +104,15 @@ int   dm_pw(DISPLAY_DESCR *dspl_descr,         /* input  */
             char          *edit_file,          /* input  */
             int            from_crash_file);   /* input  */
 
+int   dm_pw_bg(DISPLAY_DESCR *dspl_descr,         /* input  */
+               char          *edit_file);         /* input  */
+
+int   pw_timeout(void);
+
+void  pw_wait(void);
+
+int   pw_progress(DISPLAY_DESCR *dspl_descr);     /* input  */
+
 void dm_cd(DMC        *dmc,                    /* input  */
            char       *edit_file);             /* input  */
 
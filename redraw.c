@@ -35,6 +35,8 @@
 *     redo_cursor             - Generate a warp to reposition the cursor after a window size change.
 *     fake_cursor_motion      - Fudge up a motion event
 *     off_screen_warp_check   - Adjust warps to areas on the physical screen.
+*     damage_whole_window     - Mark everything in a pad's pixmap area as needing redrawing.
+*     free_damage_data        - Free the damage tracking data for a pad.
 *
 *  Internal:
 *     redraw_pad              - Perform redraw processing on one pad.
@@ -45,6 +47,11 @@
 *     y_in_winline_check      - Verify that a warp is to the window line it is supposed to be.
 *     really_moved            - Check to see if the cursor really moved
 *     position_in_window      - Check if requested x,y position in the window
+*     damage_state_ok         - Check if the pixmap can be updated from the damage list
+*     save_damage_state       - Save what the pixmap was drawn against
+*     find_damage             - Build the list of damaged window rows
+*     damage_redraw           - Redraw only the damaged rows
+*     flash_damage            - Flash redrawn rows for debugging
 *
 ***************************************************************/
 
@@ -63,14 +70,19 @@
 #include "dmc.h"
 #include "dmwin.h"
 #include "dumpxevent.h"
+#include "emalloc.h"
 #include "getevent.h"
+#include "hlmatch.h"
 #include "init.h"
+#include "journal.h"
 #include "lineno.h"
+#include "memdata.h"
 #ifdef PAD
 #include "pad.h"         /* needed for macros TTY_ECHO_MODE and TTY_DOT_MODE */
 #endif
 #include "parms.h"
 #include "pd.h"
+#include "pw.h"
 #include "redraw.h"
 #include "scroll.h"
 #include "sendevnt.h"
@@ -79,6 +91,7 @@
 #include "titlebar.h"
 #include "txcursor.h"
 #include "typing.h"
+#include "usleep.h"
 #include "window.h"
 #include "winsetup.h"
 #include "windowdefs.h" /* needed for edit file in titlebar */
@@ -86,6 +99,75 @@
 #include "unixwin.h"
 #endif
 #include "xerrorpos.h"
+#include "xutil.h"
+
+/***************************************************************
+*  
+*  Damage tracking for the main pad.
+*  
+*  After each redraw of the main pad we save what the pixmap was
+*  drawn against: geometry, font, scrolling, hex mode and tab
+*  stops.  Each win_lines entry holds the memdata line drawn on
+*  that row and its generation.  When a full or partial redraw is
+*  requested and none of the saved state changed, the damaged
+*  rows are the ones whose memdata line or generation no longer
+*  matches what was drawn.  Typing, cc updates and every memdata
+*  change show up this way, so only those rows get painted.
+*  Colored files and vt100 mode always take the old path.
+*  
+*  DEBUG31 flashes the rows painted by each redraw.
+*  
+***************************************************************/
+
+#define DAMAGE_FLASH_USECS 100000
+
+typedef struct {
+   int            first;            /* first damaged window row             */
+   int            last;             /* last damaged window row              */
+} DAMAGE_RANGE;
+
+typedef struct {
+   int            valid;            /* True if the saved state is usable    */
+   Pixmap         pixmap;           /* pixmap drawn into                    */
+   DATA_TOKEN    *token;            /* memdata drawn from                   */
+   int            first_line;       /* pad->first_line                      */
+   int            first_char;       /* pad->first_char                      */
+   int            lines_on_screen;  /* rows in the window                   */
+   int            sub_x;            /* text area in the window              */
+   int            sub_y;
+   unsigned int   sub_width;
+   unsigned int   sub_height;
+   int            line_height;
+   unsigned int   width;            /* whole window size                    */
+   unsigned int   height;
+   Font           fid;              /* window font                          */
+   int            hex_mode;
+   int            ts_generation;    /* from tab_stop_generation             */
+   int            show_lineno;
+   int            lineno_width;
+   int            highlight_mode;   /* text highlighting was on             */
+   int            range_count;      /* damaged row ranges this redraw       */
+   int            range_size;       /* malloc'ed elements in ranges         */
+   DAMAGE_RANGE  *ranges;
+   int            frames;           /* redraws of the pad                   */
+   int            damage_frames;    /* redraws done from the damage list    */
+   int            last_painted;     /* lines painted by the last redraw     */
+   long           total_painted;    /* lines painted by all redraws         */
+} DAMAGE_DATA;
+
+/***************************************************************
+*  
+*  X request counts for process_redraw, reported under DEBUG12.
+*  Requests are counted from the request serial numbers.  If the
+*  last request the server is known to have processed is one we
+*  sent during the redraw, we read from the server mid redraw,
+*  which means a round trip.
+*  
+***************************************************************/
+
+static unsigned long  redraw_frames      = 0;
+static unsigned long  redraw_requests    = 0;
+static unsigned long  redraw_round_trips = 0;
 
 /***************************************************************
 *  
@@ -122,6 +204,31 @@ static int position_in_window(int              x,
                               int              y,
                               DRAWABLE_DESCR  *window);
 
+static int  damage_state_ok(PAD_DESCR      *pad,
+                            DISPLAY_DESCR  *dspl_descr);
+
+static void save_damage_state(PAD_DESCR      *pad,
+                              DISPLAY_DESCR  *dspl_descr,
+                              int             highlight_mode);
+
+static void find_damage(PAD_DESCR      *pad,
+                        DAMAGE_DATA    *damage,
+                        int             eof_row);
+
+static int  damage_redraw(PAD_DESCR      *pad,
+                          DISPLAY_DESCR  *dspl_descr,
+                          int             highlight_mode,
+                          int             full_width,
+                          int             full_height,
+                          XExposeEvent   *expose);
+
+#ifdef DebuG
+static void flash_damage(PAD_DESCR      *pad,
+                         DISPLAY_DESCR  *dspl_descr,
+                         int             use_damage,
+                         XExposeEvent   *expose);
+#endif
+
 
 /************************************************************************
 
@@ -169,6 +276,8 @@ long                  event_mask;
 int                   overlaid_cursor = False;
 int                   warp_changed;
 int                   warp_bad;
+unsigned long         first_request = NextRequest(dspl_descr->display);
+unsigned long         frame_requests;
 
 
 DEBUG12(fprintf(stderr, "process_redraw:   Redraw = 0x%02X, Warp = %d, display %d\n", redraw_needed, warp_needed, dspl_descr->display_no);)
@@ -451,6 +560,19 @@ else
       )
    }
 
+/***************************************************************
+*  Count the requests this redraw sent and whether we had to
+*  wait on the server for any of them.
+***************************************************************/
+frame_requests = NextRequest(dspl_descr->display) - first_request;
+redraw_frames++;
+redraw_requests += frame_requests;
+if (LastKnownRequestProcessed(dspl_descr->display) >= first_request)
+   redraw_round_trips++;
+DEBUG12(fprintf(stderr, "process_redraw:   %lu X requests%s, totals: %lu redraws, %lu requests, %lu with round trips\n",
+                frame_requests, ((LastKnownRequestProcessed(dspl_descr->display) >= first_request) ? " with round trip" : ""),
+                redraw_frames, redraw_requests, redraw_round_trips);)
+
 XFlush(dspl_descr->display);
 
 /***************************************************************
@@ -583,6 +705,9 @@ int                   highlight_mode;
 int                   need_expose = False;
 DISPLAY_DESCR        *walk_dspl;
 int                   overlaid_cursor = False;
+int                   use_damage = False;
+int                   painted_before = painted_line_count();
+DAMAGE_DATA          *damage;
 
 if (dspl_descr->x_pixmap == None)
    return(overlaid_cursor);
@@ -647,7 +772,18 @@ else
 if (highlight_mode)
    highlight_setup(&(dspl_descr->mark1), dspl_descr->echo_mode);
 
-if (redraw_needed & (FULL_REDRAW & pad->redraw_mask))
+/***************************************************************
+*  For full and partial redraws of the main pad, see if we can
+*  get away with redrawing just the rows which changed.
+***************************************************************/
+if ((pad->which_window == MAIN_PAD) && (redraw_needed & ((FULL_REDRAW | PARTIAL_REDRAW) & pad->redraw_mask)))
+   {
+      if (pad->buff_modified)
+         flush(pad);
+      use_damage = damage_state_ok(pad, dspl_descr);
+   }
+
+if ((redraw_needed & (FULL_REDRAW & pad->redraw_mask)) && !use_damage)
    {
       /***************************************************************
       *  
@@ -725,6 +861,28 @@ if (redraw_needed & (FULL_REDRAW & pad->redraw_mask))
    } /* end of full redraw */
 else
    {
+      if (use_damage)
+         {
+            /***************************************************************
+            *  
+            *  DAMAGED ROWS REDRAW of WINDOW
+            *  
+            ***************************************************************/
+
+            DEBUG12( fprintf(stderr," Damage redraw %s pixmap, first row = %d, first col = %d\n", which_window_names[pad->which_window], pad->first_line, pad->first_char); )
+            if (!get_background_work(MAIN_WINDOW_EOF))
+               load_enough_data(pad->first_line + pad->window->lines_on_screen);
+
+            if (redraw_needed & (FULL_REDRAW & pad->redraw_mask))
+               draw_titlebar(redraw_needed, dspl_descr);
+
+            need_expose = damage_redraw(pad, dspl_descr, highlight_mode, full_width, full_height, &expose);
+
+            if (need_expose && cursor_in_area(pad->x_window, expose.x, expose.y, expose.width, expose.height, dspl_descr))
+               overlaid_cursor = True;
+
+         } /* end of damaged rows redraw */
+      else
       if (redraw_needed & (PARTIAL_REDRAW & pad->redraw_mask))
          {
             /***************************************************************
@@ -928,6 +1086,32 @@ if (pad->which_window == MAIN_PAD)
                   overlaid_cursor = True;
          }
 
+/***************************************************************
+*  
+*  If the find pattern highlighted on the main window changed,
+*  the old highlight has to come off everywhere, so copy the
+*  whole window.
+*  
+***************************************************************/
+if ((pad->which_window == MAIN_PAD) && hlmatch_stale(dspl_descr))
+   {
+      DEBUG12(fprintf(stderr, "Match highlight out of date, copying the whole main window\n");)
+      expose.type       = Expose;
+      expose.serial     = 0;
+      expose.send_event = True;
+      expose.display    = dspl_descr->display;
+      expose.window     = pad->x_window;
+      expose.x          = 0;
+      expose.y          = 0;
+      expose.width      = full_width;
+      expose.height     = full_height;
+      expose.count      = 0;
+      need_expose       = True;
+
+      if (cursor_in_area(pad->x_window, 0, 0, expose.width, expose.height, dspl_descr))
+         overlaid_cursor = True;
+   }
+
 if (overlaid_cursor)
    clear_text_cursor(pad->x_window, dspl_descr);
 
@@ -955,11 +1139,38 @@ if (need_expose)
                 expose.x+pixmap_x, expose.y+pixmap_y,
                 expose.width, expose.height,
                 expose.x, expose.y);
+      if (pad->which_window == MAIN_PAD)
+         hlmatch_overlay(dspl_descr, expose.x, expose.y, expose.width, expose.height);
       if (highlight_mode)
          text_rehighlight(dspl_descr->main_pad->x_window, dspl_descr->main_pad->window, dspl_descr);
 
+      DEBUG31(flash_damage(pad, dspl_descr, use_damage, &expose);)
+
    } /* end of need expose */
 
+/***************************************************************
+*  
+*  Save what the main pad pixmap was drawn against for the next
+*  damage check and count the lines painted.
+*  
+***************************************************************/
+
+if (pad->which_window == MAIN_PAD)
+   {
+      save_damage_state(pad, dspl_descr, highlight_mode);
+      damage = (DAMAGE_DATA *)pad->damage_data;
+      if (damage)
+         {
+            damage->frames++;
+            if (use_damage)
+               damage->damage_frames++;
+            damage->last_painted = painted_line_count() - painted_before;
+            damage->total_painted += damage->last_painted;
+            DEBUG12(fprintf(stderr, "redraw_pad:       %d lines painted, %d of %d redraws from damage list, %ld lines painted total\n",
+                            damage->last_painted, damage->damage_frames, damage->frames, damage->total_painted);)
+         }
+   }
+
 pad->redraw_start_line = -1;
 return(overlaid_cursor);
 
@@ -1094,12 +1305,24 @@ static void draw_titlebar(int             redraw_needed,
                           DISPLAY_DESCR  *dspl_descr)
 {
 int                   modified;
+int                   percent;
 DISPLAY_DESCR        *walk_dspl;
+char                  title[sizeof(edit_file)+32];
+char                 *no_journal;
 
 modified = dirty_bit(dspl_descr->main_pad->token) | dspl_descr->main_pad->buff_modified;
 for (walk_dspl = dspl_descr->next; walk_dspl != dspl_descr; walk_dspl = walk_dspl->next)
     modified |= walk_dspl->main_pad->buff_modified;
 
+/* while a background pw runs, show how far along it is */
+percent = pw_progress(dspl_descr); /* in pw.c */
+/* -journal was asked for but changes are not being journaled */
+no_journal = journal_missing() ? " [no journal]" : ""; /* in journal.c */
+if (percent >= 0)
+   snprintf(title, sizeof(title), "%s [pw %d%%]%s", edit_file, percent, no_journal);
+else
+   snprintf(title, sizeof(title), "%s%s", edit_file, no_journal);
+
 #ifdef PAD
 if (dspl_descr->pad_mode)
    write_titlebar(dspl_descr->display,
@@ -1125,7 +1348,7 @@ else
    write_titlebar(dspl_descr->display,
                   dspl_descr->x_pixmap,
                   dspl_descr->title_subarea,
-                  edit_file,
+                  title,
                   dspl_descr->titlebar_host_name,
                   dspl_descr->main_pad->first_line,
                   dspl_descr->main_pad->first_char,
@@ -1820,6 +2043,543 @@ return(in_window);
       
 } /* end of position_in_window */
 
+/************************************************************************
+
+NAME:      damage_state_ok - Check if the pixmap can be updated from the damage list
+
+PURPOSE:    This routine checks whether the main pad pixmap still shows the
+            same window of the file, drawn the same way, as when it was last
+            drawn.  If so, only the rows whose data changed need painting.
+
+PARAMETERS:
+
+   1.  pad            - pointer to PAD_DESCR (INPUT)
+                        This is the main pad.
+
+   2.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT)
+                        This is the display the pad is on.
+
+FUNCTIONS :
+
+   1.   Rule out the cases damage tracking does not handle: colored
+        data, vt100 mode, form feeds in the window, excluded lines.
+
+   2.   Compare the saved drawing state with the current state.
+
+   3.   Make sure there is room for the list of damaged rows.
+
+RETURNED VALUE:
+   ok  -  int
+          True  -  the damaged rows can be redrawn by themselves.
+          False -  the whole pad must be redrawn.
+
+*************************************************************************/
+
+static int  damage_state_ok(PAD_DESCR      *pad,
+                            DISPLAY_DESCR  *dspl_descr)
+{
+DAMAGE_DATA          *damage = (DAMAGE_DATA *)pad->damage_data;
+
+#ifdef EXCLUDEP
+return(False);
+#else
+if (!damage || !damage->valid || (pad->which_window != MAIN_PAD))
+   return(False);
+
+if (dspl_descr->vt100_mode || COLORED(pad->token) || pad->formfeed_in_window)
+   return(False);
+
+if ((damage->pixmap          != dspl_descr->x_pixmap)                 ||
+    (damage->token           != pad->token)                           ||
+    (damage->first_line      != pad->first_line)                      ||
+    (damage->first_char      != pad->first_char)                      ||
+    (damage->lines_on_screen != pad->window->lines_on_screen)         ||
+    (damage->sub_x           != pad->window->sub_x)                   ||
+    (damage->sub_y           != pad->window->sub_y)                   ||
+    (damage->sub_width       != pad->window->sub_width)               ||
+    (damage->sub_height      != pad->window->sub_height)              ||
+    (damage->line_height     != pad->window->line_height)             ||
+    (damage->width           != pad->window->width)                   ||
+    (damage->height          != pad->window->height)                  ||
+    (damage->fid             != pad->window->font->fid)               ||
+    (damage->hex_mode        != dspl_descr->hex_mode)                 ||
+    (damage->ts_generation   != tab_stop_generation())                ||
+    (damage->show_lineno     != dspl_descr->show_lineno)              ||
+    (damage->lineno_width    != (int)dspl_descr->lineno_subarea->width))
+   return(False);
+
+if (pad->window->lines_on_screen > pad->win_lines_size)
+   return(False);
+
+/***************************************************************
+*  At worst every other row is a separate range.
+***************************************************************/
+if (damage->range_size < pad->window->lines_on_screen)
+   {
+      if (damage->ranges)
+         free((char *)damage->ranges);
+      damage->ranges = (DAMAGE_RANGE *)CE_MALLOC(pad->window->lines_on_screen * sizeof(DAMAGE_RANGE));
+      if (!damage->ranges)
+         {
+            damage->range_size = 0;
+            return(False);
+         }
+      damage->range_size = pad->window->lines_on_screen;
+   }
+
+return(True);
+#endif
+
+} /* end of damage_state_ok */
+
+
+/************************************************************************
+
+NAME:      save_damage_state - Save what the pixmap was drawn against
+
+PURPOSE:    This routine is called at the end of each redraw of the main
+            pad to save the state the pixmap was drawn in.  The next redraw
+            compares against it in damage_state_ok.
+
+PARAMETERS:
+
+   1.  pad            - pointer to PAD_DESCR (INPUT / OUTPUT)
+                        This is the main pad.  The damage data is
+                        allocated the first time through.
+
+   2.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT)
+                        This is the display the pad is on.
+
+   3.  highlight_mode - int (INPUT)
+                        True if text highlighting is on in this window.
+
+FUNCTIONS :
+
+   1.   Get the damage data if we do not already have it.
+
+   2.   Copy the current state.  Mark it unusable in the cases
+        damage tracking does not handle.
+
+*************************************************************************/
+
+static void save_damage_state(PAD_DESCR      *pad,
+                              DISPLAY_DESCR  *dspl_descr,
+                              int             highlight_mode)
+{
+DAMAGE_DATA          *damage = (DAMAGE_DATA *)pad->damage_data;
+
+if (!damage)
+   {
+      damage = (DAMAGE_DATA *)CE_MALLOC(sizeof(DAMAGE_DATA));
+      if (!damage)
+         return;
+      memset((char *)damage, 0, sizeof(DAMAGE_DATA));
+      pad->damage_data = (void *)damage;
+   }
+
+damage->valid           = (dspl_descr->x_pixmap != None) &&
+                          !dspl_descr->vt100_mode &&
+                          !COLORED(pad->token) &&
+                          !pad->formfeed_in_window;
+damage->pixmap          = dspl_descr->x_pixmap;
+damage->token           = pad->token;
+damage->first_line      = pad->first_line;
+damage->first_char      = pad->first_char;
+damage->lines_on_screen = pad->window->lines_on_screen;
+damage->sub_x           = pad->window->sub_x;
+damage->sub_y           = pad->window->sub_y;
+damage->sub_width       = pad->window->sub_width;
+damage->sub_height      = pad->window->sub_height;
+damage->line_height     = pad->window->line_height;
+damage->width           = pad->window->width;
+damage->height          = pad->window->height;
+damage->fid             = pad->window->font->fid;
+damage->hex_mode        = dspl_descr->hex_mode;
+damage->ts_generation   = tab_stop_generation();
+damage->show_lineno     = dspl_descr->show_lineno;
+damage->lineno_width    = dspl_descr->lineno_subarea->width;
+damage->highlight_mode  = highlight_mode;
+
+} /* end of save_damage_state */
+
+
+/************************************************************************
+
+NAME:      find_damage - Build the list of damaged window rows
+
+PURPOSE:    This routine compares each row of the window with the memdata
+            line which belongs there.  A row is damaged if it shows a
+            different line, an older generation of the line, or text
+            which did not come from memdata, such as a typing buffer.
+
+PARAMETERS:
+
+   1.  pad            - pointer to PAD_DESCR (INPUT)
+                        This is the main pad.
+
+   2.  damage         - pointer to DAMAGE_DATA (OUTPUT)
+                        The ranges of damaged rows are put here.
+
+   3.  eof_row        - int (INPUT)
+                        This is the first window row past the end of
+                        the file.  These rows should be empty.
+
+FUNCTIONS :
+
+   1.   Walk the rows and the file lines together.
+
+   2.   Merge adjacent damaged rows into ranges.
+
+*************************************************************************/
+
+static void find_damage(PAD_DESCR      *pad,
+                        DAMAGE_DATA    *damage,
+                        int             eof_row)
+{
+int                   row;
+char                 *line;
+unsigned int          generation;
+WINDOW_LINE          *win_line;
+
+damage->range_count = 0;
+if (eof_row > 0)
+   position_file_pointer(pad->token, pad->first_line);
+
+for (row = 0; row < pad->window->lines_on_screen; row++)
+{
+   if (row < eof_row)
+      {
+         line = next_line(pad->token);
+         generation = line_generation(pad->token, pad->first_line+row, line);
+      }
+   else
+      {
+         line = NULL;
+         generation = 0;
+      }
+
+   win_line = &pad->win_lines[row];
+   if ((win_line->line == line) && (win_line->w_generation == generation) && (!line || generation))
+      continue;
+
+   if (damage->range_count && (damage->ranges[damage->range_count-1].last == row-1))
+      damage->ranges[damage->range_count-1].last = row;
+   else
+      {
+         damage->ranges[damage->range_count].first = row;
+         damage->ranges[damage->range_count].last  = row;
+         damage->range_count++;
+      }
+}
+
+} /* end of find_damage */
+
+
+/************************************************************************
+
+NAME:      damage_redraw - Redraw only the damaged rows
+
+PURPOSE:    This routine replaces the full and partial redraw of the main pad
+            when damage_state_ok says the pixmap is still good except for
+            the rows whose data changed.
+
+PARAMETERS:
+
+   1.  pad            - pointer to PAD_DESCR (INPUT / OUTPUT)
+                        This is the main pad.
+
+   2.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT)
+                        This is the display the pad is on.
+
+   3.  highlight_mode - int (INPUT)
+                        True if text highlighting is on in this window.
+
+   4.  full_width     - int (INPUT)
+   5.  full_height    - int (INPUT)
+                        This is the size of the window area in the pixmap.
+
+   6.  expose         - pointer to XExposeEvent (OUTPUT)
+                        The area to be copied to the window is put here.
+
+FUNCTIONS :
+
+   1.   Find the damaged rows.
+
+   2.   Redraw each one from memdata.  Once we get to the end of file
+        or hit a form feed, let textfill_drawable do the rest of
+        the window.
+
+   3.   Redo the line numbers if the end of file moved.
+
+   4.   Set up the area to copy to the window.  It is the whole
+        window if highlighting is or was on.
+
+RETURNED VALUE:
+   need_expose  -  int
+                   True if anything needs to be copied to the window.
+
+*************************************************************************/
+
+static int  damage_redraw(PAD_DESCR      *pad,
+                          DISPLAY_DESCR  *dspl_descr,
+                          int             highlight_mode,
+                          int             full_width,
+                          int             full_height,
+                          XExposeEvent   *expose)
+{
+DAMAGE_DATA          *damage = (DAMAGE_DATA *)pad->damage_data;
+int                   eof_row;
+int                   old_lines_displayed = pad->lines_displayed;
+int                   i;
+int                   row;
+int                   fill_row = -1;
+int                   first_row;
+int                   last_row;
+int                   expose_x;
+
+eof_row = total_lines(pad->token) - pad->first_line;
+if (eof_row < 0)
+   eof_row = 0;
+if (eof_row > pad->window->lines_on_screen)
+   eof_row = pad->window->lines_on_screen;
+
+find_damage(pad, damage, eof_row);
+
+for (i = 0; i < damage->range_count && fill_row < 0; i++)
+   for (row = damage->ranges[i].first; row <= damage->ranges[i].last; row++)
+   {
+      if (row >= eof_row)
+         {
+            fill_row = eof_row;
+            break;
+         }
+
+      draw_partial_line(pad,
+                        row,
+                        0,                        /* window col */
+                        pad->first_line+row,
+                        get_line_by_num(pad->token, pad->first_line+row),
+                        False,                    /* not dot mode */
+                        &expose_x);
+
+      if (pad->formfeed_in_window)
+         {
+            fill_row = row;
+            break;
+         }
+   }
+
+/***************************************************************
+*  The rest of the window is drawn in one shot.  Fix up the range
+*  list so it shows what was painted.
+***************************************************************/
+if (fill_row >= 0)
+   {
+      DEBUG12(fprintf(stderr, " Damage redraw filling from row %d\n", fill_row);)
+      textfill_drawable(pad,
+                        False,                    /* not overlay mode */
+                        fill_row,                 /* starting line on window */
+                        False);                   /* not dot mode */
+
+      while (damage->range_count && (damage->ranges[damage->range_count-1].first >= fill_row))
+         damage->range_count--;
+      if (damage->range_count && (damage->ranges[damage->range_count-1].last >= fill_row-1))
+         damage->ranges[damage->range_count-1].last = pad->window->lines_on_screen-1;
+      else
+         {
+            damage->ranges[damage->range_count].first = fill_row;
+            damage->ranges[damage->range_count].last  = pad->window->lines_on_screen-1;
+            damage->range_count++;
+         }
+   }
+else
+   pad->lines_displayed = eof_row;
+
+DEBUG12(
+   fprintf(stderr, " Damage redraw %s, %d ranges:", which_window_names[pad->which_window], damage->range_count);
+   for (i = 0; i < damage->range_count; i++)
+      fprintf(stderr, " %d-%d", damage->ranges[i].first, damage->ranges[i].last);
+   fprintf(stderr, "\n");
+)
+
+if (damage->range_count == 0)
+   {
+      first_row = 0;
+      last_row  = -1;
+   }
+else
+   {
+      first_row = damage->ranges[0].first;
+      last_row  = damage->ranges[damage->range_count-1].last;
+   }
+
+if (dspl_descr->show_lineno && (last_row >= 0) && ((pad->lines_displayed != old_lines_displayed) || (fill_row >= 0)))
+   write_lineno(dspl_descr->display,
+                dspl_descr->x_pixmap,
+                dspl_descr->lineno_subarea,
+                pad->first_line,
+                0,                        /* not overlay mode - not already cleared */
+                first_row,                /* skip lines                     */
+                pad->token,
+                pad->formfeed_in_window,
+                pad->win_lines);
+
+expose->type       = Expose;
+expose->serial     = 0;
+expose->send_event = True;
+expose->display    = dspl_descr->display;
+expose->window     = pad->x_window;
+expose->count      = 0;
+
+if (highlight_mode || damage->highlight_mode)
+   {
+      expose->x          = 0;
+      expose->y          = 0;
+      expose->width      = full_width;
+      expose->height     = full_height;
+      return(True);
+   }
+
+if (last_row < 0)
+   return(False);
+
+expose->x          = 0;
+expose->y          = (first_row * pad->window->line_height) + pad->window->sub_y;
+expose->width      = full_width;
+expose->height     = (last_row - first_row + 1) * pad->window->line_height;
+if (last_row == pad->window->lines_on_screen-1)
+   expose->height = full_height - expose->y;
+if (expose->y + expose->height > full_height)
+   expose->height = full_height - expose->y;
+
+return(expose->height > 0);
+
+} /* end of damage_redraw */
+
+
+#ifdef DebuG
+/************************************************************************
+
+NAME:      flash_damage - Flash redrawn rows for debugging
+
+PURPOSE:    This routine inverts the rows painted by a redraw for a moment
+            and then puts them back.  It is used with DEBUG31 to see exactly
+            which rows each redraw paints.
+
+PARAMETERS:
+
+   1.  pad            - pointer to PAD_DESCR (INPUT)
+                        This is the pad being redrawn.
+
+   2.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT)
+                        This is the display the pad is on.
+
+   3.  use_damage     - int (INPUT)
+                        True if the redraw came from the damage list.
+
+   4.  expose         - pointer to XExposeEvent (INPUT)
+                        This is the area copied to the window.  It is
+                        flashed when the redraw did not use the damage list.
+
+FUNCTIONS :
+
+   1.   Xor the areas, show them, wait, and xor them back.
+
+*************************************************************************/
+
+static void flash_damage(PAD_DESCR      *pad,
+                         DISPLAY_DESCR  *dspl_descr,
+                         int             use_damage,
+                         XExposeEvent   *expose)
+{
+DAMAGE_DATA          *damage = (DAMAGE_DATA *)pad->damage_data;
+int                   pass;
+int                   i;
+
+for (pass = 0; pass < 2; pass++)
+{
+   if (use_damage && damage)
+      for (i = 0; i < damage->range_count; i++)
+         XFillRectangle(dspl_descr->display, pad->x_window, pad->window->xor_gc,
+                        0, (damage->ranges[i].first * pad->window->line_height) + pad->window->sub_y,
+                        pad->window->width, (damage->ranges[i].last - damage->ranges[i].first + 1) * pad->window->line_height);
+   else
+      XFillRectangle(dspl_descr->display, pad->x_window, pad->window->xor_gc,
+                     expose->x, expose->y, expose->width, expose->height);
+
+   if (pass == 0)
+      {
+         XFlush(dspl_descr->display);
+         usleep(DAMAGE_FLASH_USECS);
+      }
+}
+
+} /* end of flash_damage */
+#endif
+
+
+/************************************************************************
+
+NAME:      damage_whole_window - Mark everything in a pad's pixmap area as needing redrawing.
+
+PURPOSE:    This routine is called when something outside the normal
+            drawing routines changes or discards the pixmap, such as
+            reallocating it.  The next redraw of the pad paints the
+            whole window.
+
+PARAMETERS:
+
+   1.  pad            - pointer to PAD_DESCR (INPUT / OUTPUT)
+                        This is the pad whose saved state is dropped.
+
+FUNCTIONS :
+
+   1.   Mark the saved drawing state unusable.
+
+*************************************************************************/
+
+void damage_whole_window(PAD_DESCR      *pad)
+{
+
+if (pad->damage_data)
+   ((DAMAGE_DATA *)pad->damage_data)->valid = False;
+
+} /* end of damage_whole_window */
+
+
+/************************************************************************
+
+NAME:      free_damage_data - Free the damage tracking data for a pad.
+
+PURPOSE:    This routine releases the damage data hung off a pad.  It is
+            called when the pad is freed.
+
+PARAMETERS:
+
+   1.  pad            - pointer to PAD_DESCR (INPUT / OUTPUT)
+                        This is the pad whose data is to be freed.
+
+FUNCTIONS :
+
+   1.   Free the range list and the damage data.
+
+*************************************************************************/
+
+void free_damage_data(PAD_DESCR      *pad)
+{
+DAMAGE_DATA          *damage = (DAMAGE_DATA *)pad->damage_data;
+
+if (!damage)
+   return;
+
+if (damage->ranges)
+   free((char *)damage->ranges);
+free((char *)damage);
+pad->damage_data = NULL;
+
+} /* end of free_damage_data */
+
+
 #ifdef  SPECIAL_DEBUG
 /***************************************************************
 *  
@@ -37,6 +37,8 @@
 *     redo_cursor             - Generate a warp to reposition the cursor after a window size change.
 *     fake_cursor_motion      - Fudge up a motion event
 *     off_screen_warp_check   - Adjust warps to areas on the physical screen.
+*     damage_whole_window     - Mark everything in a pad's pixmap area as needing redrawing.
+*     free_damage_data        - Free the damage tracking data for a pad.
 *
 ***************************************************************/
 
@@ -70,6 +72,10 @@ int off_screen_warp_check(Display            *display,
                           int                *x,
                           int                *y);
 
+void damage_whole_window(PAD_DESCR      *pad);
+
+void free_damage_data(PAD_DESCR      *pad);
+
 
 #endif
 
@@ -31,24 +31,50 @@
 *
 *  Routines:
 *     dm_reload           - Reload the file
+*     reload_watch        - Offer a reload when the file is changed by others
+*     reload_following    - Is the file being followed as it grows
+*
+*  Internal:
+*     reload_file         - Throw away the memory copy and read the file again
+*     reload_follow       - Load what was added to a followed file
+*     reload_diff         - Bring the memory copy up to date with the file by line edits
+*     reload_lines        - Split part of the mapped file into lines
+*     reload_myers        - Find the fewest line changes between two runs of lines
+*     reload_hunks        - Apply the changes found, last one first
 *
 ***************************************************************/
 
 #include <stdio.h>          /* /usr/include/stdio.h      */
 #include <string.h>         /* /usr/include/string.h     */
 #include <errno.h>          /* /usr/include/errno.h      */
+#include <stdlib.h>         /* /usr/include/stdlib.h     */
+#include <limits.h>         /* /usr/include/limits.h     */
+#ifndef WIN32
+#include <sys/types.h>      /* /usr/include/sys/types.h  */
+#include <sys/stat.h>       /* /usr/include/sys/stat.h   */
+#include <sys/mman.h>       /* /usr/include/sys/mman.h   */
+#include <fcntl.h>          /* /usr/include/fcntl.h      */
+#include <unistd.h>         /* /usr/include/unistd.h     */
+#endif
 
-
+#include "debug.h"
 #include "dmwin.h"
 #include "display.h"
+#include "emalloc.h"
 #include "getevent.h"
 #include "ind.h"
+#include "journal.h"
+#include "autoimage.h"
 #include "kd.h"
+#include "loadcache.h"
 #include "lock.h"
+#include "mvcursor.h"
 #include "prompt.h"
 #include "parms.h"
 #include "pw.h"
+#include "redraw.h"
 #include "reload.h"
+#include "undo.h"
 #include "windowdefs.h"
 
 #ifndef WIN32
@@ -60,6 +86,81 @@
 #define MAXPATHLEN	1024
 #endif
 
+/***************************************************************
+*  
+*  change_seen is set when the watch sees the file change and
+*  cleared when the reload prompt goes up.  While that prompt waits
+*  for an answer it is on the prompt stack, so prompt_in_progress
+*  keeps a second one from going up.
+*  
+***************************************************************/
+
+static int       change_seen = False;
+
+/***************************************************************
+*  
+*  A line for reload_diff.  Old lines point into memdata, new
+*  lines into the mapped file and are not null terminated.
+*  The hash makes most compares in reload_myers one test.
+*  
+*  A hunk replaces old_count lines of the memory copy, starting
+*  at old_start, with new_count lines of the file starting at
+*  new_start.
+*  
+***************************************************************/
+
+typedef struct {
+   char          *text;      /* start of the line                   */
+   int            len;       /* length without the newline          */
+   unsigned int   hash;      /* hash of the text                    */
+} RELOAD_LINE;
+
+typedef struct {
+   int            old_start;
+   int            old_count;
+   int            new_start;
+   int            new_count;
+} RELOAD_HUNK;
+
+/***************************************************************
+*  
+*  RELOAD_MAX_D is the most line changes the diff looks for.
+*  Past that, the changed part is replaced as one hunk.
+*  
+***************************************************************/
+
+#define RELOAD_MAX_D    2000
+
+#define RELOAD_SAME(a, b) (((a)->hash == (b)->hash) && ((a)->len == (b)->len) && (memcmp((a)->text, (b)->text, (a)->len) == 0))
+
+static int  reload_file(DISPLAY_DESCR   *dspl_descr,
+                        char            *edit_file);
+
+static int  reload_follow(DISPLAY_DESCR   *dspl_descr);
+
+#ifndef WIN32
+static int  reload_diff(DISPLAY_DESCR   *dspl_descr,
+                        char            *edit_file);
+
+static int  reload_lines(char            *data,
+                         size_t           start,
+                         size_t           end,
+                         RELOAD_LINE     *lines,
+                         int              max_lines);
+
+static int  reload_myers(RELOAD_LINE     *a,
+                         int              n,
+                         RELOAD_LINE     *b,
+                         int              m,
+                         RELOAD_HUNK     *hunks);
+
+static void reload_hunks(DATA_TOKEN      *token,
+                         int              first,
+                         RELOAD_LINE     *b,
+                         RELOAD_HUNK     *hunks,
+                         int              hunk_count);
+#endif
+
 /************************************************************************
 
 NAME:      dm_reload
@@ -68,10 +169,14 @@ PURPOSE:    This routine causes the file being edited/browsed to be
             reloaded from disk.  It is only valid in non-pad mode.
             It does not make sense in cetemm.  It can take a an optional
             parameter which may be 'y', 'f', or 'n'.
-            'n' is a no-op from "reload -n".  'y' or 'f' are the same.
-            and cause the reload to occur.  No parameter causes the
+            'n' is a no-op from "reload -n".  'y' or 'f' cause the
+            reload to occur.  No parameter causes the
             dirty (file modified) bit to be checked.  If the file is
             changed, a prompt is issues for yes or no (-y or -n).
+            With 'y' or no parameter, a fully loaded file is brought up
+            to date by changing just the lines which differ, as normal
+            edits, so undo, marks, and the cursor are kept.  'f' forces
+            the file to be read again from the start.
 
 PARAMETERS:
 
@@ -97,8 +202,10 @@ FUNCTIONS :
         A yes reply will cause a reload -y to be generated, which we interpret here as a
         confirmed reload.
 
-   3.   If -y or -f was specified, delete the memory copy of the file, open it and
-        reload it.
+   3.   If -y was specified, try to apply just the changed lines.
+
+   4.   If that cannot be done, or -f was specified, delete the memory copy
+        of the file, open it and reload it.
 
 OUTPUTS:
    redraw -  The mask anded with the type of redraw needed is returned.
@@ -110,13 +217,14 @@ int  dm_reload(DMC             *dmc,                    /* input  */
                char            *edit_file)              /* input  */
 {
 int              really_reload = False;
+int              full_reload = False;
 DMC             *prompt;
 char             work[MAXPATHLEN+100];
 int              rc;
 int              redraw_needed = 0;
-int              open_for_write;
 
 
+pw_wait(); /* in pw.c, let a background pw finish before the file is reread */
 
 /***************************************************************
 *  
@@ -127,8 +235,10 @@ int              open_for_write;
 
 switch (dmc->reload.type)
 {
-case 'y':
 case 'f':
+   full_reload = True;
+   /* FALLTHRU */
+case 'y':
    really_reload = True;
    break;
 
@@ -185,40 +295,11 @@ if (really_reload)
          else
             {
                dspl_descr->reload_off = False;
-               if (instream)
-                  {
-                     if (LSF)
-                        lsf_close(instream, dspl_descr->ind_data);
-                     else
-                        fclose(instream);
-                  }
-
-               if (LSF)
-                  instream = filter_in(&(dspl_descr->ind_data), dspl_descr->hsearch_data, edit_file, "r");
-               else
-                  instream = fopen(edit_file, "r");
-
-               if (instream == NULL)
-                  {
-                     snprintf(work, sizeof(work), "(reload) Can't reopen %s (%s)", edit_file, strerror(errno));
-                     dm_error(work, DM_ERROR_BEEP);
-                     return(FULL_REDRAW);  /* could not reopen, this is not good */
-                  }
-
-               open_for_write = WRITABLE(dspl_descr->main_pad->token); /* save writeable state */
-
-               mem_kill(dspl_descr->main_pad->token);
-               dspl_descr->main_pad->token = NULL;
-
-               dspl_descr->main_pad->token     = mem_init(75, False);  /* r/w fill blocks 75 %full  in memdata.c */
-
-               WRITABLE(dspl_descr->main_pad->token) = open_for_write;
-
-               change_background_work(dspl_descr, MAIN_WINDOW_EOF, False);
-               change_background_work(dspl_descr, BACKGROUND_READ_AHEAD, READAHEAD);
-               load_enough_data(dspl_descr->main_pad->first_line + dspl_descr->main_pad->lines_displayed); /* in getevent.c */
-               redraw_needed = (MAIN_PAD_MASK & FULL_REDRAW);
-               file_has_changed(edit_file);  /* in lock.c */
+#ifndef WIN32
+               if (!full_reload && ((rc = reload_diff(dspl_descr, edit_file)) >= 0))
+                  return(rc);
+#endif
+               redraw_needed = reload_file(dspl_descr, edit_file);
             }
    }
 
@@ -227,3 +308,810 @@ return(redraw_needed);
 }  /* end of dm_reload */
 
 
+/************************************************************************
+
+NAME:      reload_file - Throw away the memory copy and read the file again
+
+PURPOSE:    This routine is the full reload.  The file is opened again,
+            the old memdata thrown away, and enough of the file read to
+            fill the window.  The rest is read in the background.
+
+PARAMETERS:
+
+   1.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT / OUTPUT)
+                        This is the description for the display.
+
+   2.  edit_file      - pointer to char (INPUT)
+                        This is the file being edited and thus reloaded.
+
+RETURNED VALUE:
+   redraw -  The mask anded with the type of redraw needed is returned.
+
+*************************************************************************/
+
+static int  reload_file(DISPLAY_DESCR   *dspl_descr,
+                        char            *edit_file)
+{
+char             work[MAXPATHLEN+100];
+int              open_for_write;
+
+if (instream)
+   {
+      if (LSF)
+         lsf_close(instream, dspl_descr->ind_data);
+      else
+         fclose(instream);
+   }
+
+if (LSF)
+   instream = filter_in(&(dspl_descr->ind_data), dspl_descr->hsearch_data, edit_file, "r");
+else
+   instream = fopen(edit_file, "r");
+
+if (instream == NULL)
+   {
+      snprintf(work, sizeof(work), "(reload) Can't reopen %s (%s)", edit_file, strerror(errno));
+      dm_error(work, DM_ERROR_BEEP);
+      return(FULL_REDRAW);  /* could not reopen, this is not good */
+   }
+
+open_for_write = WRITABLE(dspl_descr->main_pad->token); /* save writeable state */
+
+mem_kill(dspl_descr->main_pad->token);
+dspl_descr->main_pad->token = NULL;
+
+dspl_descr->main_pad->token     = mem_init(75, False);  /* r/w fill blocks 75 %full  in memdata.c */
+
+WRITABLE(dspl_descr->main_pad->token) = open_for_write;
+if (LOADCACHE && !LSF && !MANFORMAT)
+   loadcache_open(dspl_descr->main_pad->token, edit_file, instream, LOADCACHE); /* in loadcache.c */
+journal_reset(dspl_descr->main_pad->token, edit_file); /* in journal.c, the file is now the base */
+autoimage_reset(dspl_descr->main_pad->token, edit_file); /* in autoimage.c */
+
+change_background_work(dspl_descr, MAIN_WINDOW_EOF, False);
+change_background_work(dspl_descr, BACKGROUND_READ_AHEAD, READAHEAD);
+load_enough_data(dspl_descr->main_pad->first_line + dspl_descr->main_pad->lines_displayed); /* in getevent.c */
+file_has_changed(edit_file);  /* in lock.c */
+
+return(MAIN_PAD_MASK & FULL_REDRAW);
+
+}  /* end of reload_file */
+
+
+/************************************************************************
+
+NAME:      reload_watch - Offer a reload when the file is changed by others
+
+PURPOSE:    This routine is called from get_next_X_event each time around
+            the event loop.  It keeps the watch in lock.c on the file being
+            edited, and when the watch reports a change, it puts up the
+            reload prompt.  It replaces the stat done on each FocusIn.
+
+PARAMETERS:
+
+   1.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT)
+                        This is the description for the display the prompt
+                        goes in.
+
+FUNCTIONS :
+
+   1.   In pad mode, after reload -n, or for stdin, stop watching.
+
+   2.   See if the watch saw a change.  A change made by our own
+        background pw does not count.
+
+   3.   If the file is being followed, load what was added to it.
+
+   4.   Otherwise, if a change was seen and no other prompt is being
+        answered, ask if the file should be reloaded.  Only one prompt is
+        put up until it is answered.
+
+*************************************************************************/
+
+void reload_watch(DISPLAY_DESCR   *dspl_descr)              /* input  */
+{
+DMC             *prompt;
+char             work[80];
+int              redraw_needed;
+
+if (dspl_descr->pad_mode || dspl_descr->reload_off || (strcmp(edit_file, STDIN_FILE_STRING) == 0))
+   {
+      watch_file(NULL); /* in lock.c */
+      change_seen = False;
+      return;
+   }
+
+watch_file(edit_file); /* in lock.c, only does something when the name changes */
+
+if (watch_changed() && (pw_progress(dspl_descr) < 0)) /* in lock.c and pw.c */
+   change_seen = True;
+
+if (change_seen && reload_following(dspl_descr))
+   {
+      change_seen = False;
+      redraw_needed = reload_follow(dspl_descr);
+      if (redraw_needed)
+         process_redraw(dspl_descr, redraw_needed, False);
+      return;
+   }
+
+if (!change_seen || prompt_in_progress(dspl_descr))
+   return;
+
+change_seen = False;
+strcpy(work, "reload -&'File externally changed, reload? ' ");
+prompt = prompt_prescan(work, True, dspl_descr->escape_char);  /* in kd.c */
+if (prompt != NULL)
+   {
+      ce_XBell(dspl_descr, 0);
+
+      redraw_needed = dm_prompt(prompt, dspl_descr);
+      if (redraw_needed)
+         process_redraw(dspl_descr, redraw_needed, False);
+   }
+
+}  /* end of reload_watch */
+
+
+/************************************************************************
+
+NAME:      reload_following - Is the file being followed as it grows
+
+PURPOSE:    With -follow yes, a file browsed read only is followed like
+            tail -f.  When the watch sees the file change, what was added
+            is loaded instead of prompting for a reload.  load_enough_data
+            calls this to keep the file open at eof, so the offset of the
+            last line loaded is where the stream is.
+
+PARAMETERS:
+
+   1.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT)
+                        This is the description for the display.
+
+RETURNED VALUE:
+   following -  True if the file is followed.
+
+*************************************************************************/
+
+int  reload_following(DISPLAY_DESCR   *dspl_descr)              /* input  */
+{
+
+return(FOLLOW && !dspl_descr->pad_mode && !dspl_descr->reload_off && !WRITABLE(dspl_descr->main_pad->token) &&
+       !LSF && !MANFORMAT && (strcmp(edit_file, STDIN_FILE_STRING) != 0));
+
+}  /* end of reload_following */
+
+
+/************************************************************************
+
+NAME:      reload_follow - Load what was added to a followed file
+
+PURPOSE:    This routine brings a followed file up to date when the
+            watch sees it change.  Only the bytes past the last line
+            loaded are read, through the normal block loader.  If the
+            window showed the end of the file, it is moved to show the
+            new end.
+
+PARAMETERS:
+
+   1.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT / OUTPUT)
+                        This is the description for the display.
+
+FUNCTIONS :
+
+   1.   If the file is still being read in, the reading will get to
+        the new lines, so there is nothing to do.
+
+   2.   If the file was replaced (a new inode, as when a log is rotated)
+        or got shorter than what was loaded, reload it from the start.
+
+   3.   If the last line loaded had no newline, more may have been added
+        to it.  Take it back out and back the stream up to its start.
+
+   4.   Read from there to the end of file.
+
+   5.   If the bottom of the file was on the screen, put the new bottom
+        on the screen.
+
+RETURNED VALUE:
+   redraw -  The mask anded with the type of redraw needed is returned.
+
+*************************************************************************/
+
+static int  reload_follow(DISPLAY_DESCR   *dspl_descr)
+{
+PAD_DESCR       *main_pad = dspl_descr->main_pad;
+struct stat      file_stats;
+struct stat      stream_stats;
+long             offset;
+int              pinned;
+int              redraw_needed;
+char            *line;
+char             last;
+
+if (!get_background_work(MAIN_WINDOW_EOF)) /* in getevent.c */
+   return(0);
+
+if (stat(edit_file, &file_stats) != 0)
+   return(0);  /* moved away, wait for the new one */
+
+pinned = (main_pad->first_line + main_pad->window->lines_on_screen >= total_lines(main_pad->token));
+
+if ((instream == NULL) || (fstat(fileno(instream), &stream_stats) != 0) ||
+    (stream_stats.st_ino != file_stats.st_ino) || (stream_stats.st_dev != file_stats.st_dev) ||
+    ((offset = ftell(instream)) < 0) || (file_stats.st_size < offset))
+   {
+      DEBUG1(fprintf(stderr, "reload_follow: %s replaced or truncated, reloading\n", edit_file);)
+      dm_error("(reload) File replaced, reloading", DM_ERROR_MSG);
+      main_pad->first_line = 0;
+      main_pad->file_line_no = 0;
+      redraw_needed = reload_file(dspl_descr, edit_file);
+      if (pinned)
+         load_enough_data(INT_MAX); /* in getevent.c */
+   }
+else
+   {
+      if (file_stats.st_size == offset)
+         return(0);
+
+      DEBUG1(fprintf(stderr, "reload_follow: loading %ld new bytes at %ld\n", (long)(file_stats.st_size - offset), offset);)
+
+      /* a last line with no newline is taken out and read again with what was added */
+      if ((offset > 0) && (total_lines(main_pad->token) > 0) &&
+          (pread(fileno(instream), &last, 1, offset - 1) == 1) && (last != '\n'))
+         {
+            line = get_line_by_num(main_pad->token, total_lines(main_pad->token) - 1);
+            offset -= strlen(line);
+            undo_semafor = ON;  /* loading is not an undoable change */
+            delete_line_by_num(main_pad->token, total_lines(main_pad->token) - 1, 1);
+            undo_semafor = OFF;
+         }
+
+      clearerr(instream);
+      fseek(instream, offset, SEEK_SET);
+      change_background_work(dspl_descr, MAIN_WINDOW_EOF, False);
+      load_enough_data(INT_MAX); /* in getevent.c, reads to the new eof */
+      redraw_needed = (MAIN_PAD_MASK & FULL_REDRAW);
+   }
+
+if (pinned)
+   {
+      pad_to_bottom(main_pad); /* in mvcursor.c */
+      if (main_pad->file_line_no < main_pad->first_line)
+         main_pad->file_line_no = total_lines(main_pad->token) - 1;
+   }
+
+if (main_pad->file_line_no >= total_lines(main_pad->token))
+   main_pad->file_line_no = (total_lines(main_pad->token) > 0) ? total_lines(main_pad->token) - 1 : 0;
+main_pad->buff_ptr = get_line_by_num(main_pad->token, main_pad->file_line_no);
+dspl_descr->cursor_buff->up_to_snuff = 0;
+
+return(redraw_needed);
+
+}  /* end of reload_follow */
+
+
+#ifndef WIN32
+/************************************************************************
+
+NAME:      reload_diff - Bring the memory copy up to date with the file by line edits
+
+PURPOSE:    This routine reloads a file that is all in memory by changing
+            only the lines which differ from the file on disk.  The changes
+            are normal memdata edits, so they can be undone, and marks, the
+            cursor and the rest of the memory copy are left alone.  A big
+            log with a few lines changed is not read in again.
+
+PARAMETERS:
+
+   1.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT / OUTPUT)
+                        This is the description for the display.
+
+   2.  edit_file      - pointer to char (INPUT)
+                        This is the file being edited and thus reloaded.
+
+FUNCTIONS :
+
+   1.   Only a plain file which has been read all the way in can be done
+        this way.
+
+   2.   If the size and time of the file are as last seen and nothing has
+        been changed in memory, there is nothing to do.
+
+   3.   Map the file and skip the lines at the top which match the memory
+        copy, then the lines at the bottom.
+
+   4.   Diff the lines left and apply the changes, last one first.  If
+        most of the file changed, give up and let the caller read it in.
+
+   5.   The memory copy now matches the file, so mark it saved and start
+        the journal and autosave image over as dm_reload would.
+
+RETURNED VALUE:
+   redraw -  The mask anded with the type of redraw needed is returned.
+             -1 is returned if the file must be read in again.
+
+*************************************************************************/
+
+static int  reload_diff(DISPLAY_DESCR   *dspl_descr,
+                        char            *edit_file)
+{
+DATA_TOKEN      *token = dspl_descr->main_pad->token;
+int              fd;
+struct stat      file_stats;
+char            *data = NULL;
+size_t           size;
+size_t           pos;
+size_t           end;
+size_t           start;
+char            *nl;
+char            *line;
+int              first;
+int              last;
+int              total;
+int              n;
+int              m;
+int              i;
+int              hunk_count;
+int              changed;
+RELOAD_LINE     *lines;
+RELOAD_HUNK     *hunks;
+char             msg[256];
+
+/***************************************************************
+*  Filters, man pages, and files still loading are read in again.
+***************************************************************/
+if (LSF || MANFORMAT || !get_background_work(MAIN_WINDOW_EOF)) /* in getevent.c */
+   return(-1);
+#ifdef Encrypt
+if (ENCRYPT)
+   return(-1);
+#endif
+
+if ((fd = open(edit_file, O_RDONLY)) < 0)
+   return(-1); /* dm_reload gives the message */
+
+if ((fstat(fd, &file_stats) < 0) || !S_ISREG(file_stats.st_mode) || ((off_t)(size_t)file_stats.st_size != file_stats.st_size))
+   {
+      close(fd);
+      return(-1);
+   }
+
+/***************************************************************
+*  Same size and time as when read or written, and no edits.
+***************************************************************/
+if (!dirty_bit(token) && !detect_changed_file(&file_stats)) /* in lock.c */
+   {
+      close(fd);
+      dm_error("(reload) File unchanged", DM_ERROR_MSG);
+      return(0);
+   }
+
+size = file_stats.st_size;
+if ((size > 0) && ((data = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0)) == (char *)MAP_FAILED))
+   {
+      DEBUG1(fprintf(stderr, "reload_diff: mmap of %s failed (%s)\n", edit_file, strerror(errno));)
+      close(fd);
+      return(-1);
+   }
+
+/***************************************************************
+*  Skip the matching lines at the top, then at the bottom.
+*  Lines are split as read_a_block splits them.  What is left
+*  is old lines first to last and file bytes pos to end.
+***************************************************************/
+total = total_lines(token);
+first = 0;
+pos   = 0;
+position_file_pointer(token, 0);
+while ((first < total) && (pos < size))
+{
+   nl   = memchr(data + pos, '\n', size - pos);
+   end  = nl ? (size_t)(nl - data) : size;
+   line = get_line_by_num(token, first);
+   if ((strlen(line) != (end - pos)) || (memcmp(line, data + pos, end - pos) != 0))
+      break;
+   first++;
+   pos = nl ? end + 1 : size;
+}
+
+last = total;
+end  = size;
+if (first < total)
+   position_file_pointer(token, total - 1);
+while ((last > first) && (end > pos))
+{
+   nl = ((end == size) && (data[size-1] != '\n')) ? data + size : data + end - 1; /* end of the line text */
+   for (start = nl - data; (start > pos) && (data[start-1] != '\n'); start--)
+      ;
+   line = get_line_by_num(token, last - 1);
+   if ((strlen(line) != (size_t)((nl - data) - start)) || (memcmp(line, data + start, (nl - data) - start) != 0))
+      break;
+   last--;
+   end = start;
+}
+
+/***************************************************************
+*  Split what is left.  Lines too long for memdata, nulls, or a
+*  change to most of the file get a full reload.
+***************************************************************/
+n = last - first;
+m = reload_lines(data, pos, end, NULL, 0);
+DEBUG1(fprintf(stderr, "reload_diff: %d lines, top %d match, %d old and %d new lines differ\n", total, first, n, m);)
+if ((m < 0) || (n > (total / 2) + RELOAD_MAX_D) || (m > (total / 2) + RELOAD_MAX_D))
+   {
+      if (data)
+         munmap(data, size);
+      close(fd);
+      return(-1);
+   }
+
+lines = (RELOAD_LINE *)CE_MALLOC((n + m + 1) * sizeof(RELOAD_LINE));
+hunks = (RELOAD_HUNK *)CE_MALLOC((RELOAD_MAX_D + 1) * sizeof(RELOAD_HUNK));
+if (!lines || !hunks)
+   {
+      if (lines)
+         free((char *)lines);
+      if (hunks)
+         free((char *)hunks);
+      if (data)
+         munmap(data, size);
+      close(fd);
+      return(-1);
+   }
+
+reload_lines(data, pos, end, lines + n, m);
+if (n > 0)
+   position_file_pointer(token, first);
+for (i = 0; i < n; i++)
+{
+   lines[i].text = get_line_by_num(token, first + i);
+   lines[i].len  = strlen(lines[i].text);
+   lines[i].hash = 2166136261U;
+   for (line = lines[i].text; *line; line++)
+      lines[i].hash = (lines[i].hash ^ (unsigned char)*line) * 16777619U;
+}
+
+hunk_count = reload_myers(lines, n, lines + n, m, hunks);
+if (hunk_count < 0)
+   {
+      /* too many changes to sort out, replace them all */
+      hunks[0].old_start = 0;
+      hunks[0].old_count = n;
+      hunks[0].new_start = 0;
+      hunks[0].new_count = m;
+      hunk_count = ((n > 0) || (m > 0)) ? 1 : 0;
+   }
+
+changed = 0;
+for (i = 0; i < hunk_count; i++)
+   changed += (hunks[i].old_count > hunks[i].new_count) ? hunks[i].old_count : hunks[i].new_count;
+
+reload_hunks(token, first, lines + n, hunks, hunk_count);
+
+free((char *)lines);
+free((char *)hunks);
+if (data)
+   munmap(data, size);
+close(fd);
+
+/***************************************************************
+*  The memory copy is the file now.  Read the file from instream
+*  so autoimage can use offsets in it again.
+***************************************************************/
+event_do(token, PW_EVENT, -1, 0, 0, NULL);
+dirty_bit(token) = 0;
+
+if (instream)
+   fclose(instream);
+instream = fopen(edit_file, "r");
+
+journal_reset(token, edit_file); /* in journal.c, the file is now the base */
+autoimage_reset(token, edit_file); /* in autoimage.c */
+file_has_changed(edit_file);  /* in lock.c */
+
+/* closing the mapped file released the lock, get it back as load_enough_data does */
+if (LOCKF && WRITABLE(token))
+   {
+      unlock_file();
+      if (lock_file(edit_file) == False)
+         WRITABLE(token) = False;
+   }
+
+if (dspl_descr->main_pad->file_line_no >= total_lines(token))
+   dspl_descr->main_pad->file_line_no = (total_lines(token) > 0) ? total_lines(token) - 1 : 0;
+if (dspl_descr->main_pad->first_line > dspl_descr->main_pad->file_line_no)
+   dspl_descr->main_pad->first_line = dspl_descr->main_pad->file_line_no;
+
+snprintf(msg, sizeof(msg), "(reload) %d of %d lines changed", changed, total_lines(token));
+dm_error(msg, DM_ERROR_MSG);
+
+return(MAIN_PAD_MASK & FULL_REDRAW);
+
+}  /* end of reload_diff */
+
+
+/************************************************************************
+
+NAME:      reload_lines - Split part of the mapped file into lines
+
+PURPOSE:    This routine counts the lines between two offsets in the
+            mapped file and, if passed an array, fills it in.
+
+PARAMETERS:
+
+   1.  data           - pointer to char (INPUT)
+                        The mapped file.
+
+   2.  start          - size_t (INPUT)
+                        Offset of the first line.
+
+   3.  end            - size_t (INPUT)
+                        Offset just past the last line.  A last line with no
+                        newline ends here.
+
+   4.  lines          - pointer to RELOAD_LINE (OUTPUT)
+                        Where the lines go, or NULL to just count them.
+
+   5.  max_lines      - int (INPUT)
+                        Size of lines.
+
+RETURNED VALUE:
+   count  -  The number of lines, or -1 if a line is too long for memdata
+             or has a null in it.
+
+*************************************************************************/
+
+static int  reload_lines(char            *data,
+                         size_t           start,
+                         size_t           end,
+                         RELOAD_LINE     *lines,
+                         int              max_lines)
+{
+int              count = 0;
+char            *p;
+char            *nl;
+char            *last = data + end;
+unsigned int     hash;
+
+for (p = data + start; p < last; p = nl + 1)
+{
+   nl = memchr(p, '\n', last - p);
+   if (!nl)
+      nl = last;
+   if (((nl - p) > MAX_LINE) || memchr(p, '\0', nl - p))
+      return(-1);
+   if (lines && (count < max_lines))
+      {
+         lines[count].text = p;
+         lines[count].len  = nl - p;
+         for (hash = 2166136261U; p < nl; p++)
+            hash = (hash ^ (unsigned char)*p) * 16777619U;
+         lines[count].hash = hash;
+      }
+   count++;
+}
+
+return(count);
+
+}  /* end of reload_lines */
+
+
+/************************************************************************
+
+NAME:      reload_myers - Find the fewest line changes between two runs of lines
+
+PURPOSE:    This routine is the Myers O(ND) diff.  For each number of changes
+            d, the furthest point reached on each diagonal is kept, and the
+            saved points are walked back from the end to find the hunks.
+
+PARAMETERS:
+
+   1.  a              - pointer to RELOAD_LINE (INPUT)
+                        The lines in memory.
+
+   2.  n              - int (INPUT)
+                        The number of lines in a.
+
+   3.  b              - pointer to RELOAD_LINE (INPUT)
+                        The lines in the file.
+
+   4.  m              - int (INPUT)
+                        The number of lines in b.
+
+   5.  hunks          - pointer to RELOAD_HUNK (OUTPUT)
+                        The changes, last one first.  There is room for
+                        RELOAD_MAX_D + 1.
+
+RETURNED VALUE:
+   count  -  The number of hunks, or -1 if there are more than RELOAD_MAX_D
+             changes or no memory.
+
+*************************************************************************/
+
+static int  reload_myers(RELOAD_LINE     *a,
+                         int              n,
+                         RELOAD_LINE     *b,
+                         int              m,
+                         RELOAD_HUNK     *hunks)
+{
+int            **trace;
+int             *v;
+int              d;
+int              k;
+int              x;
+int              y;
+int              prev_k;
+int              prev_x;
+int              prev_y;
+int              found = -1;
+int              count = 0;
+
+#define V(k) v[(k) + RELOAD_MAX_D + 1]
+
+trace = (int **)CE_MALLOC((RELOAD_MAX_D + 1) * sizeof(int *));
+v     = (int *)CE_MALLOC((2 * RELOAD_MAX_D + 3) * sizeof(int));
+if (!trace || !v)
+   {
+      if (trace)
+         free((char *)trace);
+      if (v)
+         free((char *)v);
+      return(-1);
+   }
+memset((char *)trace, 0, (RELOAD_MAX_D + 1) * sizeof(int *));
+memset((char *)v, 0, (2 * RELOAD_MAX_D + 3) * sizeof(int));
+
+/***************************************************************
+*  trace[d] is V as it was before pass d, for diagonals -d-1
+*  through d+1.
+***************************************************************/
+for (d = 0; (d <= RELOAD_MAX_D) && (found < 0); d++)
+{
+   if ((trace[d] = (int *)CE_MALLOC((2 * d + 3) * sizeof(int))) == NULL)
+      break;
+   memcpy((char *)trace[d], (char *)&V(-d - 1), (2 * d + 3) * sizeof(int));
+
+   for (k = -d; k <= d; k += 2)
+   {
+      if ((k == -d) || ((k != d) && (V(k - 1) < V(k + 1))))
+         x = V(k + 1);      /* down, a line of b inserted */
+      else
+         x = V(k - 1) + 1;  /* right, a line of a deleted */
+      y = x - k;
+      while ((x < n) && (y < m) && RELOAD_SAME(&a[x], &b[y]))
+      {
+         x++;
+         y++;
+      }
+      V(k) = x;
+      if ((x >= n) && (y >= m))
+         {
+            found = d;
+            break;
+         }
+   }
+}
+
+/***************************************************************
+*  Walk back from the end.  Each step off a diagonal is one line
+*  deleted or inserted, and joins the hunk above it if they touch.
+***************************************************************/
+if (found >= 0)
+   {
+      x = n;
+      y = m;
+      for (d = found; d > 0; d--)
+      {
+         k = x - y;
+         if ((k == -d) || ((k != d) && (trace[d][k - 1 + d + 1] < trace[d][k + 1 + d + 1])))
+            prev_k = k + 1;
+         else
+            prev_k = k - 1;
+         prev_x = trace[d][prev_k + d + 1];
+         prev_y = prev_x - prev_k;
+         while ((x > prev_x) && (y > prev_y))
+         {
+            x--;
+            y--;
+         }
+
+         if ((count == 0) || (hunks[count-1].old_start != x) || (hunks[count-1].new_start != y))
+            {
+               hunks[count].old_start = x;
+               hunks[count].old_count = 0;
+               hunks[count].new_start = y;
+               hunks[count].new_count = 0;
+               count++;
+            }
+         if (x == prev_x)
+            {
+               hunks[count-1].new_start--;
+               hunks[count-1].new_count++;
+            }
+         else
+            {
+               hunks[count-1].old_start--;
+               hunks[count-1].old_count++;
+            }
+         x = prev_x;
+         y = prev_y;
+      }
+   }
+else
+   count = -1;
+
+#undef V
+
+for (d = 0; d <= RELOAD_MAX_D; d++)
+   if (trace[d])
+      free((char *)trace[d]);
+free((char *)trace);
+free((char *)v);
+
+return(count);
+
+}  /* end of reload_myers */
+
+
+/************************************************************************
+
+NAME:      reload_hunks - Apply the changes found, last one first
+
+PURPOSE:    This routine makes the changes in memdata.  Working from the
+            bottom up keeps the line numbers of the hunks above right.
+            Lines in both are overwritten, then the extra old lines
+            deleted or the extra new lines inserted.
+
+PARAMETERS:
+
+   1.  token          - pointer to DATA_TOKEN (INPUT / OUTPUT)
+                        The main pad memdata.
+
+   2.  first          - int (INPUT)
+                        The line number of the first old line in the hunks.
+
+   3.  b              - pointer to RELOAD_LINE (INPUT)
+                        The lines in the file.
+
+   4.  hunks          - pointer to RELOAD_HUNK (INPUT)
+                        The changes, last one first.
+
+   5.  hunk_count     - int (INPUT)
+                        The number of hunks.
+
+*************************************************************************/
+
+static void reload_hunks(DATA_TOKEN      *token,
+                         int              first,
+                         RELOAD_LINE     *b,
+                         RELOAD_HUNK     *hunks,
+                         int              hunk_count)
+{
+int              i;
+int              j;
+int              line_no;
+int              common;
+char             buff[MAX_LINE+2];
+
+for (i = 0; i < hunk_count; i++)
+{
+   line_no = first + hunks[i].old_start;
+   common  = (hunks[i].old_count < hunks[i].new_count) ? hunks[i].old_count : hunks[i].new_count;
+
+   for (j = 0; j < hunks[i].new_count; j++)
+   {
+      memcpy(buff, b[hunks[i].new_start + j].text, b[hunks[i].new_start + j].len);
+      buff[b[hunks[i].new_start + j].len] = '\0';
+      if (j < common)
+         put_line_by_num(token, line_no + j, buff, OVERWRITE);
+      else
+         put_line_by_num(token, line_no + j - 1, buff, INSERT);
+   }
+
+   for (j = common; j < hunks[i].old_count; j++)
+      delete_line_by_num(token, line_no + common, 1);
+}
+
+}  /* end of reload_hunks */
+#endif
@@ -1,5 +1,5 @@
-#ifndef _WC__INCLUDED
-#define _WC__INCLUDED
+#ifndef _RELOAD__INCLUDED
+#define _RELOAD__INCLUDED
 
 /* "%Z% %M% %I% - %G% %U% " */
 
@@ -34,6 +34,8 @@
 *
 *  Routines in reload.c
 *     dm_reload              - Reload the file
+*     reload_watch           - Offer a reload when the file is changed by others
+*     reload_following       - Is the file being followed as it grows
 *
 ***************************************************************/
 
@@ -43,6 +45,10 @@
 int  dm_reload(DMC             *dmc,                    /* input  */
                DISPLAY_DESCR   *dspl_descr,             /* input  / output */
                char            *edit_file);             /* input  */
+
+void reload_watch(DISPLAY_DESCR   *dspl_descr);             /* input  */
+
+int  reload_following(DISPLAY_DESCR   *dspl_descr);             /* input  */
                                             
 
 #endif
@@ -48,6 +48,7 @@
 #include "cd.h"
 #endif
 #include "debug.h"
+#include "hlmatch.h"
 #include "memdata.h"
 #include "scroll.h"
 #include "xerrorpos.h"
@@ -259,6 +260,11 @@ XCopyArea(scroll_pad->display_data->display, scroll_pad->display_data->x_pixmap,
           scroll_pad->window->width, scroll_pad->window->sub_height,
           0, scroll_pad->window->sub_y);
 
+if (scroll_pad->which_window == MAIN_PAD)
+   hlmatch_overlay(scroll_pad->display_data,
+                   0, scroll_pad->window->sub_y,
+                   scroll_pad->window->width, scroll_pad->window->sub_height);
+
 XFlush(scroll_pad->display_data->display);
 
 } /* end of scroll_redraw  */
@@ -37,6 +37,15 @@
 *  Routines:
 *     search       -   Find a string in the file either forward or backward.
 *     process_inserted_count_change - after a subs, if count_change were added, update memdata
+*     line_matcher   -  Get a private matcher for testing lines in another thread
+*     line_may_match -  Test whether a line may hold a match
+*     free_line_matcher - Free a matcher from line_matcher
+*     free_search_data  - Free the static pattern data of a search
+*     pattern_generation - Get a number which changes when a new pattern is compiled
+*     line_match_cols   - Find the columns of every match on a line
+*     subs_line_ok      - Check if a substitute can be done one line at a time
+*     subs_line         - Do a substitute on one whole line
+*     required_text     - Get the text every match must contain
 *
 *  Internal:
 *     lower_case     -  lower case a string
@@ -54,6 +63,24 @@
 *     nbstep          -  try a bracketed newline in two steps()
 *     newline_bracket -  is there a newline in a bracket
 *     eget            -  get a character out of an expression (strchr like)
+*     literal_setup   -  pull the literal prefix out of a compiled expression
+*     literal_scan    -  Horspool search of a line for the literal prefix
+*     literal_at      -  compare the literal prefix at the start of a line
+*     nl_tail_setup   -  pull the text before the first @n out of a compiled expression
+*     nl_tail_at      -  check that a line ends with the text before the first @n
+*     fold_chr        -  memchr for a letter in either case, a word at a time
+*     fold_expression -  fold case into a compiled expression
+*     fold_set        -  add the other case of each letter to a [] set
+*     fold_cmp        -  compare strings ignoring case, for \1 in a folded expression
+*     dfa_setup       -  build the lazy DFA for a newly compiled expression
+*     dfa_build       -  turn a compiled expression into DFA positions
+*     dfa_close       -  add a position and the optional ones after it to a state
+*     dfa_state       -  find or add a DFA state
+*     dfa_next        -  build a DFA transition
+*     dfa_run         -  run the DFA over a line
+*     dfa_reverse     -  make the DFA which runs back from the end of a line
+*     dfa_first       -  run the reversed DFA to find where the first match starts
+*     dfa_step        -  step() which lets the DFA reject lines first
 *
 *  External(Too Me):
 *     compile        -  compile a Regular expression (provided by OS)
@@ -135,6 +162,47 @@ extern char *loc1, *loc2, *locs; /* return of column found */
 
 #define	NBRA	9
 
+/*
+ *  The lazy DFA run in front of step().  Each position is one
+ *  character, '.' or [] of the compiled expression.  States are
+ *  sets of positions built the first time a transition is needed.
+ */
+#define DFA_MAX_POS     128   /* positions an expression may expand to */
+#define DFA_WORDS       (DFA_MAX_POS / 32)
+#define DFA_MAX_STATES  256   /* states cached before the cache is flushed */
+#define DFA_UNKNOWN     -1    /* transition not built yet */
+
+#define DFA_ONCE        0     /* position matches exactly once */
+#define DFA_STAR        1     /* position matches zero or more times */
+#define DFA_OPT         2     /* position matches zero or one times (\{m,n\}) */
+
+#define DFA_ISSET(pos, i) ((pos)[(i) >> 5] & (1U << ((i) & 31)))
+#define DFA_SET(pos, i)   ((pos)[(i) >> 5] |= (1U << ((i) & 31)))
+
+typedef struct {
+     unsigned char  set[32];        /* bit per character matched */
+     int            repeat;         /* DFA_ONCE, DFA_STAR, or DFA_OPT */
+} DFA_POS;
+
+typedef struct {
+     unsigned int   pos[DFA_WORDS]; /* positions live in this state */
+     int            floating;       /* a match may also start at the next character */
+     int            accept;         /* the end of the expression has been reached */
+     int            dead;           /* nothing left to match */
+     short          next[256];      /* state index by character, or DFA_UNKNOWN */
+} DFA_STATE;
+
+typedef struct {
+     int            npos;           /* positions in the expression, npos is the accept position */
+     int            anchored;       /* ^ expression, matches only at the first character */
+     int            dollar;         /* expression ends in $ */
+     int            start[2];       /* anchored and floating start states, -1 if not built */
+     int            flushes;        /* times the state cache filled up */
+     int            nstates;
+     DFA_POS        pos[DFA_MAX_POS];
+     DFA_STATE      state[DFA_MAX_STATES];
+} RE_DFA;
+
 struct spattern {  /* static structure per pattern */
      int ends_in_dollar; /* the input pattern */
      /* (   V unsigned added 4/29/93 for getchr bug for 8 bit characters) */
@@ -152,6 +220,19 @@ struct spattern {  /* static structure per pattern */
      int expression_compiled;  /* prevent someone from doing a '//' in the editor */
                                /* without ever having set an expression */ 
      char sbuff[MAX_LINE+2];   /* #ifdef FAST_SUBS memdata stuff directly! */
+     int  literal_len;         /* every match starts with literal[], 0 = no literal prefix */
+     char literal[EBUF_MAX];   /* plain characters at the front of expression */
+     int  literal_skip[256];   /* Horspool shift table for literal[] */
+     RE_DFA *dfa;              /* lazy DFA for expression, kept across repeat finds */
+     RE_DFA *rdfa;             /* dfa with the positions reversed, run back to find where the first match starts */
+     int  dfa_ok;              /* dfa matches expression, 0 means use step() alone */
+     unsigned int generation;  /* changes each time a pattern is compiled, 0 = none */
+     int  compiled_ci;         /* the pattern was lower cased for a case insensitive search */
+     int  fold;                /* case is folded into expression, lines are not lower cased */
+     int  literal_ci;          /* some of literal[] matches either case */
+     char literal_fold[EBUF_MAX]; /* 040 for each literal[] char which matches either case */
+     int  nl_tail_len;         /* newlines, the first line of a match ends with nl_tail[], 0 = unknown */
+     char nl_tail[EBUF_MAX];   /* plain characters just before the first @n */
      void *color_sd;    /* static data storage for color changes */
 
 /* from  regexp.h ! */
@@ -167,6 +248,20 @@ struct spattern {  /* static structure per pattern */
 
 struct spattern *sd;
 
+static unsigned int pattern_generations = 0; /* bumped for each pattern compiled */
+
+/*
+ *  A private copy of the DFA for testing lines outside search(),
+ *  see line_matcher.
+ */
+typedef struct {
+     struct spattern *spat;    /* pattern data, only read while the matcher is in use */
+     int     lower;            /* lower case the line first */
+     int     add_newline;      /* search() appends a newline before step() */
+     char    buff[MAX_LINE+2];
+     RE_DFA  dfa;              /* states are built as this matcher runs */
+} LINE_MATCHER;
+
   /* return macro from search() */
 #define SRETURN { if (*to_col < 0) *to_col=0; \
                   if (*found_col < 0) *found_col = 0;\
@@ -187,6 +282,24 @@ static int newlines_filter(char *pat);
 static int nbstep(char *buf, char *expr);
 static int newline_bracket(char *expr, int *nstar);
 static char *eget(char *expr, char token); 
+static void literal_setup(struct spattern *sd);
+static char *literal_scan(struct spattern *sd, char *line, int len);
+static int  literal_at(struct spattern *sd, char *line);
+static void nl_tail_setup(struct spattern *sd);
+static int  nl_tail_at(struct spattern *sd, char *line, int len, int fold);
+static char *fold_chr(char *p, int c, int n);
+static void fold_expression(char *ep);
+static void fold_set(unsigned char *set, int n);
+static int  fold_cmp(char *s1, char *s2, int n);
+static void dfa_setup(struct spattern *sd);
+static int  dfa_build(RE_DFA *dfa, char *ep, int anchored);
+static void dfa_close(RE_DFA *dfa, unsigned int *pos, int i);
+static int  dfa_state(RE_DFA *dfa, unsigned int *pos, int floating);
+static int  dfa_next(RE_DFA *dfa, int s, int c);
+static int  dfa_run(RE_DFA *dfa, char *line, int floating);
+static void dfa_reverse(RE_DFA *rdfa, RE_DFA *dfa);
+static int  dfa_first(RE_DFA *rdfa, char *line);
+static int  dfa_step(char *p1, char *expr);
 
 /******************  REGEXP.H  ****************************/
 /* #include "regexp.h" */          /* /usr/include/regexp.h    */
@@ -209,6 +322,7 @@ static void getrnge(char *str);
 #define	CKET	24
 #define	CBACK	36
 #define    NCCL	40
+#define	CICHR	28	/* CCHR in a case insensitive find, the char is lower case */
 
 #define	STAR	01
 #define    RNGE	03
@@ -362,6 +476,10 @@ char *instring, *endbuf;
 			else
 				iflag = 32;
 			
+			/* case insensitive, both cases of each letter go in before ^ inverts the set */
+			if(sd->fold)
+				fold_set((unsigned char *)ep, iflag << 3);
+
 			if(neg) {
 				if(iflag == 32) {
 					for(cclcnt = 0; cclcnt < iflag; cclcnt++)
@@ -482,6 +600,18 @@ register char *p1, *p2;
 			}
 		} while(*p1++);
 		return(0);
+	}
+	if(*p2 == CICHR) {
+		c = p2[1];
+		do {
+			if((*p1 | 040) != c)
+				continue;
+			if(advance(p1, p2)) {
+				loc1 = p1;
+				return(1);
+			}
+		} while(*p1++);
+		return(0);
 	}
 		/* regular algorithm */
 	do {
@@ -511,6 +641,11 @@ register char *lp, *ep;
 			if(*ep++ == *lp++)
 				continue;
 			return(0);
+
+		case CICHR:
+			if(*ep++ == (*lp++ | 040))
+				continue;
+			return(0);
 	
 		case CDOT:
 			if(*lp++)
@@ -588,6 +723,21 @@ register char *lp, *ep;
 			ep += 2;
 			goto star;
 	
+		case CICHR | RNGE:
+			c = *ep++;
+			getrnge(ep);
+			while(sd->low--)
+				if((*lp++ | 040) != c)
+					return(0);
+			curlp = lp;
+			while(sd->size--) 
+				if((*lp++ | 040) != c)
+					break;
+			if(sd->size < 0)
+				lp++;
+			ep += 2;
+			goto star;
+	
 		case CDOT | RNGE:
 			getrnge(ep);
 			while(sd->low--)
@@ -649,7 +799,7 @@ register char *lp, *ep;
 			bbeg = braslist[*ep];
 			ct = braelist[*ep++] - bbeg;
 #endif
-			if(ecmp(bbeg, lp, ct)) {
+			if(sd->fold ? fold_cmp(bbeg, lp, ct) : ecmp(bbeg, lp, ct)) {
 				lp += ct;
 				continue;
 			}
@@ -664,7 +814,7 @@ register char *lp, *ep;
 			ct = braelist[*ep++] - bbeg;
 #endif
 			curlp = lp;
-			while(ecmp(bbeg, lp, ct))
+			while(sd->fold ? fold_cmp(bbeg, lp, ct) : ecmp(bbeg, lp, ct))
 				lp += ct;
 	
 			while(lp >= curlp) {
@@ -685,6 +835,12 @@ register char *lp, *ep;
 			ep++;
 			goto star;
 	
+		case CICHR | STAR:
+			curlp = lp;
+			while((*lp++ | 040) == *ep);
+			ep++;
+			goto star;
+	
 		case CXCL | STAR:
 			curlp = lp;
 			do {
@@ -885,6 +1041,14 @@ if (!*sdata){
   sd->expression_compiled = 0;
   sd->color_sd = NULL;
   sd->scase = True;
+  sd->literal_len = 0;
+  sd->dfa = NULL;
+  sd->rdfa = NULL;
+  sd->dfa_ok = 0;
+  sd->generation = 0;
+  sd->compiled_ci = 0;
+  sd->fold = 0;
+  sd->begin_line = 0;
 }else
   sd = (struct spattern *)*sdata;
 
@@ -967,6 +1131,7 @@ if ((pattern != NULL) && (pattern[0] != '\0')){  /* not repeat find same string
    }else
        sd->newlines = 0;
 
+   sd->fold = case_insensitive && !sd->scase && !sd->newlines && !sd->join; /* compile() folds the [] sets */
    if (!sd->compile_failed) /* 11/9/93 incase re() failed*/
        compile((char *) 0, sd->expression, sd->expression + EBUF_MAX, 0);
    if (sd->compile_failed){
@@ -974,9 +1139,17 @@ if ((pattern != NULL) && (pattern[0] != '\0')){  /* not repeat find same string
         SRETURN;  /* compile error */
    }
    sd->expression_compiled++;
+   sd->generation  = ++pattern_generations;
+   sd->compiled_ci = case_insensitive;
+   if (sd->fold)
+       fold_expression(sd->expression);
    DEBUG13(print_pat_expr(sd->pat, sd->expression);) 
+   literal_setup(sd);
+   nl_tail_setup(sd);
+   dfa_setup(sd);
 
-}   /* !repeat find */
+}else   /* repeat find, another sdata may have been compiled since */
+   circf = (sd->begin_line != 0);
 
 /*
  *  sanity checks
@@ -1075,11 +1248,46 @@ begin: /* Yes we have goto's! */
            continue;
        }
 
+       /*
+        *  Lines which do not contain the literal prefix of the pattern
+        *  cannot match, skip them without copying or running step().
+        */
+       if (sd->literal_len && !sd->newlines && !sd->join && !(case_insensitive && !substitute && !sd->scase && !sd->fold) &&
+           ((start_col > len) ||
+            (sd->begin_line ? !literal_at(sd, buff + start_col)
+                            : !literal_scan(sd, buff + start_col, len - start_col)))){
+           if (rectangular){
+               start_col = rec_start_col;
+               end_col = rec_end_col -1;
+               (*to_col) = rec_end_col;
+           }else
+               start_col = 0;
+           start_line++;
+           continue;
+       }
+
+       /*
+        *  The first line of a multi-line match must end with the text
+        *  before the first @n.  Check it in place so newline_step only
+        *  copies and walks the lines after it for lines which can match.
+        */
+       if (sd->newlines && sd->nl_tail_len &&
+           ((start_col > len) || !nl_tail_at(sd, buff + start_col, len - start_col, case_insensitive && !substitute && !sd->scase))){
+           if (rectangular){
+               start_col = rec_start_col;
+               end_col = rec_end_col -1;
+               (*to_col) = rec_end_col;
+           }else
+               start_col = 0;
+           start_line++;
+           continue;
+       }
+
        if (buff != tbuff)  /* 5/19/93 optomizes */
            strcpy(tbuff, buff);  
        buff = tbuff;      /* sub needs its own copy */
 
-       if (case_insensitive && !substitute && !sd->scase) lower_case(buff);
+       if (case_insensitive && !substitute && !sd->scase && !sd->fold) lower_case(buff);
        DEBUG13( fprintf(stderr, " scanningF(%s)[start(%d,%d),end(%d,%d)]\n", buff + start_col, start_line, start_col, end_line, end_col);) 
 
        if (sd->newlines){   /* do we have one or more sd->newlines in the pattern? */
@@ -1130,7 +1338,7 @@ begin: /* Yes we have goto's! */
                  /* commented in for s/[~x]/x/ ; [[[ this could cause trouble 7/27/94 ]]]; buff[null] commented out to prevent infinit loop s/[ ]*_/12/ */
                  /* this still does not fix /%[ @t]$/ finding blank lines ; try m1 on last letter of file name (m1=ls -la)*/
 #endif
-                step(buff + start_col, sd->expression)){ /* len<sc s/{?*}/x@1/ 2/17/94 */
+                dfa_step(buff + start_col, sd->expression)){ /* len<sc s/{?*}/x@1/ 2/17/94 */
                      if (loc1==loc2) null_offset = 1;
                      if (!sd->ends_in_dollar){
                          if (loc1 == (buff + len +1)) loc1--;  /* can't point a '\n' */
@@ -1282,13 +1490,27 @@ begin: /* Yes we have goto's! */
            continue;
        }
 
+       if (sd->literal_len && !sd->newlines && !(case_insensitive && !sd->scase && !sd->fold) &&
+           (sd->begin_line ? !literal_at(sd, buff)
+                           : !literal_scan(sd, buff, strlen(buff)))){
+           start_line--;  /* literal prefix not in this line */
+           start_col = -1;
+           continue;
+       }
+
+       if (sd->newlines && sd->nl_tail_len && !nl_tail_at(sd, buff, strlen(buff), case_insensitive && !sd->scase)){
+           start_line--;  /* does not end with the text before the first @n */
+           start_col = -1;
+           continue;
+       }
+
        strcpy(tbuff, buff);  
        buff = tbuff;        /* sub needs its own copy */
 
        start_line--;
        len = strlen(buff);
 
-       if (case_insensitive && !sd->scase) lower_case(buff);
+       if (case_insensitive && !sd->scase && !sd->fold) lower_case(buff);
        DEBUG13( fprintf(stderr, " scanningR(%s)[start_line:%d, end_line:%d]\n", buff, start_line, end_line);) 
        if (sd->newlines){
            if (newline_step(token, buff, sd->expression, start_line, &newline_change, substitute, to_line+1, (*to_col) -1)){
@@ -1409,7 +1631,7 @@ char *end_ptr;
 char *loc1_save, *loc2_save;
 
 if (sd->begin_line)  /* if the search is nailed to the begining of line only one call */
-    return(step(buff, expression));  /* is needed */
+    return(dfa_step(buff, expression));  /* is needed */
 
 if (end == -1)  /* if end=-1 then we are not on the first line so any column is ok */
     end = MAX_LINE +1; 
@@ -1422,7 +1644,7 @@ buff[MAX_LINE] = '\0'; /* just in case! */
 ptr = buff-1;
 last = NULL;
 
-while  ((rc = step(ptr+1, expression)) && (loc2 <= end_ptr)){ 
+while  ((rc = dfa_step(ptr+1, expression)) && (loc2 <= end_ptr)){ 
 
           found += rc;
           if (last)
@@ -1678,6 +1900,8 @@ int len;
 int pline; /* short for (ptr - line) */
 int count = to_line;   /* count is zero based! */
 int column_orig = *column;
+int joined;
+int i;
 
 int greatest_impacted_line = 0;
 
@@ -1689,6 +1913,16 @@ DEBUG27(print_file(token););
 while ((line != NULL) && (count >= from_line)){
 
        if (!greatest_impacted_line) greatest_impacted_line = *row;
+       /*
+        *  A run of lines joined by s/@n/x/ is put together in one step
+        *  instead of copying the growing line once per join.
+        */
+       if (sd->join && ((joined = join_marked_lines(token, from_line, count, column)) > 1)){
+           for (i = 0; i < joined; i++)
+               if ((count - i) < greatest_impacted_line)
+                   greatest_impacted_line--;
+           count -= joined - 1;
+       }else
        if ((count <= total_lines(token)) &&  /* added '=' 9/16/93 for last line del */
            delayed_delete(token, count, NOW, column, 1 /*JOIN*/) && /* changes made 9/13/93 to fix s/@n/@n@n/ */
            (count < greatest_impacted_line)) /* was <= 11/30/93 to fix s/@n/5/ cursor placement */  
@@ -2058,6 +2292,1471 @@ return(expr);
 
 } /* eget() */
 
+/***********************************************************************
+*
+*  literal_setup - Find the literal prefix of a compiled expression
+*
+*  PURPOSE:  Most finds are for plain strings.  When the compiled
+*            expression starts with one or more ordinary characters
+*            (CCHR not modified by '*' or \{\}), every match must start
+*            with those characters.  They are saved in literal[] with a
+*            Horspool shift table so search() can throw away lines which
+*            cannot match without copying them or calling step().
+*            For a '^' pattern (circf) the prefix is compared at the
+*            start of the line.  A '\n' in the prefix stops it, since
+*            search() appends a newline to the line before calling step().
+*            Letters folded by fold_expression (CICHR) go in lower
+*            case with literal_fold[] set, and both cases get a shift.
+*
+*  PARAMETERS:
+*
+*     sd   -  (INPUT/OUTPUT) The static pattern data, expression is compiled.
+*
+***********************************************************************/
+
+static void literal_setup(struct spattern *sd)
+{
+char  *ep = sd->expression;
+int    len = 0;
+int    i;
+
+sd->literal_ci = 0;
+while (((*ep == CCHR) || (*ep == CICHR)) && (ep[1] != NEWLINE) && (len < EBUF_MAX-1)){
+    sd->literal_fold[len] = (*ep == CICHR) ? 040 : 0;
+    sd->literal_ci |= sd->literal_fold[len];
+    sd->literal[len++] = ep[1];
+    ep += 2;
+}
+sd->literal[len] = '\0';
+sd->literal_len = len;
+
+for (i = 0; i < 256; i++)
+    sd->literal_skip[i] = len;
+for (i = 0; i < len-1; i++){
+    sd->literal_skip[(unsigned char)sd->literal[i]] = len-1-i;
+    if (sd->literal_fold[i])
+        sd->literal_skip[(unsigned char)sd->literal[i] & ~040] = len-1-i;
+}
+
+DEBUG13(if (len) fprintf(stderr, " literal prefix(%s)%s%s\n", sd->literal, sd->literal_ci ? " either case" : "", (*ep == CCEOF) ? " whole pattern" : "");)
+
+} /* literal_setup() */
+
+/***********************************************************************
+*
+*  literal_scan - Look for the literal prefix in a line
+*
+*  PURPOSE:  Returns a pointer to the first occurance of sd->literal in
+*            line or NULL.  The first character is found with memchr,
+*            which the C library does a word or vector at a time, and
+*            the second character is checked before the compare.  Long
+*            literals use the Horspool shift table so most of the line
+*            is skipped over.  For a case insensitive find the letters
+*            are compared with their 040 bit or'ed in, so the line is
+*            never copied or lower cased.
+*
+*  PARAMETERS:
+*
+*     sd   -  (INPUT) The static pattern data, literal_setup has been run.
+*     line -  (INPUT) The line to scan, need not be null terminated.
+*     len  -  (INPUT) The number of characters in line.
+*
+***********************************************************************/
+
+static char *literal_scan(struct spattern *sd, char *line, int len)
+{
+int            m = sd->literal_len;
+char          *lit = sd->literal;
+char          *fold = sd->literal_fold;
+char          *end;
+char          *p;
+unsigned char  last;
+
+if (len < m)
+    return(NULL);
+
+if (sd->literal_ci){
+    end = line + len - m;
+    if (m < 4){
+        for (p = line; p <= end; p++){
+            if (!(p = fold[0] ? fold_chr(p, lit[0], end - p + 1) : memchr(p, lit[0], end - p + 1)))
+                return(NULL);
+            if (literal_at(sd, p))
+                return(p);
+        }
+        return(NULL);
+    }
+    last = (unsigned char)lit[m-1];
+    for (p = line; p <= end; p += sd->literal_skip[(unsigned char)p[m-1]])
+        if ((((unsigned char)p[m-1] | fold[m-1]) == last) && literal_at(sd, p))
+            return(p);
+    return(NULL);
+}
+
+if (m < 4){
+    end = line + len - m;  /* last possible starting point */
+    for (p = line; p <= end; p++){
+        if (!(p = memchr(p, lit[0], end - p + 1)))
+            return(NULL);
+        if ((m == 1) || ((p[1] == lit[1]) && !memcmp(p+2, lit+2, m-2)))
+            return(p);
+    }
+    return(NULL);
+}
+
+last = (unsigned char)lit[m-1];
+end = line + len - m;
+for (p = line; p <= end; p += sd->literal_skip[(unsigned char)p[m-1]])
+    if (((unsigned char)p[m-1] == last) && (p[0] == lit[0]) && !memcmp(p+1, lit+1, m-2))
+        return(p);
+
+return(NULL);
+
+} /* literal_scan() */
+
+/***********************************************************************
+*
+*  literal_at - Compare the literal prefix at the start of a line
+*
+*  PURPOSE:  Returns True if line starts with sd->literal.  Like strncmp
+*            it stops at the first difference, so a short line is safe.
+*
+***********************************************************************/
+
+static int literal_at(struct spattern *sd, char *line)
+{
+int   i;
+
+if (!sd->literal_ci)
+    return(strncmp(line, sd->literal, sd->literal_len) == 0);
+
+for (i = 0; i < sd->literal_len; i++)
+    if ((line[i] | sd->literal_fold[i]) != sd->literal[i])
+        return(False);
+
+return(True);
+
+} /* literal_at() */
+
+/***********************************************************************
+*
+*  nl_tail_setup - Pull the text before the first @n out of an expression
+*
+*  PURPOSE:  newline_step copies a line and each line after it and runs
+*            step() on every piece, even when the first line cannot be
+*            the start of a match.  When the part of a multi-line
+*            pattern before the first @n ends in ordinary characters,
+*            the first line of any match must end with them.  They are
+*            saved in nl_tail[] so search() can check the end of the
+*            line in place.  The walk gives up (nl_tail_len = 0) on
+*            anything it does not understand, on @n* and on operands
+*            which eget() would mistake for a piece boundary.
+*
+*  PARAMETERS:
+*
+*     sd   -  (INPUT/OUTPUT) The static pattern data, expression is compiled.
+*
+***********************************************************************/
+
+static void nl_tail_setup(struct spattern *sd)
+{
+char  *ep = sd->expression;
+int    len = 0;
+int    op;
+int    skip;
+int    i;
+
+sd->nl_tail_len = 0;
+if (!sd->newlines)
+    return;
+
+while(1){
+    op = *ep & 0377;
+    if ((op == CBRA) || (op == CKET)){
+        if ((ep[1] == EDOLLAR) || (ep[1] == CCEOF))
+            return;
+        ep += 2;
+        continue;
+    }
+
+    if (((op & ~RNGE) == CCHR) && (ep[1] == EDOLLAR)){
+        if (op == CCHR){  /* not @n* */
+            sd->nl_tail_len = len;
+            DEBUG13(sd->nl_tail[len] = '\0'; if (len) fprintf(stderr, " newline tail(%s)\n", sd->nl_tail);)
+        }
+        return;
+    }
+
+    if (op == CCHR){
+        if ((ep[1] == CCEOF) || (len >= EBUF_MAX-1))
+            return;
+        sd->nl_tail[len++] = ep[1];
+        ep += 2;
+        continue;
+    }
+
+    switch(op & ~RNGE){
+    case CCHR:
+    case CBACK:
+        skip = 2;
+        break;
+    case CDOT:
+        skip = 1;
+        break;
+    case CCL:
+    case NCCL:
+        skip = 17;
+        break;
+    case CXCL:
+        skip = 33;
+        break;
+    default:  /* CDOL, CCEOF or something new */
+        return;
+    }
+    if ((op & RNGE) == RNGE)
+        skip += 2;
+    for (i = 1; i < skip; i++)
+        if ((ep[i] == EDOLLAR) || (ep[i] == CCEOF))
+            return;
+    ep += skip;
+    len = 0;
+}
+
+} /* nl_tail_setup() */
+
+/***********************************************************************
+*
+*  nl_tail_at - Check that a line ends with the text before the first @n
+*
+*  PURPOSE:  Returns True if line could be the first line of a match.
+*            The line is not copied.  When search() would lower case
+*            the line before step(), fold is set and upper case
+*            characters are compared as lower case.
+*
+*  PARAMETERS:
+*
+*     sd   -  (INPUT) The static pattern data, nl_tail_setup has been run.
+*     line -  (INPUT) The line, from the column the scan starts in.
+*     len  -  (INPUT) The number of characters in line.
+*     fold -  (INPUT) True for a case insensitive find.
+*
+***********************************************************************/
+
+static int nl_tail_at(struct spattern *sd, char *line, int len, int fold)
+{
+int            m = sd->nl_tail_len;
+unsigned char *p;
+unsigned char *t = (unsigned char *)sd->nl_tail;
+int            i;
+
+if (len < m)
+    return(False);
+
+p = (unsigned char *)line + len - m;
+if (!fold)
+    return(memcmp(p, t, m) == 0);
+
+for (i = 0; i < m; i++)
+    if ((isupper(p[i]) ? (p[i] | 040) : p[i]) != t[i])
+        return(False);
+
+return(True);
+
+} /* nl_tail_at() */
+
+/***********************************************************************
+*
+*  fold_chr - memchr for a letter in either case
+*
+*  PURPOSE:  Returns a pointer to the first of the n characters at p
+*            which is c in either case, c is a lower case letter.  The
+*            line is read a word at a time, each word is or'ed with 040
+*            in every byte and compared to c in every byte at once, so
+*            the scan runs near memchr speed with no copy.  Or'ing in
+*            040 only turns the upper case of c into c, since c is a
+*            lower case letter.
+*
+***********************************************************************/
+
+static char *fold_chr(char *p, int c, int n)
+{
+unsigned long  ones  = ~0UL / 0377;      /* 0x01 in every byte */
+unsigned long  highs = ones * 0200;
+unsigned long  fold  = ones * 040;
+unsigned long  want  = ones * (unsigned char)c;
+unsigned long  w;
+char          *end = p + n;
+
+while (end - p >= (long)sizeof(w)){
+    memcpy((char *)&w, p, sizeof(w));
+    w = (w | fold) ^ want;
+    if ((w - ones) & ~w & highs)
+        break;  /* a zero byte, c is in this word */
+    p += sizeof(w);
+}
+
+for (; p < end; p++)
+    if ((*p | 040) == c)
+        return(p);
+
+return(NULL);
+
+} /* fold_chr() */
+
+/***********************************************************************
+*
+*  fold_expression - Fold case into a compiled expression
+*
+*  PURPOSE:  A case insensitive find used to copy and lower case every
+*            line before calling step().  Instead the expression is
+*            changed once when it is compiled.  Each letter becomes a
+*            CICHR, which advance() matches by or'ing 040 into the line
+*            character.  The [] sets are already folded, compile() adds
+*            the other case of each letter before a ^ inverts the set.
+*            Folding an inverted set here would put back the letters the
+*            ^ took out.  The pattern was lower cased before compile,
+*            so CICHR always holds a lower case letter.  The DFA and the
+*            literal prefix are then built from the folded expression.
+*
+*  PARAMETERS:
+*
+*     ep   -  (INPUT/OUTPUT) The compiled expression.
+*
+***********************************************************************/
+
+static void fold_expression(char *ep)
+{
+int   op;
+int   c;
+
+while(1){
+    op = *ep & 0377;
+    switch(op){
+    case CCEOF:
+        return;
+
+    case CDOL:
+        ep++;
+        continue;
+
+    case CBRA:
+    case CKET:
+    case CBACK:
+    case CBACK | STAR:
+        ep += 2;
+        continue;
+    }
+
+    switch(op & ~RNGE){
+    case CCHR:
+        c = ep[1] & 0377;
+        if ((c < 0200) && isalpha(c)){
+            *ep = CICHR | (op & RNGE);
+            ep[1] = c | 040;
+        }
+        ep += 2;
+        break;
+
+    case CDOT:
+        ep++;
+        break;
+
+    case CCL:
+    case NCCL:
+        ep += 17;
+        break;
+
+    case CXCL:
+        ep += 33;
+        break;
+
+    default:
+        DEBUG13(fprintf(stderr, " fold_expression: unknown op %d\n", op);)
+        return;
+    }
+
+    if ((op & RNGE) == RNGE)
+        ep += 2;
+}
+
+} /* fold_expression() */
+
+/***********************************************************************
+*
+*  fold_set - Add the other case of each letter to a [] set
+*
+*  PURPOSE:  Called by compile() on the bits of a [] set before a ^
+*            inverts it, n is the number of characters in the set.
+*
+***********************************************************************/
+
+static void fold_set(unsigned char *set, int n)
+{
+int   c;
+int   uc;
+
+for (c = 'a'; (c <= 'z') && (c < n); c++){
+    uc = c & ~040;
+    if ((set[c >> 3] & bittab[c & 07]) || (set[uc >> 3] & bittab[uc & 07])){
+        set[c >> 3]  |= bittab[c & 07];
+        set[uc >> 3] |= bittab[uc & 07];
+    }
+}
+
+} /* fold_set() */
+
+/***********************************************************************
+*
+*  fold_cmp - Compare strings ignoring case
+*
+*  PURPOSE:  Used for \1 in a folded expression, the text matched by the
+*            bracket may differ in case from the text it is compared to.
+*            Returns True if the first n characters are the same.
+*
+***********************************************************************/
+
+static int fold_cmp(char *s1, char *s2, int n)
+{
+int   c1;
+int   c2;
+
+while (n-- > 0){
+    c1 = (unsigned char)*s1++;
+    c2 = (unsigned char)*s2++;
+    if (c1 != c2){
+        if ((c1 < 0200) && isupper(c1)) c1 |= 040;
+        if ((c2 < 0200) && isupper(c2)) c2 |= 040;
+        if (c1 != c2)
+            return(False);
+    }
+    if (!c1)
+        break;
+}
+
+return(True);
+
+} /* fold_cmp() */
+
+/************************************************************************
+
+NAME:      line_matcher  -  Get a private matcher for testing lines
+
+PURPOSE:    This routine returns a matcher which tells, without calling
+            step(), whether a line may hold a match for the expression
+            last compiled into sdata.  Each matcher has its own copy of
+            the DFA, so several matchers can run at once in different
+            threads.  A line it accepts is not always found by search(),
+            which applies column rules, but a line it rejects never is.
+
+PARAMETERS:
+
+   1.  sdata          - pointer to void (INPUT)
+                        The static pattern data from a previous call to search.
+
+   2.  case_insensitive - int (INPUT)
+                        The case flag which will be passed to search.
+
+FUNCTIONS :
+
+   1.   Returns NULL if the expression cannot be run in the DFA
+        (back references, newlines, join) or no expression has been
+        compiled.  The caller then uses search().
+
+*************************************************************************/
+
+void *line_matcher(void *sdata, int case_insensitive)
+{
+struct spattern *spat = (struct spattern *)sdata;
+LINE_MATCHER    *lm;
+
+if (!spat || !spat->expression_compiled || !spat->dfa_ok || spat->newlines || spat->join ||
+    ((spat->begin_line != 0) != spat->dfa->anchored))
+   return(NULL);
+
+lm = (LINE_MATCHER *)CE_MALLOC(sizeof(LINE_MATCHER));
+if (!lm)
+   return(NULL);
+
+lm->spat        = spat;
+lm->lower       = case_insensitive && !spat->scase && !spat->fold;
+lm->add_newline = !spat->ends_in_dollar;
+lm->dfa.npos     = spat->dfa->npos;
+lm->dfa.anchored = spat->dfa->anchored;
+lm->dfa.dollar   = spat->dfa->dollar;
+lm->dfa.nstates  = 0;
+lm->dfa.flushes  = 0;
+lm->dfa.start[0] = lm->dfa.start[1] = -1;
+memcpy((char *)lm->dfa.pos, (char *)spat->dfa->pos, spat->dfa->npos * sizeof(DFA_POS));
+
+return((void *)lm);
+
+} /* end of line_matcher */
+
+
+/************************************************************************
+
+NAME:      line_may_match  -  Test whether a line may hold a match
+
+PURPOSE:    The line is prepared the way search() prepares it for step()
+            (lower cased, newline added) and run through the matcher's DFA.
+            The literal prefix test is tried first.  This routine uses no
+            static data and may be called from any thread, one thread per
+            matcher.
+
+PARAMETERS:
+
+   1.  matcher     - pointer to void (INPUT)
+                     The matcher from line_matcher.
+
+   2.  line        - pointer to char (INPUT)
+                     The line to test.
+
+FUNCTIONS :
+
+   1.   Returns True if the line may hold a match.
+
+*************************************************************************/
+
+int   line_may_match(void *matcher, char *line)
+{
+LINE_MATCHER    *lm = (LINE_MATCHER *)matcher;
+struct spattern *spat = lm->spat;
+int              len;
+
+if (!line)
+   return(False);
+
+len = strlen(line);
+if (len > MAX_LINE)
+   len = MAX_LINE;
+
+if (spat->literal_len && !lm->lower &&
+    (spat->begin_line ? !literal_at(spat, line)
+                      : !literal_scan(spat, line, len)))
+   return(False);
+
+if (lm->lower || lm->add_newline)
+   {
+      memcpy(lm->buff, line, len);
+      lm->buff[len] = '\0';
+      if (lm->lower)
+         lower_case(lm->buff);
+      if (lm->add_newline)
+         {
+            lm->buff[len] = '\n';
+            lm->buff[len+1] = '\0';
+         }
+      line = lm->buff;
+   }
+
+return(dfa_run(&lm->dfa, line, !lm->dfa.anchored) >= 0);
+
+} /* end of line_may_match */
+
+
+/************************************************************************
+
+NAME:      free_line_matcher  -  Free a matcher from line_matcher
+
+*************************************************************************/
+
+void  free_line_matcher(void *matcher)
+{
+
+if (matcher)
+   free((char *)matcher);
+
+} /* end of free_line_matcher */
+
+
+/************************************************************************
+
+NAME:      free_search_data  -  Free the static pattern data of a search
+
+PURPOSE:    search() allocates the static pattern data the first time it is
+            called with a given sdata pointer.  Callers which use a
+            temporary pattern free it with this routine.
+
+*************************************************************************/
+
+void  free_search_data(void **sdata)
+{
+struct spattern *spat = (struct spattern *)*sdata;
+
+if (!spat)
+   return;
+
+if (spat->dfa)
+   free((char *)spat->dfa);
+if (spat->rdfa)
+   free((char *)spat->rdfa);
+free((char *)spat);
+if (sd == spat)
+   sd = NULL;
+*sdata = NULL;
+
+} /* end of free_search_data */
+
+
+/************************************************************************
+
+NAME:      pattern_generation  -  Get a number which changes when a new pattern is compiled
+
+PURPOSE:    Callers which save results computed with the pattern in sdata,
+            such as the match highlighting in hlmatch.c, compare this number
+            to tell when the results are stale.
+
+FUNCTIONS :
+
+   1.   Returns zero if there is no pattern or the pattern cannot be
+        matched one line at a time (newlines or join).
+
+*************************************************************************/
+
+unsigned int pattern_generation(void *sdata)
+{
+struct spattern *spat = (struct spattern *)sdata;
+
+if (!spat || !spat->expression_compiled || spat->newlines || spat->join)
+   return(0);
+else
+   return(spat->generation);
+
+} /* end of pattern_generation */
+
+
+/************************************************************************
+
+NAME:      line_match_cols  -  Find the columns of every match on a line
+
+PURPOSE:    This routine runs the pattern last compiled into sdata over one
+            line and returns the start and end column of each match, left
+            to right, without overlaps.  The line is prepared the way
+            search() prepares it.  Empty matches (^ or $ alone) are not
+            returned since there is nothing to show.
+
+PARAMETERS:
+
+   1.  sdata       - pointer to void (INPUT)
+                     The static pattern data from a previous call to search.
+
+   2.  line        - pointer to char (INPUT)
+                     The line to scan.
+
+   3.  cols        - pointer to short (OUTPUT)
+                     Pairs of start and end (one past the last char) columns.
+
+   4.  max_matches - int (INPUT)
+                     The number of pairs cols can hold.
+
+FUNCTIONS :
+
+   1.   Returns the number of matches found.  Must be called from the
+        main thread, step() uses static data.
+
+*************************************************************************/
+
+int   line_match_cols(void    *sdata,
+                      char    *line,
+                      short   *cols,
+                      int      max_matches)
+{
+struct spattern *spat = (struct spattern *)sdata;
+struct spattern *save_sd = sd;
+int              save_circf = circf;
+char            *save_loc1 = loc1;
+char            *save_loc2 = loc2;
+char            *save_locs = locs;
+char             buff[MAX_LINE+2];
+char            *p;
+int              len;
+int              start;
+int              end;
+int              count = 0;
+
+if (!line || !pattern_generation(sdata))
+   return(0);
+
+len = strlen(line);
+if (len > MAX_LINE)
+   len = MAX_LINE;
+memcpy(buff, line, len);
+buff[len] = '\0';
+
+if (spat->literal_len && !(spat->compiled_ci && !spat->scase && !spat->fold) &&
+    (spat->begin_line ? !literal_at(spat, buff)
+                      : !literal_scan(spat, buff, len)))
+   return(0);
+
+if (spat->compiled_ci && !spat->scase && !spat->fold)
+   lower_case(buff);
+if (!spat->ends_in_dollar)
+   {
+      buff[len] = '\n';
+      buff[len+1] = '\0';
+   }
+
+sd    = spat;
+circf = (spat->begin_line != 0);
+locs  = "";
+
+p = buff;
+while ((count < max_matches) && (p - buff < len) && dfa_step(p, spat->expression))
+{
+   start = loc1 - buff;
+   end   = loc2 - buff;
+   if (end > len)
+      end = len;
+   if (start >= len)
+      break;
+   if (end > start)
+      {
+         cols[count*2]   = start;
+         cols[count*2+1] = end;
+         count++;
+      }
+   p = (loc2 > loc1) ? loc2 : loc1 + 1;
+   if (circf)
+      break;  /* ^ only matches once */
+}
+
+sd    = save_sd;
+circf = save_circf;
+loc1  = save_loc1;
+loc2  = save_loc2;
+locs  = save_locs;
+
+return(count);
+
+} /* end of line_match_cols */
+
+
+/************************************************************************
+
+NAME:      subs_line_ok  -  Check if a substitute can be done one line at a time
+
+PURPOSE:    This routine tells whether the pattern and replacement last
+            compiled into sdata by search() only ever change text within
+            a line.  Patterns with newlines, joins, and replacements which
+            insert newlines change the number of lines and must go through
+            search().
+
+PARAMETERS:
+
+   1.  sdata       - pointer to void (INPUT)
+                     The static pattern data from a previous call to search
+                     with a substitute string.
+
+FUNCTIONS :
+
+   1.   Returns True if subs_line may be used.
+
+*************************************************************************/
+
+int   subs_line_ok(void    *sdata)
+{
+struct spattern *spat = (struct spattern *)sdata;
+char            *rp;
+int              c;
+
+if (!pattern_generation(sdata) || spat->newlines || spat->join || spat->ends_in_newline)
+   return(False);
+
+for (rp = spat->saved_subs; (c = *rp++) != '\0';)
+{
+   if (c == '\\')
+      {
+         c = *rp++;
+         if (c == '\0')
+            break;
+         if (c == 'n')
+            return(False);
+      }
+   if (c == NEWLINE)
+      return(False);
+}
+
+return(True);
+
+} /* end of subs_line_ok */
+
+
+/************************************************************************
+
+NAME:      subs_line  -  Do a substitute on one whole line
+
+PURPOSE:    This routine applies the pattern and replacement last compiled
+            into sdata to one line, the same way search() does when the
+            line is in the middle of a substitute range.  The result goes
+            to a separate buffer so the caller can decide how to put it
+            back in memdata.
+
+PARAMETERS:
+
+   1.  token       - pointer to DATA_TOKEN (INPUT)
+                     The memdata the line came from, used for color data.
+
+   2.  sdata       - pointer to void (INPUT)
+                     The static pattern data, subs_line_ok must be True.
+
+   3.  lineno      - int (INPUT)
+                     The line number of line in token.
+
+   4.  line        - pointer to char (INPUT)
+                     The line to change.  It is not modified.
+
+   5.  so          - int (INPUT)
+                     True for substitute once, only the first match on the
+                     line is replaced.
+
+   6.  out         - pointer to char (OUTPUT)
+                     The changed line is placed here.  It must hold
+                     MAX_LINE+2 characters.
+
+   7.  last_col    - pointer to int (OUTPUT)
+                     The column just past the last replacement is placed
+                     here when a change is made.
+
+FUNCTIONS :
+
+   1.   Returns the number of substitutions made.  Must be called from
+        the main thread, step() and subs() use static data.
+
+*************************************************************************/
+
+int   subs_line(DATA_TOKEN *token,
+                void       *sdata,
+                int         lineno,
+                char       *line,
+                int         so,
+                char       *out,
+                int        *last_col)
+{
+int              len;
+int              size;
+int              start_col = 0;
+int              found_col;
+int              dollar_only;
+int              null_offset = 0;
+int              dummy = 0;
+int              count = 0;
+
+sd    = (struct spattern *)sdata;
+circf = (sd->begin_line != 0);
+locs  = loc1 = loc2 = "";
+init_bra();
+
+if (((sd->pat[0] == '$') && (sd->pat[1] == '\0')) || !sd->ends_in_dollar)
+   dollar_only = 1;
+else
+   dollar_only = 0;
+
+strcpy(out, line);
+
+while(1)
+{
+   len = strlen(out);
+   if ((sd->begin_line && (start_col > 0)) ||
+       ((start_col >= (len + dollar_only)) && len))
+      break;
+
+   if (sd->literal_len &&
+       ((start_col > len) ||
+        (sd->begin_line ? !literal_at(sd, out + start_col)
+                        : !literal_scan(sd, out + start_col, len - start_col))))
+      break;
+
+   if (start_col > len)
+      break;
+
+   if (!sd->ends_in_dollar)
+      strcat(out, "\n");
+
+   found_col = DM_FIND_NOT_FOUND;
+   if (((start_col < len) ||
+        ((start_col == len) &&
+         (((sd->pat[0] == '$') && !sd->pat[1]) ||
+          ((sd->pat[0] == '^') && !start_col)  ||
+          (sd->ends_in_dollar) ||
+          (sd->pat[strlen(sd->pat)-1] == ']')))) &&
+       dfa_step(out + start_col, sd->expression))
+      {
+         if (loc1 == loc2)
+            null_offset = 1;
+         if (!sd->ends_in_dollar)
+            {
+               if (loc1 == (out + len +1)) loc1--;  /* can't point a '\n' */
+               if (loc2 == (out + len +1)) loc2--;
+            }
+         found_col = loc1 - out;
+      }
+
+   if (!sd->ends_in_dollar)
+      out[len] = '\0'; /* kill the newline */
+
+   if (found_col == DM_FIND_NOT_FOUND)
+      break;
+
+   strcpy(sd->sbuff, sd->saved_subs);
+   subs(token, &(sd->color_sd), lineno, sd->sbuff, out, &dummy, &size);
+   count++;
+
+   found_col = null_offset + loc2 - out - 1; /* point to end of replacement */
+   *last_col = (found_col < 0) ? 0 : found_col;
+   if (so || sd->begin_line || (start_col >= len))
+      break; /* so means only one change per line, s/[~a]/x/ can match the end of line forever */
+   start_col = found_col + 1;
+}
+
+if (sd->color_sd)
+   cd_add_remove(token, &(sd->color_sd), -1, 0, 0);
+
+return(count);
+
+} /* end of subs_line */
+
+
+/************************************************************************
+
+NAME:      required_text  -  Get the text every match must contain
+
+PURPOSE:    This routine walks the expression last compiled into sdata and
+            copies out each run of plain characters which every match must
+            contain.  There is no alternation in these expressions, so a
+            character which is not starred or ranged is always in a match,
+            and characters next to each other in the expression are next
+            to each other in the match.  Callers use the runs to rule out
+            text without running the matcher.  Letters of a case insensitive
+            find are returned in lower case.
+
+PARAMETERS:
+
+   1.  sdata       - pointer to void (INPUT)
+                     The static pattern data from a previous call to search.
+
+   2.  runs        - pointer to char (OUTPUT)
+                     The runs, each null terminated, with an empty run at
+                     the end.
+
+   3.  size        - int (INPUT)
+                     The number of bytes in runs.
+
+FUNCTIONS :
+
+   1.   Returns the number of runs.  Zero is returned if there is no
+        pattern or it can span lines.
+
+*************************************************************************/
+
+int   required_text(void    *sdata,
+                    char    *runs,
+                    int      size)
+{
+struct spattern *spat = (struct spattern *)sdata;
+char            *ep;
+char            *out = runs;
+char            *end = runs + size - 2;   /* room for the two nulls */
+int              op;
+int              count = 0;
+int              len = 0;
+
+if ((size < 2) || !pattern_generation(sdata))
+   return(0);
+
+ep = spat->expression;
+while ((out < end) && ((op = *ep & 0377) != CCEOF) && (op != CDOL))
+{
+   switch(op)
+   {
+   case CBRA:
+   case CKET:
+      ep += 2;  /* takes no room in the match */
+      continue;
+
+   case CCHR:
+   case CICHR:
+      if (ep[1] != NEWLINE)
+         {
+            *out++ = ep[1];
+            len++;
+            ep += 2;
+            continue;
+         }
+      break;
+   }
+
+   if (len)
+      {
+         *out++ = '\0';
+         count++;
+         len = 0;
+      }
+
+   switch(op & ~RNGE)
+   {
+   case CCHR:
+   case CICHR:
+   case CBACK:
+      ep += 2;
+      break;
+
+   case CDOT:
+      ep++;
+      break;
+
+   case CCL:
+   case NCCL:
+      ep += 17;
+      break;
+
+   case CXCL:
+      ep += 33;
+      break;
+
+   default:
+      op = 0;   /* unknown, stop here */
+      break;
+   }
+
+   if (!op)
+      break;
+   if ((op & RNGE) == RNGE)
+      ep += 2;
+}
+
+if (len)
+   {
+      *out++ = '\0';
+      count++;
+   }
+*out = '\0';
+
+return(count);
+
+} /* end of required_text */
+
+/***********************************************************************
+*
+*  dfa_setup - Build the lazy DFA for a newly compiled expression
+*
+*  PURPOSE:  step() backtracks over every '*' at every starting column,
+*            which can take seconds per line for some patterns.  The
+*            DFA answers whether a line matches in one pass.  It is
+*            kept in the static pattern data so repeat finds reuse the
+*            states already built.  Expressions with back references
+*            (\1) or a '$' which is not at the end are left to step().
+*            A second DFA with the positions in reverse order finds the
+*            column the first match starts in.
+*
+*  PARAMETERS:
+*
+*     sd   -  (INPUT/OUTPUT) The static pattern data, expression is compiled.
+*
+***********************************************************************/
+
+static void dfa_setup(struct spattern *sd)
+{
+
+sd->dfa_ok = 0;
+
+if (!sd->dfa)
+    sd->dfa = (RE_DFA *)CE_MALLOC(sizeof(RE_DFA));
+
+if (!sd->rdfa)
+    sd->rdfa = (RE_DFA *)CE_MALLOC(sizeof(RE_DFA));
+
+if (sd->dfa && sd->rdfa && dfa_build(sd->dfa, sd->expression, circf)){
+    dfa_reverse(sd->rdfa, sd->dfa);
+    sd->dfa_ok = True;
+}
+
+DEBUG13(fprintf(stderr, " dfa %s (%d positions)\n", sd->dfa_ok ? "built" : "not used", sd->dfa_ok ? sd->dfa->npos : 0);)
+
+} /* dfa_setup() */
+
+/***********************************************************************
+*
+*  dfa_build - Turn a compiled expression into DFA positions
+*
+*  PURPOSE:  Walks the output of compile() and makes one position per
+*            character, '.' or [] in the expression.  A '*' makes the
+*            position DFA_STAR.  \{m,n\} is expanded to m DFA_ONCE
+*            positions followed by n-m DFA_OPT positions, or a DFA_STAR
+*            position when there is no upper limit.  The character sets
+*            follow advance(), '\0' is never matched.
+*
+*  PARAMETERS:
+*
+*     dfa      -  (OUTPUT) The DFA to build.
+*     ep       -  (INPUT)  The compiled expression.
+*     anchored -  (INPUT)  The expression started with '^' (circf).
+*
+*  FUNCTIONS:
+*
+*     1.  Returns True if the DFA can be used for this expression.
+*
+***********************************************************************/
+
+static int dfa_build(RE_DFA *dfa, char *ep, int anchored)
+{
+unsigned char  set[32];
+int            op;
+int            c;
+int            i;
+int            low;
+int            high;
+
+dfa->npos = 0;
+dfa->anchored = anchored;
+dfa->dollar = 0;
+dfa->nstates = 0;
+dfa->flushes = 0;
+dfa->start[0] = dfa->start[1] = -1;
+
+while(1){
+    op = *ep++ & 0377;
+    switch(op){
+    case CCEOF:
+        return(True);
+
+    case CDOL:
+        if (*ep != CCEOF)
+            return(False);
+        dfa->dollar = True;
+        continue;
+
+    case CBRA:
+    case CKET:
+        ep++;
+        continue;
+    }
+
+    memset((char *)set, 0, sizeof(set));
+    switch(op & ~RNGE){
+    case CCHR:
+        c = *ep++ & 0377;
+        set[c >> 3] |= bittab[c & 07];
+        break;
+
+    case CICHR:
+        c = *ep++ & 0377;
+        set[c >> 3] |= bittab[c & 07];
+        c &= ~040;
+        set[c >> 3] |= bittab[c & 07];
+        break;
+
+    case CDOT:
+        for (c = 1; c < 256; c++)
+            set[c >> 3] |= bittab[c & 07];
+        break;
+
+    case CCL:
+        for (c = 1; c < 0200; c++)
+            if (ISTHERE(c))
+                set[c >> 3] |= bittab[c & 07];
+        ep += 16;
+        break;
+
+    case NCCL:
+        for (c = 1; c < 256; c++)
+            if ((c & 0200) || !ISTHERE(c))
+                set[c >> 3] |= bittab[c & 07];
+        ep += 16;
+        break;
+
+    case CXCL:
+        for (c = 1; c < 256; c++)
+            if (ISTHERE(c))
+                set[c >> 3] |= bittab[c & 07];
+        ep += 32;
+        break;
+
+    default: /* CBACK and anything new */
+        return(False);
+    }
+
+    if ((op & RNGE) == RNGE){
+        low = *ep++ & 0377;
+        high = *ep++ & 0377;   /* 255 means no upper limit */
+    }else if (op & STAR){
+        low = 0;
+        high = 255;
+    }else
+        low = high = 1;
+
+    for (i = 0; i < low + ((high == 255) ? 1 : high - low); i++){
+        if (dfa->npos >= DFA_MAX_POS-1)
+            return(False);
+        memcpy((char *)dfa->pos[dfa->npos].set, (char *)set, sizeof(set));
+        dfa->pos[dfa->npos++].repeat = (i < low) ? DFA_ONCE : ((high == 255) ? DFA_STAR : DFA_OPT);
+    }
+}
+
+} /* dfa_build() */
+
+/***********************************************************************
+*
+*  dfa_close - Add a position to a state along with the DFA_STAR and
+*              DFA_OPT positions which may be skipped after it
+*
+***********************************************************************/
+
+static void dfa_close(RE_DFA *dfa, unsigned int *pos, int i)
+{
+
+DFA_SET(pos, i);
+while ((i < dfa->npos) && (dfa->pos[i].repeat != DFA_ONCE)){
+    i++;
+    DFA_SET(pos, i);
+}
+
+} /* dfa_close() */
+
+/***********************************************************************
+*
+*  dfa_state - Find or add the DFA state for a set of positions
+*
+*  PURPOSE:  Returns the index of the state.  When the cache is full it
+*            is flushed and rebuilt as lines are scanned, so indexes
+*            held by the caller are only good until the next call.
+*
+***********************************************************************/
+
+static int dfa_state(RE_DFA *dfa, unsigned int *pos, int floating)
+{
+DFA_STATE     *st;
+unsigned int   any = 0;
+int            s;
+
+for (s = 0; s < dfa->nstates; s++)
+    if ((dfa->state[s].floating == floating) && !memcmp((char *)dfa->state[s].pos, (char *)pos, sizeof(st->pos)))
+        return(s);
+
+if (dfa->nstates >= DFA_MAX_STATES){
+    DEBUG13(fprintf(stderr, " dfa cache flushed\n");)
+    dfa->nstates = 0;
+    dfa->start[0] = dfa->start[1] = -1;
+    dfa->flushes++;
+}
+
+st = &dfa->state[dfa->nstates];
+memcpy((char *)st->pos, (char *)pos, sizeof(st->pos));
+for (s = 0; s < DFA_WORDS; s++)
+    any |= pos[s];
+st->floating = floating;
+st->accept = DFA_ISSET(pos, dfa->npos) != 0;
+st->dead = !any && !floating;
+for (s = 0; s < 256; s++)
+    st->next[s] = DFA_UNKNOWN;
+
+return(dfa->nstates++);
+
+} /* dfa_state() */
+
+/***********************************************************************
+*
+*  dfa_next - Build the transition out of state s on character c
+*
+***********************************************************************/
+
+static int dfa_next(RE_DFA *dfa, int s, int c)
+{
+unsigned int   pos[DFA_WORDS];
+int            floating = dfa->state[s].floating;
+int            flushes = dfa->flushes;
+int            i;
+int            n;
+
+memset((char *)pos, 0, sizeof(pos));
+for (i = 0; i < dfa->npos; i++)
+    if (DFA_ISSET(dfa->state[s].pos, i) && (dfa->pos[i].set[c >> 3] & bittab[c & 07]))
+        dfa_close(dfa, pos, (dfa->pos[i].repeat == DFA_STAR) ? i : i+1);
+
+if (floating)
+    dfa_close(dfa, pos, 0);
+
+n = dfa_state(dfa, pos, floating);
+if (dfa->flushes == flushes)
+    dfa->state[s].next[c] = n;
+
+return(n);
+
+} /* dfa_next() */
+
+/***********************************************************************
+*
+*  dfa_run - Run the DFA over a line
+*
+*  PURPOSE:  A floating run finds whether a match starts anywhere in
+*            the line, an anchored run whether one starts at the first
+*            character.  This is a single pass over the line.
+*
+*  PARAMETERS:
+*
+*     dfa      -  (INPUT/OUTPUT) The DFA, states are added as needed.
+*     line     -  (INPUT) The null terminated line.
+*     floating -  (INPUT) True for a floating run.
+*
+*  FUNCTIONS:
+*
+*     1.  Returns the offset at which the first match ends, or -1
+*         if there is no match.
+*
+***********************************************************************/
+
+static int dfa_run(RE_DFA *dfa, char *line, int floating)
+{
+unsigned int   pos[DFA_WORDS];
+unsigned char *p = (unsigned char *)line;
+DFA_STATE     *st;
+int            s;
+int            c;
+
+if ((s = dfa->start[floating]) < 0){
+    memset((char *)pos, 0, sizeof(pos));
+    dfa_close(dfa, pos, 0);
+    s = dfa_state(dfa, pos, floating);
+    dfa->start[floating] = s;
+}
+
+while(1){
+    st = &dfa->state[s];
+    if (st->accept && (!dfa->dollar || !*p))
+        return(p - (unsigned char *)line);
+    if (st->dead || !(c = *p++))
+        return(-1);
+    if ((s = st->next[c]) == DFA_UNKNOWN)
+        s = dfa_next(dfa, st - dfa->state, c);
+}
+
+} /* dfa_run() */
+
+/***********************************************************************
+*
+*  dfa_reverse - Make the DFA which runs back from the end of a line
+*
+*  PURPOSE:  The positions are one after the other, so the same
+*            positions in reverse order match the expression spelled
+*            backwards.  A '$' at the end becomes an anchor at the end
+*            of the line, where the reversed run starts.
+*
+*  PARAMETERS:
+*
+*     rdfa  -  (OUTPUT) The reversed DFA.
+*     dfa   -  (INPUT)  The DFA built by dfa_build.
+*
+***********************************************************************/
+
+static void dfa_reverse(RE_DFA *rdfa, RE_DFA *dfa)
+{
+int            i;
+
+rdfa->npos = dfa->npos;
+rdfa->anchored = dfa->dollar;
+rdfa->dollar = 0;
+rdfa->nstates = 0;
+rdfa->flushes = 0;
+rdfa->start[0] = rdfa->start[1] = -1;
+
+for (i = 0; i < dfa->npos; i++)
+    rdfa->pos[i] = dfa->pos[dfa->npos - 1 - i];
+
+} /* dfa_reverse() */
+
+/***********************************************************************
+*
+*  dfa_first - Run the reversed DFA to find where the first match starts
+*
+*  PURPOSE:  The reversed DFA is run floating from the end of the line
+*            back to the front, or anchored at the end for a '$'.  It
+*            accepts at every column where a match starts, so the last
+*            column it accepts at is the first match.  This is a single
+*            pass over the line.
+*
+*  PARAMETERS:
+*
+*     rdfa  -  (INPUT/OUTPUT) The reversed DFA, states are added as needed.
+*     line  -  (INPUT) The null terminated line.
+*
+*  FUNCTIONS:
+*
+*     1.  Returns the column the first match starts in, or -1 if
+*         there is no match.
+*
+***********************************************************************/
+
+static int dfa_first(RE_DFA *rdfa, char *line)
+{
+unsigned int   pos[DFA_WORDS];
+unsigned char *p = (unsigned char *)line + strlen(line);
+DFA_STATE     *st;
+int            floating = !rdfa->anchored;
+int            first = -1;
+int            s;
+int            c;
+
+if ((s = rdfa->start[floating]) < 0){
+    memset((char *)pos, 0, sizeof(pos));
+    dfa_close(rdfa, pos, 0);
+    s = dfa_state(rdfa, pos, floating);
+    rdfa->start[floating] = s;
+}
+
+while(1){
+    st = &rdfa->state[s];
+    if (st->accept)
+        first = p - (unsigned char *)line;
+    if (st->dead || (p == (unsigned char *)line))
+        return(first);
+    c = *--p;
+    if ((s = st->next[c]) == DFA_UNKNOWN)
+        s = dfa_next(rdfa, st - rdfa->state, c);
+}
+
+} /* dfa_first() */
+
+/***********************************************************************
+*
+*  dfa_step - step() which lets the DFA reject lines first
+*
+*  PURPOSE:  When the DFA applies, lines with no match are rejected in
+*            a single pass.  On a match step() is called at the column
+*            the first match starts in, where its first advance()
+*            succeeds, so loc1, loc2 and the \( \) brackets come out as
+*            before.  For a ^ expression that is the first column, for
+*            others dfa_first finds it in one pass back over the line.
+*
+*  PARAMETERS:
+*
+*     p1   -  (INPUT) The string to search.
+*     expr -  (INPUT) The compiled expression.
+*
+*  FUNCTIONS:
+*
+*     1.  Returns what step() returns.
+*
+***********************************************************************/
+
+static int dfa_step(char *p1, char *expr)
+{
+RE_DFA  *dfa = sd->dfa;
+int      first;
+
+if (!sd->dfa_ok || (expr != sd->expression) || (circf != dfa->anchored))
+    return(step(p1, expr));
+
+if (circf)
+    first = (dfa_run(dfa, p1, False) < 0) ? -1 : 0;
+else
+    first = dfa_first(sd->rdfa, p1);
+
+if (first < 0)
+    return(0);
+
+return(step(p1 + first, expr));
+
+} /* dfa_step() */
+
 #ifdef DebuG
 /***********************************************************************
 *
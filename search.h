@@ -90,6 +90,35 @@ void process_inserted_newlines(DATA_TOKEN *token,       /* input */
                                        int *row,        /* input/output */
                                        int *column);    /* input/output */
 
+void *line_matcher(void *sdata, int case_insensitive);
+
+int   line_may_match(void *matcher, char *line);
+
+void  free_line_matcher(void *matcher);
+
+void  free_search_data(void **sdata);
+
+unsigned int pattern_generation(void *sdata);
+
+int   line_match_cols(void    *sdata,
+                      char    *line,
+                      short   *cols,
+                      int      max_matches);
+
+int   subs_line_ok(void    *sdata);
+
+int   subs_line(DATA_TOKEN *token,
+                void       *sdata,
+                int         lineno,
+                char       *line,
+                int         so,
+                char       *out,
+                int        *last_col);
+
+int   required_text(void    *sdata,
+                    char    *runs,
+                    int      size);
+
 int a_to_re(char *t, int replace); 
 
 void compile_error(int rc);
@@ -1395,6 +1395,7 @@ case DM_cv:
 case DM_cc:
 case DM_ceterm:
 case DM_cp:
+case DM_fcnt:
    *((*buff)++) = dmc->cv.argc;
    for (i = 0; i < dmc->cv.argc; i++)
    {
@@ -1493,6 +1494,7 @@ case DM_dq:
 ***************************************************************/
 
 case DM_echo:
+case DM_ifind:
    *((*buff)++) = dmc->echo.dash_r;
    break;
 
@@ -2340,6 +2342,7 @@ case DM_cv:
 case DM_cc:
 case DM_ceterm:
 case DM_cp:
+case DM_fcnt:
    /* the argc */
    def_len++;
    for (i = 0; i < dmc->cv.argc; i++)
@@ -2415,6 +2418,7 @@ case DM_dq:
 ***************************************************************/
 
 case DM_echo:
+case DM_ifind:
    def_len++;
    break;
 
@@ -3182,6 +3186,7 @@ case DM_cv:
 case DM_cc:
 case DM_ceterm:
 case DM_cp:
+case DM_fcnt:
    dmc->cv.argc   = *((*buff)++);
 
    dmc->cv.argv = (char **)CE_MALLOC((dmc->cv.argc + 1) * sizeof(var_part_start));
@@ -3305,6 +3310,7 @@ case DM_dq:
 ***************************************************************/
 
 case DM_echo:
+case DM_ifind:
    dmc->echo.dash_r = *((*buff)++);
    break;
 
@@ -0,0 +1,841 @@
+/*static char *sccsid = "%Z% %M% %I% - %G% %U% ";*/
+/***************************************************************
+*
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in shmdraw.c
+*     shm_begin_text          - Start drawing a band of text lines into shared memory
+*     shm_draw_string         - Draw a string into the shared memory band
+*     shm_end_text            - Copy the shared memory band to the pixmap
+*     free_shm_data           - Free the shared memory drawing data for a display
+*
+*  Internal routines:
+*     get_shm_data            - Get the shared memory data for a display, allocating it if needed
+*     create_shm_image        - Create the shared memory XImage and attach it to the server
+*     release_shm_image       - Detach and free the shared memory XImage
+*     shm_attach_error        - Error handler used while attaching the segment
+*     build_glyph_cache       - Get the font bitmaps from the server
+*     wait_for_put            - Make sure the server is done with the image
+*
+*  When the -shm option is on and the display is on the local
+*  machine, textfill_drawable draws large repaints of the main
+*  window into a shared memory XImage instead of sending text
+*  requests to the server.  The glyphs come from a client side
+*  cache built once per font from the server's bitmaps.  The
+*  whole band is then copied to the pixmap with one XShmPutImage.
+*  If the MIT-SHM extension is missing, the display is remote, or
+*  anything fails while setting up, the normal core protocol
+*  drawing is used.
+*
+***************************************************************/
+
+#include <stdio.h>          /* /usr/include/stdio.h      */
+#include <string.h>         /* /usr/include/string.h     */
+
+#ifdef HAVE_XSHM
+#include <sys/types.h>      /* /usr/include/sys/types.h  */
+#include <sys/ipc.h>        /* /usr/include/sys/ipc.h    */
+#include <sys/shm.h>        /* /usr/include/sys/shm.h    */
+#include <X11/Xlib.h>       /* /usr/include/X11/Xlib.h   */
+#include <X11/Xutil.h>      /* /usr/include/X11/Xutil.h  */
+#include <X11/extensions/XShm.h>   /* /usr/include/X11/extensions/XShm.h */
+#endif
+
+#include "debug.h"
+#include "emalloc.h"
+#include "parms.h"
+#include "shmdraw.h"
+#include "xerrorpos.h"
+#include "xutil.h"
+
+
+#ifdef HAVE_XSHM
+
+/***************************************************************
+*
+*  Repaints smaller than this many lines are left to the core
+*  protocol.  They are cheap and waiting for the server to let
+*  go of the image would cost more than it saves.
+*
+***************************************************************/
+
+#define SHM_MIN_LINES     4
+
+/***************************************************************
+*
+*  Minor opcode of XShmAttach.  This is X_ShmAttach from
+*  shmproto.h, which cannot be included without the server
+*  protocol headers.
+*
+***************************************************************/
+
+#define SHM_ATTACH_REQUEST  1
+
+/***************************************************************
+*
+*  The glyph cache is the font bitmaps from get_font_glyphs plus
+*  the box in each cell which has ink, so blank space is skipped.
+*
+***************************************************************/
+
+typedef struct {
+   short          ink_x;           /* box in the cell which has bits set       */
+   short          ink_y;
+   short          ink_width;       /* zero for chars with no ink, like blank   */
+   short          ink_height;
+} SHM_GLYPH;
+
+typedef struct {
+   int              disabled;      /* True once we know shared memory cannot be used */
+   XShmSegmentInfo  shminfo;       /* segment attached to the server           */
+   XImage          *image;         /* shared memory image, NULL till needed    */
+   int              fast32;        /* True if pixels can be stored as 32 bit ints */
+   GC               put_gc;        /* plain GC used for XShmPutImage           */
+   unsigned long    put_serial;    /* request number of the last XShmPutImage  */
+   Font             fid;           /* font the glyph cache was built from      */
+   Font             bad_fid;       /* font which cannot be cached, two byte fonts */
+   FONT_GLYPHS      glyphs;        /* font bitmaps, glyphs.bits NULL till built */
+   SHM_GLYPH        glyph[FONT_GLYPH_COUNT];
+   int              band_active;   /* True between shm_begin_text and shm_end_text */
+   Drawable         band_drawable; /* pixmap the band is copied to             */
+   int              band_x;        /* area of the pixmap covered by the band   */
+   int              band_y;
+   int              band_width;
+   int              band_height;
+   unsigned long    fg_pixel;      /* colors from the window gc's              */
+   unsigned long    bg_pixel;
+   int              puts;          /* number of bands copied to the server     */
+   int              waits;         /* number of times we had to wait for the server */
+} SHM_DATA;
+
+
+/***************************************************************
+*
+*  Set by shm_attach_error when the server rejects XShmAttach.
+*
+***************************************************************/
+
+static int            shm_attach_failed;
+static int            shm_major_opcode;
+static int          (*prev_error_handler)(Display *, XErrorEvent *);
+
+
+/***************************************************************
+*
+*  Local prototypes
+*
+***************************************************************/
+
+static SHM_DATA *get_shm_data(DISPLAY_DESCR   *dspl_descr);
+
+static int  create_shm_image(DISPLAY_DESCR   *dspl_descr,
+                             SHM_DATA        *shm,
+                             Drawable         drawable,
+                             int              width,
+                             int              height);
+
+static void release_shm_image(Display         *display,
+                              SHM_DATA        *shm);
+
+static int  shm_attach_error(Display         *display,
+                             XErrorEvent     *err_event);
+
+static int  build_glyph_cache(Display         *display,
+                              Drawable         drawable,
+                              XFontStruct     *font,
+                              SHM_DATA        *shm);
+
+static void wait_for_put(Display         *display,
+                         SHM_DATA        *shm);
+
+#endif
+
+
+/************************************************************************
+
+NAME:      shm_begin_text - Start drawing a band of text lines into shared memory
+
+PURPOSE:    This routine checks whether a repaint of a pad can be drawn
+            in the shared memory image and, if so, prepares the band.
+            The band is filled with the background color, so the caller
+            does not need to clear the area.
+
+PARAMETERS:
+
+   1.  pad   - pointer to PAD_DESCR (INPUT)
+               This is the pad being drawn.  Only the main pad is done
+               in shared memory.
+
+   2.  x     - int (INPUT)
+               This is the left side of the area in the pixmap.
+
+   3.  y     - int (INPUT)
+               This is the top of the area in the pixmap.
+
+   4.  width - int (INPUT)
+               This is the width of the area in pixels.
+
+   5.  height - int (INPUT)
+               This is the height of the area in pixels.
+
+FUNCTIONS :
+
+   1.   Make sure the -shm option is on and the pad only uses the
+        window gc.
+
+   2.   Create the shared memory image and glyph cache if needed.
+
+   3.   Wait for the server to finish with the last band.
+
+   4.   Fill the band with the background color.
+
+RETURNED VALUE:
+   started  -  int
+               True  - The band is ready, use shm_draw_string and shm_end_text
+               False - Use the normal drawing routines
+
+*************************************************************************/
+
+int  shm_begin_text(PAD_DESCR       *pad,               /* input  */
+                    int              x,                 /* input  */
+                    int              y,                 /* input  */
+                    int              width,             /* input  */
+                    int              height)            /* input  */
+{
+#ifdef HAVE_XSHM
+DISPLAY_DESCR        *dspl_descr = pad->display_data;
+Display              *display    = dspl_descr->display;
+XFontStruct          *font       = pad->pix_window->font;
+SHM_DATA             *shm;
+XGCValues             gcvalues;
+XImage               *image;
+char                 *row;
+int                   i;
+int                   row_bytes;
+
+if (!SHMDRAW || (pad != dspl_descr->main_pad) || (dspl_descr->x_pixmap == None))
+   return(False);
+
+/***************************************************************
+*  Colored pads and vt100 mode draw with more than one gc.
+***************************************************************/
+if (dspl_descr->vt100_mode || COLORED(pad->token))
+   return(False);
+
+if (x < 0)
+   {
+      width += x;
+      x = 0;
+   }
+if ((width <= 0) || (height < SHM_MIN_LINES * pad->pix_window->line_height))
+   return(False);
+
+shm = get_shm_data(dspl_descr);
+if (!shm || shm->disabled || (font->fid == shm->bad_fid))
+   return(False);
+
+/***************************************************************
+*  Get an image big enough for the band.
+***************************************************************/
+if (!shm->image || (shm->image->width < width) || (shm->image->height < height))
+   if (!create_shm_image(dspl_descr, shm, dspl_descr->x_pixmap,
+                         (shm->image && (shm->image->width > width)) ? shm->image->width : width,
+                         (shm->image && (shm->image->height > height)) ? shm->image->height : height))
+      {
+         shm->disabled = True;
+         DEBUG12(fprintf(stderr, "shm_begin_text:  Shared memory drawing not available, using core requests\n");)
+         return(False);
+      }
+
+if (shm->fid != font->fid)
+   if (!build_glyph_cache(display, dspl_descr->x_pixmap, font, shm))
+      {
+         shm->bad_fid = font->fid;
+         DEBUG12(fprintf(stderr, "shm_begin_text:  Cannot cache font 0x%lX, using core requests\n", font->fid);)
+         return(False);
+      }
+
+/***************************************************************
+*  Colors come from the gc's the core requests would have used.
+*  Xlib keeps the values, so this is not a round trip.
+***************************************************************/
+DEBUG9(XERRORPOS)
+if (!XGetGCValues(display, pad->pix_window->gc, GCForeground, &gcvalues))
+   return(False);
+shm->fg_pixel = gcvalues.foreground;
+DEBUG9(XERRORPOS)
+if (!XGetGCValues(display, pad->pix_window->reverse_gc, GCForeground, &gcvalues))
+   return(False);
+shm->bg_pixel = gcvalues.foreground;
+
+/***************************************************************
+*  The server may still be reading the last band.
+***************************************************************/
+wait_for_put(display, shm);
+
+/***************************************************************
+*  Fill the band with the background.  Do one row and copy it.
+***************************************************************/
+image = shm->image;
+row = image->data;
+if (shm->fast32)
+   for (i = 0; i < width; i++)
+      ((unsigned int *)row)[i] = (unsigned int)shm->bg_pixel;
+else
+   for (i = 0; i < width; i++)
+      XPutPixel(image, i, 0, shm->bg_pixel);
+
+row_bytes = (width * image->bits_per_pixel) / 8;
+for (i = 1; i < height; i++)
+   memcpy(image->data + (i * image->bytes_per_line), row, row_bytes);
+
+shm->band_active   = True;
+shm->band_drawable = dspl_descr->x_pixmap;
+shm->band_x        = x;
+shm->band_y        = y;
+shm->band_width    = width;
+shm->band_height   = height;
+
+return(True);
+#else
+return(False);
+#endif
+
+} /* end of shm_begin_text */
+
+
+/************************************************************************
+
+NAME:      shm_draw_string - Draw a string into the shared memory band
+
+PURPOSE:    This routine is the shared memory version of XDrawString
+            using the window gc.  The glyphs come from the glyph cache.
+
+PARAMETERS:
+
+   1.  pad   - pointer to PAD_DESCR (INPUT)
+               This is the pad being drawn.
+
+   2.  x     - int (INPUT)
+               This is the x coordinate of the string in the pixmap.
+
+   3.  y     - int (INPUT)
+               This is the baseline of the string in the pixmap.
+
+   4.  text  - pointer to char (INPUT)
+               This is the string to draw.  It need not be null terminated.
+
+   5.  len   - int (INPUT)
+               This is the number of chars to draw.
+
+FUNCTIONS :
+
+   1.   Walk the string, copying the ink of each glyph into the band.
+
+*************************************************************************/
+
+void shm_draw_string(PAD_DESCR       *pad,               /* input  */
+                     int              x,                 /* input  */
+                     int              y,                 /* input  */
+                     char            *text,              /* input  */
+                     int              len)               /* input  */
+{
+#ifdef HAVE_XSHM
+SHM_DATA             *shm = (SHM_DATA *)pad->display_data->shm_data;
+XImage               *image;
+SHM_GLYPH            *glyph;
+unsigned char        *bits;
+unsigned int         *pixel_row;
+int                   pen_x;
+int                   cell_top;
+int                   gx;
+int                   gy;
+int                   px;
+int                   py;
+int                   i;
+
+if (!shm || !shm->band_active)
+   return;
+
+image    = shm->image;
+pen_x    = x - shm->band_x;
+cell_top = y - shm->band_y - shm->glyphs.origin_y;
+
+for (i = 0; i < len && pen_x < shm->band_width; i++)
+{
+   glyph = &shm->glyph[(unsigned char)text[i]];
+   if (glyph->ink_width)
+      {
+         bits = shm->glyphs.bits + ((unsigned char)text[i] * shm->glyphs.cell_width * shm->glyphs.cell_height);
+         for (gy = glyph->ink_y; gy < glyph->ink_y + glyph->ink_height; gy++)
+         {
+            py = cell_top + gy;
+            if ((py < 0) || (py >= shm->band_height))
+               continue;
+            pixel_row = (unsigned int *)(image->data + (py * image->bytes_per_line));
+            for (gx = glyph->ink_x; gx < glyph->ink_x + glyph->ink_width; gx++)
+            {
+               if (!bits[(gy * shm->glyphs.cell_width) + gx])
+                  continue;
+               px = pen_x - shm->glyphs.origin_x + gx;
+               if ((px < 0) || (px >= shm->band_width))
+                  continue;
+               if (shm->fast32)
+                  pixel_row[px] = (unsigned int)shm->fg_pixel;
+               else
+                  XPutPixel(image, px, py, shm->fg_pixel);
+            }
+         }
+      }
+   pen_x += shm->glyphs.advance[(unsigned char)text[i]];
+}
+#endif
+
+} /* end of shm_draw_string */
+
+
+/************************************************************************
+
+NAME:      shm_end_text - Copy the shared memory band to the pixmap
+
+PURPOSE:    This routine sends the band drawn since shm_begin_text
+            to the pixmap with one XShmPutImage.
+
+PARAMETERS:
+
+   1.  pad   - pointer to PAD_DESCR (INPUT)
+               This is the pad being drawn.
+
+FUNCTIONS :
+
+   1.   Put the image and remember the request number so the next
+        band can tell when the server is done with it.
+
+*************************************************************************/
+
+void shm_end_text(PAD_DESCR       *pad)                 /* input  */
+{
+#ifdef HAVE_XSHM
+SHM_DATA             *shm = (SHM_DATA *)pad->display_data->shm_data;
+Display              *display = pad->display_data->display;
+
+if (!shm || !shm->band_active)
+   return;
+
+shm->put_serial = NextRequest(display);
+DEBUG9(XERRORPOS)
+XShmPutImage(display, shm->band_drawable, shm->put_gc, shm->image,
+             0, 0,
+             shm->band_x, shm->band_y,
+             shm->band_width, shm->band_height,
+             False);
+shm->band_active = False;
+shm->puts++;
+
+DEBUG12(fprintf(stderr, "shm_end_text:  put %dx%d+%d+%d, %d puts, %d waits\n",
+                shm->band_width, shm->band_height, shm->band_x, shm->band_y, shm->puts, shm->waits);
+)
+#endif
+
+} /* end of shm_end_text */
+
+
+/************************************************************************
+
+NAME:      free_shm_data - Free the shared memory drawing data for a display
+
+PURPOSE:    This routine releases the shared memory segment and glyph
+            cache hung off a display.  It is called after the display
+            is closed, so no X calls are made.  The server lets go of
+            the segment when the connection closes.
+
+PARAMETERS:
+
+   1.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT / OUTPUT)
+                        This is the display whose data is to be freed.
+
+FUNCTIONS :
+
+   1.   Detach the segment and free the image and the glyph bits.
+
+*************************************************************************/
+
+void free_shm_data(DISPLAY_DESCR   *dspl_descr)         /* input  */
+{
+#ifdef HAVE_XSHM
+SHM_DATA             *shm = (SHM_DATA *)dspl_descr->shm_data;
+
+if (!shm)
+   return;
+
+if (shm->image)
+   {
+      shmdt(shm->shminfo.shmaddr);
+      shm->image->data = NULL;
+      XDestroyImage(shm->image);
+   }
+if (shm->glyphs.bits)
+   free((char *)shm->glyphs.bits);
+free((char *)shm);
+#endif
+dspl_descr->shm_data = NULL;
+
+} /* end of free_shm_data */
+
+
+#ifdef HAVE_XSHM
+/************************************************************************
+
+NAME:      get_shm_data - Get the shared memory data for a display, allocating it if needed
+
+*************************************************************************/
+
+static SHM_DATA *get_shm_data(DISPLAY_DESCR   *dspl_descr)
+{
+SHM_DATA             *shm = (SHM_DATA *)dspl_descr->shm_data;
+
+if (!shm)
+   {
+      shm = (SHM_DATA *)CE_MALLOC(sizeof(SHM_DATA));
+      if (!shm)
+         return(NULL);
+      memset((char *)shm, 0, sizeof(SHM_DATA));
+      shm->fid     = None;
+      shm->bad_fid = None;
+      dspl_descr->shm_data = (void *)shm;
+   }
+
+return(shm);
+
+} /* end of get_shm_data */
+
+
+/************************************************************************
+
+NAME:      create_shm_image - Create the shared memory XImage and attach it to the server
+
+PURPOSE:    This routine gets a shared memory segment big enough for
+            the requested band and attaches it to the server.  Any
+            old image is released first.
+
+PARAMETERS:
+
+   1.  dspl_descr - pointer to DISPLAY_DESCR (INPUT)
+                    This is the display to draw on.
+
+   2.  shm        - pointer to SHM_DATA (INPUT / OUTPUT)
+                    This is the shared memory data for the display.
+
+   3.  drawable   - Drawable (INPUT)
+                    This is the pixmap the image will be put to.
+
+   4.  width      - int (INPUT)
+   5.  height     - int (INPUT)
+                    This is the size of the image.
+
+FUNCTIONS :
+
+   1.   Make sure the display is local and has MIT-SHM.
+
+   2.   Create the image, get the segment, and attach it.
+
+   3.   Mark the segment for removal so it goes away when we exit.
+
+RETURNED VALUE:
+   ok  -  int
+          True  - The image is ready
+          False - Shared memory cannot be used on this display
+
+*************************************************************************/
+
+static int  create_shm_image(DISPLAY_DESCR   *dspl_descr,
+                             SHM_DATA        *shm,
+                             Drawable         drawable,
+                             int              width,
+                             int              height)
+{
+Display              *display = dspl_descr->display;
+int                   screen  = DefaultScreen(display);
+XImage               *image;
+int                   first_event;
+int                   first_error;
+int                   endian_test = 1;
+
+/***************************************************************
+*  display_host_name is the null string for displays on this
+*  machine.  Remote servers cannot see our memory.
+***************************************************************/
+if (dspl_descr->display_host_name[0] != '\0')
+   return(False);
+
+DEBUG9(XERRORPOS)
+if (!XQueryExtension(display, "MIT-SHM", &shm_major_opcode, &first_event, &first_error))
+   return(False);
+
+if (shm->image)
+   release_shm_image(display, shm);
+
+DEBUG9(XERRORPOS)
+image = XShmCreateImage(display, DefaultVisual(display, screen), DefaultDepth(display, screen),
+                        ZPixmap, NULL, &shm->shminfo, width, height);
+if (!image)
+   return(False);
+
+/***************************************************************
+*  We copy whole rows with memcpy, so pixels must be whole bytes.
+***************************************************************/
+if (image->bits_per_pixel < 8)
+   {
+      XDestroyImage(image);
+      return(False);
+   }
+
+shm->shminfo.shmid = shmget(IPC_PRIVATE, image->bytes_per_line * image->height, IPC_CREAT | 0600);
+if (shm->shminfo.shmid < 0)
+   {
+      XDestroyImage(image);
+      return(False);
+   }
+
+shm->shminfo.shmaddr = image->data = (char *)shmat(shm->shminfo.shmid, NULL, 0);
+if (shm->shminfo.shmaddr == (char *)-1)
+   {
+      shmctl(shm->shminfo.shmid, IPC_RMID, NULL);
+      image->data = NULL;
+      XDestroyImage(image);
+      return(False);
+   }
+shm->shminfo.readOnly = False;
+
+/***************************************************************
+*  The attach fails with an X error if the server cannot get at
+*  the segment.  Catch it instead of letting ce_xerror report it.
+***************************************************************/
+shm_attach_failed = False;
+prev_error_handler = XSetErrorHandler(shm_attach_error);
+DEBUG9(XERRORPOS)
+XShmAttach(display, &shm->shminfo);
+XSync(display, False);
+XSetErrorHandler(prev_error_handler);
+
+shmctl(shm->shminfo.shmid, IPC_RMID, NULL);
+
+if (shm_attach_failed)
+   {
+      shmdt(shm->shminfo.shmaddr);
+      image->data = NULL;
+      XDestroyImage(image);
+      return(False);
+   }
+
+if (shm->put_gc == None)
+   {
+      DEBUG9(XERRORPOS)
+      shm->put_gc = XCreateGC(display, drawable, 0L, NULL);
+   }
+
+shm->image      = image;
+shm->put_serial = 0;
+shm->fast32     = (image->bits_per_pixel == 32) &&
+                  (image->byte_order == ((*(char *)&endian_test) ? LSBFirst : MSBFirst));
+
+DEBUG12(fprintf(stderr, "create_shm_image:  %dx%d image, %d bits per pixel, shmid %d\n",
+                width, height, image->bits_per_pixel, shm->shminfo.shmid);
+)
+
+return(True);
+
+} /* end of create_shm_image */
+
+
+/************************************************************************
+
+NAME:      release_shm_image - Detach and free the shared memory XImage
+
+*************************************************************************/
+
+static void release_shm_image(Display         *display,
+                              SHM_DATA        *shm)
+{
+
+wait_for_put(display, shm);
+DEBUG9(XERRORPOS)
+XShmDetach(display, &shm->shminfo);
+shmdt(shm->shminfo.shmaddr);
+shm->image->data = NULL;
+XDestroyImage(shm->image);
+shm->image = NULL;
+
+} /* end of release_shm_image */
+
+
+/************************************************************************
+
+NAME:      shm_attach_error - Error handler used while attaching the segment
+
+PURPOSE:    This routine notes a failed XShmAttach.  Other errors are
+            passed to the normal handler.
+
+*************************************************************************/
+
+static int  shm_attach_error(Display         *display,
+                             XErrorEvent     *err_event)
+{
+
+if ((err_event->request_code == shm_major_opcode) && (err_event->minor_code == SHM_ATTACH_REQUEST))
+   {
+      shm_attach_failed = True;
+      return(0);
+   }
+
+if (prev_error_handler)
+   return((*prev_error_handler)(display, err_event));
+else
+   return(0);
+
+} /* end of shm_attach_error */
+
+
+/************************************************************************
+
+NAME:      build_glyph_cache - Get the font bitmaps from the server
+
+PURPOSE:    This routine builds the client side copy of the glyphs in
+            a font with get_font_glyphs and finds the box in each cell
+            which has ink in it.
+
+PARAMETERS:
+
+   1.  display    - pointer to Display (INPUT)
+                    This is the display the font is on.
+
+   2.  drawable   - Drawable (INPUT)
+                    This is any drawable on the screen.
+
+   3.  font       - pointer to XFontStruct (INPUT)
+                    This is the font to cache.
+
+   4.  shm        - pointer to SHM_DATA (INPUT / OUTPUT)
+                    The glyph cache is kept here.
+
+RETURNED VALUE:
+   ok  -  int
+          True  - The glyph cache is built
+          False - The font cannot be cached
+
+*************************************************************************/
+
+static int  build_glyph_cache(Display         *display,
+                              Drawable         drawable,
+                              XFontStruct     *font,
+                              SHM_DATA        *shm)
+{
+unsigned char        *bits;
+SHM_GLYPH            *glyph;
+int                   c;
+int                   gx;
+int                   gy;
+int                   min_x;
+int                   max_x;
+int                   min_y;
+int                   max_y;
+
+if (shm->glyphs.bits)
+   free((char *)shm->glyphs.bits);
+shm->fid = None;
+
+if (!get_font_glyphs(display, drawable, font, &shm->glyphs))
+   return(False);
+
+for (c = 0; c < FONT_GLYPH_COUNT; c++)
+{
+   glyph = &shm->glyph[c];
+   bits  = shm->glyphs.bits + (c * shm->glyphs.cell_width * shm->glyphs.cell_height);
+   min_x = shm->glyphs.cell_width;
+   min_y = shm->glyphs.cell_height;
+   max_x = -1;
+   max_y = -1;
+
+   for (gy = 0; gy < shm->glyphs.cell_height; gy++)
+      for (gx = 0; gx < shm->glyphs.cell_width; gx++)
+         if (*bits++)
+            {
+               if (gx < min_x) min_x = gx;
+               if (gx > max_x) max_x = gx;
+               if (gy < min_y) min_y = gy;
+               if (gy > max_y) max_y = gy;
+            }
+
+   if (max_x < 0)
+      {
+         glyph->ink_x      = 0;
+         glyph->ink_y      = 0;
+         glyph->ink_width  = 0;
+         glyph->ink_height = 0;
+      }
+   else
+      {
+         glyph->ink_x      = min_x;
+         glyph->ink_y      = min_y;
+         glyph->ink_width  = (max_x - min_x) + 1;
+         glyph->ink_height = (max_y - min_y) + 1;
+      }
+}
+
+shm->fid = font->fid;
+return(True);
+
+} /* end of build_glyph_cache */
+
+
+/************************************************************************
+
+NAME:      wait_for_put - Make sure the server is done with the image
+
+PURPOSE:    XShmPutImage reads the segment when the server gets to the
+            request.  We cannot draw into the image again till it has.
+            Usually the reply to some later request has already shown
+            the put was processed and no wait is needed.
+
+*************************************************************************/
+
+static void wait_for_put(Display         *display,
+                         SHM_DATA        *shm)
+{
+
+if (shm->put_serial && (LastKnownRequestProcessed(display) < shm->put_serial))
+   {
+      DEBUG9(XERRORPOS)
+      XSync(display, False);
+      shm->waits++;
+   }
+shm->put_serial = 0;
+
+} /* end of wait_for_put */
+
+#endif
+
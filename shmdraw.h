@@ -0,0 +1,66 @@
+#ifndef _SHMDRAW_INCLUDED
+#define _SHMDRAW_INCLUDED
+
+/* "%Z% %M% %I% - %G% %U% " */
+
+/***************************************************************
+*  
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*  
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*  
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*  
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*  
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*  
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in shmdraw.c
+*     shm_begin_text          - Start drawing a band of text lines into shared memory
+*     shm_draw_string         - Draw a string into the shared memory band
+*     shm_end_text            - Copy the shared memory band to the pixmap
+*     free_shm_data           - Free the shared memory drawing data for a display
+*
+*  Shared memory drawing is only compiled in when HAVE_XSHM is
+*  defined.  Without it shm_begin_text always returns False and
+*  the core protocol drawing is used.
+*
+***************************************************************/
+
+#include "buffer.h"
+
+int  shm_begin_text(PAD_DESCR       *pad,               /* input  */
+                    int              x,                 /* input  */
+                    int              y,                 /* input  */
+                    int              width,             /* input  */
+                    int              height);           /* input  */
+
+void shm_draw_string(PAD_DESCR       *pad,               /* input  */
+                     int              x,                 /* input  */
+                     int              y,                 /* input  */
+                     char            *text,              /* input  */
+                     int              len);              /* input  */
+
+void shm_end_text(PAD_DESCR       *pad);                 /* input  */
+
+void free_shm_data(DISPLAY_DESCR   *dspl_descr);         /* input  */
+
+
+#endif
+
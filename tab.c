@@ -39,6 +39,7 @@
 *     dm_hex                -   Turn hex mode display on an off.
 *     dm_untab              -   Change tabs to blanks according to the current tab stops.
 *     window_col_to_x_pixel -   Calculate 'x' pixel position for a given window column
+*     tab_stop_generation   -   Return a number which changes each time the tab stops change
 *
 * Internal:
 *     process_char        -   detect and process special characters.
@@ -84,6 +85,12 @@ static DMC_ts   current_ts = {NULL,      /* next pointer      */
                               0,         /* zero stops        */
                               NULL};     /* no tab stop array */
 
+/***************************************************************
+*  Bumped each time the tab stops change.  Anything which saves
+*  expanded lines (the render cache in xutil.c) keys on this.
+***************************************************************/
+static int      ts_generation = 0;
+
 
 
 /************************************************************************
@@ -128,6 +135,7 @@ if (current_ts.stops)
    free((char *)current_ts.stops);
 
 memcpy((char *)&current_ts, (char *)dmc, sizeof(DMC_ts));
+ts_generation++;
 
 
 /***************************************************************
@@ -1321,3 +1329,34 @@ return(redraw_needed);
 } /* end of dm_untab */
 
 
+
+
+/************************************************************************
+
+NAME:      tab_stop_generation - Report changes in the tab stops
+
+PURPOSE:    This routine returns a number which changes each time the
+            tab stops are changed by a ts command.  Routines which save
+            tab expanded copies of lines use it to tell when the saved
+            copies are no good any more.
+
+PARAMETERS:
+
+   none
+
+FUNCTIONS :
+
+   1.  Return the current tab stop generation.
+
+RETURNED VALUE:
+
+   generation  -  int
+                  The current tab stop generation.
+
+*************************************************************************/
+
+int tab_stop_generation(void)
+{
+return(ts_generation);
+} /* end of tab_stop_generation */
+
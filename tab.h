@@ -41,6 +41,7 @@
 *     dm_hex                -   Turn hex mode display on an off.
 *     dm_untab              -   Change tabs to blanks according to the current tab stops.
 *     window_col_to_x_pixel -   Calculate 'x' pixel position for a given window column
+*     tab_stop_generation   -   Return a number which changes each time the tab stops change
 *
 ***************************************************************/
 
@@ -130,6 +131,8 @@ int window_col_to_x_pixel(char         *buff_ptr,
                           XFontStruct  *font,
                           int           hex_mode);
 
+int tab_stop_generation(void);
+
 
 #endif
 
@@ -56,6 +56,10 @@
 
 #include "debug.h"
 #include "dmwin.h"
+#include "journal.h"
+#include "autoimage.h"
+#include "lock.h"
+#include "pw.h"
 #include "sendevnt.h"
 #include "timeout.h"
 #include "xerror.h"         /* needed for CURRENT_TIME */
@@ -256,6 +260,70 @@ DEBUG22(
       fprintf(stderr, "timeout_set: Scrollbar or Pulldown search found something\n");
 )
 
+/***************************************************************
+*  
+*  If journaled changes are waiting to be committed, wake up in
+*  time to do it.  journal_timeout does the commit when it is due.
+*  
+***************************************************************/
+
+work_microseconds = journal_timeout(); /* in journal.c */
+if (work_microseconds && (work_microseconds < curr_microseconds))
+   {
+      time_ptr = &time_out;
+      time_out.tv_sec  = work_microseconds / 1000000;
+      time_out.tv_usec = work_microseconds % 1000000;
+      curr_microseconds = work_microseconds;
+   }
+
+/***************************************************************
+*  
+*  An autosave image is written a slice at a time, wake up for
+*  the next slice or when the image is due.
+*  
+***************************************************************/
+
+work_microseconds = autoimage_timeout(); /* in autoimage.c */
+if (work_microseconds && (work_microseconds < curr_microseconds))
+   {
+      time_ptr = &time_out;
+      time_out.tv_sec  = work_microseconds / 1000000;
+      time_out.tv_usec = work_microseconds % 1000000;
+      curr_microseconds = work_microseconds;
+   }
+
+/***************************************************************
+*  
+*  While a background pw runs, look at its progress now and then.
+*  pw_timeout finishes the pw when the writer is done.
+*  
+***************************************************************/
+
+work_microseconds = pw_timeout(); /* in pw.c */
+if (work_microseconds && (work_microseconds < curr_microseconds))
+   {
+      time_ptr = &time_out;
+      time_out.tv_sec  = work_microseconds / 1000000;
+      time_out.tv_usec = work_microseconds % 1000000;
+      curr_microseconds = work_microseconds;
+   }
+
+/***************************************************************
+*  
+*  When the edit file cannot be watched with inotify, it is stat'ed
+*  on a timer.  watch_timeout does the stat when it is due.
+*  
+***************************************************************/
+
+work_microseconds = watch_timeout(); /* in lock.c */
+if (work_microseconds && (work_microseconds < curr_microseconds))
+   {
+      time_ptr = &time_out;
+      time_out.tv_sec  = work_microseconds / 1000000;
+      time_out.tv_usec = work_microseconds % 1000000;
+      curr_microseconds = work_microseconds;
+   }
+
 /***************************************************************
 *  
 *  If we set a timer, we will need the time of day for next time.
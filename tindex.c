@@ -0,0 +1,735 @@
+/*static char *sccsid = "%Z% %M% %I% - %G% %U% ";*/
+/***************************************************************
+*
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in tindex.c
+*     tindex_idle             - The main thread is about to wait for input
+*     tindex_busy             - The main thread has input to process
+*     tindex_skips            - Flag the blocks of a find which cannot match
+*     tindex_stats            - Get the size, build time and hit rate of the index
+*
+*  Internal routines:
+*     tindex_worker           - The index thread body
+*     tindex_spans            - Get a new list of the blocks in the file
+*     tindex_step             - Do one small piece of the index work
+*     tindex_block            - Record the trigrams of one block
+*     tindex_find             - Find the slot for a block in the hash table
+*     tindex_add              - Put an entry in the hash table
+*     tindex_sweep            - Drop entries for blocks which are gone
+*     tindex_reset            - Throw the index away
+*
+*  Each memdata block gets a bit map with one bit per trigram
+*  hash.  Trigrams are folded to lower case so the same map
+*  serves case sensitive and case insensitive finds.  A bit
+*  which is off means no line in the block holds any trigram
+*  with that hash.  The map is kept with the line count and
+*  generation sum of the block (span_generation in memdata.c)
+*  and is only trusted while both still match, so an edit to
+*  a block stops its map from being used until it is rebuilt.
+*
+*  The index thread takes one block at a time, and only while
+*  the main thread is waiting for input.  tindex_busy waits for
+*  the block in progress to finish, so memdata never changes
+*  under the thread.  Without threads, nothing is indexed.
+*
+***************************************************************/
+
+#include <stdio.h>          /* /usr/include/stdio.h      */
+#include <string.h>         /* /usr/include/string.h     */
+#include <stdlib.h>         /* /usr/include/stdlib.h     */
+#ifndef WIN32
+#include <sys/time.h>       /* /usr/include/sys/time.h   */
+#endif
+
+#ifdef HAVE_PTHREAD
+#include <pthread.h>        /* /usr/include/pthread.h    */
+#endif
+
+#include "debug.h"
+#include "dmwin.h"          /* needed for True and False */
+#include "emalloc.h"
+#include "memdata.h"
+#include "search.h"
+#include "tindex.h"
+
+/***************************************************************
+*
+*  TINDEX_BITS bits of trigram hash per block, 2K bytes for a
+*  block of 256 lines.  Finds only use TINDEX_MAX_TRIGRAMS of
+*  the pattern, more would rarely skip another block.
+*
+***************************************************************/
+
+#define TINDEX_LOG2          14
+#define TINDEX_BITS          (1 << TINDEX_LOG2)
+#define TINDEX_MAX_TRIGRAMS  32
+#define TINDEX_MIN_TABLE     256
+
+#define TINDEX_FOLD(c) ((((c) >= 'A') && ((c) <= 'Z')) ? ((c) | 040) : (c))
+#define TINDEX_HASH(a, b, c) ((((unsigned int)(((a) << 16) | ((b) << 8) | (c))) * 2654435761u) >> (32 - TINDEX_LOG2))
+
+typedef struct {
+   void           *block;          /* LINE_SPAN block, only compared, never used */
+   int             lines;          /* lines in the block when indexed            */
+   unsigned int    gensum;         /* span_generation when indexed               */
+   int             pass;           /* last pass which saw the block              */
+   unsigned char   bits[TINDEX_BITS / 8];
+} TINDEX_BLOCK;
+
+typedef struct {
+   DATA_TOKEN     *token;          /* memdata being indexed, NULL for none       */
+   TINDEX_BLOCK  **table;          /* open hash on the block address             */
+   int             table_size;     /* power of 2                                 */
+   int             nblocks;        /* entries in table                           */
+   LINE_SPAN      *spans;          /* whole file, from line_spans                */
+   int             nspans;
+   int             next;           /* next span to look at this pass             */
+   unsigned int    spans_generation; /* current_generation when spans were got   */
+   int             spans_lines;    /* total_lines when spans were got            */
+   int             pass;           /* bumped each time spans are refreshed       */
+   int             built;          /* every block of the pass is indexed         */
+   long            build_usec;     /* time spent building maps                   */
+   long            checked;        /* blocks tindex_skips had a map for          */
+   long            skipped;        /* of those, blocks which could not match     */
+#ifdef HAVE_PTHREAD
+   pthread_mutex_t lock;
+   pthread_cond_t  wake;           /* main thread went idle                      */
+   pthread_cond_t  done;           /* thread finished a step                     */
+   pthread_t       thread;
+#endif
+   int             started;        /* True once the thread is running, -1 if it could not start */
+   int             main_idle;      /* the main thread is waiting for input       */
+   int             working;        /* the thread is in tindex_step               */
+   int             caught_up;      /* nothing left to do this idle period        */
+} TINDEX;
+
+static TINDEX      ti;
+
+/***************************************************************
+*
+*  Prototypes for local routines
+*
+***************************************************************/
+
+#ifdef HAVE_PTHREAD
+static void *tindex_worker(void *arg);
+
+static void  tindex_spans(void);
+
+static int   tindex_step(void);
+
+static void  tindex_block(LINE_SPAN       *span,
+                          TINDEX_BLOCK    *entry);
+
+static int   tindex_add(TINDEX_BLOCK    *entry);
+
+static void  tindex_sweep(void);
+
+static void  tindex_reset(DATA_TOKEN      *token);
+#endif
+
+static TINDEX_BLOCK **tindex_find(void            *block);
+
+
+/************************************************************************
+
+NAME:      tindex_idle  -  The main thread is about to wait for input
+
+PURPOSE:    This routine lets the index thread run until tindex_busy is
+            called.  The thread is started the first time it is needed.
+
+PARAMETERS:
+
+   1.  token          - pointer to DATA_TOKEN (INPUT)
+                        The memdata in the main window.
+
+   2.  build          - int (INPUT)
+                        True if token should be indexed.  False throws
+                        away any index.
+
+*************************************************************************/
+
+void  tindex_idle(DATA_TOKEN      *token,             /* input  */
+                  int              build)             /* input  */
+{
+#ifdef HAVE_PTHREAD
+if (!ti.started)
+   {
+      if (!build)
+         return;
+      pthread_mutex_init(&ti.lock, NULL);
+      pthread_cond_init(&ti.wake, NULL);
+      pthread_cond_init(&ti.done, NULL);
+      if (pthread_create(&ti.thread, NULL, tindex_worker, NULL) != 0)
+         {
+            DEBUG13(fprintf(stderr, "tindex_idle: cannot start the index thread\n");)
+            ti.started = -1;
+            return;
+         }
+      ti.started = True;
+   }
+
+if (ti.started != True)
+   return;
+
+pthread_mutex_lock(&ti.lock);
+while (ti.working)
+   pthread_cond_wait(&ti.done, &ti.lock);
+if (!build)
+   token = NULL;
+if (token != ti.token)
+   tindex_reset(token);
+if (ti.token)
+   tindex_spans();
+ti.main_idle = True;
+ti.caught_up = False;
+pthread_cond_signal(&ti.wake);
+pthread_mutex_unlock(&ti.lock);
+#endif
+
+} /* end of tindex_idle */
+
+
+/************************************************************************
+
+NAME:      tindex_busy  -  The main thread has input to process
+
+PURPOSE:    This routine stops the index thread from starting another
+            block and waits for the one in progress.  After it returns,
+            the main thread may change memdata.
+
+*************************************************************************/
+
+void  tindex_busy(void)
+{
+#ifdef HAVE_PTHREAD
+if (ti.started != True)
+   return;
+
+pthread_mutex_lock(&ti.lock);
+ti.main_idle = False;
+while (ti.working)
+   pthread_cond_wait(&ti.done, &ti.lock);
+pthread_mutex_unlock(&ti.lock);
+#endif
+
+} /* end of tindex_busy */
+
+
+/************************************************************************
+
+NAME:      tindex_skips  -  Flag the blocks of a find which cannot match
+
+PURPOSE:    This routine checks the spans of a find against the index.
+            A span which is a whole indexed block, and whose block lacks
+            a trigram the expression needs, cannot hold a match.
+
+PARAMETERS:
+
+   1.  token          - pointer to DATA_TOKEN (INPUT)
+                        The memdata being searched.
+
+   2.  sdata          - pointer to void (INPUT)
+                        The static pattern data of a previous call to search.
+
+   3.  spans          - pointer to LINE_SPAN (INPUT)
+                        The spans of the find, from line_spans.
+
+   4.  nspans         - int (INPUT)
+                        The number of spans.
+
+FUNCTIONS :
+
+   1.   Returns a malloc'ed array with one byte per span, non-zero if
+        the span can be passed over.  The caller frees it.  NULL is
+        returned if no span can be passed over.
+
+*************************************************************************/
+
+unsigned char *tindex_skips(DATA_TOKEN      *token,             /* input  */
+                            void            *sdata,             /* input  */
+                            LINE_SPAN       *spans,             /* input  */
+                            int              nspans)            /* input  */
+{
+char                     runs[256];
+char                    *p;
+unsigned int             trigrams[TINDEX_MAX_TRIGRAMS];
+int                      ntrigrams = 0;
+int                      nruns;
+int                      a, b, c;
+unsigned int             h;
+TINDEX_BLOCK            *entry;
+unsigned char           *skips = NULL;
+int                      i;
+int                      k;
+
+if (!token || (token != ti.token) || !ti.nblocks)
+   return(NULL);
+
+/***************************************************************
+*  Collect the trigrams of the text every match must contain.
+***************************************************************/
+nruns = required_text(sdata, runs, sizeof(runs));
+for (p = runs, i = 0; (i < nruns) && (ntrigrams < TINDEX_MAX_TRIGRAMS); i++, p += strlen(p) + 1)
+{
+   if (strlen(p) < 3)
+      continue;
+   a = TINDEX_FOLD((unsigned char)p[0]);
+   b = TINDEX_FOLD((unsigned char)p[1]);
+   for (k = 2; p[k] && (ntrigrams < TINDEX_MAX_TRIGRAMS); k++)
+   {
+      c = TINDEX_FOLD((unsigned char)p[k]);
+      trigrams[ntrigrams++] = TINDEX_HASH(a, b, c);
+      a = b;
+      b = c;
+   }
+}
+
+if (!ntrigrams)
+   return(NULL);
+
+for (k = 0; k < nspans; k++)
+{
+   if (spans[k].first_idx)
+      continue;
+   entry = *tindex_find(spans[k].block);
+   if (!entry || (entry->lines != spans[k].lines) || (entry->gensum != span_generation(&spans[k])))
+      continue;
+
+   ti.checked++;
+   for (i = 0; i < ntrigrams; i++)
+   {
+      h = trigrams[i];
+      if (!(entry->bits[h >> 3] & (1 << (h & 7))))
+         break;
+   }
+   if (i == ntrigrams)
+      continue;
+
+   if (!skips)
+      {
+         skips = (unsigned char *)CE_MALLOC(nspans);
+         if (!skips)
+            return(NULL);
+         memset((char *)skips, 0, nspans);
+      }
+   skips[k] = 1;
+   ti.skipped++;
+}
+
+DEBUG13(fprintf(stderr, "tindex_skips: %d trigrams, %ld of %ld blocks skipped so far\n", ntrigrams, ti.skipped, ti.checked);)
+
+return(skips);
+
+} /* end of tindex_skips */
+
+
+/************************************************************************
+
+NAME:      tindex_stats  -  Get the size, build time and hit rate of the index
+
+PARAMETERS:
+
+   1.  kbytes         - pointer to int (OUTPUT)
+                        The memory used by the index in K bytes.
+
+   2.  build_tenths   - pointer to int (OUTPUT)
+                        The time spent building maps in tenths of a second.
+
+   3.  hit_pct        - pointer to int (OUTPUT)
+                        The percent of indexed blocks finds were able to pass over.
+
+   4.  state          - pointer to int (OUTPUT)
+                        TINDEX_NONE, TINDEX_BUILDING or TINDEX_BUILT.
+
+*************************************************************************/
+
+void  tindex_stats(int             *kbytes,            /* output */
+                   int             *build_tenths,      /* output */
+                   int             *hit_pct,           /* output */
+                   int             *state)             /* output */
+{
+
+*kbytes       = (int)(((long)ti.nblocks * sizeof(TINDEX_BLOCK) + (long)ti.table_size * sizeof(TINDEX_BLOCK *) + 1023) / 1024);
+*build_tenths = (int)(ti.build_usec / 100000);
+*hit_pct      = ti.checked ? (int)((ti.skipped * 100) / ti.checked) : 0;
+if (!ti.token)
+   *state = TINDEX_NONE;
+else
+   *state = ti.built ? TINDEX_BUILT : TINDEX_BUILDING;
+
+} /* end of tindex_stats */
+
+
+#ifdef HAVE_PTHREAD
+/************************************************************************
+
+NAME:      tindex_worker  -  The index thread body
+
+PURPOSE:    The thread sleeps until the main thread is idle and there is
+            something to index, then does one step at a time until the
+            main thread is busy again or the index is up to date.
+
+*************************************************************************/
+
+static void *tindex_worker(void *arg)
+{
+int                      more;
+
+pthread_mutex_lock(&ti.lock);
+while(1)
+{
+   while (!ti.main_idle || !ti.token || ti.caught_up)
+      pthread_cond_wait(&ti.wake, &ti.lock);
+
+   ti.working = True;
+   pthread_mutex_unlock(&ti.lock);
+
+   more = tindex_step();
+
+   pthread_mutex_lock(&ti.lock);
+   ti.working = False;
+   if (!more)
+      ti.caught_up = True;
+   pthread_cond_signal(&ti.done);
+}
+
+return(NULL);
+
+} /* end of tindex_worker */
+
+
+/************************************************************************
+
+NAME:      tindex_spans  -  Get a new list of the blocks in the file
+
+PURPOSE:    If the file has changed since the list was made, a new list
+            is made and a new pass started.  This is called from
+            tindex_idle, line_spans uses CE_MALLOC which reports failures
+            with dm_error, so it is not run in the index thread.
+
+*************************************************************************/
+
+static void  tindex_spans(void)
+{
+
+if ((ti.spans_generation == current_generation()) && (ti.spans_lines == total_lines(ti.token)))
+   return;
+
+if (ti.spans)
+   free((char *)ti.spans);
+ti.spans = NULL;
+ti.nspans = 0;
+ti.next = 0;
+ti.built = False;
+ti.pass++;
+ti.spans_generation = current_generation();
+ti.spans_lines = total_lines(ti.token);
+if (ti.spans_lines > 0)
+   ti.spans = line_spans(ti.token, 0, ti.spans_lines - 1, &ti.nspans);
+DEBUG13(fprintf(stderr, "tindex_spans: pass %d, %d lines in %d blocks\n", ti.pass, ti.spans_lines, ti.nspans);)
+
+} /* end of tindex_spans */
+
+
+/************************************************************************
+
+NAME:      tindex_step  -  Do one small piece of the index work
+
+PURPOSE:    Each call either indexes one block of the list tindex_spans
+            made, or drops the entries for blocks which are no longer in
+            the file.  Steps are kept short because the main thread waits
+            for the current one when input arrives.
+
+FUNCTIONS :
+
+   1.   Returns False if the index is up to date.
+
+*************************************************************************/
+
+static int   tindex_step(void)
+{
+LINE_SPAN               *span;
+TINDEX_BLOCK           **slot;
+TINDEX_BLOCK            *entry;
+unsigned int             gensum;
+struct timeval           start;
+struct timeval           end;
+
+if (ti.next < ti.nspans)
+   {
+      span = &ti.spans[ti.next++];
+      if (span->first_idx)
+         return(True);
+
+      gensum = span_generation(span);
+      slot = tindex_find(span->block);
+      entry = *slot;
+      if (entry && (entry->lines == span->lines) && (entry->gensum == gensum))
+         {
+            entry->pass = ti.pass;
+            return(True);
+         }
+
+      if (!entry)
+         {
+            /* plain malloc, CE_MALLOC reports failures with dm_error which is main thread only */
+            entry = (TINDEX_BLOCK *)malloc(sizeof(TINDEX_BLOCK));
+            if (!entry)
+               return(True);
+            entry->block = span->block;
+            if (!tindex_add(entry))
+               {
+                  free((char *)entry);
+                  return(True);
+               }
+         }
+
+      gettimeofday(&start, NULL);
+      tindex_block(span, entry);
+      gettimeofday(&end, NULL);
+      ti.build_usec += ((end.tv_sec - start.tv_sec) * 1000000) + (end.tv_usec - start.tv_usec);
+
+      entry->lines  = span->lines;
+      entry->gensum = gensum;
+      entry->pass   = ti.pass;
+      return(True);
+   }
+
+if (!ti.built)
+   {
+      tindex_sweep();
+      ti.built = True;
+      DEBUG13(fprintf(stderr, "tindex_step: built, %d blocks, %ld usec\n", ti.nblocks, ti.build_usec);)
+      return(True);
+   }
+
+return(False);
+
+} /* end of tindex_step */
+
+
+/************************************************************************
+
+NAME:      tindex_block  -  Record the trigrams of one block
+
+*************************************************************************/
+
+static void  tindex_block(LINE_SPAN       *span,
+                          TINDEX_BLOCK    *entry)
+{
+unsigned char           *p;
+int                      a, b, c;
+unsigned int             h;
+int                      i;
+
+memset((char *)entry->bits, 0, sizeof(entry->bits));
+
+for (i = 0; i < span->lines; i++)
+{
+   p = (unsigned char *)span_line(span, i);
+   if (!p || !p[0] || !p[1])
+      continue;
+   a = TINDEX_FOLD(p[0]);
+   b = TINDEX_FOLD(p[1]);
+   for (p += 2; *p; p++)
+   {
+      c = TINDEX_FOLD(*p);
+      h = TINDEX_HASH(a, b, c);
+      entry->bits[h >> 3] |= (1 << (h & 7));
+      a = b;
+      b = c;
+   }
+}
+
+} /* end of tindex_block */
+
+
+/************************************************************************
+
+NAME:      tindex_add  -  Put an entry in the hash table
+
+PURPOSE:    The table is doubled when it gets half full.
+
+FUNCTIONS :
+
+   1.   Returns False if there is no memory.
+
+*************************************************************************/
+
+static int   tindex_add(TINDEX_BLOCK    *entry)
+{
+TINDEX_BLOCK           **old_table = ti.table;
+int                      old_size = ti.table_size;
+int                      i;
+
+if ((ti.nblocks + 1) * 2 > ti.table_size)
+   {
+      ti.table_size = old_size ? old_size * 2 : TINDEX_MIN_TABLE;
+      ti.table = (TINDEX_BLOCK **)calloc(ti.table_size, sizeof(TINDEX_BLOCK *));
+      if (!ti.table)
+         {
+            ti.table = old_table;
+            ti.table_size = old_size;
+            return(False);
+         }
+      for (i = 0; i < old_size; i++)
+         if (old_table[i])
+            *tindex_find(old_table[i]->block) = old_table[i];
+      if (old_table)
+         free((char *)old_table);
+   }
+
+*tindex_find(entry->block) = entry;
+ti.nblocks++;
+return(True);
+
+} /* end of tindex_add */
+
+
+/************************************************************************
+
+NAME:      tindex_sweep  -  Drop entries for blocks which are gone
+
+PURPOSE:    Entries not seen in the current pass are freed and the rest
+            are hashed into a fresh table.
+
+*************************************************************************/
+
+static void  tindex_sweep(void)
+{
+TINDEX_BLOCK           **old_table = ti.table;
+int                      old_size = ti.table_size;
+int                      i;
+
+if (!old_table)
+   return;
+
+ti.table = (TINDEX_BLOCK **)calloc(old_size, sizeof(TINDEX_BLOCK *));
+if (!ti.table)
+   {
+      ti.table = old_table;
+      return;
+   }
+
+ti.nblocks = 0;
+for (i = 0; i < old_size; i++)
+{
+   if (!old_table[i])
+      continue;
+   if (old_table[i]->pass == ti.pass)
+      {
+         *tindex_find(old_table[i]->block) = old_table[i];
+         ti.nblocks++;
+      }
+   else
+      free((char *)old_table[i]);
+}
+
+free((char *)old_table);
+
+} /* end of tindex_sweep */
+#endif
+
+
+/************************************************************************
+
+NAME:      tindex_find  -  Find the slot for a block in the hash table
+
+FUNCTIONS :
+
+   1.   Returns the slot holding the block, or the empty slot where
+        it would go.  With no table, a pointer to NULL is returned.
+
+*************************************************************************/
+
+static TINDEX_BLOCK **tindex_find(void            *block)
+{
+static TINDEX_BLOCK     *none = NULL;
+unsigned int             i;
+
+if (!ti.table)
+   {
+      none = NULL;
+      return(&none);
+   }
+
+i = ((unsigned int)((unsigned long)block >> 4) * 2654435761u) & (ti.table_size - 1);
+while (ti.table[i] && (ti.table[i]->block != block))
+   i = (i + 1) & (ti.table_size - 1);
+
+return(&ti.table[i]);
+
+} /* end of tindex_find */
+
+
+#ifdef HAVE_PTHREAD
+/************************************************************************
+
+NAME:      tindex_reset  -  Throw the index away
+
+PURPOSE:    This routine frees the index and starts over on a new token.
+            It is called with the thread idle.
+
+PARAMETERS:
+
+   1.  token          - pointer to DATA_TOKEN (INPUT)
+                        The memdata to index next, or NULL.
+
+*************************************************************************/
+
+static void  tindex_reset(DATA_TOKEN      *token)
+{
+int                      i;
+
+DEBUG13(fprintf(stderr, "tindex_reset: %s\n", token ? "new file" : "off");)
+
+for (i = 0; i < ti.table_size; i++)
+   if (ti.table[i])
+      free((char *)ti.table[i]);
+if (ti.table)
+   free((char *)ti.table);
+if (ti.spans)
+   free((char *)ti.spans);
+
+ti.token       = token;
+ti.table       = NULL;
+ti.table_size  = 0;
+ti.nblocks     = 0;
+ti.spans       = NULL;
+ti.nspans      = 0;
+ti.spans_lines = -1;   /* tindex_spans makes a new list */
+ti.next        = 0;
+ti.built       = False;
+ti.build_usec  = 0;
+ti.checked     = 0;
+ti.skipped     = 0;
+
+} /* end of tindex_reset */
+#endif
+
@@ -0,0 +1,78 @@
+#ifndef _TINDEX_INCLUDED
+#define _TINDEX_INCLUDED
+
+/* "%Z% %M% %I% - %G% %U% " */
+
+/***************************************************************
+*  
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*  
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*  
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*  
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*  
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*  
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in tindex.c
+*     tindex_idle             - The main thread is about to wait for input
+*     tindex_busy             - The main thread has input to process
+*     tindex_skips            - Flag the blocks of a find which cannot match
+*     tindex_stats            - Get the size, build time and hit rate of the index
+*
+*  With -tindex yes (resource .tindex), a browse session on a file
+*  which is not writable gets a trigram index once the whole file
+*  is loaded.  A worker thread records, for each memdata block, the
+*  three character sequences found in its lines.  Finds which cover
+*  the file block by block (pfind.c) pass over blocks missing a
+*  trigram of the pattern.  The worker only reads memdata while the
+*  main thread is waiting for input.
+*
+***************************************************************/
+
+#include "memdata.h"
+
+/***************************************************************
+*
+*  Values for the state returned by tindex_stats.
+*
+***************************************************************/
+
+#define TINDEX_NONE      0
+#define TINDEX_BUILDING  1
+#define TINDEX_BUILT     2
+
+void  tindex_idle(DATA_TOKEN      *token,             /* input  */
+                  int              build);            /* input  */
+
+void  tindex_busy(void);
+
+unsigned char *tindex_skips(DATA_TOKEN      *token,             /* input  */
+                            void            *sdata,             /* input  */
+                            LINE_SPAN       *spans,             /* input  */
+                            int              nspans);           /* input  */
+
+void  tindex_stats(int             *kbytes,            /* output */
+                   int             *build_tenths,      /* output */
+                   int             *hit_pct,           /* output */
+                   int             *state);            /* output */
+
+
+#endif
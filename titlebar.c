@@ -64,6 +64,7 @@
 #include "emalloc.h"
 #include "titlebar.h"
 #include "xerrorpos.h"
+#include "xutil.h"      /* needed for draw_text_items */
 
 #define   TITLEBAR_HEIGHT_PADDING   60
 
@@ -326,7 +327,12 @@ int                   title_width;
 int                   title_start;
 char                  printed_title[256];
 char                  line_text[20];
+char                  col_text[20];
 char                 *box_char;
+TEXT_AT               text_at[3];        /* title, column and line number, drawn with gc */
+int                   text_count = 0;
+TEXT_AT               letter_at[5];      /* box letters, drawn with reverse_gc */
+int                   letter_count = 0;
 XCharStruct           overall;
 int                   ascent;
 int                   descent;
@@ -455,12 +461,10 @@ else
 *  
 ***************************************************************/
 
-DEBUG9(XERRORPOS)
-XDrawString(display,
-            x_pixmap,
-            titlebar_subwin->gc,
-            title_start,baseline_y,
-            printed_title, strlen(printed_title));
+text_at[text_count].x      = title_start;
+text_at[text_count].chars  = printed_title;
+text_at[text_count].nchars = strlen(printed_title);
+text_count++;
 
 /***************************************************************
 *
@@ -512,12 +516,10 @@ if ((line_no >= 0) && window_wrap)
      i = overall.rbearing - overall.lbearing;
      letter_x = box_0_x + ((box_side / 2) - (overall.lbearing + (i/2))) - 1;
 
-     DEBUG9(XERRORPOS)
-     XDrawString(display,
-                 x_pixmap,
-                 titlebar_subwin->reverse_gc,
-                 letter_x, baseline_y,
-                 box_char, 1);
+     letter_at[letter_count].x      = letter_x;
+     letter_at[letter_count].chars  = box_char;
+     letter_at[letter_count].nchars = 1;
+     letter_count++;
       
    }
 
@@ -558,12 +560,10 @@ if (!writable || insert_mode)
      i = overall.rbearing - overall.lbearing;
      letter_x = box_1_x + ((box_side / 2) - (overall.lbearing + (i/2))) - 1;
 
-     DEBUG9(XERRORPOS)
-     XDrawString(display,
-                 x_pixmap,
-                 titlebar_subwin->reverse_gc,
-                 letter_x, baseline_y,
-                 box_char, 1);
+     letter_at[letter_count].x      = letter_x;
+     letter_at[letter_count].chars  = box_char;
+     letter_at[letter_count].nchars = 1;
+     letter_count++;
       
    }
 
@@ -582,28 +582,24 @@ if (line_no >= 0)
       else
          line_no_x = (box_4_x + box_side) - XTextWidth(titlebar_subwin->font, line_text, text_len);
 
-      DEBUG9(XERRORPOS)
-      XDrawString(display,
-                  x_pixmap,
-                  titlebar_subwin->gc,
-                  line_no_x, baseline_y,
-                  line_text, text_len);
+      text_at[text_count].x      = line_no_x;
+      text_at[text_count].chars  = line_text;
+      text_at[text_count].nchars = text_len;
+      text_count++;
 
       if (col_no > 0)
          {
-            sprintf(line_text, "%d", col_no+1); /* plus one because we display 1 based line numbers, internal numbers are zero based */
-            text_len = strlen(line_text);
+            sprintf(col_text, "%d", col_no+1); /* plus one because we display 1 based line numbers, internal numbers are zero based */
+            text_len = strlen(col_text);
             if (titlebar_subwin->fixed_font)
                line_no_x = box_0_x - ((titlebar_subwin->fixed_font * text_len) + box_side);
             else
-               line_no_x = box_0_x - (XTextWidth(titlebar_subwin->font, line_text, text_len) + box_side);
+               line_no_x = box_0_x - (XTextWidth(titlebar_subwin->font, col_text, text_len) + box_side);
 
-            DEBUG9(XERRORPOS)
-            XDrawString(display,
-                        x_pixmap,
-                        titlebar_subwin->gc,
-                        line_no_x, baseline_y,
-                        line_text, text_len);
+            text_at[text_count].x      = line_no_x;
+            text_at[text_count].chars  = col_text;
+            text_at[text_count].nchars = text_len;
+            text_count++;
 
          }
       /***************************************************************
@@ -630,12 +626,10 @@ if (line_no >= 0)
             i = overall.rbearing - overall.lbearing;
             letter_x = box_2_x + ((box_side / 2) - (overall.lbearing + (i/2))) - 1;
 
-            DEBUG9(XERRORPOS)
-            XDrawString(display,
-                        x_pixmap,
-                        titlebar_subwin->reverse_gc,
-                        letter_x, baseline_y,
-                        box_char, 1);
+            letter_at[letter_count].x      = letter_x;
+            letter_at[letter_count].chars  = box_char;
+            letter_at[letter_count].nchars = 1;
+            letter_count++;
       
          }
 
@@ -667,12 +661,10 @@ else
             i = overall.rbearing - overall.lbearing;
             letter_x = box_2_x + ((box_side / 2) - (overall.lbearing + (i/2))) - 1;
 
-            DEBUG9(XERRORPOS)
-            XDrawString(display,
-                        x_pixmap,
-                        titlebar_subwin->reverse_gc,
-                        letter_x, baseline_y,
-                        box_char, 1);
+            letter_at[letter_count].x      = letter_x;
+            letter_at[letter_count].chars  = box_char;
+            letter_at[letter_count].nchars = 1;
+            letter_count++;
       
          }
 
@@ -712,12 +704,10 @@ else
            i = overall.rbearing - overall.lbearing;
            letter_x = box_3_x + ((box_side / 2) - (overall.lbearing + (i/2))) - 1;
 
-           DEBUG9(XERRORPOS)
-           XDrawString(display,
-                       x_pixmap,
-                       titlebar_subwin->reverse_gc,
-                       letter_x, baseline_y,
-                       box_char, 1);
+           letter_at[letter_count].x      = letter_x;
+           letter_at[letter_count].chars  = box_char;
+           letter_at[letter_count].nchars = 1;
+           letter_count++;
       
          }
 
@@ -746,17 +736,26 @@ else
            i = overall.rbearing - overall.lbearing;
            letter_x = box_4_x + ((box_side / 2) - (overall.lbearing + (i/2))) - 1;
 
-           DEBUG9(XERRORPOS)
-           XDrawString(display,
-                       x_pixmap,
-                       titlebar_subwin->reverse_gc,
-                       letter_x, baseline_y,
-                       box_char, 1);
+           letter_at[letter_count].x      = letter_x;
+           letter_at[letter_count].chars  = box_char;
+           letter_at[letter_count].nchars = 1;
+           letter_count++;
       
          }
    }  /* else checking out the boxes */
 
+/***************************************************************
+*  
+*  The boxes are filled in above.  Now draw the text and the box
+*  letters, one request for each.
+*  
+***************************************************************/
+
+draw_text_items(display, x_pixmap, titlebar_subwin->gc, titlebar_subwin->font,
+                baseline_y, text_at, text_count);
 
+draw_text_items(display, x_pixmap, titlebar_subwin->reverse_gc, titlebar_subwin->font,
+                baseline_y, letter_at, letter_count);
 
 
 } /* end write_titlebar  */
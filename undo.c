@@ -24,60 +24,122 @@
 *  Email:  styma@swlink.net
 *  
 ***************************************************************/
-
 /**************************************************************************
 *
 *   This is the Undo functions file.
 *
-*   Undo maintains a doubly linked list of memdata altering events. 
-*   an 'un_do()'  walks the list backwards effecting the reverse of the event
-*   on the memdata structure. Redo walks forward in the undo dlist.
+*   Undo maintains a list of memdata altering events.  An 'un_do()' walks
+*   the list backwards effecting the reverse of the event on the memdata
+*   structure. Redo walks forward in the undo list.
+*
+*   The events are kept in an append only log of chunks (see memdata.h).
+*   Each event is one record with the text it saved packed in after it,
+*   so there is no malloc per event.  Throwing away the events past the
+*   current position just moves the end of the log back.  The pad write
+*   event is a flag on the event the file was written after, so a write
+*   never has to be spliced into the middle of the log.  Repeated
+*   overwrites of the same line with nothing in between, such as
+*   several changes to a line in one command, keep only the first one,
+*   which holds the text to go back to.
+*
+*   With -undomem the memory held for undo is kept under a limit.  When
+*   a new chunk pushes it over, the oldest chunks behind the current
+*   position are written to a temporary spill file along with the lines
+*   their events hold outside the log.  The chunk header stays in the
+*   list with the file offset, and walking back into it reads it in
+*   again.  Undo stays unlimited without keeping it all in memory.
 *
 * External Interfaces
 *
-*    un_do()        - undo to the last key stroke 
-*    re_do()        - redo to the last key stroke 
-*    event_do()     - Add an event to the undo dlist 
-* 
+*    un_do()            - undo to the last key stroke
+*    re_do()            - redo to the last key stroke
+*    event_do()         - Add an event to the undo list
+*    event_swap()       - Add a swap_lines event to the undo list
+*    event_pw_failed()  - Take back the pad write event of a failed write
+*    undo_init()        - initialize the undo list
+*    kill_event_dlist() - kill all events on the list
+*    undo_free()        - free the undo list of a token being killed
+*    undo_limit()       - set the memory limit for undo
+*
 * Internal Routines
 *
-*    rm_event()        - remove an event from the event dlist
-*    last_event()      - take a step backwards in the event dlist
-*    next_event()      - take a step forwards in the event dlist
-*    free_forward()    - remove everything forward of the current pointer
-*    remove_pwevents() - Remove any pw event in the linked list
-* 
+*    new_record()      - make room for a record at the end of the log
+*    rec_last()        - find the live record before a record
+*    rec_next()        - find the live record after a record
+*    pos_last()        - take a step backwards in the event list
+*    pos_next()        - take a step forwards in the event list
+*    pos_type()        - get the event type at a position
+*    free_forward()    - remove everything forward of the current position
+*    remove_pwevents() - Remove the pad write event
+*    free_chunk()      - free a chunk and its records
+*    swap_bytes()      - memory held by a swap_lines event
+*    spill_chunks()    - write old chunks to the spill file to get under the limit
+*    spill_chunk()     - write a chunk to the spill file
+*    page_in()         - read a spilled chunk back in
+*
 ****************************************************************************/
 
 #define _UNDO_  1
 
-#include <stdio.h>          /* /usr/include/stdio.h      */ 
-#include <errno.h>          /* /usr/include/errno.h      */ 
-#include <limits.h>         /* /usr/include/limits.h     */ 
-#include <string.h>         /* /usr/include/string.h     */ 
+#include <stdio.h>          /* /usr/include/stdio.h      */
+#include <errno.h>          /* /usr/include/errno.h      */
+#include <limits.h>         /* /usr/include/limits.h     */
+#include <string.h>         /* /usr/include/string.h     */
+#ifndef WIN32
+#include <unistd.h>         /* /usr/include/unistd.h     */
+#endif
 
 
-#include "debug.h"                                          
+#include "debug.h"
 #include "dmwin.h"
 #include "emalloc.h"
-#include "memdata.h"                                          
+#include "memdata.h"
 #include "undo.h"
 
-
+/*
+ *  Chunks start small, since most tokens (paste buffers, the dm
+ *  windows) see few events, and double up to UNDO_CHUNK_MAX.
+ */
+#define UNDO_CHUNK_MIN   512
+#define UNDO_CHUNK_MAX   65536
+
+#define EVENT_DATA  1   /* text follows the record */
+#define EVENT_DEAD  2   /* removed, skipped when walking */
+#define EVENT_PW    4   /* the file was written after this event (PW_EVENT) */
+
+#define EVENT_ROUND(n)  (((n) + 7) & ~7)
+#define CHUNK_AREA(c)   ((c)->area)
+#define EVENT_TEXT(e)   (((e)->flags & EVENT_DATA) ? (char *)((e) + 1) : NULL)
+#define EVENT_SWAPS(e)  (*(LINE_SWAP **)((e) + 1))
+
+static event_struct *new_record(DATA_TOKEN *token, int len);
+static int   rec_last(undo_chunk **chunk, event_struct **event);
+static int   rec_next(undo_chunk **chunk, event_struct **event);
+static int   pos_last(UNDO_POS *pos);
+static int   pos_next(UNDO_POS *pos);
+static int   pos_type(UNDO_POS *pos);
 static int   free_forward(DATA_TOKEN *token);
-static void  rm_event(event_struct *kill_event);
-static void  next_event(DATA_TOKEN *token);
-static void  last_event(DATA_TOKEN *token);
 static char *print_event(int event);
 static void  remove_pwevents(DATA_TOKEN *token);
+static int   free_event(event_struct *event);
+static void  free_chunk(undo_chunk *chunk);
+static long  swap_bytes(event_struct *event);
+static void  spill_chunks(undo_log *log);
+static int   spill_chunk(undo_chunk *chunk);
+static int   page_in(undo_chunk *chunk);
 void dump_event_list(DATA_TOKEN *token, int count);
 
 void  exit(int code);
 
+static long  undo_bytes = 0;       /* memory held by undo in all the tokens */
+static long  undo_limit_bytes = 0; /* -undomem, 0 for no limit */
+static FILE *spill_fp = NULL;      /* the spill file, deleted when closed */
+static int   spill_count = 0;      /* chunks out in the spill file */
+
 /***********************************************************
 *
-*   un_do -  move backward on key_strokeon the  dlist and 
-*            effect the changes 
+*   un_do -  move backward on key_strokeon the  dlist and
+*            effect the changes
 *
 ***********************************************************/
 #ifdef DebuG
@@ -92,35 +154,51 @@ int line;
 int dummy;
 int last_line = -1;
 char *ptr;
+int nothing = True;
+undo_log *log = token->undo_log;
+UNDO_POS pos;
 
 event_struct *event;
 
 DEBUG0( if (token->marker != TOKEN_MARKER) {fprintf(stderr, "Bad token passed to un_do"); exit(8);})
 DEBUG6( fprintf(stderr, " @Un_do \n"); dump_event_list(token, 500);)
 
-*line_out = INT_MAX; 
+*line_out = INT_MAX;
 
-if (!token->event_head || 
-   ((token->event_head->type == KS_EVENT) && (token->event_head->last == NULL)) ||
-   ((token->event_head->type == PW_EVENT) && (token->event_head->last != NULL) && (token->event_head->last->type == KS_EVENT) && (token->event_head->last->last == NULL) )){ 
+/*
+ *  Nothing to undo if the only thing behind us is the first key stroke.
+ */
+if (log && log->head.event){
+   pos = log->head;
+   if (pos_type(&pos) == PW_EVENT)
+      pos_last(&pos);
+   if ((pos_type(&pos) != KS_EVENT) || pos_last(&pos))
+      nothing = False;
+}
+
+if (nothing){
        dm_error("Nothing left to UNDO", DM_ERROR_BEEP);
        return;
 }
 
 /*
- *  Walk backwards on the event dlist until a key_stroke is found
+ *  Walk backwards on the event list until a key_stroke is found
  */
 
-if (token->event_head &&   /* if on a key_stroke get off before looking */
-    (token->event_head->type == KS_EVENT) &&
-     (token->event_head->last != NULL)) 
-         last_event(token); /* backup over the key_stroke */
-
-event = token->event_head;
+if (pos_type(&log->head) == KS_EVENT) /* if on a key_stroke get off before looking */
+    pos_last(&log->head);             /* backup over the key_stroke */
 
 undo_semafor = ON;  /* don't want the memdata(base) to log our changes! */
 
-while (event && (event->type != KS_EVENT)){      
+while (pos_type(&log->head) != KS_EVENT){
+
+    event = log->head.event;
+    if (log->head.pw){
+        DEBUG6( fprintf(stderr, " EVENT[%d]#%d\n", PW_EVENT, Dcount++);)
+        dirty_bit(token) = 0;
+        if (!pos_last(&log->head)) break; /* dont go off the end */
+        continue;
+    }
 
     DEBUG6( fprintf(stderr, " EVENT[%d]#%d\n", event->type, Dcount++);)
 
@@ -128,16 +206,19 @@ while (event && (event->type != KS_EVENT)){
     if (event->line > last_line) last_line = event->line;
 
     switch(event->type){
-         case  PC_EVENT: 
+         case  PC_EVENT:
                         ptr = get_color_by_num(token, event->line, COLOR_CURRENT, &dummy);
                         if (!event->old_data){
                             len = strlen(ptr) + 1;
-                            event->malloc_old_size = len;
                             event->old_data = (char *)CE_MALLOC(len);
-                            if (!event->old_data) return; 
+                            if (!event->old_data){
+                                undo_semafor = OFF;
+                                return;
+                            }
                             strcpy(event->old_data, ptr);
+                            undo_bytes += len;
                         }
-                        put_color_by_num(token, event->line, event->data);
+                        put_color_by_num(token, event->line, EVENT_TEXT(event));
                         break;
 
          case  PL_EVENT:
@@ -145,12 +226,15 @@ while (event && (event->type != KS_EVENT)){
 
                              line = event->line +1;
                              ptr = get_line_by_num(token, line);
-                             if (!event->data){ 
+                             if (!event->old_data){   /* saved for the redo */
                                  len = strlen(ptr) + 1;
-                                 event->malloc_size = len;
-                                 event->data = (char *)CE_MALLOC(len);
-                                 if (!event->data) return; 
-                                 strcpy(event->data, ptr);
+                                 event->old_data = (char *)CE_MALLOC(len);
+                                 if (!event->old_data){
+                                     undo_semafor = OFF;
+                                     return;
+                                 }
+                                 strcpy(event->old_data, ptr);
+                                 undo_bytes += len;
                              }
                              delete_line_by_num(token, line, 1);
 
@@ -159,61 +243,49 @@ while (event && (event->type != KS_EVENT)){
                              ptr = get_line_by_num(token, event->line);
                              if (!event->old_data){
                                  len = strlen(ptr) + 1;
-                                 event->malloc_old_size = len;
                                  event->old_data = (char *)CE_MALLOC(len);
                                  if (!event->old_data){
                                /*    dm_error("Cannot CE_MALLOC event->old_data.", DM_ERROR_LOG);  */
+                                     undo_semafor = OFF;
                                      return;
                                  }
                                  strcpy(event->old_data, ptr);
+                                 undo_bytes += len;
                              }
-                             put_line_by_num(token, event->line, event->data, OVERWRITE);
+                             put_line_by_num(token, event->line, EVENT_TEXT(event), OVERWRITE);
 
                          }
                          break;
-     
+
          case  DL_EVENT:
-                         put_line_by_num(token, event->line -1, event->data, INSERT);
+                         put_line_by_num(token, event->line -1, EVENT_TEXT(event), INSERT);
                          break;
 
-         case  PW_EVENT:
-                         dirty_bit(token) = 0;
+         case  SW_EVENT:
+                         undo_bytes -= swap_bytes(event);
+                         swap_lines(token, EVENT_SWAPS(event), event->column);
+                         undo_bytes += swap_bytes(event);
                          break;
-     
+
 #ifdef PUTBLOCK
 
          case  RB_EVENT:
                          line = event->line +1;
                          ptr =  get_line_by_num(token, line);
                          len = strlen(ptr) + 1;
-                         event->malloc_size = len;
-                         event->data = (char *)CE_MALLOC(len);
-                         if (!event->data){
-                           /*  dm_error("Cannot CE_MALLOC event.data.", DM_ERROR_LOG); */
-                             return;
-                         }
-                         strcpy(event->data, ptr);
-                         delete_line_by_num(token, line, 1);
-                         break;
-     
-#endif
-
-#ifdef blah
-         case  SL_EVENT:
-                         ptr = get_line_by_num(token, event->line);
-                         len = strlen(ptr) + strlen(event->data)+ 1;
-                         event->malloc_old_size = len;
                          event->old_data = (char *)CE_MALLOC(len);
                          if (!event->old_data){
-                           /*  dm_error("Cannot CE_MALLOC event.old_data.", DM_ERROR_LOG); */
+                           /*  dm_error("Cannot CE_MALLOC event.data.", DM_ERROR_LOG); */
+                             undo_semafor = OFF;
                              return;
                          }
                          strcpy(event->old_data, ptr);
-                         strcat(event->old_data, event->data);
-                         put_line_by_num(token, event->line, event->old_data, OVERWRITE);
+                         undo_bytes += len;
+                         delete_line_by_num(token, line, 1);
                          break;
-       
+
 #endif
+
          case  ES_EVENT:
          case  DS_EVENT:
          default:
@@ -221,46 +293,37 @@ while (event && (event->type != KS_EVENT)){
 
     } /*switch */
 
-    if (event->last == NULL) break; /* dont go off the end */
-    last_event(token);
-    event = token->event_head;
+    if (!pos_last(&log->head)) break; /* dont go off the end */
 
 } /* while !key_stroke */
 
 DEBUG6( fprintf(stderr, " @Un_do[END](%d)\n", *line_out);)
 
-if ((token->event_head->type == PW_EVENT) ||
-   ((token->event_head->type == KS_EVENT) && token->event_head->last && (token->event_head->last->type == PW_EVENT)))
+pos = log->head;
+if ((pos_type(&pos) == PW_EVENT) ||
+   ((pos_type(&pos) == KS_EVENT) && pos_last(&pos) && (pos_type(&pos) == PW_EVENT)))
           dirty_bit(token) = 0;
 
 undo_semafor = OFF;
 
 DEBUG6( fprintf(stderr, " #Un_do \n"); dump_event_list(token, 500);)
 
-#ifdef old_dirty_bit
-if (!token->event_head || 
-   ((token->event_head->type == KS_EVENT) && 
-    (token->event_head->last == NULL))){ 
-       dirty_bit(token) = 0; /* file is no longer dirty */
-       return;
-}
-#endif  
-
 }   /* un_do() */
 
 /***********************************************************
 *
-*   re_do -  move forward on key_stroke on the  dlist and 
-*            effect the changes 
+*   re_do -  move forward on key_stroke on the  dlist and
+*            effect the changes
 *
 ***********************************************************/
 
 void re_do(DATA_TOKEN *token, int *line_out)
 {
 
-/*int line;*/
-/*char *ptr;*/
 int last_line = -1;
+int nothing = True;
+undo_log *log = token->undo_log;
+UNDO_POS pos;
 
 event_struct *event;
 
@@ -269,93 +332,91 @@ DEBUG6( fprintf(stderr, " @Re_do: ");dump_event_list(token, 500);)
 
 *line_out = INT_MAX;
 
-if (!token->event_head ||  /* if on a key_stroke get off before looking */
-    (token->event_head->next == NULL) ||
-    ((token->event_head->type == PW_EVENT) && (token->event_head->next != NULL) && (token->event_head->next->next == NULL))){ 
+if (log && log->head.event){
+   pos = log->head;
+   if (pos_next(&pos) &&
+       ((pos_type(&log->head) != PW_EVENT) || pos_next(&pos)))
+      nothing = False;
+}
+
+if (nothing){
        dm_error("Nothing to REDO", DM_ERROR_BEEP);
        return;
 }
 
 /*
- *  Walk forward on the event dlist until a key_stroke is found
+ *  Walk forward on the event list until a key_stroke is found
  */
 
-if (token->event_head && 
-    (token->event_head->type == KS_EVENT) && 
-    (token->event_head->next != NULL)) 
-       next_event(token); /* go forward over the key_stroke */
-
-event = token->event_head;
+if (pos_type(&log->head) == KS_EVENT) /* if on a key_stroke get off before looking */
+    pos_next(&log->head);             /* go forward over the key_stroke */
 
 undo_semafor = ON;   /* don't wnat the memdata(base) to log our changes! */
 
-while (event && (event->type != KS_EVENT)){
+while (pos_type(&log->head) != KS_EVENT){
 
-    if ((event->line < *line_out) && (event->line >= 0)) *line_out = event->line;
-    if (event->line > last_line) last_line = event->line;
+    event = log->head.event;
+    if (log->head.pw){
+        DEBUG6( fprintf(stderr, " EVENT[%d]\n", PW_EVENT);)
+        dirty_bit(token) = 0;
+    }else{
+        if ((event->line < *line_out) && (event->line >= 0)) *line_out = event->line;
+        if (event->line > last_line) last_line = event->line;
+
+        DEBUG6( fprintf(stderr, " EVENT[%d]\n", event->type);)
+
+        switch(event->type){
+             case  PC_EVENT:  /* put more code here */
+                             put_color_by_num(token, event->line, event->old_data);
+                             break;
+             case  PL_EVENT:
+                             if (event->paste_type == INSERT){
+                                 put_line_by_num(token, event->line, event->old_data, INSERT);
+                             }else{
+                                 put_line_by_num(token, event->line, event->old_data, OVERWRITE);
+                             }
+                             break;
 
-    DEBUG6( fprintf(stderr, " EVENT[%d]\n", event->type);)
+             case  DL_EVENT:
+                             delete_line_by_num(token, event->line, 1);
+                             break;
+
+             case  SW_EVENT:
+                             undo_bytes -= swap_bytes(event);
+                             swap_lines(token, EVENT_SWAPS(event), event->column);
+                             undo_bytes += swap_bytes(event);
+                             break;
 
-    switch(event->type){
-         case  PC_EVENT:  /* put more code here */
-                         put_color_by_num(token, event->line, event->old_data);
-                         break;
-         case  PL_EVENT:
-                         if (event->paste_type == INSERT){
-                             put_line_by_num(token, event->line, event->data, INSERT);
-                         }else{
-                             put_line_by_num(token, event->line, event->old_data, OVERWRITE);
-                         }
-                         break;
-     
-         case  DL_EVENT:
-                         delete_line_by_num(token, event->line, 1);
-                         break;
-     
-         case  PW_EVENT:
-                         dirty_bit(token) = 0;
-                         break;
-     
 #ifdef PUTBLOCK
 
-         case  RB_EVENT: 
-                         put_line_by_num(token, event->line, event->data, INSERT);
-                         free(event->data);
-                         event->malloc_size = 0;
-                         break;
-     
-#endif
-#ifdef blah
-         case  SL_EVENT:
-                         event->old_data[event->column] = NULL;
-                         put_line_by_num(token, event->line, event->old_data, OVERWRITE);
-                         free(event->old_data);
-                         event->malloc_old_size = 0;
-                         break;   /* paste_type also implies a new line was created */
-       
+             case  RB_EVENT:
+                             put_line_by_num(token, event->line, event->old_data, INSERT);
+                             undo_bytes -= strlen(event->old_data) + 1;
+                             free(event->old_data);
+                             event->old_data = NULL;
+                             break;
+
 #endif
-         case  ES_EVENT:
-         case  DS_EVENT:
-         default:
-                         dm_error("Program Error! (redo)", DM_ERROR_LOG);
-                         return;
+             case  ES_EVENT:
+             case  DS_EVENT:
+             default:
+                             dm_error("Program Error! (redo)", DM_ERROR_LOG);
+                             undo_semafor = OFF;
+                             return;
 
-    } /*switch */
+        } /*switch */
+    }
 
-    if ((event->next == NULL) && (event->type !=KS_EVENT)){ 
+    if (!pos_next(&log->head)){
         event_do(token, KS_EVENT, 0, 0, 0, NULL); /* terminate the redo */
         break;   /* dont go off the end */
     }
 
-    next_event(token); 
-    event = token->event_head;
-
-
-
 } /* while !key_stroke */
 
-if ((token->event_head->type == PW_EVENT) ||
-   ((token->event_head->type == KS_EVENT) && token->event_head->next && (token->event_head->next->type == PW_EVENT)))
+pos = log->head;
+if ((pos_type(&pos) == PW_EVENT) ||
+   ((pos_type(&pos) == KS_EVENT) && pos_next(&pos) && (pos_type(&pos) == PW_EVENT)))
         dirty_bit(token) = 0;
 
 DEBUG6( fprintf(stderr, " @Re_do[END](%d)\n", *line_out);)
@@ -367,59 +428,80 @@ undo_semafor = OFF;
 
 /***********************************************************
 *
-*   event_do -  Place an event on the dlist
+*   event_do -  Place an event on the list
 *
 ***********************************************************/
 
 void event_do(DATA_TOKEN *token,
               int event,
               int line,
-              int column,   
+              int column,
               int paste_type,
               char *data)
 {
 
-int len;
+int len = 0;
+undo_log *log = token->undo_log;
+UNDO_POS pos;
 event_struct *new_event;
 
 DEBUG0( if (token->marker != TOKEN_MARKER) {fprintf(stderr, "Bad token passed to event_do"); exit(8);})
-DEBUG6( fprintf(stderr, " @event_do[event=%s]H=%d\n", print_event(event), token->event_head);)
+DEBUG6( fprintf(stderr, " @event_do[event=%s]\n", print_event(event));)
 
 DEBUG6( fprintf(stderr, " BEFOR: ");dump_event_list(token, 500);)
 
-if (!WRITABLE(token)){
+if (!WRITABLE(token) || !log){
          DEBUG6( fprintf(stderr, " event_do - Attempt to event to a readonly window. 0x%X\n", token);)
-         return; 
+         return;
 }
 
-if (token->event_head &&  event == KS_EVENT &&   /* no events on the dlist since last key_stroke */
-    ((token->event_head->type == KS_EVENT) ||
-    ((token->event_head->type == PW_EVENT) && token->event_head->last && (token->event_head->last->type == KS_EVENT)))){
+pos = log->head;
+if (pos.event && (event == KS_EVENT) &&   /* no events on the list since last key_stroke */
+    ((pos_type(&pos) == KS_EVENT) ||
+    ((pos_type(&pos) == PW_EVENT) && pos_last(&pos) && (pos_type(&pos) == KS_EVENT)))){
          DEBUG6( fprintf(stderr, " event_do- \"event=%d is redundant!\"\n", event);)
-         return; 
+         return;
 }
-        
-/* #678 */
 
-/* merge mallocs for efficiency */
-/* cut extra check in free forwrd */
-new_event = (event_struct *)CE_MALLOC(sizeof(event_struct));
-if (!new_event)  return;
+/*
+ *  A pad write is a flag on the event it came after.  The events
+ *  after it are kept, they can still be redone.
+ */
+if (event == PW_EVENT){
+    remove_pwevents(token);
+    if (log->head.event){
+        log->head.event->flags |= EVENT_PW;
+        log->head.pw = True;
+        log->pw = log->head;
+    }
+    DEBUG6( fprintf(stderr, " AFTER: ");dump_event_list(token, 500);)
+    return;
+}
 
-if (data){
-  len = strlen(data) + 1;
-  new_event->data = (char *)CE_MALLOC(len);
-  new_event->malloc_size = len;
-  if (!new_event->data) return;
+free_forward(token);
+
+/*
+ *  Overwriting the line the last event overwrote adds nothing,
+ *  undo goes back to the text saved by the first one.
+ */
+pos = log->head;
+if ((event == PL_EVENT) && (paste_type == OVERWRITE) && !undo_semafor &&
+    pos.event && !pos.pw && (pos.event->type == PL_EVENT) &&
+    (pos.event->paste_type == OVERWRITE) && (pos.event->line == line)){
+         DEBUG6( fprintf(stderr, " event_do- overwrite of line %d merged\n", line);)
+         return;
 }
 
-if (event == KS_EVENT) free_forward(token); /* moved down 10/7/92 from #678 */
-if (event == PW_EVENT) remove_pwevents(token);
+if (data)
+   len = strlen(data) + 1;
+
+new_event = new_record(token, len);
+if (!new_event)  return;
 
-if ((event == PW_EVENT) || (event == KS_EVENT)) line = -1;
+if (event == KS_EVENT) line = -1;
 
 /*
- *  Put the new data in the event rec, and add the rec to the head of the dlist
+ *  Put the new data in the event rec, it is already at the end of the list
  */
 
 new_event->line = line;
@@ -427,32 +509,12 @@ new_event->column = column;
 new_event->type = event;
 new_event->paste_type = paste_type;
 new_event->old_data = NULL;
-new_event->malloc_old_size = 0; /* added 11/7/97 RES */
-if (data)
-     strcpy(new_event->data, data);
-else
-     new_event->data = NULL;
-
-new_event->last = token->event_head;
-if (token->event_head){ 
-       new_event->next = token->event_head->next; /* new */
-       if (token->event_head->next) token->event_head->next->last = new_event;
-       token->event_head->next = new_event;
-}else  /* else added */
-        new_event->next = NULL;
-token->event_head = new_event;
-
-if (event != PW_EVENT) free_forward(token);
-
-#ifdef blah
-new_event->last = token->event_head;
-if (token->event_head) 
-       token->event_head->next = new_event;
-new_event->next = NULL;
-token->event_head = new_event;
-#endif
+if (data){
+     memcpy((char *)(new_event + 1), data, len);
+     new_event->flags |= EVENT_DATA;
+}
 
-DEBUG6( fprintf(stderr, " event{ADDRS(%d),line(%d)}\n", new_event, line);)
+DEBUG6( fprintf(stderr, " event{ADDRS(0x%lX),line(%d)}\n", (unsigned long)new_event, line);)
 DEBUG6( fprintf(stderr, " @event_do[END]\n");)
 
 DEBUG6( fprintf(stderr, " AFTER: ");dump_event_list(token, 500);)
@@ -462,37 +524,364 @@ DEBUG6( fprintf(stderr, " AFTER: ");dump_event_list(token, 500);)
 
 /***********************************************************
 *
-*   free_forward - Free up everything forward of the current 
-*                  in the dlist
+*   event_swap -  Place a swap_lines event on the list.
+*                 The swaps array and the lines in it now
+*                 belong to the event.
+*
+***********************************************************/
+
+void event_swap(DATA_TOKEN *token,
+                LINE_SWAP  *swaps,
+                int         count)
+{
+
+event_struct *new_event;
+
+DEBUG0( if (token->marker != TOKEN_MARKER) {fprintf(stderr, "Bad token passed to event_swap"); exit(8);})
+DEBUG6( fprintf(stderr, " @event_swap[%d lines from %d]\n", count, swaps[0].line_no);)
+
+new_event = NULL;
+if (WRITABLE(token) && token->undo_log){
+   free_forward(token);
+   new_event = new_record(token, sizeof(LINE_SWAP *));
+}
+
+if (!new_event){
+   while (count-- > 0)
+      if (swaps[count].text)
+         free(swaps[count].text);
+   free((char *)swaps);
+   return;
+}
+
+new_event->line = swaps[0].line_no;
+new_event->column = count;
+new_event->type = SW_EVENT;
+new_event->paste_type = OVERWRITE;
+new_event->old_data = NULL;
+EVENT_SWAPS(new_event) = swaps;
+undo_bytes += swap_bytes(new_event);
+spill_chunks(token->undo_log);
+
+DEBUG6( fprintf(stderr, " AFTER: ");dump_event_list(token, 500);)
+
+} /* event_swap() */
+
+/***********************************************************
+*
+*   event_pw_failed - The write the last PW_EVENT marked did
+*                     not reach the file.  Take the mark back
+*                     so undo does not clear the dirty bit at
+*                     a place which was never saved.
+*
+***********************************************************/
+
+void event_pw_failed(DATA_TOKEN *token)
+{
+
+DEBUG0( if (token->marker != TOKEN_MARKER) {fprintf(stderr, "Bad token passed to event_pw_failed"); exit(8);})
+DEBUG6( fprintf(stderr, " @event_pw_failed\n");)
+
+if (!token->undo_log)
+   return;
+
+remove_pwevents(token);
+
+DEBUG6( fprintf(stderr, " AFTER: ");dump_event_list(token, 500);)
+
+} /* event_pw_failed() */
+
+/***********************************************************
+*
+*   new_record - Make room for a record at the end of the log
+*                with len bytes of data after it and make it
+*                the head.  The caller fills it in.
+*
+***********************************************************/
+
+static event_struct *new_record(DATA_TOKEN *token, int len)
+{
+
+undo_log *log = token->undo_log;
+undo_chunk *chunk = log->end;
+event_struct *new_event;
+unsigned int size = EVENT_ROUND(sizeof(event_struct) + len);
+unsigned int room;
+
+if (!chunk || (chunk->used + size > chunk->size)){
+    if (log->spare && (log->spare->size >= size)){
+        chunk = log->spare;
+        log->spare = NULL;
+    }else{
+        room = chunk ? chunk->size * 2 : UNDO_CHUNK_MIN;
+        if (room > UNDO_CHUNK_MAX)
+            room = UNDO_CHUNK_MAX;
+        if (room < size)
+            room = size;
+        chunk = (undo_chunk *)CE_MALLOC(sizeof(undo_chunk));
+        if (!chunk) return(NULL);
+        chunk->area = CE_MALLOC(room);
+        if (!chunk->area){
+            free((char *)chunk);
+            return(NULL);
+        }
+        chunk->size = room;
+        undo_bytes += room;
+    }
+    chunk->used = 0;
+    chunk->last_rec = 0;
+    chunk->next = NULL;
+    chunk->last = log->end;
+    chunk->seq = log->end ? log->end->seq + 1 : 0;
+    if (log->end)
+        log->end->next = chunk;
+    else
+        log->first = chunk;
+    log->end = chunk;
+    spill_chunks(log);
+}
+
+new_event = (event_struct *)(CHUNK_AREA(chunk) + chunk->used);
+memset((char *)new_event, 0, sizeof(event_struct));
+new_event->size = size;
+new_event->last_size = chunk->used ? chunk->used - chunk->last_rec : 0;
+chunk->last_rec = chunk->used;
+chunk->used += size;
+
+log->head.chunk = chunk;
+log->head.event = new_event;
+log->head.pw = False;
+
+return(new_event);
+
+} /* new_record */
+
+/***********************************************************
+*
+*   rec_last - Find the live record before a record.
+*              Returns False at the start of the list.
+*
+***********************************************************/
+
+static int rec_last(undo_chunk **chunk, event_struct **event)
+{
+
+undo_chunk *c = *chunk;
+event_struct *e = *event;
+
+do{
+   if (e->last_size)
+       e = (event_struct *)((char *)e - e->last_size);
+   else{
+       c = c->last;
+       if (!c || (!c->area && !page_in(c))) return(False);
+       e = (event_struct *)(CHUNK_AREA(c) + c->last_rec);
+   }
+} while (e->flags & EVENT_DEAD);
+
+*chunk = c;
+*event = e;
+return(True);
+
+} /* rec_last */
+
+/***********************************************************
+*
+*   rec_next - Find the live record after a record.
+*              Returns False at the end of the list.
+*
+***********************************************************/
+
+static int rec_next(undo_chunk **chunk, event_struct **event)
+{
+
+undo_chunk *c = *chunk;
+event_struct *e = *event;
+unsigned int offset;
+
+do{
+   offset = ((char *)e - CHUNK_AREA(c)) + e->size;
+   if (offset < c->used)
+       e = (event_struct *)(CHUNK_AREA(c) + offset);
+   else{
+       c = c->next;
+       if (!c || !c->used || (!c->area && !page_in(c))) return(False);
+       e = (event_struct *)CHUNK_AREA(c);
+   }
+} while (e->flags & EVENT_DEAD);
+
+*chunk = c;
+*event = e;
+return(True);
+
+} /* rec_next */
+
+/***********************************************************
+*
+*   pos_last - move a position back to the last event.
+*              The pad write after an event comes between
+*              it and the event after it.
+*
+***********************************************************/
+
+static int pos_last(UNDO_POS *pos)
+{
+
+DEBUG6( fprintf(stderr, " @pos_last\n");)
+
+if (pos->pw){
+    pos->pw = False;
+    return(True);
+}
+
+if (!rec_last(&pos->chunk, &pos->event))
+    return(False);
+
+pos->pw = (pos->event->flags & EVENT_PW) != 0;
+return(True);
+
+} /* pos_last */
+
+/***********************************************************
+*
+*   pos_next - move a position on to the next event
+*
+***********************************************************/
+
+static int pos_next(UNDO_POS *pos)
+{
+
+DEBUG6( fprintf(stderr, " @pos_next\n");)
+
+if (!pos->pw && (pos->event->flags & EVENT_PW)){
+    pos->pw = True;
+    return(True);
+}
+
+if (!rec_next(&pos->chunk, &pos->event))
+    return(False);
+
+pos->pw = False;
+return(True);
+
+} /* pos_next */
+
+/***********************************************************
+*
+*   pos_type - get the type of the event at a position
+*
+***********************************************************/
+
+static int pos_type(UNDO_POS *pos)
+{
+
+return(pos->pw ? PW_EVENT : pos->event->type);
+
+} /* pos_type */
+
+/***********************************************************
+*
+*   free_event - Free the memory an event holds outside the
+*                log and return how much it was.
+*
+***********************************************************/
+
+static int free_event(event_struct *event)
+{
+
+LINE_SWAP *swaps;
+int mem_sum = 0;
+int i;
+
+if ((event->type == SW_EVENT) && EVENT_SWAPS(event)){
+   mem_sum += swap_bytes(event);
+   swaps = EVENT_SWAPS(event);
+   for (i = 0; i < event->column; i++)
+      if (swaps[i].text)
+         free(swaps[i].text);
+   free((char *)swaps);
+   EVENT_SWAPS(event) = NULL;
+}
+
+if (event->old_data){
+   mem_sum += strlen(event->old_data) + 1;
+   free(event->old_data);
+   event->old_data = NULL;
+}
+
+undo_bytes -= mem_sum;
+return(mem_sum);
+
+} /* free_event */
+
+/***********************************************************
+*
+*   free_forward - Free up everything forward of the current
+*                  position in the list
 *
 ***********************************************************/
 
 static int free_forward(DATA_TOKEN *token)
 {
 int mem_sum = 0;
-event_struct *kill_event, *last_event;
+undo_log *log = token->undo_log;
+undo_chunk *chunk, *kill_chunk;
+event_struct *event;
+unsigned int offset;
 
 DEBUG6( fprintf(stderr, " @Free_forward\n");)
 
-if (!token->event_head) return(0);
+if (!log->head.event) return(0);
 
-kill_event = token->event_head->next;
+/*
+ *  A pad write right after the head is forward of it.
+ */
+if (!log->head.pw && (log->head.event->flags & EVENT_PW)){
+   log->head.event->flags &= ~EVENT_PW;
+   log->pw.event = NULL;
+}
+if (log->pw.event &&
+    ((log->pw.chunk->seq > log->head.chunk->seq) ||
+     ((log->pw.chunk == log->head.chunk) && (log->pw.event > log->head.event))))
+   log->pw.event = NULL;  /* in the part being freed */
 
-while (kill_event){
-   mem_sum += kill_event->malloc_size + kill_event->malloc_old_size + sizeof(event_struct);
-   if (kill_event->type != KS_EVENT){
-       if (kill_event->data)
-           free(kill_event->data);
-       if (kill_event->old_data)
-           free(kill_event->old_data);
+/*
+ *  Records after the head only hold memory of their own once they
+ *  have been undone or if they are swaps.
+ */
+chunk = log->head.chunk;
+event = log->head.event;
+offset = ((char *)event - CHUNK_AREA(chunk)) + event->size;
+while (chunk){
+   while (chunk->area && (offset < chunk->used)){
+      event = (event_struct *)(CHUNK_AREA(chunk) + offset);
+      mem_sum += event->size + free_event(event);
+      offset += event->size;
    }
-   last_event = kill_event;
-   kill_event = kill_event->next;
-   free((char *)last_event);
+   chunk = chunk->next;
+   offset = 0;
 }
 
-/* All the elements we freed are gone - 10/7/93  RES */
-token->event_head->next = NULL;
+/*
+ *  Cut the log off after the head.  One empty chunk is kept.
+ */
+chunk = log->head.chunk;
+event = log->head.event;
+chunk->last_rec = (char *)event - CHUNK_AREA(chunk);
+chunk->used = chunk->last_rec + event->size;
+
+kill_chunk = chunk->next;
+chunk->next = NULL;
+log->end = chunk;
+while (kill_chunk){
+   chunk = kill_chunk;
+   kill_chunk = kill_chunk->next;
+   if (chunk->area && (!log->spare || (log->spare->size < chunk->size))){
+      if (log->spare) free_chunk(log->spare);
+      log->spare = chunk;
+   }else
+      free_chunk(chunk);
+}
 
 return(mem_sum);
 
@@ -500,41 +889,40 @@ return(mem_sum);
 
 /***********************************************************
 *
-*   remove_pwevents - Remove any pw event in the linked list
-*                     before placing the new one.
+*   remove_pwevents - Remove the pad write event before
+*                     placing the new one.
 *
 ***********************************************************/
 
 static void remove_pwevents(DATA_TOKEN *token)
 {
-int mem_sum = 0;
-event_struct *kill_event, *last_event, *next_event;;
+undo_log *log = token->undo_log;
+UNDO_POS pos;
 
 DEBUG6( fprintf(stderr, " @Remove PW Events()\n");)
 
-if (!token->event_head) return;
+if (!log->pw.event) return;
 
-kill_event = token->event_head;
+log->pw.event->flags &= ~EVENT_PW;
+if (log->head.pw && (log->head.event == log->pw.event))
+   log->head.pw = False;
 
-while(kill_event->next)
-    kill_event = kill_event->next;  /* get to the top of the dlist */
-
-while (kill_event){
-   next_event = kill_event->next;
-   last_event = kill_event->last;
-   if (kill_event->type == PW_EVENT){ 
-      if (kill_event == token->event_head) token->event_head = kill_event->next;
-      rm_event(kill_event);
-      if (last_event && (last_event->type == KS_EVENT) &&
-          next_event && (next_event->type == KS_EVENT)){ 
-                    if (next_event == token->event_head) token->event_head = next_event->next;
-                    rm_event(next_event);
-                    next_event = last_event->next;
-      }
+/*
+ *  A key stroke on both sides of the write leaves two in a row,
+ *  drop the second one.
+ */
+pos = log->pw;
+pos.pw = False;
+if ((log->pw.event->type == KS_EVENT) && rec_next(&pos.chunk, &pos.event) && (pos.event->type == KS_EVENT)){
+   pos.event->flags |= EVENT_DEAD;
+   if (log->head.event == pos.event){
+      log->head = log->pw;
+      log->head.pw = False;
    }
-   kill_event = last_event;
 }
 
+log->pw.event = NULL;
+
 DEBUG6( fprintf(stderr, " @Remove PW Events/Done\n");dump_event_list(token, 500);)
 return;
 
@@ -542,113 +930,375 @@ return;
 
 /***********************************************************
 *
-*   rm_event - remove move an event from the dlist
+*   undo_init - initialize the undo list
+*
+***********************************************************/
+
+void undo_init(DATA_TOKEN *token)
+{
+
+if (!token->undo_log){
+   token->undo_log = (undo_log *)CE_MALLOC(sizeof(undo_log));
+   if (!token->undo_log) return;
+   memset((char *)token->undo_log, 0, sizeof(undo_log));
+}
+
+kill_event_dlist(token);
+if (token->undo_log->first){
+   token->undo_log->first->used = 0;
+   token->undo_log->first->last_rec = 0;
+}
+token->undo_log->end = token->undo_log->first;
+token->undo_log->head.event = NULL;
+
+event_do(token, KS_EVENT, 0, 0, 0, NULL); /* init the undo list with a key stroke */
+event_do(token, PW_EVENT, 0, 0, 0, NULL); /* init the undo list with a key stroke */
+
+} /* undo_init() */
+
+/***********************************************************
+*
+*   kill_event_dlist - kill all events on the list but the
+*                      first.
 *
-*   NOTE: This routine does not free the memory from the 
-*         data or old_data fields.
 ***********************************************************/
 
-static void rm_event(event_struct *kill_event)
+int kill_event_dlist(DATA_TOKEN *token)
 {
 
-DEBUG6( fprintf(stderr, " @rm_event\n");)
+int freed;
+undo_log *log = token->undo_log;
+
+if (!log || !log->head.event) return(0);
+
+log->head.chunk = log->first;               /* get to the bottom of the list */
+log->head.event = (event_struct *)CHUNK_AREA(log->first);
+log->head.pw = False;
+
+freed = free_forward(token);
 
-if (kill_event->next) 
-      (kill_event->next)->last = kill_event->last;
+if (log->spare){
+   freed += log->spare->size;
+   free_chunk(log->spare);
+   log->spare = NULL;
+}
 
-if (kill_event->last)
-      (kill_event->last)->next = kill_event->next;
+DEBUG6( fprintf(stderr, " @kill_event_dlist freed(%d) bytes\n", freed);)
 
-free((char *)kill_event);
+return(freed);
 
-} /* rm_event() */
+}  /* kill_event_dlist() */
 
 /***********************************************************
 *
-*   next_event - move event_head on to the next event
+*   undo_free - free the undo list of a token being killed
 *
 ***********************************************************/
 
-static void next_event(DATA_TOKEN *token)
+void undo_free(DATA_TOKEN *token)
 {
 
-DEBUG6( fprintf(stderr, " @next_event\n");)
+undo_log *log = token->undo_log;
+undo_chunk *chunk;
 
-if (token->event_head) 
-    token->event_head =  token->event_head->next;
+if (!log) return;
 
-} /* next _event */
+kill_event_dlist(token);
+if (log->head.event)
+   free_event(log->head.event);
+
+while (log->first){
+   chunk = log->first;
+   log->first = chunk->next;
+   free_chunk(chunk);
+}
+
+free((char *)log);
+token->undo_log = NULL;
+
+}  /* undo_free() */
 
 /***********************************************************
 *
-*   last_event - move event_head back to the last event
+*   undo_limit - set the memory limit for undo in kilobytes,
+*                zero for no limit.  From -undomem.
 *
 ***********************************************************/
 
-static void last_event(DATA_TOKEN *token)
+void undo_limit(int kbytes)
 {
 
-DEBUG6( fprintf(stderr, " @last_event\n");)
+undo_limit_bytes = (kbytes > 0) ? kbytes * 1024L : 0;
 
-if (token->event_head) 
-    token->event_head =  token->event_head->last;
+}  /* undo_limit() */
 
-} /* last _event */
+/***********************************************************
+*
+*   free_chunk - free a chunk, the records in it have
+*                already been freed or spilled.
+*
+***********************************************************/
+
+static void free_chunk(undo_chunk *chunk)
+{
+
+if (chunk->area){
+   free(chunk->area);
+   undo_bytes -= chunk->size;
+}else if (--spill_count == 0){
+   /* nothing left out there, start the file over */
+#ifndef WIN32
+   ftruncate(fileno(spill_fp), 0);
+#endif
+   rewind(spill_fp);
+}
+free((char *)chunk);
+
+}  /* free_chunk() */
 
 /***********************************************************
 *
-*   undo_init - initialize the undo dlist
+*   swap_bytes - memory held by a swap_lines event, the
+*                array and the lines in it.
 *
 ***********************************************************/
 
-void undo_init(DATA_TOKEN *token)
+static long swap_bytes(event_struct *event)
 {
 
-kill_event_dlist(token);
+LINE_SWAP *swaps = EVENT_SWAPS(event);
+long sum = event->column * sizeof(LINE_SWAP);
+int i;
 
-token->event_head = NULL;
+for (i = 0; i < event->column; i++)
+   if (swaps[i].text)
+      sum += ABSVALUE(swaps[i].size);
 
-event_do(token, KS_EVENT, 0, 0, 0, NULL); /* init the undo dlist with a key stroke */
-event_do(token, PW_EVENT, 0, 0, 0, NULL); /* init the undo dlist with a key stroke */
+return(sum);
 
-} /* undo_init() */
+}  /* swap_bytes() */
 
 /***********************************************************
 *
-*   kill_event_dlist - kill all events on the dlist
+*   spill_chunks - write the oldest chunks behind the head
+*                  to the spill file until undo is back
+*                  under the limit.  The first chunk, the
+*                  head's and the pad write's stay in memory.
 *
 ***********************************************************/
 
-int kill_event_dlist(DATA_TOKEN *token)
+static void spill_chunks(undo_log *log)
 {
 
-int freed;
+undo_chunk *chunk;
+
+if (!undo_limit_bytes || (undo_bytes <= undo_limit_bytes) || !log->head.event)
+   return;
+
+for (chunk = log->first->next;
+     chunk && (chunk->seq < log->head.chunk->seq) && (undo_bytes > undo_limit_bytes);
+     chunk = chunk->next)
+   if (chunk->area && (!log->pw.event || (chunk != log->pw.chunk)))
+      if (!spill_chunk(chunk))
+         return;
+
+}  /* spill_chunks() */
+
+/***********************************************************
+*
+*   spill_chunk - write a chunk to the end of the spill file
+*                 and free its records.  The records go out
+*                 as they are, followed by the text their
+*                 events hold outside the chunk, in record
+*                 order.  page_in reverses this.
+*
+***********************************************************/
+
+static int spill_chunk(undo_chunk *chunk)
+{
 
 event_struct *event;
+LINE_SWAP *swaps;
+unsigned int offset;
+int len;
+int i;
+int ok;
+long start;
+
+if (!spill_fp){
+   spill_fp = tmpfile();
+   if (!spill_fp){
+      dm_error("Cannot create the undo spill file, -undomem ignored", DM_ERROR_LOG);
+      undo_limit_bytes = 0;
+      return(False);
+   }
+}
 
-event = token->event_head;
+ok = (fseek(spill_fp, 0L, SEEK_END) == 0);
+start = ftell(spill_fp);
+if (ok)
+   ok = (fwrite(chunk->area, 1, chunk->used, spill_fp) == chunk->used);
+
+for (offset = 0; ok && (offset < chunk->used); offset += event->size){
+   event = (event_struct *)(chunk->area + offset);
+   if (event->old_data){
+      len = strlen(event->old_data) + 1;
+      ok = (fwrite((char *)&len, sizeof(len), 1, spill_fp) == 1) &&
+           (fwrite(event->old_data, 1, len, spill_fp) == len);
+   }
+   if ((event->type == SW_EVENT) && ok){
+      swaps = EVENT_SWAPS(event);
+      ok = (fwrite((char *)swaps, sizeof(LINE_SWAP), event->column, spill_fp) == event->column);
+      for (i = 0; ok && (i < event->column); i++)
+         if (swaps[i].text){
+            len = strlen(swaps[i].text) + 1;
+            ok = (fwrite((char *)&len, sizeof(len), 1, spill_fp) == 1) &&
+                 (fwrite(swaps[i].text, 1, len, spill_fp) == len);
+         }
+   }
+}
 
-if (!event) return(0);
+if (!ok || (fflush(spill_fp) != 0)){
+   dm_error("Cannot write the undo spill file, -undomem ignored", DM_ERROR_LOG);
+   undo_limit_bytes = 0;
+   return(False);
+}
 
-while (event->last)       /* get to the bottom of the list */
-       event =  event->last;
+chunk->spill_offset = start;
+chunk->spill_bytes = ftell(spill_fp) - start;
 
-token->event_head = event;
+for (offset = 0; offset < chunk->used; offset += event->size){
+   event = (event_struct *)(chunk->area + offset);
+   free_event(event);
+}
+free(chunk->area);
+chunk->area = NULL;
+undo_bytes -= chunk->size;
+spill_count++;
 
-freed = free_forward(token);
+DEBUG6( fprintf(stderr, " @spill_chunk(%d) %d bytes at %ld, undo now %ld bytes\n", chunk->seq, chunk->spill_bytes, start, undo_bytes);)
 
-DEBUG6( fprintf(stderr, " @kill_event_dlist freed(%d) bytes\n", freed);)
+return(True);
 
-return(freed);
+}  /* spill_chunk() */
 
-}  /* kill_event_dlist() */
+/***********************************************************
+*
+*   page_in - read a spilled chunk back into memory.  The
+*             pointers in the records read back are stale,
+*             they only say which events had data outside
+*             the chunk.  If memory runs out part way, what
+*             was read back is freed and the chunk stays
+*             spilled.
+*
+***********************************************************/
+
+static int page_in(undo_chunk *chunk)
+{
+
+event_struct *event;
+LINE_SWAP *swaps;
+char *extra;
+char *ptr;
+unsigned int offset;
+unsigned int last;
+long save_bytes;
+int len;
+int i;
+
+chunk->area = CE_MALLOC(chunk->size);
+if (!chunk->area) return(False);
+extra = CE_MALLOC(chunk->spill_bytes - chunk->used + 1);
+if (!extra){
+   free(chunk->area);
+   chunk->area = NULL;
+   return(False);
+}
+
+if ((fseek(spill_fp, chunk->spill_offset, SEEK_SET) != 0) ||
+    (fread(chunk->area, 1, chunk->used, spill_fp) != chunk->used) ||
+    (fread(extra, 1, chunk->spill_bytes - chunk->used, spill_fp) != chunk->spill_bytes - chunk->used)){
+   dm_error("Cannot read the undo spill file", DM_ERROR_BEEP);
+   free(chunk->area);
+   chunk->area = NULL;
+   free(extra);
+   return(False);
+}
+save_bytes = undo_bytes;
+undo_bytes += chunk->size;
+spill_count--;
+
+ptr = extra;
+for (offset = 0; offset < chunk->used; offset += event->size){
+   event = (event_struct *)(chunk->area + offset);
+   if (event->old_data){
+      memcpy((char *)&len, ptr, sizeof(len));
+      ptr += sizeof(len);
+      event->old_data = CE_MALLOC(len);
+      if (!event->old_data){
+         if (event->type == SW_EVENT) EVENT_SWAPS(event) = NULL; /* still stale */
+         break;
+      }
+      memcpy(event->old_data, ptr, len);
+      ptr += len;
+      undo_bytes += len;
+   }
+   if (event->type == SW_EVENT){
+      swaps = (LINE_SWAP *)CE_MALLOC(event->column * sizeof(LINE_SWAP) + 1);
+      if (!swaps){
+         EVENT_SWAPS(event) = NULL;
+         break;
+      }
+      memcpy((char *)swaps, ptr, event->column * sizeof(LINE_SWAP));
+      ptr += event->column * sizeof(LINE_SWAP);
+      EVENT_SWAPS(event) = swaps;
+      for (i = 0; i < event->column; i++)
+         if (swaps[i].text){
+            memcpy((char *)&len, ptr, sizeof(len));
+            ptr += sizeof(len);
+            swaps[i].text = CE_MALLOC(MAX(len, ABSVALUE(swaps[i].size)));
+            if (!swaps[i].text) break;
+            memcpy(swaps[i].text, ptr, len);
+            ptr += len;
+         }
+      if (i < event->column){
+         for (; i < event->column; i++)
+            swaps[i].text = NULL; /* the rest are still stale */
+         break;
+      }
+      undo_bytes += swap_bytes(event);
+   }
+}
+
+/* out of memory, free what was read back up to this event and leave the chunk spilled */
+if (offset < chunk->used){
+   last = offset;
+   for (offset = 0; offset <= last; offset += event->size){
+      event = (event_struct *)(chunk->area + offset);
+      free_event(event);
+   }
+   undo_bytes = save_bytes;
+   spill_count++;
+   free(chunk->area);
+   chunk->area = NULL;
+   free(extra);
+   return(False);
+}
+
+free(extra);
+
+DEBUG6( fprintf(stderr, " @page_in(%d) %d bytes from %ld, undo now %ld bytes\n", chunk->seq, chunk->spill_bytes, chunk->spill_offset, undo_bytes);)
+
+return(True);
+
+}  /* page_in() */
 
 #ifdef DebuG
 /***********************************************************
 *
 *   dump_event_list - dah'   :-)
 *
-*                count is the max number of events to dump 
+*                count is the max number of events to dump
 *                         (helps to reduce the output)
 *
 ***********************************************************/
@@ -656,25 +1306,30 @@ return(freed);
 void dump_event_list(DATA_TOKEN *token, int count)
 {
 
-
-event_struct *event;
+undo_log *log = token->undo_log;
+UNDO_POS pos;
 
 DEBUG6( fprintf(stderr, " Dump_event_list:\n");)
 
-if (!token->event_head) return;
+if (!log || !log->head.event) return;
 
-event = token->event_head;
+pos.chunk = log->end;
+pos.event = (event_struct *)(CHUNK_AREA(log->end) + log->end->last_rec);
+pos.pw = False;
+if (pos.event->flags & EVENT_DEAD)
+   rec_last(&pos.chunk, &pos.event);
+pos.pw = (pos.event->flags & EVENT_PW) != 0;
 
-while(event->next)
-  event = event->next;  /* get to the top of the dlist */
-
-while (event && count){       /* get to the bottom of the list */
+do{       /* from the top of the list to the bottom */
        count--;
-       if (event == token->event_head) fprintf(stderr, "HEAD->");
-       fprintf(stderr, "   Event: %-20s(%d), ms(%d), mos(%d), l(%d), c(%d), pt(%d), d(%d), od(%d), n(%d), l(%d)\n", 
-               print_event(event->type), event, event->malloc_size, event->malloc_old_size, event->line, event->column, event->paste_type, event->data, event->old_data, event->next, event->last);
-       event = event->last;
-}
+       if ((pos.event == log->head.event) && (pos.pw == log->head.pw)) fprintf(stderr, "HEAD->");
+       if (pos.pw)
+          fprintf(stderr, "   Event: %-20s\n", print_event(PW_EVENT));
+       else
+          fprintf(stderr, "   Event: %-20s(0x%lX), size(%d), l(%d), c(%d), pt(%d), d(%s), od(%s)\n",
+                  print_event(pos.event->type), (unsigned long)pos.event, pos.event->size, pos.event->line, pos.event->column,
+                  pos.event->paste_type, (pos.event->flags & EVENT_DATA) ? EVENT_TEXT(pos.event) : "", pos.event->old_data ? pos.event->old_data : "");
+} while (count && pos_last(&pos));
 
 }  /* dump__event_list() */
 
@@ -691,35 +1346,39 @@ switch(event){
 
 case  PL_EVENT:
                return("PUT_LINE_EVENT");
-      break;         
-               
+      break;
+
 case  DL_EVENT:
                return("DELETE_LINE_EVENT");
-      break;         
-               
+      break;
+
 case  RB_EVENT:
                return("READ_BLOCK_EVENT");
-      break;         
-               
+      break;
+
 case  KS_EVENT:
                return("KEY_STROKE_EVENT");
-      break;         
+      break;
 
 case  SL_EVENT:
                return("SPLIT_LINE_EVENT");
-      break;         
+      break;
 
 case  PC_EVENT:
                return("PUT_COLOR_EVENT");
-      break;         
+      break;
 
 case  PW_EVENT:
                return("PAD_WRITE_EVENT");
-      break;         
-               
+      break;
+
+case  SW_EVENT:
+               return("SWAP_LINES_EVENT");
+      break;
+
 case  ES_EVENT:
 case  DS_EVENT:
-default:       
+default:
           dm_error("No Such event type.", DM_ERROR_LOG);
           return("NO_SUCH_EVENT");
 }
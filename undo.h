@@ -45,6 +45,7 @@
 #define SL_EVENT  6  /* Split_line                                 */
 #define PC_EVENT  7  /* Put Color                                  */
 #define PW_EVENT  8  /* Pad Write event                            */
+#define SW_EVENT  9  /* Swap_lines, many lines replaced at once     */
 
 #define ON  1
 #define OFF 0
@@ -66,9 +67,18 @@ void event_do(DATA_TOKEN *token,
               int paste_type,   /* if paste, was it OVERWRITE or INSERT */
               char *data);      /* data being deleted ... */
 
+void event_swap(DATA_TOKEN *token,
+                LINE_SWAP  *swaps,  /* lines replaced, owned by the event */
+                int         count); /* number of swaps */
+
+void event_pw_failed(DATA_TOKEN *token); /* used by pw when a background write fails */
+
 void undo_init(DATA_TOKEN *token);    /* used by memdata  */
 
 int kill_event_dlist(DATA_TOKEN *token);
 
+void undo_free(DATA_TOKEN *token);    /* used by memdata  */
+void undo_limit(int kbytes);          /* used by winsetup */
+
 #endif
 
@@ -74,7 +74,9 @@
 #include "dmc.h"
 #include "dmwin.h"
 #include "getevent.h"
+#include "hlmatch.h"
 #include "init.h"
+#include "lock.h"
 #include "pad.h"
 #include "parms.h"
 #include "pw.h"
@@ -479,6 +481,10 @@ XCopyArea(main_pad->display_data->display, main_pad->display_data->x_pixmap, mai
           main_pad->window->width, main_pad->window->sub_height,
           0, main_pad->window->sub_y);
 
+hlmatch_overlay(main_pad->display_data,
+                0, main_pad->window->sub_y,
+                main_pad->window->width, main_pad->window->sub_height);
+
 XFlush(main_pad->display_data->display);
 
 
@@ -662,6 +668,7 @@ while(!done)
                (lines_read_from_shell ? Shell_socket : -1),
                *cmd_fd,
                &readfds, &writefds);
+   nfds = MAX(nfds, (watch_fdset(&readfds)+1));  /* in lock.c */
 #ifdef  HAVE_X11_SM_SMLIB_H
    if (dspl_descr->xsmp_active)
       nfds = MAX(nfds,(xsmp_fdset(dspl_descr->xsmp_private_data, &readfds)+1));  /* in xsmp.c */
@@ -681,6 +688,7 @@ while(!done)
             fprintf(stderr, "wait_for_input: select interupted(%d), retrying (%s)\n", nfound, strerror(errno));
       )
       setup_fdset(dspl_descr, Shell_socket, *cmd_fd, &readfds, &writefds);
+      nfds = MAX(nfds, (watch_fdset(&readfds)+1));  /* in lock.c */
 #ifdef  HAVE_X11_SM_SMLIB_H
       if (dspl_descr->xsmp_active)
          nfds = MAX(nfds,(xsmp_fdset(dspl_descr->xsmp_private_data, &readfds)+1));  /* in xsmp.c */
@@ -691,6 +699,8 @@ while(!done)
             DEBUG22(fprintf(stderr, "X Data is ready on queued list(a)\n");)
             break;
          }
+      if (watch_ready(NULL)) /* a poll in timeout_set saw the edit file change */
+         break;
       DEBUG22(
          if (time_ptr)
             fprintf(stderr, "Select timeout %d seconds, %d microseconds\n",  time_ptr->tv_sec, time_ptr->tv_usec);
@@ -716,6 +726,15 @@ while(!done)
          break;
       }
 
+   /**************************************************************
+   *  If the edit file changed, return so the reload prompt can go up.
+   **************************************************************/
+   if (watch_ready((nfound > 0) ? &readfds : NULL))
+      {
+         DEBUG22(fprintf(stderr, "Edit file changed\n");)
+         done = True;
+      }
+
    /**************************************************************
    *  cmd fd data, read it and return.  Routine creates a fake keypress event.
    **************************************************************/
@@ -48,6 +48,8 @@
 #include "display.h"
 #include "getevent.h"
 #include "init.h"
+#include "journal.h"
+#include "autoimage.h"
 #ifdef PAD
 #include "pad.h"
 #endif
@@ -181,6 +183,7 @@ case '\0':
 /* FALLTHRU */
 case 'f':
 case 'w':
+   pw_wait(); /* a background pw must be done before the dirty bit means anything */
    if (dmc->wc.type == 'w')
       dash_w = True;
    if (dmc->wc.type == 'f')
@@ -206,6 +209,7 @@ case 'q':
          break;
       }
 #endif
+   pw_wait();
    if (!dirty_bit(dspl_descr->main_pad->token) || no_prompt)
       shut_down = True;
    else
@@ -275,7 +279,11 @@ if (shut_down || dash_f)
       DEBUG9(XERRORPOS)
       XCloseDisplay(dspl_descr->display);
       if (del_display(dspl_descr) || dash_f)
-         exit(0);
+         {
+            journal_close(); /* in journal.c, clean exit, the journal is not needed */
+            autoimage_close(); /* in autoimage.c */
+            exit(0);
+         }
       else
          {
             set_global_dspl(next_dspl_descr);
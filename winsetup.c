@@ -81,6 +81,8 @@
 #include "titlebar.h"
 #include "tab.h"
 #include "typing.h"
+#include "undo.h"
+#include "autoimage.h"
 #include "unixwin.h"
 #include "vt100.h"   /* needed for free_drawable */
 #include "wdf.h"
@@ -331,6 +333,28 @@ if (AUTOSAVE)
          }
    }
 
+if (UNDOMEM)
+   {
+      if ((sscanf(UNDOMEM, "%d%9s", &i, msg) == 1) && (i >= 0))  /* msg is a scrap variable here */
+         undo_limit(i);
+      else
+         {
+            snprintf(msg, sizeof(msg), "Bad undomem value %s, undo memory not limited", UNDOMEM);
+            dm_error_dspl(msg, DM_ERROR_BEEP, dspl_descr);
+         }
+   }
+
+if (AUTOIMAGE)
+   {
+      if ((sscanf(AUTOIMAGE, "%d%9s", &i, msg) == 1) && (i > 0))  /* msg is a scrap variable here */
+         autoimage_interval(i);
+      else
+         {
+            snprintf(msg, sizeof(msg), "Bad autoimage value %s, no autosave images", AUTOIMAGE);
+            dm_error_dspl(msg, DM_ERROR_BEEP, dspl_descr);
+         }
+   }
+
 if ((LINENO_PARM[0] | 0x20) == 'y')
    dspl_descr->show_lineno = 1;
 else
@@ -79,6 +79,7 @@
 #endif
 #include "dmwin.h"
 #include "getevent.h"
+#include "journal.h"
 #include "memdata.h"
 #include "normalize.h"
 #ifdef PAD
@@ -543,6 +544,26 @@ if (dspl_descr->pad_mode)
 BACKUP_TYPE = "n";
 OPTION_VALUES[LOCKF_IDX] = "no"; /* don't worry about cleaning up at this point */
 
+/***************************************************************
+*  
+*  If the changes are being journaled, all that is needed is to
+*  get the last of them onto the disk.  ce -recover replays the
+*  journal over the file.
+*  
+***************************************************************/
+
+if (journal_active())
+   {
+      journal_commit(); /* in journal.c */
+      stream = fopen(ERROR_LOG, "a");
+      if (stream != NULL)
+         {
+            fprintf(stream, "%s XIOERROR PID(%d) UID(%d) Journal kept for recovery: %s%s\n", CURRENT_TIME, getpid(), getuid(), edit_file, JOURNAL_SUFFIX);
+            fclose(stream);
+         }
+      return(0);
+   }
+
 /***************************************************************
 *  
 *  First create a crash file in the current directory.  If that
@@ -0,0 +1,697 @@
+/*static char *sccsid = "%Z% %M% %I% - %G% %U% ";*/
+/***************************************************************
+*
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in xrtext.c
+*     xr_begin_line           - Start drawing a colored line with XRender
+*     xr_add_run              - Add a run of chars in one gc to the line
+*     xr_end_line             - Draw the runs saved for the line
+*     free_xr_data            - Free the XRender drawing data for a display
+*
+*  Internal routines:
+*     get_xr_data             - Get the XRender data for a display, allocating it if needed
+*     setup_render            - Check the extension and find the picture formats
+*     build_glyph_set         - Load the glyphs in a font into a GlyphSet
+*     get_color               - Get the XRender color and fill picture for a pixel
+*
+*  When the -render option is on, colored lines are drawn with
+*  the RENDER extension instead of a gc per color pair.  The
+*  glyphs of the window font are loaded into a GlyphSet once.
+*  The runs of a line are saved up, then the backgrounds are
+*  filled with one XRenderFillRectangles per background color and
+*  the text is drawn with one XRenderCompositeText8 per foreground
+*  color.  The colors come from the gc's cdgc.c built, so nothing
+*  else changes.  If RENDER is missing or older than 0.10, the
+*  normal core protocol drawing is used.
+*
+***************************************************************/
+
+#include <stdio.h>          /* /usr/include/stdio.h      */
+#include <string.h>         /* /usr/include/string.h     */
+
+#ifdef HAVE_XRENDER
+#include <X11/Xlib.h>       /* /usr/include/X11/Xlib.h   */
+#include <X11/extensions/Xrender.h>   /* /usr/include/X11/extensions/Xrender.h */
+#endif
+
+#include "debug.h"
+#include "emalloc.h"
+#include "parms.h"
+#include "xerrorpos.h"
+#include "xrtext.h"
+#include "xutil.h"
+
+
+#ifdef HAVE_XRENDER
+
+/***************************************************************
+*
+*  A line is saved up to this many runs.  Longer lines are drawn
+*  in pieces.
+*
+***************************************************************/
+
+#define XR_MAX_RUNS      256
+
+/***************************************************************
+*
+*  Colors seen so far.  Each pixel is looked up once.
+*
+***************************************************************/
+
+#define XR_MAX_COLORS     64
+
+typedef struct {
+   unsigned long    pixel;         /* pixel value from the gc                  */
+   XRenderColor     color;         /* same color for XRender                   */
+   Picture          fill;          /* solid fill picture, None till needed     */
+} XR_COLOR;
+
+typedef struct {
+   int              disabled;      /* True once we know XRender cannot be used */
+   int              setup_done;    /* True after the extension has been checked */
+   XRenderPictFormat *dst_format;  /* format of the pixmap                     */
+   XRenderPictFormat *glyph_format;/* A8 format used for the glyphs            */
+   Pixmap           pixmap;        /* pixmap dst_picture was made for          */
+   Picture          dst_picture;   /* picture on the pixmap                    */
+   GlyphSet         glyph_set;     /* glyphs of the window font                */
+   Font             fid;           /* font loaded in glyph_set                 */
+   Font             bad_fid;       /* font which cannot be loaded, two byte fonts */
+   int              color_count;
+   XR_COLOR         colors[XR_MAX_COLORS];
+   int              lines;         /* number of lines drawn                    */
+   int              requests;      /* requests used to draw them               */
+} XR_DATA;
+
+/***************************************************************
+*
+*  Runs saved for the line being drawn.
+*
+***************************************************************/
+
+typedef struct {
+   XR_COLOR        *fg;            /* text color                               */
+   XR_COLOR        *bg;            /* background color, used if image is True  */
+   int              image;         /* True if the background is drawn too      */
+   int              x;             /* where the run goes in the pixmap         */
+   int              y;             /* baseline                                 */
+   int              width;         /* pixel width of the run                   */
+   char            *chars;
+   int              len;
+   int              done;          /* True once the text has been drawn        */
+} XR_RUN;
+
+static XR_RUN        line_runs[XR_MAX_RUNS];
+static int           run_count = 0;
+static XGlyphElt8    elts[XR_MAX_RUNS];
+static XRectangle    rects[XR_MAX_RUNS];
+
+
+/***************************************************************
+*
+*  Local prototypes
+*
+***************************************************************/
+
+static XR_DATA *get_xr_data(DISPLAY_DESCR   *dspl_descr);
+
+static int  setup_render(Display         *display,
+                         XR_DATA         *xr);
+
+static int  build_glyph_set(Display         *display,
+                            Drawable         drawable,
+                            XFontStruct     *font,
+                            XR_DATA         *xr);
+
+static XR_COLOR *get_color(Display         *display,
+                           XR_DATA         *xr,
+                           unsigned long    pixel,
+                           int              need_fill);
+
+#endif
+
+
+/************************************************************************
+
+NAME:      xr_begin_line - Start drawing a colored line with XRender
+
+PURPOSE:    This routine checks whether a line of a pad can be drawn
+            with XRender and, if so, gets the picture and glyphs ready.
+
+PARAMETERS:
+
+   1.  pad   - pointer to PAD_DESCR (INPUT)
+               This is the pad being drawn.
+
+FUNCTIONS :
+
+   1.   Make sure the -render option is on and the extension is usable.
+
+   2.   Make a picture for the pixmap if it changed.
+
+   3.   Load the font glyphs if the font changed.
+
+RETURNED VALUE:
+   started  -  int
+               True  - Use xr_add_run and xr_end_line
+               False - Use the normal drawing routines
+
+*************************************************************************/
+
+int  xr_begin_line(PAD_DESCR       *pad)               /* input  */
+{
+#ifdef HAVE_XRENDER
+DISPLAY_DESCR        *dspl_descr = pad->display_data;
+Display              *display    = dspl_descr->display;
+XFontStruct          *font       = pad->pix_window->font;
+XR_DATA              *xr;
+
+if (!RENDERTEXT || (dspl_descr->x_pixmap == None))
+   return(False);
+
+xr = get_xr_data(dspl_descr);
+if (!xr || xr->disabled || (font->fid == xr->bad_fid))
+   return(False);
+
+if (!xr->setup_done)
+   {
+      xr->setup_done = True;
+      if (!setup_render(display, xr))
+         {
+            xr->disabled = True;
+            DEBUG12(fprintf(stderr, "xr_begin_line:  XRender text not available, using core requests\n");)
+            return(False);
+         }
+   }
+
+/***************************************************************
+*  The pixmap is replaced on resize, get a picture for the new one.
+***************************************************************/
+if (xr->pixmap != dspl_descr->x_pixmap)
+   {
+      if (xr->dst_picture != None)
+         {
+            DEBUG9(XERRORPOS)
+            XRenderFreePicture(display, xr->dst_picture);
+         }
+      DEBUG9(XERRORPOS)
+      xr->dst_picture = XRenderCreatePicture(display, dspl_descr->x_pixmap, xr->dst_format, 0, NULL);
+      xr->pixmap = dspl_descr->x_pixmap;
+   }
+
+if (xr->fid != font->fid)
+   if (!build_glyph_set(display, dspl_descr->x_pixmap, font, xr))
+      {
+         xr->bad_fid = font->fid;
+         DEBUG12(fprintf(stderr, "xr_begin_line:  Cannot load font 0x%lX into a GlyphSet, using core requests\n", font->fid);)
+         return(False);
+      }
+
+run_count = 0;
+return(True);
+#else
+return(False);
+#endif
+
+} /* end of xr_begin_line */
+
+
+/************************************************************************
+
+NAME:      xr_add_run - Add a run of chars in one gc to the line
+
+PURPOSE:    This routine saves a run of chars to be drawn by xr_end_line.
+            It takes the place of an XDrawString or XDrawImageString
+            with the gc.
+
+PARAMETERS:
+
+   1.  pad   - pointer to PAD_DESCR (INPUT)
+               This is the pad being drawn.
+
+   2.  gc    - GC (INPUT)
+               This is the gc the core request would have used.  Only
+               its colors are used.
+
+   3.  image - int (INPUT)
+               True if the background is drawn too, as in XDrawImageString.
+
+   4.  x     - int (INPUT)
+               This is the x coordinate of the run in the pixmap.
+
+   5.  y     - int (INPUT)
+               This is the baseline of the run in the pixmap.
+
+   6.  width - int (INPUT)
+               This is the pixel width of the run.
+
+   7.  text  - pointer to char (INPUT)
+               This is the string to draw.  It must stay put till
+               xr_end_line.
+
+   8.  len   - int (INPUT)
+               This is the number of chars to draw.
+
+*************************************************************************/
+
+void xr_add_run(PAD_DESCR       *pad,                   /* input  */
+                GC               gc,                    /* input  */
+                int              image,                 /* input  */
+                int              x,                     /* input  */
+                int              y,                     /* input  */
+                int              width,                 /* input  */
+                char            *text,                  /* input  */
+                int              len)                   /* input  */
+{
+#ifdef HAVE_XRENDER
+XR_DATA              *xr = (XR_DATA *)pad->display_data->xr_data;
+Display              *display = pad->display_data->display;
+XGCValues             gcvalues;
+XR_RUN               *run;
+
+if (!xr || (len <= 0))
+   return;
+
+if (run_count >= XR_MAX_RUNS)
+   xr_end_line(pad);
+
+/***************************************************************
+*  Xlib keeps the gc values, so this is not a round trip.
+*  If the color table is full, draw this run the old way.
+***************************************************************/
+run = &line_runs[run_count];
+DEBUG9(XERRORPOS)
+if (XGetGCValues(display, gc, GCForeground | GCBackground, &gcvalues))
+   {
+      run->fg = get_color(display, xr, gcvalues.foreground, True);
+      run->bg = image ? get_color(display, xr, gcvalues.background, False) : NULL;
+   }
+else
+   run->fg = NULL;
+
+if (!run->fg || (image && !run->bg))
+   {
+      DEBUG9(XERRORPOS)
+      if (image)
+         XDrawImageString(display, pad->display_data->x_pixmap, gc, x, y, text, len);
+      else
+         XDrawString(display, pad->display_data->x_pixmap, gc, x, y, text, len);
+      return;
+   }
+
+run->image = image;
+run->x     = x;
+run->y     = y;
+run->width = width;
+run->chars = text;
+run->len   = len;
+run->done  = False;
+run_count++;
+#endif
+
+} /* end of xr_add_run */
+
+
+/************************************************************************
+
+NAME:      xr_end_line - Draw the runs saved for the line
+
+PURPOSE:    This routine draws the runs saved by xr_add_run.  The pen
+            color is changed per request, so there is no gc switching.
+
+PARAMETERS:
+
+   1.  pad   - pointer to PAD_DESCR (INPUT)
+               This is the pad being drawn.
+
+FUNCTIONS :
+
+   1.   Fill the backgrounds of the image runs, one request per
+        background color.
+
+   2.   Draw the text, one request per foreground color.  Each run
+        is an element positioned relative to where the last one
+        ended.
+
+*************************************************************************/
+
+void xr_end_line(PAD_DESCR       *pad)                 /* input  */
+{
+#ifdef HAVE_XRENDER
+XR_DATA              *xr = (XR_DATA *)pad->display_data->xr_data;
+Display              *display = pad->display_data->display;
+XFontStruct          *font = pad->pix_window->font;
+XR_COLOR             *color;
+int                   i;
+int                   j;
+int                   count;
+int                   pen_x;
+int                   pen_y;
+
+if (!xr || (run_count == 0))
+   return;
+
+/***************************************************************
+*  Backgrounds first, so text that hangs over the edge of a run
+*  is not covered by the next run's background.
+***************************************************************/
+for (i = 0; i < run_count; i++)
+   line_runs[i].done = !line_runs[i].image;
+
+for (i = 0; i < run_count; i++)
+{
+   if (line_runs[i].done)
+      continue;
+   color = line_runs[i].bg;
+   count = 0;
+   for (j = i; j < run_count; j++)
+      if (!line_runs[j].done && (line_runs[j].bg == color))
+         {
+            rects[count].x      = line_runs[j].x;
+            rects[count].y      = line_runs[j].y - font->ascent;
+            rects[count].width  = line_runs[j].width;
+            rects[count].height = font->ascent + font->descent;
+            line_runs[j].done = True;
+            count++;
+         }
+   DEBUG9(XERRORPOS)
+   XRenderFillRectangles(display, PictOpSrc, xr->dst_picture, &color->color, rects, count);
+   xr->requests++;
+}
+
+/***************************************************************
+*  Now the text.
+***************************************************************/
+for (i = 0; i < run_count; i++)
+   line_runs[i].done = False;
+
+for (i = 0; i < run_count; i++)
+{
+   if (line_runs[i].done)
+      continue;
+   color = line_runs[i].fg;
+   count = 0;
+   pen_x = 0;
+   pen_y = 0;
+   for (j = i; j < run_count; j++)
+      if (!line_runs[j].done && (line_runs[j].fg == color))
+         {
+            elts[count].glyphset = xr->glyph_set;
+            elts[count].chars    = line_runs[j].chars;
+            elts[count].nchars   = line_runs[j].len;
+            elts[count].xOff     = line_runs[j].x - pen_x;
+            elts[count].yOff     = line_runs[j].y - pen_y;
+            pen_x = line_runs[j].x + line_runs[j].width;
+            pen_y = line_runs[j].y;
+            line_runs[j].done = True;
+            count++;
+         }
+   DEBUG9(XERRORPOS)
+   XRenderCompositeText8(display, PictOpOver, color->fill, xr->dst_picture, xr->glyph_format,
+                         0, 0, 0, 0, elts, count);
+   xr->requests++;
+}
+
+xr->lines++;
+run_count = 0;
+
+DEBUG12(
+   if ((xr->lines % 100) == 0)
+      fprintf(stderr, "xr_end_line:  %d colored lines in %d requests, %d colors\n",
+              xr->lines, xr->requests, xr->color_count);
+)
+#endif
+
+} /* end of xr_end_line */
+
+
+/************************************************************************
+
+NAME:      free_xr_data - Free the XRender drawing data for a display
+
+PURPOSE:    This routine releases the XRender data hung off a display.
+            It is called after the display is closed, so no X calls
+            are made.  The server frees the pictures and the GlyphSet
+            when the connection closes.
+
+PARAMETERS:
+
+   1.  dspl_descr     - pointer to DISPLAY_DESCR (INPUT / OUTPUT)
+                        This is the display whose data is to be freed.
+
+*************************************************************************/
+
+void free_xr_data(DISPLAY_DESCR   *dspl_descr)         /* input  */
+{
+
+if (dspl_descr->xr_data)
+   free((char *)dspl_descr->xr_data);
+dspl_descr->xr_data = NULL;
+
+} /* end of free_xr_data */
+
+
+#ifdef HAVE_XRENDER
+/************************************************************************
+
+NAME:      get_xr_data - Get the XRender data for a display, allocating it if needed
+
+*************************************************************************/
+
+static XR_DATA *get_xr_data(DISPLAY_DESCR   *dspl_descr)
+{
+XR_DATA              *xr = (XR_DATA *)dspl_descr->xr_data;
+
+if (!xr)
+   {
+      xr = (XR_DATA *)CE_MALLOC(sizeof(XR_DATA));
+      if (!xr)
+         return(NULL);
+      memset((char *)xr, 0, sizeof(XR_DATA));
+      xr->pixmap      = None;
+      xr->dst_picture = None;
+      xr->glyph_set   = None;
+      xr->fid         = None;
+      xr->bad_fid     = None;
+      dspl_descr->xr_data = (void *)xr;
+   }
+
+return(xr);
+
+} /* end of get_xr_data */
+
+
+/************************************************************************
+
+NAME:      setup_render - Check the extension and find the picture formats
+
+PURPOSE:    This routine makes sure the server has RENDER 0.10 or later,
+            which is needed for solid fill pictures, and finds the
+            formats for the pixmap and the glyphs.
+
+RETURNED VALUE:
+   ok  -  int
+          True  - XRender can be used
+          False - Use the core protocol
+
+*************************************************************************/
+
+static int  setup_render(Display         *display,
+                         XR_DATA         *xr)
+{
+int                   first_event;
+int                   first_error;
+int                   major;
+int                   minor;
+
+DEBUG9(XERRORPOS)
+if (!XRenderQueryExtension(display, &first_event, &first_error))
+   return(False);
+
+DEBUG9(XERRORPOS)
+if (!XRenderQueryVersion(display, &major, &minor) || ((major == 0) && (minor < 10)))
+   return(False);
+
+xr->dst_format   = XRenderFindVisualFormat(display, DefaultVisual(display, DefaultScreen(display)));
+xr->glyph_format = XRenderFindStandardFormat(display, PictStandardA8);
+if (!xr->dst_format || !xr->glyph_format)
+   return(False);
+
+DEBUG12(fprintf(stderr, "setup_render:  RENDER %d.%d\n", major, minor);)
+
+return(True);
+
+} /* end of setup_render */
+
+
+/************************************************************************
+
+NAME:      build_glyph_set - Load the glyphs in a font into a GlyphSet
+
+PURPOSE:    This routine gets the bitmaps of the window font with
+            get_font_glyphs and sends all 256 of them to the server
+            in one request.  Glyph n is char n.
+
+RETURNED VALUE:
+   ok  -  int
+          True  - The GlyphSet is loaded
+          False - The font cannot be loaded
+
+*************************************************************************/
+
+static int  build_glyph_set(Display         *display,
+                            Drawable         drawable,
+                            XFontStruct     *font,
+                            XR_DATA         *xr)
+{
+FONT_GLYPHS           glyphs;
+Glyph                 gids[FONT_GLYPH_COUNT];
+XGlyphInfo            info[FONT_GLYPH_COUNT];
+char                 *data;
+char                 *out;
+unsigned char        *bits;
+int                   stride;
+int                   c;
+int                   gx;
+int                   gy;
+
+if (xr->glyph_set != None)
+   {
+      DEBUG9(XERRORPOS)
+      XRenderFreeGlyphSet(display, xr->glyph_set);
+      xr->glyph_set = None;
+   }
+xr->fid = None;
+
+if (!get_font_glyphs(display, drawable, font, &glyphs))
+   return(False);
+
+/***************************************************************
+*  A8 glyph rows are padded to 4 bytes.
+***************************************************************/
+stride = (glyphs.cell_width + 3) & ~3;
+data = (char *)CE_MALLOC(stride * glyphs.cell_height * FONT_GLYPH_COUNT);
+if (!data)
+   {
+      free((char *)glyphs.bits);
+      return(False);
+   }
+memset(data, 0, stride * glyphs.cell_height * FONT_GLYPH_COUNT);
+
+bits = glyphs.bits;
+for (c = 0; c < FONT_GLYPH_COUNT; c++)
+{
+   gids[c]        = c;
+   info[c].width  = glyphs.cell_width;
+   info[c].height = glyphs.cell_height;
+   info[c].x      = glyphs.origin_x;
+   info[c].y      = glyphs.origin_y;
+   info[c].xOff   = glyphs.advance[c];
+   info[c].yOff   = 0;
+
+   out = data + (c * stride * glyphs.cell_height);
+   for (gy = 0; gy < glyphs.cell_height; gy++)
+      for (gx = 0; gx < glyphs.cell_width; gx++)
+         if (*bits++)
+            out[(gy * stride) + gx] = (char)0xff;
+}
+
+DEBUG9(XERRORPOS)
+xr->glyph_set = XRenderCreateGlyphSet(display, xr->glyph_format);
+DEBUG9(XERRORPOS)
+XRenderAddGlyphs(display, xr->glyph_set, gids, info, FONT_GLYPH_COUNT,
+                 data, stride * glyphs.cell_height * FONT_GLYPH_COUNT);
+
+free(data);
+free((char *)glyphs.bits);
+xr->fid = font->fid;
+
+return(True);
+
+} /* end of build_glyph_set */
+
+
+/************************************************************************
+
+NAME:      get_color - Get the XRender color and fill picture for a pixel
+
+PURPOSE:    This routine finds the XRender color for a pixel value.
+            Pixels are looked up in the colormap the first time they
+            are seen.  Foreground colors also get a solid fill picture
+            to use as the source for the text.
+
+RETURNED VALUE:
+   color  -  pointer to XR_COLOR
+             The color entry, NULL if the table is full.
+
+*************************************************************************/
+
+static XR_COLOR *get_color(Display         *display,
+                           XR_DATA         *xr,
+                           unsigned long    pixel,
+                           int              need_fill)
+{
+XR_COLOR             *color = NULL;
+XColor                xcolor;
+int                   i;
+
+for (i = 0; i < xr->color_count; i++)
+   if (xr->colors[i].pixel == pixel)
+      {
+         color = &xr->colors[i];
+         break;
+      }
+
+if (!color)
+   {
+      if (xr->color_count >= XR_MAX_COLORS)
+         return(NULL);
+      color = &xr->colors[xr->color_count++];
+      xcolor.pixel = pixel;
+      DEBUG9(XERRORPOS)
+      XQueryColor(display, DefaultColormap(display, DefaultScreen(display)), &xcolor);
+      color->pixel       = pixel;
+      color->color.red   = xcolor.red;
+      color->color.green = xcolor.green;
+      color->color.blue  = xcolor.blue;
+      color->color.alpha = 0xffff;
+      color->fill        = None;
+   }
+
+if (need_fill && (color->fill == None))
+   {
+      DEBUG9(XERRORPOS)
+      color->fill = XRenderCreateSolidFill(display, &color->color);
+   }
+
+return(color);
+
+} /* end of get_color */
+
+#endif
+
@@ -0,0 +1,65 @@
+#ifndef _XRTEXT_INCLUDED
+#define _XRTEXT_INCLUDED
+
+/* "%Z% %M% %I% - %G% %U% " */
+
+/***************************************************************
+*  
+*  ARPUS/Ce text editor and terminal emulator modeled after the
+*  Apollo(r) Domain systems.
+*  Copyright 1988 - 2002 Enabling Technologies Group
+*  Copyright 2003 - 2005 Robert Styma Consulting
+*  
+*  This program is free software; you can redistribute it and/or
+*  modify it under the terms of the GNU General Public License
+*  as published by the Free Software Foundation; either version 2
+*  of the License, or (at your option) any later version.
+*  
+*  This program is distributed in the hope that it will be useful,
+*  but WITHOUT ANY WARRANTY; without even the implied warranty of
+*  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+*  GNU General Public License for more details.
+*  
+*  You should have received a copy of the GNU General Public License
+*  along with this program; if not, write to the Free Software
+*  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA  02111-1307, USA.
+*  
+*  Original Authors:  Robert Styma and Kevin Plyler
+*  Email:  styma@swlink.net
+*  
+***************************************************************/
+
+/**************************************************************
+*
+*  Routines in xrtext.c
+*     xr_begin_line           - Start drawing a colored line with XRender
+*     xr_add_run              - Add a run of chars in one gc to the line
+*     xr_end_line             - Draw the runs saved for the line
+*     free_xr_data            - Free the XRender drawing data for a display
+*
+*  XRender drawing is only compiled in when HAVE_XRENDER is
+*  defined.  Without it xr_begin_line always returns False and
+*  the core protocol drawing is used.
+*
+***************************************************************/
+
+#include "buffer.h"
+
+int  xr_begin_line(PAD_DESCR       *pad);               /* input  */
+
+void xr_add_run(PAD_DESCR       *pad,                   /* input  */
+                GC               gc,                    /* input  */
+                int              image,                 /* input  */
+                int              x,                     /* input  */
+                int              y,                     /* input  */
+                int              width,                 /* input  */
+                char            *text,                  /* input  */
+                int              len);                  /* input  */
+
+void xr_end_line(PAD_DESCR       *pad);                 /* input  */
+
+void free_xr_data(DISPLAY_DESCR   *dspl_descr);         /* input  */
+
+
+#endif
+
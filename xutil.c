@@ -33,10 +33,18 @@
 *     draw_partial_line       - Draw a partial line.
 *     colorname_to_pixel      - Convert a named color to a Pixel value.
 *     translate_gc_function   - translate a GC function code to the name for debugging
+*     free_render_cache       - Free the saved line drawing data for a pad.
+*     painted_line_count      - Get the number of lines drawn so far
+*     draw_text_items         - Draw several strings on one baseline in one request
+*     get_font_glyphs         - Get a client side copy of the glyphs in a font
 *
 *  Internal routines:
 *     make_dots               - create a string of dots from a text string.
+*     get_render_line         -  Get the expanded display data for a line, from the render cache if possible
+*     render_line_runs        -  Get the cached GC runs for a colored line
 *     draw_fancy_line         -  Draw a line that uses multiple gc's
+*     build_gc_runs           -  Split a line into runs which use the same gc
+*     draw_gc_runs            -  Draw a line from a list of gc runs
 *     draw_xed_out_line       -  Draw the symbol which marks out 1 or more x'ed out lines
 *     draw_xed_out_char       -  Draw the symbol which marks a partially x'ed out line
 *
@@ -48,10 +56,91 @@
 #include "cd.h"
 #include "cdgc.h"
 #include "debug.h"
+#include "emalloc.h"
 #include "tab.h"
 #include "xerrorpos.h"
 #include "xutil.h"  /* contains other includes */
 #include "memdata.h"
+#include "shmdraw.h"
+#include "xrtext.h"
+
+/***************************************************************
+*  
+*  Render cache.  For each line drawn we save the tab expanded
+*  text as it appears in the window, its pixel width, and for
+*  colored lines, the runs of characters drawn with the same GC.
+*  Entries are hashed on the memdata line address.  An entry is
+*  good as long as the line generation, horizontal scroll, font,
+*  hex mode, and tab stops match what was used to build it.
+*  Memdata gives a line a new generation each time its text or
+*  color is changed, so nothing needs to be flushed on a change.
+*  Only the lines which changed miss the cache.
+*  
+***************************************************************/
+
+#define RENDER_CACHE_SIZE   256   /* must be a power of 2 */
+#define RENDER_HASH(line)   ((((unsigned long)(line)) >> 4) & (RENDER_CACHE_SIZE-1))
+
+typedef struct {
+   GC             gc;              /* GC to draw with, DEFAULT_GC means the window gc */
+   int            len;             /* number of window chars drawn with this gc       */
+} GC_RUN;
+
+typedef struct {
+   char          *line;            /* memdata line address             (key)   */
+   unsigned int   generation;      /* memdata line generation          (key)   */
+   int            first_char;      /* horizontal scroll                (key)   */
+   int            max_chars;       /* max chars displayable            (key)   */
+   Font           fid;             /* window font                      (key)   */
+   int            hex_mode;        /* hex mode                         (key)   */
+   int            ts_generation;   /* tab stop generation              (key)   */
+   int            cached;          /* True for entries in the cache, False for the scratch entry */
+   int            tabs_on_line;    /* value returned by untab                   */
+   int            full_line_len;   /* length of the whole expanded line         */
+   int            line_len;        /* chars from first_char to the end of line  */
+   int            text_width;      /* pixel width of the drawable part          */
+   char          *display_line;    /* expanded text starting at first_char      */
+   int            display_size;    /* malloc'ed size of display_line            */
+   int            run_count;       /* number of gc runs, -1 when not built yet  */
+   int            run_size;        /* malloc'ed elements in runs                */
+   GC_RUN        *runs;            /* gc runs for a colored line                */
+} RENDER_LINE;
+
+typedef struct {
+   int            hits;            /* lines drawn without expanding them again  */
+   int            misses;          /* lines which had to be expanded            */
+   RENDER_LINE    line[RENDER_CACHE_SIZE];
+} RENDER_CACHE;
+
+/***************************************************************
+*  
+*  Work area for building gc runs.  A run is at least one char
+*  so there can never be more runs than chars on a line.
+*  
+***************************************************************/
+
+static GC_RUN  fancy_runs[MAX_LINE+1];
+
+/***************************************************************
+*  
+*  Work areas for batching text requests.  A line never has more
+*  pieces than it has chars.
+*  
+***************************************************************/
+
+static TEXT_AT    text_pieces[MAX_LINE+1];
+#ifndef WIN32
+static XTextItem  text_items[MAX_LINE+1];
+#endif
+
+/***************************************************************
+*  
+*  Count of lines drawn into the pixmap by textfill_drawable and
+*  draw_partial_line.  Redraw uses it to measure each frame.
+*  
+***************************************************************/
+
+static int     painted_lines = 0;
 
 /***************************************************************
 *  
@@ -61,6 +150,37 @@
 
 static char  *make_dots(char *master);
 
+static RENDER_LINE *get_render_line(PAD_DESCR       *pad,
+                                    char            *line,
+                                    int              file_line_no,
+                                    int              max_chars_displayable,
+                                    char            *work);
+
+static int  render_line_runs(PAD_DESCR       *pad,
+                             RENDER_LINE     *rl,
+                             WINDOW_LINE     *win_lines,
+                             FANCY_LINE      *fancy_line,
+                             int              fancy_line_no,
+                             int              file_line_no);
+
+static int  build_gc_runs(PAD_DESCR       *pad,
+                          WINDOW_LINE     *win_lines,
+                          int              line_len,
+                          int              win_start_char,
+                          FANCY_LINE      *fancy_line,
+                          int              fancy_line_no,
+                          int              file_line_no,
+                          GC_RUN          *runs);
+
+static void draw_gc_runs(PAD_DESCR       *pad,
+                         int              x,
+                         int              base_y,
+                         char            *display_line,
+                         int              line_len,
+                         int              skip_chars,
+                         GC_RUN          *runs,
+                         int              run_count);
+
 static void draw_fancy_line(PAD_DESCR       *pad,
                             WINDOW_LINE     *win_lines,
                             int              x,
@@ -169,6 +289,9 @@ int                 move_height;
 int                 corner;
 int                 resized = 0;
 int                 depth;
+static Display     *depth_display = NULL;
+static Window       depth_window  = None;
+static int          window_depth;
 
 if ((*drawable != None) && (pix->width == (unsigned)event->xconfigure.width) && (pix->height == (unsigned)event->xconfigure.height))
    {
@@ -184,16 +307,30 @@ else
       *  
       ***************************************************************/
 
-      DEBUG9(XERRORPOS)
-      if (!XGetWindowAttributes(event->xconfigure.display,
-                               event->xconfigure.window,
-                               &window_attributes))
+      /***************************************************************
+      *  A window's depth never changes.  Only ask the server the
+      *  first time, it costs a round trip on every resize.
+      ***************************************************************/
+      if ((event->xconfigure.display == depth_display) && (event->xconfigure.window == depth_window))
+         depth = window_depth;
+      else
          {
-            fprintf(stderr, "resize_pixmap:  Cannot get window attributes for window 0x%X\n", event->xconfigure.window);
-            depth = DefaultDepth(event->xconfigure.display, DefaultScreen(event->xconfigure.display));
+            DEBUG9(XERRORPOS)
+            if (!XGetWindowAttributes(event->xconfigure.display,
+                                     event->xconfigure.window,
+                                     &window_attributes))
+               {
+                  fprintf(stderr, "resize_pixmap:  Cannot get window attributes for window 0x%X\n", event->xconfigure.window);
+                  depth = DefaultDepth(event->xconfigure.display, DefaultScreen(event->xconfigure.display));
+               }
+            else
+               {
+                  depth = window_attributes.depth;
+                  depth_display = event->xconfigure.display;
+                  depth_window  = event->xconfigure.window;
+                  window_depth  = depth;
+               }
          }
-      else
-         depth = window_attributes.depth;
 
       resized = 1;
       DEBUG9(XERRORPOS)
@@ -502,6 +639,8 @@ int            cur_file_line;
 FANCY_LINE    *fancy_line_ll = NULL;
 int            fancy_line_no;
 int            max_chars_displayable;
+RENDER_LINE   *rl;
+int            shm_band = False;
 
 
 /***************************************************************
@@ -594,6 +733,8 @@ pad->lines_displayed = cur_file_line - pad->first_line;
 *  Blank out the area to draw in using the background color.
 *  Overlay is used when the area has already been blanked out.
 *  some fonts have a negative lbearing, so we have to clear out more.
+*  For big repaints on a local display, the text may be drawn in
+*  shared memory.  The shared memory band starts out blanked.
 ***************************************************************/
 
 if (!overlay)
@@ -601,11 +742,15 @@ if (!overlay)
       x = pad->pix_window->sub_x;
       if (pad->pix_window->font->min_bounds.lbearing < 0)
          x += pad->pix_window->font->min_bounds.lbearing;
-      DEBUG9(XERRORPOS)
-      XFillRectangle(display,
-                     drawable,
-                     pad->pix_window->reverse_gc,
-                     x, y, pad->pix_window->sub_width, ending_y - y);
+      shm_band = shm_begin_text(pad, x, y, pad->pix_window->sub_width, ending_y - y);
+      if (!shm_band)
+         {
+            DEBUG9(XERRORPOS)
+            XFillRectangle(display,
+                           drawable,
+                           pad->pix_window->reverse_gc,
+                           x, y, pad->pix_window->sub_width, ending_y - y);
+         }
    }
 
 /***************************************************************
@@ -624,13 +769,13 @@ if (COLORED(pad->token))
 
 while((line_no_on_window < pad->pix_window->lines_on_screen) && ((cur_line = next_line(pad->token)) != NULL))
 {
-   if ((tabs_on_line = untab(cur_line, 
-                             work,
-                             max_chars_displayable+pad->first_char,
-                             pad->display_data->hex_mode)))
-      display_line = work;
-   else
-      display_line = cur_line;
+   /***************************************************************
+   *  Get the tab expanded line, shifted for the horizontal scroll.
+   *  Lines which have not changed since last drawn come from the
+   *  render cache.
+   ***************************************************************/
+   rl = get_render_line(pad, cur_line, cur_file_line, max_chars_displayable, work);
+   tabs_on_line = rl->tabs_on_line;
 
    /***************************************************************
    *  If there is a form feed on the line save it's window line number.
@@ -647,20 +792,9 @@ while((line_no_on_window < pad->pix_window->lines_on_screen) && ((cur_line = nex
             break;
       }
 
-   full_line_len =
-   line_len = strlen(display_line);
-
-
-   if (line_len > pad->first_char)
-      {
-         display_line = &display_line[pad->first_char];
-         line_len -= pad->first_char;
-      }
-   else
-      {
-         display_line = "";
-         line_len = 0;
-      }
+   full_line_len = rl->full_line_len;
+   line_len      = rl->line_len;
+   display_line  = rl->display_line;
 
    /***************************************************************
    *  Set the win_lines data.  This is the pointer to the line
@@ -669,6 +803,7 @@ while((line_no_on_window < pad->pix_window->lines_on_screen) && ((cur_line = nex
    ***************************************************************/
    win_lines->line           = cur_line;
    win_lines->tabs           = tabs_on_line;
+   win_lines->w_generation   = rl->generation;
 #ifdef EXCLUDEP
    win_lines->w_file_line_offset = cur_file_line - pad->first_line;
 #endif
@@ -677,11 +812,7 @@ while((line_no_on_window < pad->pix_window->lines_on_screen) && ((cur_line = nex
       win_lines->w_first_char = pad->first_char;
    else
       win_lines->w_first_char = full_line_len;
-   DEBUG9(XERRORPOS)
-   if (pad->pix_window->fixed_font)
-      win_lines->pix_len = pad->pix_window->fixed_font * line_len;
-   else
-      win_lines->pix_len = XTextWidth(pad->pix_window->font, display_line, MIN(line_len, max_chars_displayable));
+   win_lines->pix_len = rl->text_width;
 
    if (!pad->display_data->hex_mode)
    if (pad->first_char == 0 || line_len > 0)
@@ -701,19 +832,34 @@ while((line_no_on_window < pad->pix_window->lines_on_screen) && ((cur_line = nex
    
    if (line_len)
       if (fancy_line_ll)
-         draw_fancy_line(pad, win_lines,
+         if (render_line_runs(pad, rl, win_lines, fancy_line_ll, fancy_line_no, cur_file_line))
+            draw_gc_runs(pad,
                          pad->pix_window->sub_x,
                          y,
-                         display_line, MIN(line_len, max_chars_displayable), 0, /* RES 3/20/1998, MIN test added */
-                         fancy_line_ll, fancy_line_no, cur_file_line);
+                         display_line, MIN(line_len, max_chars_displayable), 0,
+                         rl->runs, rl->run_count);
+         else
+            draw_fancy_line(pad, win_lines,
+                            pad->pix_window->sub_x,
+                            y,
+                            display_line, MIN(line_len, max_chars_displayable), 0, /* RES 3/20/1998, MIN test added */
+                            fancy_line_ll, fancy_line_no, cur_file_line);
       else
          if (!win_lines->fancy_line)
             {
-               DEBUG9(XERRORPOS)
-               XDrawString(display, drawable, pad->pix_window->gc,
-                           pad->pix_window->sub_x,
-                           y,
-                           display_line, MIN(line_len, max_chars_displayable)); /* RES 3/20/1998, MIN test added */
+               if (shm_band)
+                  shm_draw_string(pad,
+                                  pad->pix_window->sub_x,
+                                  y,
+                                  display_line, MIN(line_len, max_chars_displayable));
+               else
+                  {
+                     DEBUG9(XERRORPOS)
+                     XDrawString(display, drawable, pad->pix_window->gc,
+                                 pad->pix_window->sub_x,
+                                 y,
+                                 display_line, MIN(line_len, max_chars_displayable)); /* RES 3/20/1998, MIN test added */
+                  }
             }
          else
             draw_fancy_line(pad, win_lines,
@@ -730,11 +876,20 @@ while((line_no_on_window < pad->pix_window->lines_on_screen) && ((cur_line = nex
 
    win_lines++;
    line_no_on_window++;
+   painted_lines++;
 
 } /* end of do while */
 
+if (shm_band)
+   shm_end_text(pad);
+
 pad->lines_displayed      = cur_file_line - pad->first_line;
 
+DEBUG7(
+   if (pad->render_cache)
+      fprintf(stderr, "textfill_drawable: render cache hits %d, misses %d\n",
+              ((RENDER_CACHE *)pad->render_cache)->hits, ((RENDER_CACHE *)pad->render_cache)->misses);
+)
 
 /***************************************************************
 *  
@@ -749,6 +904,7 @@ while(line_no_on_window < pad->pix_window->lines_on_screen)
    win_lines->pix_len        = 0;
    win_lines->w_first_char   = 0;
    win_lines->line           = NULL;
+   win_lines->w_generation   = 0;
    win_lines->fancy_line     = NULL;
 #ifdef EXCLUDEP
    win_lines->w_file_line_offset = -1;
@@ -851,6 +1007,7 @@ Display       *display   = pad->display_data->display;
 Drawable       drawable  = pad->display_data->x_pixmap;
 FANCY_LINE    *fancy_line_ll;
 int            fancy_line_no;
+RENDER_LINE   *rl;
 
 DEBUG7(fprintf(stderr, "@dpl: char_in_col_0=%d, win_start_char=%d, line_no=%d \"%s\"\n", pad->first_char, win_start_char, win_line_no, text);)
 /***************************************************************
@@ -895,13 +1052,13 @@ win_lines += win_line_no;
 if (text == NULL)
    text = "";
 
-if ((tabs_on_line = untab(text,
-                          work,
-                          max_chars_displayable+pad->first_char,
-                          pad->display_data->hex_mode)))
-   display_line = work;
-else
-   display_line = text;
+/***************************************************************
+*  Get the tab expanded line.  If text is the memdata copy of the
+*  line and it has not changed, this comes from the render cache.
+*  Work buffers (typing) are always expanded.
+***************************************************************/
+rl = get_render_line(pad, text, file_line_no, max_chars_displayable, work);
+tabs_on_line = rl->tabs_on_line;
 
 if (tabs_on_line & TAB_FORMFEED_FOUND)
    {
@@ -917,19 +1074,9 @@ if (tabs_on_line & TAB_FORMFEED_FOUND)
 *  line_len is the number of chars in the window.  full_line_len
 *  is the actual length of the line.
 ***************************************************************/
-full_line_len =
-line_len = strlen(display_line);
-
-if (line_len > pad->first_char)
-   {
-      display_line = &display_line[pad->first_char];
-      line_len -= pad->first_char;
-   }
-else
-   {
-      display_line = "";
-      line_len = 0;
-   }
+full_line_len = rl->full_line_len;
+line_len      = rl->line_len;
+display_line  = rl->display_line;
 
 /***************************************************************
 *  Calculate left_side_x.  This is the left edge in the window
@@ -995,17 +1142,32 @@ corner_y += pad->pix_window->font->ascent;
 ***************************************************************/
 win_lines->line       = text;
 win_lines->tabs       = tabs_on_line;
+win_lines->w_generation = rl->generation;  /* zero for work buffers */
+painted_lines++;
 
 if (do_dots)
    display_line = make_dots(display_line);
 
 if (display_line[0] != '\0')
    if (fancy_line_ll)
-      draw_fancy_line(pad, win_lines, 
+      /***************************************************************
+      *  Cached gc runs cover the whole line from window column zero.
+      *  They are only built by textfill_drawable, which refreshes the
+      *  color data first, so here they are used but never built.
+      ***************************************************************/
+      if (rl->cached && (rl->run_count >= 0) && (rl->line_len <= rl->max_chars) &&
+          (fancy_line_no == file_line_no) && !cdpad_cdgc_pending(pad, file_line_no))
+         draw_gc_runs(pad,
                       *left_side_x, corner_y,
                       display_line, line_len,
                       win_start_char,
-                      fancy_line_ll, fancy_line_no, file_line_no);
+                      rl->runs, rl->run_count);
+      else
+         draw_fancy_line(pad, win_lines, 
+                         *left_side_x, corner_y,
+                         display_line, line_len,
+                         win_start_char,
+                         fancy_line_ll, fancy_line_no, file_line_no);
    else
       if (!win_lines->fancy_line)
          {
@@ -1400,7 +1562,8 @@ FUNCTIONS :
 
    5.  Continue until we run out of window or line.
 
-
+   Steps 1 through 4 are done by build_gc_runs and the drawing by
+   draw_gc_runs so textfill_drawable can save the runs in the render cache.
 
 *************************************************************************/
 
@@ -1415,23 +1578,92 @@ static void draw_fancy_line(PAD_DESCR       *pad,
                             int              fancy_line_no,
                             int              file_line_no)
 {
-GC             cur_gc;
+int            run_count;
+
+run_count = build_gc_runs(pad, win_lines, line_len, win_start_char,
+                          fancy_line, fancy_line_no, file_line_no,
+                          fancy_runs);
+
+draw_gc_runs(pad, x, base_y, display_line, line_len, 0, fancy_runs, run_count);
+
+} /* end of draw_fancy_line */
+
+
+/************************************************************************
+
+NAME:      build_gc_runs  -  Split a line into runs which use the same gc
+
+PURPOSE:    This routine walks the cdgc linked list for a line and works
+            out which gc each piece of the displayed line is drawn with.
+            This was the front half of draw_fancy_line.  It is split out
+            so the runs can be saved in the render cache.
+
+PARAMETERS:
+
+   1.  pad            -  pointer to PAD_DESCR (INPUT)
+                         This is the pad being drawn.
+
+   2.  win_lines      -  pointer to WINDOW_LINE (INPUT)
+                         This is the window line being drawn.  The line and
+                         w_first_char fields must already be set up.
+
+   3.  line_len       -  int (INPUT)
+                         This is the number of window chars to cover.
+
+   4.  win_start_char -  int (INPUT)
+                         This is the window column of the first char.
+
+   5.  fancy_line     -  pointer to FANCY_LINE (INPUT)
+                         This is the cdgc linked list for the line.
+
+   6.  fancy_line_no  -  int (INPUT)
+                         This is the file line number the cdgc list goes with.
+
+   7.  file_line_no   -  int (INPUT)
+                         This is the file line number being drawn.
+
+   8.  runs           -  pointer to GC_RUN (OUTPUT)
+                         The runs are put here.  There must be room for
+                         line_len runs.
+
+FUNCTIONS :
+
+   1.   Figure out where the window column is in the file line and get
+        the gc and end column for that column.
+
+   2.   Convert the end column back to a window column to get the run length.
+        Merge it with the previous run if it uses the same gc.
+
+   3.   Continue until we run out of line.
+
+RETURNED VALUE:
+   run_count  -  int
+                 The number of runs put in the runs array.
+
+*************************************************************************/
+
+static int  build_gc_runs(PAD_DESCR       *pad,
+                          WINDOW_LINE     *win_lines,
+                          int              line_len,
+                          int              win_start_char,
+                          FANCY_LINE      *fancy_line,
+                          int              fancy_line_no,
+                          int              file_line_no,
+                          GC_RUN          *runs)
+{
 int            file_col;
 int            win_col = win_start_char;
-Display       *display   = pad->display_data->display;
-Drawable       drawable  = pad->display_data->x_pixmap;
 int            drawn_len;
-int            tmp;
 int            end_col;
 int            end_win_col;
+int            run_count = 0;
+GC             gc;
 
-while((line_len > 0) && (x < (int)pad->pix_window->width))
+while((line_len > 0) && (run_count <= MAX_LINE))
 {
    file_col = tab_cursor_adjust(win_lines->line, win_col, win_lines->w_first_char, TAB_LINE_OFFSET, pad->display_data->hex_mode);
 
-   cur_gc = extract_gc(fancy_line, fancy_line_no, file_line_no, file_col, &end_col);
-   if (cur_gc == DEFAULT_GC)
-      cur_gc = pad->window->gc;
+   gc = extract_gc(fancy_line, fancy_line_no, file_line_no, file_col, &end_col);
 
    if (end_col < MAX_LINE)
       {
@@ -1443,23 +1675,713 @@ while((line_len > 0) && (x < (int)pad->pix_window->width))
       }
    else
       drawn_len = line_len;
-   
-   DEBUG9(XERRORPOS)
-   XDrawImageString(display, drawable, cur_gc, 
-                    x, base_y,
-                    display_line, drawn_len);
 
+   /***************************************************************
+   *  Pieces of the line next to each other with the same gc are
+   *  drawn as one run.
+   ***************************************************************/
+   if (run_count && (runs[run_count-1].gc == gc))
+      runs[run_count-1].len += drawn_len;
+   else
+      {
+         runs[run_count].gc    = gc;
+         runs[run_count++].len = drawn_len;
+      }
+   win_col      += drawn_len;
+   line_len     -= drawn_len;
+
+} /* while line len */
 
+return(run_count);
 
-   tmp           = XTextWidth(pad->pix_window->font, display_line, drawn_len);
-   x            += tmp;
-   win_col      += drawn_len;
+} /* end of build_gc_runs */
+
+
+/************************************************************************
+
+NAME:      draw_gc_runs  -  Draw a line from a list of gc runs
+
+PURPOSE:    This routine draws a string using the gc runs built by
+            build_gc_runs.  It is the back half of draw_fancy_line.
+
+PARAMETERS:
+
+   1.  pad            -  pointer to PAD_DESCR (INPUT)
+                         This is the pad being drawn.
+
+   2.  x              -  int (INPUT)
+                         This is the x coordinate to start drawing the string.
+
+   3.  base_y         -  int (INPUT)
+                         This is the y coordinate to draw the string.
+
+   4.  display_line   -  pointer to char (INPUT)
+                         This is the string to draw.
+
+   5.  line_len       -  int (INPUT)
+                         This is the length of string display_line.
+
+   6.  skip_chars     -  int (INPUT)
+                         This is the number of chars at the front of the runs
+                         which are not to be drawn.  It is used when the runs
+                         were built from window column zero and drawing starts
+                         further into the line.
+
+   7.  runs           -  pointer to GC_RUN (INPUT)
+                         This is the list of runs.
+
+   8.  run_count      -  int (INPUT)
+                         This is the number of runs.
+
+FUNCTIONS :
+
+   1.   Skip the runs before the place drawing starts.
+
+   2.   Draw each run with its gc until we run out of window or line.
+        Runs in the window gc are collected and drawn together at
+        the end with one request.  With -render, all the runs go
+        to xrtext.c which draws them without switching gc's.
+
+*************************************************************************/
+
+static void draw_gc_runs(PAD_DESCR       *pad,
+                         int              x,
+                         int              base_y,
+                         char            *display_line,
+                         int              line_len,
+                         int              skip_chars,
+                         GC_RUN          *runs,
+                         int              run_count)
+{
+GC             cur_gc;
+Display       *display   = pad->display_data->display;
+Drawable       drawable  = pad->display_data->x_pixmap;
+int            drawn_len;
+int            drawn_width;
+int            i;
+int            piece_count = 0;
+int            use_render  = xr_begin_line(pad);
+
+for (i = 0; (i < run_count) && (line_len > 0) && (x < (int)pad->pix_window->width); i++)
+{
+   drawn_len = runs[i].len;
+   if (skip_chars >= drawn_len)
+      {
+         skip_chars -= drawn_len;
+         continue;
+      }
+   drawn_len -= skip_chars;
+   skip_chars = 0;
+
+   if (drawn_len > line_len)
+      drawn_len = line_len;
+
+   /***************************************************************
+   *  Runs in the window gc have the same background as the cleared
+   *  line, so they are saved up and drawn with one request.  Runs
+   *  in other gc's may have their own background and are drawn
+   *  as image strings.
+   ***************************************************************/
+   cur_gc = runs[i].gc;
+   drawn_width = XTextWidth(pad->pix_window->font, display_line, drawn_len);
+   if (use_render)
+      {
+         if (cur_gc == DEFAULT_GC)
+            xr_add_run(pad, pad->window->gc, False, x, base_y, drawn_width, display_line, drawn_len);
+         else
+            xr_add_run(pad, cur_gc, (cur_gc != pad->window->gc), x, base_y, drawn_width, display_line, drawn_len);
+      }
+   else
+   if ((cur_gc == DEFAULT_GC) || (cur_gc == pad->window->gc))
+      {
+         text_pieces[piece_count].x      = x;
+         text_pieces[piece_count].chars  = display_line;
+         text_pieces[piece_count].nchars = drawn_len;
+         piece_count++;
+      }
+   else
+      {
+         DEBUG9(XERRORPOS)
+         XDrawImageString(display, drawable, cur_gc, 
+                          x, base_y,
+                          display_line, drawn_len);
+      }
+
+   x            += drawn_width;
    display_line += drawn_len;
    line_len     -= drawn_len;
 
-} /* while line len */
+} /* for each run */
 
-} /* end of draw_fancy_line */
+if (use_render)
+   xr_end_line(pad);
+
+if (piece_count)
+   draw_text_items(display, drawable, pad->window->gc, pad->pix_window->font,
+                   base_y, text_pieces, piece_count);
+
+} /* end of draw_gc_runs */
+
+
+/************************************************************************
+
+NAME:      get_render_line  -  Get the expanded display data for a line
+
+PURPOSE:    This routine returns the tab expanded version of a line
+            shifted for the horizontal scroll, along with its length and
+            pixel width.  If the line is unchanged since the last time it
+            was drawn, the data comes from the render cache.  Otherwise
+            the line is expanded and, if it is a memdata line, saved in
+            the cache.
+
+PARAMETERS:
+
+   1.  pad            -  pointer to PAD_DESCR (INPUT / OUTPUT)
+                         This is the pad being drawn.  The render cache
+                         hangs off the pad and is created on first use.
+
+   2.  line           -  pointer to char (INPUT)
+                         This is the line to be drawn.  It may be a memdata
+                         line or a work buffer.
+
+   3.  file_line_no   -  int (INPUT)
+                         This is the file line number of the line.
+
+   4.  max_chars_displayable - int (INPUT)
+                         This is the maximum number of chars which fit in the window.
+
+   5.  work           -  pointer to char (INPUT)
+                         This is a MAX_LINE+1 work buffer for untab.  The
+                         returned data may point into it when the line
+                         cannot be cached.
+
+FUNCTIONS :
+
+   1.   Get the memdata generation of the line.  Zero means the line
+        is not a memdata line and cannot be cached.
+
+   2.   If the cache entry for the line matches, return it.
+
+   3.   Expand the line and fill in the cache entry, or a scratch entry
+        if the line cannot be cached.
+
+RETURNED VALUE:
+   rl  -  pointer to RENDER_LINE
+          The display data for the line.  The scratch entry is only
+          good until the next call.
+
+*************************************************************************/
+
+static RENDER_LINE *get_render_line(PAD_DESCR       *pad,
+                                    char            *line,
+                                    int              file_line_no,
+                                    int              max_chars_displayable,
+                                    char            *work)
+{
+static RENDER_LINE     scratch;
+RENDER_CACHE          *cache = (RENDER_CACHE *)pad->render_cache;
+RENDER_LINE           *rl    = &scratch;
+unsigned int           generation;
+char                  *expanded;
+int                    hex_mode = pad->display_data->hex_mode;
+int                    ts_generation = tab_stop_generation();
+Font                   fid = pad->pix_window->font->fid;
+
+/***************************************************************
+*  Lines we can cache have a non-zero generation.
+***************************************************************/
+generation = line_generation(pad->token, file_line_no, line);
+
+if (generation && !cache)
+   {
+      cache = (RENDER_CACHE *)CE_MALLOC(sizeof(RENDER_CACHE));
+      if (cache)
+         {
+            memset((char *)cache, 0, sizeof(RENDER_CACHE));
+            pad->render_cache = (void *)cache;
+         }
+   }
+
+if (generation && cache)
+   {
+      rl = &cache->line[RENDER_HASH(line)];
+      if ((rl->line          == line)                  &&
+          (rl->generation    == generation)            &&
+          (rl->first_char    == pad->first_char)       &&
+          (rl->max_chars     == max_chars_displayable) &&
+          (rl->fid           == fid)                   &&
+          (rl->hex_mode      == hex_mode)              &&
+          (rl->ts_generation == ts_generation))
+         {
+            cache->hits++;
+            return(rl);
+         }
+      cache->misses++;
+   }
+
+/***************************************************************
+*  Expand the line and shift it for the horizontal scroll.
+***************************************************************/
+if ((rl->tabs_on_line = untab(line,
+                              work,
+                              max_chars_displayable+pad->first_char,
+                              hex_mode)))
+   expanded = work;
+else
+   expanded = line;
+
+rl->full_line_len = strlen(expanded);
+
+if (rl->full_line_len > pad->first_char)
+   {
+      expanded    += pad->first_char;
+      rl->line_len = rl->full_line_len - pad->first_char;
+   }
+else
+   {
+      expanded    = "";
+      rl->line_len = 0;
+   }
+
+DEBUG9(XERRORPOS)
+if (pad->pix_window->fixed_font)
+   rl->text_width = pad->pix_window->fixed_font * rl->line_len;
+else
+   rl->text_width = XTextWidth(pad->pix_window->font, expanded, MIN(rl->line_len, max_chars_displayable));
+
+/***************************************************************
+*  The scratch entry just points at the expanded line.  A cache
+*  entry gets its own copy.  If we cannot get the space, drop the
+*  entry and use the scratch copy.
+***************************************************************/
+if (rl != &scratch)
+   {
+      if (rl->display_size < rl->line_len+1)
+         {
+            if (rl->display_line)
+               free(rl->display_line);
+            rl->display_size = rl->line_len+1;
+            rl->display_line = (char *)CE_MALLOC(rl->display_size);
+            if (!rl->display_line)
+               {
+                  rl->display_size = 0;
+                  rl->line         = NULL;
+                  memcpy((char *)&scratch, (char *)rl, sizeof(RENDER_LINE));
+                  rl = &scratch;
+               }
+         }
+   }
+
+if (rl == &scratch)
+   {
+      rl->display_line = expanded;
+      rl->generation   = generation;
+      rl->cached       = False;
+   }
+else
+   {
+      memcpy(rl->display_line, expanded, rl->line_len+1);
+      rl->line          = line;
+      rl->generation    = generation;
+      rl->first_char    = pad->first_char;
+      rl->max_chars     = max_chars_displayable;
+      rl->fid           = fid;
+      rl->hex_mode      = hex_mode;
+      rl->ts_generation = ts_generation;
+      rl->cached        = True;
+   }
+
+rl->run_count = -1;
+
+return(rl);
+
+} /* end of get_render_line */
+
+
+/************************************************************************
+
+NAME:      render_line_runs  -  Get the cached GC runs for a colored line
+
+PURPOSE:    This routine makes sure the render cache entry for a colored
+            line has its gc runs built.  The runs can only be cached when
+            the color data comes from the line itself and is in memdata,
+            since only then does the line generation cover the color.
+
+PARAMETERS:
+
+   1.  pad            -  pointer to PAD_DESCR (INPUT)
+                         This is the pad being drawn.
+
+   2.  rl             -  pointer to RENDER_LINE (INPUT / OUTPUT)
+                         This is the entry from get_render_line.
+
+   3.  win_lines      -  pointer to WINDOW_LINE (INPUT)
+                         This is the window line being drawn.
+
+   4.  fancy_line     -  pointer to FANCY_LINE (INPUT)
+                         This is the cdgc linked list for the line.
+
+   5.  fancy_line_no  -  int (INPUT)
+                         This is the file line number the cdgc list goes with.
+
+   6.  file_line_no   -  int (INPUT)
+                         This is the file line number being drawn.
+
+FUNCTIONS :
+
+   1.   Make sure the runs can be cached.
+
+   2.   If they are not already built, build them and save a copy.
+
+RETURNED VALUE:
+   cached  -  int
+              True  - rl->runs and rl->run_count are good
+              False - The caller must use draw_fancy_line
+
+*************************************************************************/
+
+static int  render_line_runs(PAD_DESCR       *pad,
+                             RENDER_LINE     *rl,
+                             WINDOW_LINE     *win_lines,
+                             FANCY_LINE      *fancy_line,
+                             int              fancy_line_no,
+                             int              file_line_no)
+{
+int            run_count;
+
+if (!rl->cached || (fancy_line_no != file_line_no) || cdpad_cdgc_pending(pad, file_line_no))
+   return(False);
+
+if (rl->run_count >= 0)
+   return(True);
+
+run_count = build_gc_runs(pad, win_lines, MIN(rl->line_len, rl->max_chars), 0,
+                          fancy_line, fancy_line_no, file_line_no,
+                          fancy_runs);
+
+if (rl->run_size < run_count)
+   {
+      if (rl->runs)
+         free((char *)rl->runs);
+      rl->runs = (GC_RUN *)CE_MALLOC(run_count * sizeof(GC_RUN));
+      if (!rl->runs)
+         {
+            rl->run_size = 0;
+            return(False);
+         }
+      rl->run_size = run_count;
+   }
+
+memcpy((char *)rl->runs, (char *)fancy_runs, run_count * sizeof(GC_RUN));
+rl->run_count = run_count;
+
+return(True);
+
+} /* end of render_line_runs */
+
+
+/************************************************************************
+
+NAME:      free_render_cache  -  Free the saved line drawing data for a pad.
+
+PURPOSE:    This routine releases the render cache hung off a pad.  It is
+            called when the pad is freed.
+
+PARAMETERS:
+
+   1.  pad            -  pointer to PAD_DESCR (INPUT / OUTPUT)
+                         This is the pad whose cache is to be freed.
+
+FUNCTIONS :
+
+   1.   Free the text and runs in each entry, then the cache itself.
+
+*************************************************************************/
+
+void free_render_cache(PAD_DESCR       *pad)               /* input/output */
+{
+RENDER_CACHE          *cache = (RENDER_CACHE *)pad->render_cache;
+int                    i;
+
+if (!cache)
+   return;
+
+for (i = 0; i < RENDER_CACHE_SIZE; i++)
+{
+   if (cache->line[i].display_line)
+      free(cache->line[i].display_line);
+   if (cache->line[i].runs)
+      free((char *)cache->line[i].runs);
+}
+
+free((char *)cache);
+pad->render_cache = NULL;
+
+} /* end of free_render_cache */
+
+
+/************************************************************************
+
+NAME:      painted_line_count  -  Get the number of lines drawn so far
+
+PURPOSE:    This routine returns the running count of lines drawn into
+            the pixmap by textfill_drawable and draw_partial_line.  The
+            difference between two calls is the number of lines painted
+            in between.
+
+PARAMETERS:
+
+   none
+
+FUNCTIONS :
+
+   1.   Return the count.
+
+RETURNED VALUE:
+   count  -  int
+             The number of lines drawn since startup.
+
+*************************************************************************/
+
+int  painted_line_count(void)
+{
+return(painted_lines);
+} /* end of painted_line_count */
+
+
+/************************************************************************
+
+NAME:      draw_text_items  -  Draw several strings on one baseline in one request
+
+PURPOSE:    This routine draws a list of strings which share a gc and a
+            baseline with a single XDrawText (PolyText8) request instead of
+            one XDrawString request per string.  Over a remote connection
+            it is the number of requests which costs.
+
+PARAMETERS:
+
+   1.  display        -  pointer to Display (INPUT)
+                         This is the display to draw on.
+
+   2.  drawable       -  Drawable (INPUT)
+                         This is the pixmap or window to draw in.
+
+   3.  gc             -  GC (INPUT)
+                         This is the gc to draw with.  Its font is used.
+
+   4.  font           -  pointer to XFontStruct (INPUT)
+                         This is the font in the gc.  It is used to get the
+                         width of each string.
+
+   5.  y              -  int (INPUT)
+                         This is the baseline to draw on.
+
+   6.  text           -  pointer to TEXT_AT (INPUT)
+                         This is the list of strings and where each starts.
+
+   7.  count          -  int (INPUT)
+                         This is the number of strings in the list.
+
+FUNCTIONS :
+
+   1.   Convert each x position to a delta from where the previous
+        string ended.
+
+   2.   Draw the items.  Xlib splits up deltas and strings which are
+        too long for one item.
+
+*************************************************************************/
+
+void draw_text_items(Display         *display,          /* input  */
+                     Drawable         drawable,         /* input  */
+                     GC               gc,               /* input  */
+                     XFontStruct     *font,             /* input  */
+                     int              y,                /* input  */
+                     TEXT_AT         *text,             /* input  */
+                     int              count)            /* input  */
+{
+int            i;
+#ifndef WIN32
+int            pen_x;
+#endif
+
+if (count <= 0)
+   return;
+
+#ifdef WIN32
+for (i = 0; i < count; i++)
+   XDrawString(display, drawable, gc, text[i].x, y, text[i].chars, text[i].nchars);
+#else
+if (count > MAX_LINE+1)
+   count = MAX_LINE+1;
+
+pen_x = text[0].x;
+for (i = 0; i < count; i++)
+{
+   text_items[i].chars  = text[i].chars;
+   text_items[i].nchars = text[i].nchars;
+   text_items[i].delta  = text[i].x - pen_x;
+   text_items[i].font   = None;
+   pen_x = text[i].x + XTextWidth(font, text[i].chars, text[i].nchars);
+}
+
+DEBUG9(XERRORPOS)
+XDrawText(display, drawable, gc, text[0].x, y, text_items, count);
+#endif
+
+} /* end of draw_text_items */
+
+
+/************************************************************************
+
+NAME:      get_font_glyphs - Get a client side copy of the glyphs in a font
+
+PURPOSE:    This routine gets the bitmaps of the 256 chars in a single
+            byte font.  The XFontStruct only has the metrics, so the
+            server draws every char into a grid of cells in a bitmap
+            and the bitmap is read back in one XGetImage.  Chars the
+            font does not have come back as the font's default char,
+            just as the server would draw them.
+
+PARAMETERS:
+
+   1.  display    - pointer to Display (INPUT)
+                    This is the display the font is on.
+
+   2.  drawable   - Drawable (INPUT)
+                    This is any drawable on the screen.
+
+   3.  font       - pointer to XFontStruct (INPUT)
+                    This is the font to copy.
+
+   4.  glyphs     - pointer to FONT_GLYPHS (OUTPUT)
+                    The cell sizes, char widths, and bits are returned
+                    here.  The caller frees glyphs->bits.
+
+FUNCTIONS :
+
+   1.   Size the cells to hold any char in the font.
+
+   2.   Draw the chars a row at a time into a bitmap.
+
+   3.   Read the bitmap and copy the bits out a cell at a time so
+        each glyph is contiguous.
+
+RETURNED VALUE:
+   ok  -  int
+          True  - The glyphs were copied
+          False - The font cannot be copied, two byte fonts for example
+
+*************************************************************************/
+
+#define GLYPH_COLS  16  /* cells across the bitmap */
+
+int  get_font_glyphs(Display         *display,          /* input  */
+                     Drawable         drawable,         /* input  */
+                     XFontStruct     *font,             /* input  */
+                     FONT_GLYPHS     *glyphs)           /* output */
+{
+#ifdef WIN32
+return(False);
+#else
+Pixmap                bitmap;
+GC                    gc;
+XGCValues             gcvalues;
+XImage               *image;
+char                  chars[FONT_GLYPH_COUNT];
+unsigned char        *bits;
+int                   width;
+int                   height;
+int                   cell_size;
+int                   c;
+int                   gx;
+int                   gy;
+
+glyphs->bits = NULL;
+
+/***************************************************************
+*  Two byte fonts have more glyphs than we copy.
+***************************************************************/
+if (font->min_byte1 || font->max_byte1)
+   return(False);
+
+glyphs->origin_x    = (font->min_bounds.lbearing < 0) ? -font->min_bounds.lbearing : 0;
+glyphs->origin_y    = MAX(font->ascent, font->max_bounds.ascent);
+glyphs->cell_width  = glyphs->origin_x + MAX(font->max_bounds.rbearing, font->max_bounds.width);
+glyphs->cell_height = glyphs->origin_y + MAX(font->descent, font->max_bounds.descent);
+if ((glyphs->cell_width <= 0) || (glyphs->cell_height <= 0))
+   return(False);
+
+width  = glyphs->cell_width  * GLYPH_COLS;
+height = glyphs->cell_height * (FONT_GLYPH_COUNT / GLYPH_COLS);
+if ((width > 32767) || (height > 32767))
+   return(False);
+
+/***************************************************************
+*  Have the server draw all the chars into a bitmap.
+***************************************************************/
+DEBUG9(XERRORPOS)
+bitmap = XCreatePixmap(display, drawable, width, height, 1);
+gcvalues.foreground = 0;
+gcvalues.background = 0;
+gcvalues.font       = font->fid;
+DEBUG9(XERRORPOS)
+gc = XCreateGC(display, bitmap, GCForeground | GCBackground | GCFont, &gcvalues);
+DEBUG9(XERRORPOS)
+XFillRectangle(display, bitmap, gc, 0, 0, width, height);
+DEBUG9(XERRORPOS)
+XSetForeground(display, gc, 1);
+
+for (c = 0; c < FONT_GLYPH_COUNT; c++)
+{
+   chars[c] = (char)c;
+   text_pieces[c % GLYPH_COLS].x      = ((c % GLYPH_COLS) * glyphs->cell_width) + glyphs->origin_x;
+   text_pieces[c % GLYPH_COLS].chars  = &chars[c];
+   text_pieces[c % GLYPH_COLS].nchars = 1;
+   if ((c % GLYPH_COLS) == (GLYPH_COLS - 1))
+      draw_text_items(display, bitmap, gc, font,
+                      ((c / GLYPH_COLS) * glyphs->cell_height) + glyphs->origin_y,
+                      text_pieces, GLYPH_COLS);
+}
+
+DEBUG9(XERRORPOS)
+image = XGetImage(display, bitmap, 0, 0, width, height, 1, XYPixmap);
+DEBUG9(XERRORPOS)
+XFreeGC(display, gc);
+DEBUG9(XERRORPOS)
+XFreePixmap(display, bitmap);
+if (!image)
+   return(False);
+
+cell_size = glyphs->cell_width * glyphs->cell_height;
+glyphs->bits = (unsigned char *)CE_MALLOC(cell_size * FONT_GLYPH_COUNT);
+if (!glyphs->bits)
+   {
+      XDestroyImage(image);
+      return(False);
+   }
+
+for (c = 0; c < FONT_GLYPH_COUNT; c++)
+{
+   bits = glyphs->bits + (c * cell_size);
+   for (gy = 0; gy < glyphs->cell_height; gy++)
+      for (gx = 0; gx < glyphs->cell_width; gx++)
+         *bits++ = (XGetPixel(image,
+                              ((c % GLYPH_COLS) * glyphs->cell_width) + gx,
+                              ((c / GLYPH_COLS) * glyphs->cell_height) + gy) != 0);
+   glyphs->advance[c] = XTextWidth(font, &chars[c], 1);
+}
+
+XDestroyImage(image);
+
+DEBUG12(fprintf(stderr, "get_font_glyphs:  font 0x%lX copied, cells %dx%d\n",
+                font->fid, glyphs->cell_width, glyphs->cell_height);
+)
+
+return(True);
+#endif
+
+} /* end of get_font_glyphs */
 
 
 #ifdef EXCLUDEP 
@@ -38,6 +38,10 @@
 *     draw_partial_line  - Draw a partial line.
 *     colorname_to_pixel - Convert a named color to a Pixel value.
 *     translate_gc_function - translate a GC function code to the name for debugging
+*     free_render_cache  - Free the saved line drawing data for a pad.
+*     painted_line_count - Get the number of lines drawn so far
+*     draw_text_items    - Draw several strings on one baseline in one request
+*     get_font_glyphs    - Get a client side copy of the glyphs in a font
 *
 ***************************************************************/
 
@@ -58,6 +62,39 @@
 #include "buffer.h"    /* needed for def of DRAWABLE_DESCR and WINDOW_LINE */
 #include "memdata.h"   /* needed for def of DATA_TOKEN */
 
+/***************************************************************
+*  
+*  A string to be drawn at a given x by draw_text_items.
+*  
+***************************************************************/
+
+typedef struct {
+   int            x;               /* x coordinate to draw the string at */
+   char          *chars;           /* string, need not be null terminated */
+   int            nchars;          /* number of chars to draw            */
+} TEXT_AT;
+
+/***************************************************************
+*  
+*  Client side copy of the glyphs in a single byte font, built
+*  by get_font_glyphs.  Each of the 256 chars has a cell of
+*  cell_width x cell_height bytes in bits, 1 where there is ink.
+*  The char is drawn with its origin at origin_x, origin_y in
+*  the cell.
+*  
+***************************************************************/
+
+#define FONT_GLYPH_COUNT 256
+
+typedef struct {
+   int            cell_width;      /* size of each glyph cell in pixels         */
+   int            cell_height;
+   int            origin_x;        /* char origin within the cell               */
+   int            origin_y;
+   int            advance[FONT_GLYPH_COUNT]; /* pixels to move the pen after each char */
+   unsigned char *bits;            /* malloc'ed, FONT_GLYPH_COUNT cells          */
+} FONT_GLYPHS;
+
 /***************************************************************
 *  
 *  Function prototypes
@@ -119,6 +156,23 @@ unsigned long colorname_to_pixel(Display   *display,   /* input  */
 
 void translate_gc_function(int function, char *str);
 
+void free_render_cache(PAD_DESCR       *pad);               /* input/output */
+
+int  painted_line_count(void);
+
+void draw_text_items(Display         *display,          /* input  */
+                     Drawable         drawable,         /* input  */
+                     GC               gc,               /* input  */
+                     XFontStruct     *font,             /* input  */
+                     int              y,                /* input  */
+                     TEXT_AT         *text,             /* input  */
+                     int              count);           /* input  */
+
+int  get_font_glyphs(Display         *display,          /* input  */
+                     Drawable         drawable,         /* input  */
+                     XFontStruct     *font,             /* input  */
+                     FONT_GLYPHS     *glyphs);          /* output */
+
 /***************************************************************
 *  
 *  Test of exclude color extraction.